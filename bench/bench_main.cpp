@@ -0,0 +1,452 @@
+/**
+ * @file bench_main.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Micro-benchmarks of hot paths (build with -DBUILD_BENCH=ON)
+ * @version 0.1
+ * @date 2026-01-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "peripheral/bme280_compensation.h"
+#include "peripheral/sensirion_codec.h"
+#include "peripheral/sensor_concepts.h"
+#include "peripheral/peripheral_factory.h"
+#include "config/json_parser.h"
+#include "app/metrics_server.h"
+#include "app/shm_publisher.h"
+#include "legacy_json.h"
+#ifdef USE_BOOST
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#endif
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace peripherals;
+
+// Runs fn once and prints wall time and per-item cost
+static void report(const std::string &name, size_t items, const std::function<void()> &fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << name << ": " << s << " s, " << (s * 1e9 / double(items)) << " ns/item" << std::endl;
+}
+
+// A year of 1 Hz BME280 samples: scalar per-sample path vs the SoA batch engine
+static void bench_bme280_compensation()
+{
+    bme280_calibration c;
+    c.dig_T1 = 27504; c.dig_T2 = 26435; c.dig_T3 = -1000;
+    c.dig_P1 = 36477; c.dig_P2 = -10685; c.dig_P3 = 3024; c.dig_P4 = 2855; c.dig_P5 = 140;
+    c.dig_P6 = -7; c.dig_P7 = 15500; c.dig_P8 = -14600; c.dig_P9 = 6000;
+    c.dig_H1 = 75; c.dig_H2 = 362; c.dig_H3 = 0; c.dig_H4 = 313; c.dig_H5 = 50; c.dig_H6 = 30;
+
+    const size_t n = 365u * 24u * 3600u;
+    std::vector<int32_t> raw_t(n), raw_p(n), raw_h(n);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        raw_t[i] = 500000 + int32_t(seed >> 16);
+        raw_p[i] = 400000 + int32_t(seed & 0x7FFF);
+        raw_h[i] = 30000 + int32_t((seed >> 8) & 0x3FFF);
+    }
+
+    std::vector<int32_t> t_scalar(n), t_batch(n);
+    std::vector<uint32_t> p_scalar(n), p_batch(n), h_scalar(n), h_batch(n);
+
+    report("bme280 scalar, 1 year @ 1 Hz", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            int32_t t_fine = bme280_t_fine(c, raw_t[i]);
+            t_scalar[i] = bme280_temperature_centi(t_fine);
+            p_scalar[i] = bme280_pressure_q24_8(c, raw_p[i], t_fine);
+            h_scalar[i] = bme280_humidity_q22_10(c, raw_h[i], t_fine);
+        }
+    });
+
+    report("bme280 batch,  1 year @ 1 Hz", n, [&] {
+        bme280_compensate_batch(c, raw_t, raw_p, raw_h, t_batch, p_batch, h_batch);
+    });
+
+    bool same = t_scalar == t_batch && p_scalar == p_batch && h_scalar == h_batch;
+    std::cout << "bme280 batch bit-exact: " << (same ? "yes" : "NO") << std::endl;
+}
+
+// SCD41 read_measurement reply: 3 words, CRC-checked decode per frame
+static void bench_sensirion_decode()
+{
+    const size_t frames = 10000000;
+    std::array<uint8_t, 9> wire{};
+    const uint16_t reply[3] = {0x01F4, 0x6667, 0x8000};
+    for (size_t w = 0; w < 3; ++w) {
+        wire[3 * w] = uint8_t(reply[w] >> 8);
+        wire[3 * w + 1] = uint8_t(reply[w] & 0xFF);
+        wire[3 * w + 2] = sensirion::crc8(reply[w]);
+    }
+
+    uint64_t sum = 0;
+    report("sensirion decode, 3 words", frames, [&] {
+        std::array<uint16_t, 3> words;
+        for (size_t i = 0; i < frames; ++i) {
+            wire[1] = uint8_t(i); // vary the frame so the decode is not hoisted
+            wire[2] = sensirion::crc8(wire[0], wire[1]);
+            if (sensirion::decode<3>(wire, words))
+                sum += words[0] + words[1] + words[2];
+        }
+    });
+    std::cout << "checksum " << sum << std::endl;
+}
+
+// Register-free gas driver: measures dispatch, not I/O
+template <int Base>
+class bench_gas final : public gas_sensor_iface
+{
+public:
+    bench_gas() : gas_sensor_iface(nullptr, 0) {}
+    Status initialize() override { initialized_ = true; return Status::Success; }
+    void deinitialize() override { initialized_ = false; }
+    bool is_connected() override { return true; }
+    Status reset() override { return Status::Success; }
+    Status read_data(gas_data &data) override
+    {
+        data.co2_ppm = float(Base + int(++counter_ & 0xFF));
+        data.valid = true;
+        return Status::Success;
+    }
+    Status set_measurement_mode(uint8_t) override { return Status::Success; }
+    Status read_co2(float &ppm) override { ppm = 0; return Status::Success; }
+    Status read_tvoc(float &ppb) override { ppb = 0; return Status::Success; }
+
+private:
+    uint32_t counter_ = 0;
+};
+
+// Runtime choice of the concrete type keeps the compiler from devirtualizing
+[[gnu::noinline]] static std::unique_ptr<gas_sensor_iface> make_dynamic_gas(int which)
+{
+    if (which == 0) return std::make_unique<bench_gas<400>>();
+    if (which == 1) return std::make_unique<bench_gas<500>>();
+    return std::make_unique<bench_gas<600>>();
+}
+
+// Size of these two is what `nm -C --size-sort bench_atmolyt | grep poll_` compares
+[[gnu::noinline]] double poll_dynamic(const std::vector<std::unique_ptr<gas_sensor_iface>> &sensors)
+{
+    double sum = 0;
+    for (auto &sensor : sensors) {
+        gas_data data{};
+        if (sensor->read_data(data) == Status::Success)
+            sum += data.co2_ppm;
+    }
+    return sum;
+}
+
+[[gnu::noinline]] double poll_static(sensor_set<bench_gas<400>, bench_gas<500>, bench_gas<600>> &sensors)
+{
+    double sum = 0;
+    sensors.poll([&sum](auto &, Status status, const gas_data &data) {
+        if (status == Status::Success)
+            sum += data.co2_ppm;
+    });
+    return sum;
+}
+
+// Three gas sensors polled through the virtual interface vs a compile-time set,
+// plus the config-time type lookup (std::map vs constexpr table)
+static void bench_peripheral_dispatch()
+{
+    const size_t polls = 20000000;
+
+    std::vector<std::unique_ptr<gas_sensor_iface>> dynamic_set;
+    for (int i = 0; i < 3; ++i)
+        dynamic_set.push_back(make_dynamic_gas(i));
+
+    bench_gas<400> a;
+    bench_gas<500> b;
+    bench_gas<600> c;
+    sensor_set static_set(a, b, c);
+
+    double sum_dynamic = 0, sum_static = 0;
+    report("dispatch virtual, 3 sensors", polls * 3, [&] {
+        for (size_t i = 0; i < polls; ++i)
+            sum_dynamic += poll_dynamic(dynamic_set);
+    });
+    report("dispatch static,  3 sensors", polls * 3, [&] {
+        for (size_t i = 0; i < polls; ++i)
+            sum_static += poll_static(static_set);
+    });
+    std::cout << "dispatch results match: " << (sum_dynamic == sum_static ? "yes" : "NO") << std::endl;
+
+    const std::map<std::string, PeripheralType> legacy_map = {
+        {"bmp280", PeripheralType::BMP280}, {"bme280", PeripheralType::BME280},
+        {"mpu6050", PeripheralType::MPU6050}, {"dht22", PeripheralType::DHT22},
+        {"sgp41", PeripheralType::SGP41}, {"scd41", PeripheralType::SCD41},
+        {"ssd1306", PeripheralType::SSD1306}, {"ds3231", PeripheralType::DS3231}};
+    const std::array<std::string, 4> names = {"SCD41", "bme280", "ds3231", "unknown"};
+    const size_t lookups = 5000000;
+    size_t hits_map = 0, hits_table = 0;
+
+    report("type lookup std::map (lowercased copy)", lookups, [&] {
+        for (size_t i = 0; i < lookups; ++i) {
+            std::string lower = names[i & 3];
+            for (auto &ch : lower) ch = char(std::tolower(static_cast<unsigned char>(ch)));
+            hits_map += legacy_map.count(lower);
+        }
+    });
+    report("type lookup constexpr table", lookups, [&] {
+        for (size_t i = 0; i < lookups; ++i)
+            hits_table += type_from_name(names[i & 3]) != PeripheralType::Unknown;
+    });
+    std::cout << "lookup results match: " << (hits_map == hits_table ? "yes" : "NO") << std::endl;
+}
+
+// A config with `count` peripherals, each with a handful of option keys
+static std::string make_config(size_t count)
+{
+    std::string out = R"({"log_path": "atmolyt_data.csv", "sparkline_minutes": 30, "peripherals": [)";
+    for (size_t i = 0; i < count; ++i) {
+        if (i)
+            out += ",";
+        out += R"({"connection": "i2c", "type": "scd41", "device": "/dev/i2c-)" + std::to_string(i % 8) +
+               R"(", "address": "0x62", "speed_hz": 400000, "i2c_timeout_ms": 100,)" +
+               R"( "label": "room \"lab\" )" + std::to_string(i) + R"(", "altitude_m": 152.5, "enabled": true})";
+    }
+    return out + "]}";
+}
+
+// Parse a multi-hundred-peripheral config from disk and read every key the way
+// load_config does: legacy shared_ptr DOM vs arena DOM vs pull reader vs Boost ptree
+static void bench_json_config()
+{
+    const char *path = "/tmp/bench_atmolyt_config.json";
+    for (size_t count : {100u, 500u}) {
+        {
+            std::ofstream f(path);
+            f << make_config(count);
+        }
+        const size_t rounds = 20000 / count;
+        const std::string tag = std::to_string(count) + " peripherals, per peripheral";
+        size_t legacy_keys = 0, arena_keys = 0;
+
+        report("json legacy shared_ptr DOM, " + tag, rounds * count, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                auto root = legacy_json::parse_file(path);
+                for (const auto &item : root->get("peripherals")->as_array()) {
+                    legacy_keys += item->get_string("type").size() + item->get_string("address").size();
+                    legacy_keys += item->as_object().size() + size_t(item->get_int("speed_hz") > 0);
+                }
+            }
+        });
+
+        size_t footprint = 0, nodes = 0;
+        report("json arena DOM,             " + tag, rounds * count, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                auto doc = json::parse_file(path);
+                for (json::Value item : doc.root().get("peripherals")) {
+                    arena_keys += item.get_string("type").size() + item.get_string("address").size();
+                    arena_keys += item.size() + size_t(item.get_int("speed_hz") > 0);
+                }
+                footprint = doc.footprint_bytes();
+                nodes = doc.node_count();
+            }
+        });
+        std::cout << "json results match: " << (legacy_keys == arena_keys ? "yes" : "NO") << ", arena " << nodes
+                  << " nodes, " << footprint << " B incl. text; legacy node " << sizeof(legacy_json::Value)
+                  << " B + control block + strings" << std::endl;
+
+        size_t reader_keys = 0;
+        report("json pull reader, no tree,  " + tag, rounds * count, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                json::FileBuffer file;
+                file.load(path);
+                json::Reader in(file.view());
+                in.object([&](std::string_view key) {
+                    if (key != "peripherals")
+                        return;
+                    in.array([&] {
+                        in.object([&](std::string_view member) {
+                            ++reader_keys;
+                            if (member == "type" || member == "address") {
+                                in.read_scalar();
+                                reader_keys += in.string().size();
+                            } else if (member == "speed_hz") {
+                                int speed = 0;
+                                in.read(speed);
+                                reader_keys += size_t(speed > 0);
+                            }
+                        });
+                    });
+                });
+            }
+        });
+        std::cout << "reader results match: " << (reader_keys == arena_keys ? "yes" : "NO") << std::endl;
+
+#ifdef USE_BOOST
+        size_t ptree_keys = 0;
+        report("json boost ptree,           " + tag, rounds * count, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                boost::property_tree::ptree root;
+                boost::property_tree::read_json(path, root);
+                for (auto &item : root.get_child("peripherals")) {
+                    ptree_keys += item.second.get<std::string>("type").size() +
+                                  item.second.get<std::string>("address").size();
+                    ptree_keys += item.second.size() + size_t(item.second.get<int>("speed_hz") > 0);
+                }
+            }
+        });
+        std::cout << "ptree results match: " << (ptree_keys == arena_keys ? "yes" : "NO") << std::endl;
+#endif
+    }
+    std::remove(path);
+}
+
+// Keep-alive scrapes of /metrics over loopback from a few concurrent clients
+static void bench_metrics_scrape()
+{
+    app::sample_bus bus;
+    app::health_monitor health;
+    int devices[6];
+    for (int i = 0; i < 6; ++i) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "gas@0x%02x", 0x60 + i);
+        health.add(&devices[i], name, [] { return true; });
+    }
+    app::metrics_server server("127.0.0.1", 0, bus, &health);
+    app::sample_frame frame;
+    for (size_t i = 0; i < app::CHANNEL_COUNT; ++i)
+        frame.set(app::channel(i), 100.0 + double(i));
+    bus.publish(frame);
+    while (server.renders() < 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    const int clients = 4;
+    const int per_client = 20000;
+    size_t bytes = 0;
+    report("metrics scrape, 4 keep-alive clients", size_t(clients) * per_client, [&] {
+        std::vector<std::thread> threads;
+        std::vector<size_t> received(clients);
+        for (int c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c] {
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr{};
+                addr.sin_family = AF_INET;
+                addr.sin_port = htons(server.port());
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+                const char req[] = "GET /metrics HTTP/1.1\r\n\r\n";
+                std::string buf(65536, '\0');
+                size_t response_size = 0;
+                for (int i = 0; i < per_client; ++i) {
+                    send(fd, req, sizeof(req) - 1, 0);
+                    size_t got = 0;
+                    do {
+                        ssize_t n = recv(fd, &buf[got], buf.size() - got, 0);
+                        if (n <= 0) { close(fd); return; }
+                        got += size_t(n);
+                        if (!response_size) {
+                            size_t head = buf.find("\r\n\r\n");
+                            if (head != std::string::npos && head < got)
+                                response_size = head + 4 + std::stoul(buf.substr(buf.find("Content-Length: ") + 16));
+                        }
+                    } while (!response_size || got < response_size);
+                    received[c] += got;
+                }
+                close(fd);
+            });
+        }
+        for (auto &t : threads)
+            t.join();
+        for (size_t r : received)
+            bytes += r;
+    });
+    std::cout << "responses: " << bytes / (size_t(clients) * per_client) << " bytes each, renders: "
+              << server.renders() << std::endl;
+}
+
+// Reader side of the shared-memory segment: quiet, and with a writer hammering the same record
+static void bench_shm_read()
+{
+    const std::string name = "/atmolyt_bench_" + std::to_string(getpid());
+    app::shm_publisher writer(name);
+    const atmolyt_shm_segment *seg = atmolyt_shm_map(name.c_str());
+    if (!seg) {
+        std::cout << "shm: cannot map " << name << std::endl;
+        return;
+    }
+    app::sample_frame frame;
+    frame.set(app::channel::co2_ppm, 612);
+    writer.publish(frame);
+
+    const size_t n = 50000000;
+    double sum = 0;
+    atmolyt_shm_sample s{};
+    report("shm read, no writer", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &s);
+            sum += s.value;
+        }
+    });
+
+    std::atomic<bool> done{false};
+    uint64_t writes = 0;
+    std::thread hammer([&] {
+        app::sample_frame f;
+        while (!done.load(std::memory_order_relaxed)) {
+            f.set(app::channel::co2_ppm, double(writes++));
+            writer.publish(f);
+        }
+    });
+    report("shm read, writer on the same record", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &s);
+            sum += s.value;
+        }
+    });
+    done = true;
+    hammer.join();
+    std::cout << "writes meanwhile: " << writes << " (checksum " << (sum > 0 ? "ok" : "?") << ")" << std::endl;
+
+    atmolyt_shm_unmap(seg);
+    shm_unlink(name.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    // Optional filter: run only benchmarks whose name contains argv[1]
+    const std::string filter = argc > 1 ? argv[1] : "";
+    auto selected = [&filter](const char *name) { return filter.empty() || std::strstr(name, filter.c_str()); };
+
+    if (selected("bme280"))
+        bench_bme280_compensation();
+    if (selected("sensirion"))
+        bench_sensirion_decode();
+    if (selected("dispatch"))
+        bench_peripheral_dispatch();
+    if (selected("json"))
+        bench_json_config();
+    if (selected("metrics"))
+        bench_metrics_scrape();
+    if (selected("shm"))
+        bench_shm_read();
+
+    return 0;
+}
@@ -0,0 +1,349 @@
+/**
+ * @file legacy_json.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  The shared_ptr JSON DOM the fallback parser used before the arena
+ *         rewrite, kept verbatim as the benchmark baseline
+ * @version 0.1
+ * @date 2026-01-28
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace legacy_json {
+
+
+class Value;
+using Object = std::map<std::string, std::shared_ptr<Value>>;
+using Array = std::vector<std::shared_ptr<Value>>;
+
+enum class Type {
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+class Value {
+public:
+    Value() : type_(Type::Null) {}
+    explicit Value(bool b) : type_(Type::Boolean), bool_value_(b) {}
+    explicit Value(double n) : type_(Type::Number), number_value_(n) {}
+    explicit Value(int n) : type_(Type::Number), number_value_(static_cast<double>(n)) {}
+    explicit Value(const std::string& s) : type_(Type::String), string_value_(s) {}
+    explicit Value(std::string&& s) : type_(Type::String), string_value_(std::move(s)) {}
+    explicit Value(const Array& a) : type_(Type::Array), array_value_(a) {}
+    explicit Value(Array&& a) : type_(Type::Array), array_value_(std::move(a)) {}
+    explicit Value(const Object& o) : type_(Type::Object), object_value_(o) {}
+    explicit Value(Object&& o) : type_(Type::Object), object_value_(std::move(o)) {}
+
+    Type type() const { return type_; }
+    bool is_null() const { return type_ == Type::Null; }
+    bool is_bool() const { return type_ == Type::Boolean; }
+    bool is_number() const { return type_ == Type::Number; }
+    bool is_string() const { return type_ == Type::String; }
+    bool is_array() const { return type_ == Type::Array; }
+    bool is_object() const { return type_ == Type::Object; }
+
+    bool as_bool() const { return bool_value_; }
+    double as_number() const { return number_value_; }
+    int as_int() const { return static_cast<int>(number_value_); }
+    const std::string& as_string() const { return string_value_; }
+    const Array& as_array() const { return array_value_; }
+    const Object& as_object() const { return object_value_; }
+
+    // Get object value by key with optional default
+    std::shared_ptr<Value> get(const std::string& key) const;
+    std::string get_string(const std::string& key, const std::string& default_val = "") const;
+    int get_int(const std::string& key, int default_val = 0) const;
+    double get_number(const std::string& key, double default_val = 0.0) const;
+    bool get_bool(const std::string& key, bool default_val = false) const;
+
+private:
+    Type type_;
+    bool bool_value_ = false;
+    double number_value_ = 0.0;
+    std::string string_value_;
+    Array array_value_;
+    Object object_value_;
+};
+
+
+class Parser {
+public:
+    explicit Parser(const std::string& str) : input_(str), pos_(0) {}
+
+    std::shared_ptr<Value> parse() {
+        skip_whitespace();
+        return parse_value();
+    }
+
+private:
+    std::string input_;
+    size_t pos_;
+
+    char current() const { return pos_ < input_.length() ? input_[pos_] : '\0'; }
+   
+    char peek(int offset = 1) const {
+        return pos_ + offset < input_.length() ? input_[pos_ + offset] : '\0';
+    }
+
+    void advance() { pos_++; }
+
+    void skip_whitespace() {
+        while (pos_ < input_.length() && std::isspace(input_[pos_])) {
+            pos_++;
+        }
+    }
+
+    std::shared_ptr<Value> parse_value() {
+        skip_whitespace();
+       
+        char c = current();
+        if (c == '{') {
+            return parse_object();
+        } else if (c == '[') {
+            return parse_array();
+        } else if (c == '"') {
+            return std::make_shared<Value>(parse_string());
+        } else if (c == 't' || c == 'f') {
+            return parse_bool();
+        } else if (c == 'n') {
+            return parse_null();
+        } else if (c == '-' || std::isdigit(c)) {
+            return parse_number();
+        }
+        throw std::runtime_error("Invalid JSON value");
+    }
+
+    std::shared_ptr<Value> parse_object() {
+        Object obj;
+        advance(); // skip '{'
+        skip_whitespace();
+
+        if (current() == '}') {
+            advance();
+            return std::make_shared<Value>(obj);
+        }
+
+        while (true) {
+            skip_whitespace();
+            if (current() != '"') {
+                throw std::runtime_error("Expected string key in object");
+            }
+            std::string key = parse_string();
+           
+            skip_whitespace();
+            if (current() != ':') {
+                throw std::runtime_error("Expected ':' after key");
+            }
+            advance();
+           
+            auto value = parse_value();
+            obj[key] = value;
+           
+            skip_whitespace();
+            if (current() == '}') {
+                advance();
+                break;
+            } else if (current() == ',') {
+                advance();
+            } else {
+                throw std::runtime_error("Expected ',' or '}' in object");
+            }
+        }
+        return std::make_shared<Value>(obj);
+    }
+
+    std::shared_ptr<Value> parse_array() {
+        Array arr;
+        advance(); // skip '['
+        skip_whitespace();
+
+        if (current() == ']') {
+            advance();
+            return std::make_shared<Value>(arr);
+        }
+
+        while (true) {
+            arr.push_back(parse_value());
+            skip_whitespace();
+           
+            if (current() == ']') {
+                advance();
+                break;
+            } else if (current() == ',') {
+                advance();
+            } else {
+                throw std::runtime_error("Expected ',' or ']' in array");
+            }
+        }
+        return std::make_shared<Value>(arr);
+    }
+
+    std::string parse_string() {
+        std::string result;
+        advance(); // skip opening '"'
+       
+        while (pos_ < input_.length() && current() != '"') {
+            if (current() == '\\') {
+                advance();
+                if (pos_ >= input_.length()) {
+                    throw std::runtime_error("Unexpected end of string");
+                }
+                char c = current();
+                switch (c) {
+                    case '"': result += '"'; break;
+                    case '\\': result += '\\'; break;
+                    case '/': result += '/'; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'n': result += '\n'; break;
+                    case 'r': result += '\r'; break;
+                    case 't': result += '\t'; break;
+                    case 'u': {
+                        // Simple unicode escape - just skip for now
+                        advance();
+                        for (int i = 0; i < 3 && pos_ < input_.length(); i++) {
+                            advance();
+                        }
+                        continue;
+                    }
+                    default: result += c;
+                }
+                advance();
+            } else {
+                result += current();
+                advance();
+            }
+        }
+       
+        if (current() != '"') {
+            throw std::runtime_error("Unterminated string");
+        }
+        advance(); // skip closing '"'
+        return result;
+    }
+
+    std::shared_ptr<Value> parse_number() {
+        std::string num_str;
+        if (current() == '-') {
+            num_str += current();
+            advance();
+        }
+       
+        while (pos_ < input_.length() && (std::isdigit(current()) || current() == '.' ||
+               current() == 'e' || current() == 'E' || current() == '+' || current() == '-')) {
+            num_str += current();
+            advance();
+        }
+       
+        try {
+            double value = std::stod(num_str);
+            return std::make_shared<Value>(value);
+        } catch (...) {
+            throw std::runtime_error("Invalid number: " + num_str);
+        }
+    }
+
+    std::shared_ptr<Value> parse_bool() {
+        if (input_.substr(pos_, 4) == "true") {
+            pos_ += 4;
+            return std::make_shared<Value>(true);
+        } else if (input_.substr(pos_, 5) == "false") {
+            pos_ += 5;
+            return std::make_shared<Value>(false);
+        }
+        throw std::runtime_error("Invalid boolean");
+    }
+
+    std::shared_ptr<Value> parse_null() {
+        if (input_.substr(pos_, 4) == "null") {
+            pos_ += 4;
+            return std::make_shared<Value>();
+        }
+        throw std::runtime_error("Invalid null");
+    }
+};
+
+inline std::shared_ptr<Value> Value::get(const std::string& key) const {
+    if (type_ != Type::Object) {
+        return nullptr;
+    }
+    auto it = object_value_.find(key);
+    if (it != object_value_.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+inline std::string Value::get_string(const std::string& key, const std::string& default_val) const {
+    auto val = get(key);
+    if (val && val->is_string()) {
+        return val->as_string();
+    }
+    return default_val;
+}
+
+inline int Value::get_int(const std::string& key, int default_val) const {
+    auto val = get(key);
+    if (val && val->is_number()) {
+        return val->as_int();
+    }
+    return default_val;
+}
+
+inline double Value::get_number(const std::string& key, double default_val) const {
+    auto val = get(key);
+    if (val && val->is_number()) {
+        return val->as_number();
+    }
+    return default_val;
+}
+
+inline bool Value::get_bool(const std::string& key, bool default_val) const {
+    auto val = get(key);
+    if (val && val->is_bool()) {
+        return val->as_bool();
+    }
+    return default_val;
+}
+
+inline std::shared_ptr<Value> parse(const std::string& json_str) {
+    try {
+        Parser parser(json_str);
+        return parser.parse();
+    } catch (const std::exception& e) {
+        std::cerr << "JSON parse error: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+inline std::shared_ptr<Value> parse_file(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open file: " << filepath << std::endl;
+        return nullptr;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    file.close();
+
+    return parse(buffer.str());
+}
+
+} // namespace legacy_json
@@ -11,50 +11,94 @@
 
 #pragma once
 
+#include "app/peripheral_health.h"
+#include "app/peripheral_set.h"
 #include "config/config_loader.h"
-#include "connections/connection_iface.h"
 #include "peripheral/peripheral_factory.h"
+#include <condition_variable>
 #include <memory>
-#include <vector>
+#include <mutex>
+#include <thread>
 
 namespace app
 {
+    struct query_command;
+
     class atmolyt
     {
     public:
         atmolyt(int argc, char *argv[]);
         ~atmolyt();
 
-        // Check if app should run main loop (false if --help, --view, --st was used)
+        // Check if app should run main loop (false if --help, --view, --st, --query was used)
         bool should_run() const { return should_run_; }
 
-        // Getters for peripherals
-        const std::vector<std::unique_ptr<peripherals::environmental_sensor_iface>>& get_environmental_sensors() const { return environmental_sensors_; }
-        const std::vector<std::unique_ptr<peripherals::gas_sensor_iface>>& get_gas_sensors() const { return gas_sensors_; }
-        const std::vector<std::unique_ptr<peripherals::display_iface>>& get_displays() const { return displays_; }
-        const std::vector<std::unique_ptr<peripherals::rtc_iface>>& get_rtcs() const { return rtcs_; }
-        
+        // Current peripherals; hold the snapshot for a whole tick, a reload swaps
+        // in a new one and tears removed devices down only after it is released
+        std::shared_ptr<const peripheral_set> get_peripherals() const;
+
+        // Startup values; per-tick settings of a reloaded config are in the snapshot
         const std::string& get_log_path() const { return config_.log_path; }
+        int get_sparkline_minutes() const { return config_.sparkline_minutes; }
+        const std::string& get_raw_capture_path() const { return config_.raw_capture_path; }
+        int get_history_minutes() const { return config_.history_minutes; }
+        int get_read_budget_ms() const { return config_.read_budget_ms; }
+        int get_poll_interval_ms() const { return config_.poll_interval_ms; }
+        const std::string& get_metrics_listen() const { return config_.metrics_listen; }
+        const std::string& get_shm_name() const { return config_.shm_name; }
+        const std::string& get_stream_socket() const { return config_.stream_socket; }
+        const config::MqttConfig& get_mqtt() const { return config_.mqtt; }
+
+        // nullptr for devices that are not tracked; failed devices must not be polled
+        peripheral_health *health_of(const void *device) { return health_.find(device); }
+        const health_monitor &get_health() const { return health_; }
+
+        // Cheap and thread-safe (called from the SIGHUP watcher): wakes the reload thread
+        void request_reload();
+
+        // Re-reads the config and swaps in a set where only changed entries are
+        // rebuilt; a config that fails to load keeps the running set
+        bool reload();
 
     private:
 
         int parse_inarg(int, char**);
 
+        // --query: aggregates to stdout; 1 when done, negative errno on failure
+        int run_query(query_command cmd);
+
         // Load configuration and instantiate peripherals
         bool load_and_create_peripherals();
 
+        // Bring up one config entry: its bus, optional D/C line and the device
+        std::shared_ptr<peripheral_slot> make_slot(const config::PeripheralSpec &p);
+
+        // Register a new device with the health monitor
+        void watch(const peripheral_slot &slot);
+
+        void publish(std::shared_ptr<const peripheral_set> set);
+        // Waits until the poll loop lets go of the replaced snapshot, then takes the
+        // removed devices out of the monitor and tears them down
+        void retire(const std::weak_ptr<const peripheral_set> &old,
+                    std::vector<std::shared_ptr<peripheral_slot>> &removed);
+        void reload_loop(std::stop_token stop);
+
     private:
         bool is_periphery_init = false;
         bool should_run_ = true;
         std::string config_path_ = "./config/atmolyt.json";
         config::AppConfig config_;
 
-        // storage for live connections and peripheral objects
-        std::vector<std::unique_ptr<connections::connection_iface<uint8_t>>> connections_;
-        std::vector<std::unique_ptr<peripherals::environmental_sensor_iface>> environmental_sensors_;
-        std::vector<std::unique_ptr<peripherals::gas_sensor_iface>> gas_sensors_;
-        std::vector<std::unique_ptr<peripherals::display_iface>> displays_;
-        std::vector<std::unique_ptr<peripherals::rtc_iface>> rtcs_;
+        // live connections and peripherals, swapped as a whole on reload
+        mutable std::mutex set_mutex_;
+        std::shared_ptr<const peripheral_set> set_;
+
+        health_monitor health_;
+
+        std::mutex reload_mutex_;
+        std::condition_variable_any reload_cv_;
+        bool reload_pending_ = false;
+        std::jthread reload_worker_;
 
     };
 
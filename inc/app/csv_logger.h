@@ -4,49 +4,40 @@
  * @brief  Declaration of the csv_logger class
  * @version 0.1
  * @date 2025-12-23
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 
 #pragma once
 
+#include "app/log_index.h"
+#include "app/sample_bus.h"
 #include <fstream>
 #include <string>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 #include <thread>
-#include <atomic>
 
 namespace app
 {
-    struct LogEntry {
-        double co2_ppm;
-        double temp_c;
-        double press_pa;
-        double humidity_rh;
-        std::string timestamp;
-    };
-
+    // Sample bus subscriber: one CSV row per published frame, written from its own
+    // thread. Channels missing from a frame are left empty. Keeps the sparse
+    // <log>.idx time index (log_index.h) in step with the rows.
     class csv_logger
     {
     public:
-        explicit csv_logger(const std::string& filename);
+        csv_logger(const std::string& filename, sample_bus& bus);
         ~csv_logger();
 
-        void log(double co2_ppm, double temp_c, double press_pa, double humidity_rh, const std::string& timestamp);
-        void log_async(double co2_ppm, double temp_c, double press_pa, double humidity_rh, const std::string& timestamp);
+        static constexpr const char *HEADER =
+            "timestamp,co2_ppm,temperature_c,pressure_pa,humidity_rh,voc_index,nox_index";
 
     private:
-        void worker_thread();
-        void write_entry(const LogEntry& entry);
+        void worker_thread(std::stop_token stop);
+        void write_frame(const sample_frame& frame);
 
         std::ofstream file_;
-        std::queue<LogEntry> queue_;
-        std::mutex mutex_;
-        std::condition_variable cv_;
-        std::thread worker_;
-        std::atomic<bool> stop_{false};
+        log_index_writer index_;
+        sample_bus::subscription *feed_ = nullptr;
+        std::jthread worker_;
     };
 }
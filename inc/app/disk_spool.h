@@ -0,0 +1,115 @@
+/**
+ * @file disk_spool.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Disk-backed FIFO of opaque records for store-and-forward sinks
+ * @version 0.1
+ * @date 2026-02-03
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace app
+{
+    // Where the next unread record starts
+    struct spool_position
+    {
+        uint64_t segment = 0;
+        uint64_t offset = 0;
+
+        bool operator==(const spool_position &) const = default;
+    };
+
+    struct spool_settings
+    {
+        uint64_t segment_bytes = 4u << 20; // a segment is closed once it would grow past this
+        uint64_t max_bytes = 256u << 20;   // on disk; past it whole oldest segments are dropped
+        std::chrono::milliseconds sync_interval{1000}; // data and cursor reach the disk at least this often
+    };
+
+    // Directory of append-only segments "<id>.seg", each record framed as
+    // [u32 length][u32 crc32][payload]. Reading hands records out in order and
+    // ack() moves the committed cursor, kept in "cursor" (written aside and
+    // renamed); segments wholly before it are deleted. After a crash a torn
+    // tail record is cut off and reading resumes at the last committed cursor,
+    // so a record can come twice but is never skipped. Memory use does not
+    // depend on the backlog: only positions are held, records are read with
+    // pread. Not thread-safe; one owner thread.
+    class disk_spool
+    {
+    public:
+        static constexpr uint32_t MAX_RECORD = 1u << 20;
+
+        explicit disk_spool(const std::string &dir, const spool_settings &settings = {});
+        ~disk_spool();
+
+        disk_spool(const disk_spool &) = delete;
+        disk_spool &operator=(const disk_spool &) = delete;
+
+        bool ok() const { return write_fd_ >= 0; }
+
+        bool append(std::string_view record);
+
+        // Next record past the read cursor; next is the position after it, to
+        // pass to ack(). false when everything written has been read.
+        bool read(std::string &record, spool_position &next);
+
+        // All records before pos were delivered
+        void ack(const spool_position &pos);
+
+        // Read again from the committed cursor, e.g. after a lost connection
+        void rewind() { read_ = committed_; }
+
+        // Nothing left to read
+        bool empty() const { return read_ == write_; }
+
+        // Bytes between the committed cursor and the end, segment framing included
+        uint64_t backlog_bytes() const;
+        uint64_t dropped_segments() const { return dropped_segments_; }
+        uint64_t corrupt_records() const { return corrupt_records_; }
+
+        // Data and cursor to disk now, or only once sync_interval has passed since
+        // the last time; an owner that appends in bursts calls sync_if_due() from
+        // its loop so the tail of a burst does not wait for the next append
+        void sync();
+        void sync_if_due();
+
+    private:
+        std::string segment_path(uint64_t id) const;
+        bool open_write_segment(uint64_t id);
+        bool open_read_segment(uint64_t id);
+        uint64_t recover_tail(uint64_t id);
+        void load_cursor();
+        void save_cursor();
+        void drop_oldest();
+        void delete_before(uint64_t segment);
+
+        std::string dir_;
+        spool_settings settings_;
+
+        uint64_t first_segment_ = 0; // oldest file on disk
+        spool_position committed_;
+        spool_position read_;
+        spool_position write_; // end of the newest segment
+        uint64_t bytes_ = 0;   // all segments on disk
+
+        int write_fd_ = -1;
+        int read_fd_ = -1;
+        uint64_t read_fd_segment_ = 0;
+
+        bool data_dirty_ = false;
+        bool cursor_dirty_ = false;
+        std::chrono::steady_clock::time_point last_sync_{};
+
+        uint64_t dropped_segments_ = 0;
+        uint64_t corrupt_records_ = 0;
+    };
+
+} // namespace app
@@ -0,0 +1,101 @@
+/**
+ * @file log_index.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Sparse (time, offset) sidecar index of the CSV log
+ * @version 0.1
+ * @date 2026-02-06
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace app
+{
+    // <log>.idx: a 16-byte header, then one entry per EVERY_ROWS rows or
+    // EVERY_SECONDS of log time, whichever comes first. Each entry is the civil
+    // time of a row and the offset of its line; times never decrease (a row
+    // stamped earlier than the last entry gets none). The logger appends an
+    // entry only after the row itself is flushed, so an entry never points past
+    // the end of the log.
+    struct log_index_entry
+    {
+        int64_t t;
+        uint64_t offset;
+    };
+
+    inline constexpr char LOG_INDEX_MAGIC[8] = {'A', 'T', 'L', 'I', 'D', 'X', '1', '\n'};
+    inline constexpr size_t LOG_INDEX_HEADER = 16;
+
+    std::string log_index_path(const std::string &log_path);
+
+    // Read side: the sidecar mapped read-only; a lookup is a bisection over
+    // the entries and touches a handful of pages of either file
+    class log_index
+    {
+    public:
+        log_index() = default;
+        // ok() stays false if the index is missing or does not match log
+        log_index(const std::string &log_path, std::string_view log);
+        ~log_index();
+
+        log_index(const log_index &) = delete;
+        log_index &operator=(const log_index &) = delete;
+
+        bool ok() const { return entries_ != nullptr; }
+        size_t size() const { return count_; }
+        const log_index_entry &operator[](size_t i) const { return entries_[i]; }
+
+        // [lo, hi) of the log, both line starts, that holds the first row at
+        // or after t: every row before lo is earlier, the row at hi is not
+        std::pair<size_t, size_t> window(int64_t t, size_t log_size) const;
+
+    private:
+        void *map_ = nullptr;
+        size_t map_size_ = 0;
+        const log_index_entry *entries_ = nullptr;
+        size_t count_ = 0;
+    };
+
+    // Write side, owned by csv_logger
+    class log_index_writer
+    {
+    public:
+        static constexpr uint64_t EVERY_ROWS = 256;
+        // add() only starts an entry for a row not stamped before the last entry:
+        // after a clock step back (DST fall-back) the repeated hour goes
+        // unindexed and window() brackets it with the entries on either side
+        static constexpr int64_t EVERY_SECONDS = 60;
+
+        log_index_writer() = default;
+        ~log_index_writer();
+
+        log_index_writer(const log_index_writer &) = delete;
+        log_index_writer &operator=(const log_index_writer &) = delete;
+
+        // Checks <log_path>.idx against the log, rebuilds it if it is missing
+        // or stale and indexes rows the last run left unindexed
+        bool open(const std::string &log_path);
+        void close();
+
+        // A row stamped t was flushed to the log at offset
+        void add(int64_t t, uint64_t offset);
+
+        size_t entries() const { return entries_; }
+
+    private:
+        bool append(int64_t t, uint64_t offset);
+
+        int fd_ = -1;
+        size_t entries_ = 0;
+        int64_t last_t_ = 0;
+        uint64_t rows_since_ = 0;
+    };
+
+} // namespace app
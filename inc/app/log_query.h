@@ -0,0 +1,126 @@
+/**
+ * @file log_query.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Grouped aggregates over the CSV log: mmap, time-range bisection, parallel parse
+ * @version 0.1
+ * @date 2026-02-04
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/log_index.h"
+#include "app/sample_bus.h"
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace app
+{
+    // Log timestamps are local wall-clock text; they are compared and bucketed as
+    // "civil seconds" (seconds since 1970-01-01 00:00:00 on that wall clock), so a
+    // row costs no time-zone lookup and hour/day buckets follow the local clock.
+    int64_t civil_seconds(int year, int month, int day, int hour, int minute, int second);
+
+    // "YYYY-MM-DD HH:MM:SS", as csv_logger writes it
+    bool parse_log_timestamp(std::string_view text, int64_t &civil);
+
+    // "YYYY-MM-DD[ HH:MM[:SS]]", or relative to now_civil: "-7d", "-12h", "-30m", "-90s"
+    bool parse_query_time(std::string_view text, int64_t now_civil, int64_t &civil);
+
+    // "15m", "1h", "1d", "3600" (seconds); "0" or "all" = one bucket
+    bool parse_query_duration(std::string_view text, int64_t &seconds);
+
+    std::string format_civil(int64_t civil);
+
+    // Now on the local wall clock
+    int64_t civil_now();
+
+    // Read-only mapping of the whole log
+    class mapped_log
+    {
+    public:
+        mapped_log() = default;
+        explicit mapped_log(const std::string &path);
+        ~mapped_log();
+
+        mapped_log(const mapped_log &) = delete;
+        mapped_log &operator=(const mapped_log &) = delete;
+
+        bool ok() const { return data_ != nullptr || ok_empty_; }
+        std::string_view text() const { return {data_, size_}; }
+
+    private:
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        bool ok_empty_ = false;
+    };
+
+    // Offset of the first row at or after civil time t, found by bisection on
+    // line starts (the log is appended in time order); body is the log text and
+    // [begin, end) the line starts to search, end if no row there is that late.
+    // Civil time is assumed not to decrease: after a step back (DST fall-back, the
+    // clock set by hand) the repeated hour makes the answer one of the rows where
+    // the times cross t, not necessarily the first.
+    size_t find_log_time(std::string_view body, size_t begin, int64_t t, size_t end = std::string_view::npos);
+
+    struct query_spec
+    {
+        channel ch = channel::co2_ppm;
+        int64_t from = std::numeric_limits<int64_t>::min(); // civil, inclusive
+        int64_t to = std::numeric_limits<int64_t>::max();   // civil, exclusive
+        int64_t bucket_s = 3600;                             // 0 = the whole range in one bucket
+        unsigned threads = 0;                                // 0 = one per core and MiB
+        std::vector<double> percentiles{50, 95, 99};
+    };
+
+    struct query_bucket
+    {
+        int64_t start = 0; // civil; the first value's time for a single bucket
+        uint64_t count = 0;
+        double min = 0;
+        double max = 0;
+        double mean = 0;
+        std::vector<double> percentiles; // as in query_spec
+    };
+
+    struct query_result
+    {
+        bool ok = false;
+        std::string error;
+        std::vector<query_bucket> buckets;
+        uint64_t rows = 0;  // rows in range, with or without the channel
+        size_t bytes = 0;   // of the log scanned after the range lookup
+        unsigned threads = 0;
+        bool indexed = false; // the range came from the .idx sidecar
+    };
+
+    // log is the whole CSV text, header line included; with its index the range
+    // lookup reads a few pages instead of bisecting the whole log. The range
+    // bounds come from find_log_time(), so they share its caveat about clock steps.
+    query_result run_log_query(std::string_view log, const query_spec &spec, const log_index *index = nullptr);
+
+    // One CSV line per bucket: bucket,count,min,max,mean,p<N>...
+    void print_query_result(const query_result &result, const query_spec &spec, std::ostream &out);
+
+    // --query as typed on the command line
+    struct query_command
+    {
+        std::string log_path;
+        std::string channel;
+        std::string from;                   // empty = the start of the log
+        std::string to;                     // empty = the end of the log
+        std::string bucket = "1h";
+        std::string percentiles = "50,95,99"; // comma-separated, empty = none
+        unsigned threads = 0;
+    };
+
+    // Buckets to out, timing to err; 0, -EINVAL (bad arguments) or -EIO
+    int run_query_command(const query_command &cmd, std::ostream &out, std::ostream &err);
+
+} // namespace app
@@ -0,0 +1,98 @@
+/**
+ * @file metrics_server.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Prometheus text exposition over a minimal HTTP/1.1 listener
+ * @version 0.1
+ * @date 2026-01-30
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/peripheral_health.h"
+#include "app/sample_bus.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace app
+{
+    // Latest readings, per-device error counters and read times, subscriber queue
+    // depths; appended to out in the Prometheus text format. health may be null.
+    void render_metrics(const sample_bus &bus, const health_monitor *health, std::string &out);
+
+    // "host:port" ("127.0.0.1:9105", ":9105" for all interfaces); false if malformed
+    bool parse_listen_address(const std::string &listen, std::string &host, uint16_t &port);
+
+    // GET /metrics served from one pre-rendered response. A render thread on its
+    // own bus subscription rebuilds it when a frame arrives; the epoll thread
+    // only swaps in the new buffer and writes it out, so a scrape never touches
+    // a device, the bus or the health records.
+    class metrics_server
+    {
+    public:
+        static constexpr size_t MAX_CONNECTIONS = 256;
+        static constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+        // Port 0 picks a free one (see port()); errors are reported and leave it not listening
+        metrics_server(const std::string &host, uint16_t port, sample_bus &bus, const health_monitor *health);
+        ~metrics_server();
+
+        metrics_server(const metrics_server &) = delete;
+        metrics_server &operator=(const metrics_server &) = delete;
+
+        bool listening() const { return listen_fd_ >= 0; }
+        uint16_t port() const { return port_; }
+
+        // Responses rendered so far (the first one at start-up)
+        uint64_t renders() const { return renders_.load(std::memory_order_acquire); }
+
+    private:
+        struct connection
+        {
+            std::string in;
+            std::shared_ptr<const std::string> out; // response being written
+            size_t out_pos = 0;
+            size_t out_end = 0;
+            bool close_after = false;
+            bool writing = false; // EPOLLOUT is registered
+        };
+
+        void render();
+        void render_loop(std::stop_token stop);
+        void serve_loop(std::stop_token stop);
+
+        void accept_all();
+        // false once the connection is closed
+        bool on_readable(int fd, connection &conn);
+        // Writes pending output, then answers buffered requests one at a time
+        bool handle_requests(int fd, connection &conn);
+        void close_connection(int fd);
+
+        sample_bus &bus_;
+        const health_monitor *health_;
+        sample_bus::subscription *feed_ = nullptr;
+
+        int listen_fd_ = -1;
+        int epoll_fd_ = -1;
+        int wake_fd_ = -1;
+        uint16_t port_ = 0;
+
+        // Swapped with std::atomic_store by the render thread only
+        std::shared_ptr<const std::string> response_;
+        std::atomic<uint64_t> renders_{0};
+
+        // epoll thread only
+        std::unordered_map<int, connection> connections_;
+
+        std::jthread render_worker_;
+        std::jthread serve_worker_;
+    };
+
+} // namespace app
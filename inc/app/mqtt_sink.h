@@ -0,0 +1,201 @@
+/**
+ * @file mqtt_sink.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  MQTT 3.1.1 publisher fed by the sample bus
+ * @version 0.1
+ * @date 2026-02-02
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/disk_spool.h"
+#include "app/sample_bus.h"
+#include "app/spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace app
+{
+    // Control packet types (high nibble of the fixed header)
+    enum class mqtt_packet : uint8_t
+    {
+        connect = 1,
+        connack = 2,
+        publish = 3,
+        puback = 4,
+        pingreq = 12,
+        pingresp = 13,
+        disconnect = 14,
+    };
+
+    void mqtt_append_length(std::string &out, size_t length);
+    std::string mqtt_connect(std::string_view client_id, uint16_t keepalive_s, std::string_view username,
+                             std::string_view password);
+    std::string mqtt_publish(std::string_view topic, std::string_view payload, int qos, uint16_t packet_id, bool dup);
+    std::string mqtt_puback(uint16_t packet_id);
+
+    enum class mqtt_parse
+    {
+        complete,
+        incomplete,
+        malformed,
+    };
+
+    // Takes one whole packet off the front of in: first header byte and the body
+    // after the remaining length
+    mqtt_parse mqtt_take_packet(std::string &in, uint8_t &header, std::string &body);
+
+    // Samples as JSON: one object {"t": <unix s>, "<channel>": value, ...}, or an array of them
+    std::string mqtt_payload(const std::vector<sample_frame> &frames);
+
+    struct mqtt_settings
+    {
+        std::string host = "127.0.0.1";
+        uint16_t port = 1883;
+        std::string client_id = "atmolyt";
+        std::string topic = "atmolyt/samples";
+        std::string username;
+        std::string password;
+        int qos = 1;               // 0 or 1
+        size_t batch = 1;          // samples per payload
+        size_t max_inflight = 16;  // QoS 1 publishes awaiting PUBACK
+        size_t max_queued = 1024;  // payloads held in memory; past it the oldest is dropped (or spooled)
+        std::chrono::seconds keepalive{30};
+        std::chrono::milliseconds reconnect_min{1000};
+        std::chrono::milliseconds reconnect_max{60000};
+
+        // Store-and-forward: with a directory, payloads that cannot go out now are
+        // appended there instead of waiting in memory, and drained once the broker
+        // is back at up to drain_rate messages/s (0 = no limit)
+        std::string spool_dir;
+        uint64_t spool_max_bytes = 256u << 20;
+        double drain_rate = 20;
+    };
+
+    // All network I/O is on an own epoll thread; frames reach it from an own bus
+    // subscription, so the poll loop never waits on the broker. QoS 1 publishes
+    // are pipelined up to max_inflight and resent (DUP) after a reconnect until
+    // acknowledged; the connection is retried with doubling backoff. With a spool,
+    // live payloads go out first and the backlog takes at most half the window,
+    // so draining hours of backlog does not delay the current samples.
+    class mqtt_sink
+    {
+    public:
+        mqtt_sink(const mqtt_settings &settings, sample_bus &bus);
+        ~mqtt_sink();
+
+        mqtt_sink(const mqtt_sink &) = delete;
+        mqtt_sink &operator=(const mqtt_sink &) = delete;
+
+        bool running() const { return io_worker_.joinable(); }
+        bool connected() const { return connected_.load(std::memory_order_acquire); }
+
+        uint64_t connects() const { return connects_.load(std::memory_order_relaxed); }
+        uint64_t published() const { return published_.load(std::memory_order_relaxed); } // written to the socket
+        uint64_t acked() const { return acked_.load(std::memory_order_relaxed); }         // QoS 1 confirmed
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }     // payloads lost to max_queued
+        uint64_t spooled() const { return spooled_.load(std::memory_order_relaxed); }     // payloads written to the spool
+        uint64_t backlog_bytes() const { return backlog_bytes_.load(std::memory_order_relaxed); }
+        size_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+
+    private:
+        enum class link
+        {
+            down,
+            connecting, // TCP handshake
+            handshake,  // CONNECT sent, waiting for CONNACK
+            up,
+        };
+
+        struct message
+        {
+            std::string payload;
+            uint16_t packet_id = 0;
+            bool dup = false;
+            uint64_t spool_seq = 0; // read from the spool, 0 = live
+        };
+
+        struct spool_read
+        {
+            uint64_t seq;
+            spool_position next;
+            bool acked;
+        };
+
+        using clock = std::chrono::steady_clock;
+
+        void feed_loop(std::stop_token stop);
+        void io_loop(std::stop_token stop);
+
+        void add_frame(const sample_frame &frame);
+        void enqueue(std::string payload);
+        void spill(std::string_view payload);
+        void drain(clock::time_point now);
+        void spool_acked(uint64_t seq);
+
+        void start_connect(clock::time_point now);
+        void on_socket(uint32_t events, clock::time_point now);
+        void on_timeout(clock::time_point now);
+        void handle_packet(uint8_t header, const std::string &body, clock::time_point now);
+        void pump(clock::time_point now);
+        bool flush();
+        void send_packet(const std::string &packet, clock::time_point now);
+        void drop_link(const char *why, clock::time_point now);
+        void watch_socket(bool want_write);
+        uint16_t next_packet_id();
+
+        mqtt_settings settings_;
+        sample_bus::subscription *feed_ = nullptr;
+
+        int epoll_fd_ = -1;
+        int wake_fd_ = -1;
+        int frame_fd_ = -1;
+        spsc_queue<sample_frame, 64> pending_;
+
+        // io thread only
+        int sock_ = -1;
+        link state_ = link::down;
+        bool want_write_ = false;
+        std::string out_;
+        size_t out_pos_ = 0;
+        std::string in_;
+        std::vector<sample_frame> batch_;
+        std::deque<message> queue_;    // not yet written on this connection
+        std::deque<message> inflight_; // written, waiting for PUBACK (QoS 1)
+        uint16_t last_packet_id_ = 0;
+        std::chrono::milliseconds backoff_{0};
+        clock::time_point deadline_{};  // reconnect, connect timeout, or keepalive
+        clock::time_point last_sent_{};
+        bool ping_outstanding_ = false;
+
+        std::optional<disk_spool> spool_;
+        std::deque<spool_read> spool_reads_; // in read order, until a contiguous prefix is acked
+        uint64_t spool_seq_ = 0;
+        double drain_tokens_ = 0;
+        clock::time_point drain_refill_{};
+        clock::time_point drain_at_ = clock::time_point::max(); // next token, while the backlog waits for one
+
+        std::atomic<bool> connected_{false};
+        std::atomic<uint64_t> connects_{0};
+        std::atomic<uint64_t> published_{0};
+        std::atomic<uint64_t> acked_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<size_t> in_flight_{0};
+        std::atomic<uint64_t> spooled_{0};
+        std::atomic<uint64_t> backlog_bytes_{0};
+
+        std::jthread io_worker_;
+        std::jthread feed_worker_;
+    };
+
+} // namespace app
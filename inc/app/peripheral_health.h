@@ -0,0 +1,151 @@
+/**
+ * @file peripheral_health.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Per-peripheral health state with backoff re-probing
+ * @version 0.1
+ * @date 2026-01-26
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "peripheral/peripheral_iface.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace app
+{
+    enum class health_state : uint8_t
+    {
+        healthy,
+        degraded, // recent failures, still polled
+        failed,   // out of the poll loop, owned by the re-probe thread
+    };
+
+    const char *health_state_name(health_state state);
+
+    struct health_policy
+    {
+        uint32_t fail_after = 3; // consecutive failures before the device leaves the poll
+        std::chrono::milliseconds initial_backoff{2000};
+        std::chrono::milliseconds max_backoff{300000};
+    };
+
+    // The state doubles as an ownership hand-off: the poll loop only touches a
+    // device that is not failed, the monitor only one that is. reprobe() brings
+    // the device back (typically deinitialize() + initialize()).
+    class peripheral_health
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        peripheral_health(const void *device, std::string name, std::function<bool()> reprobe,
+                          const health_policy &policy = {});
+
+        health_state state() const { return state_.load(std::memory_order_acquire); }
+        bool usable() const { return state() != health_state::failed; }
+
+        // Outcome of a regular read; only bus-level errors count (not "no data yet")
+        health_state report(peripherals::Status status, clock::time_point now = clock::now());
+
+        // E.g. initialization failed at start-up
+        void mark_failed(clock::time_point now = clock::now());
+
+        // Monitor side: re-probe a failed device once its backoff has expired
+        bool probe_if_due(clock::time_point now = clock::now());
+
+        static bool is_failure(peripherals::Status status);
+
+        // Poll side: how long one read took, whatever its outcome
+        void record_read(std::chrono::microseconds took);
+
+        const void *device() const { return device_; }
+        const std::string &name() const { return name_; }
+        uint32_t consecutive_failures() const { return failures_.load(std::memory_order_relaxed); }
+        uint32_t recoveries() const { return recoveries_.load(std::memory_order_relaxed); }
+        std::chrono::milliseconds backoff() const { return backoff_; }
+        clock::time_point next_probe() const { return next_probe_; }
+
+        // Running totals for exporters; each is read on its own, not as a set
+        uint64_t errors() const { return errors_.load(std::memory_order_relaxed); }
+        uint64_t reads() const { return reads_.load(std::memory_order_relaxed); }
+        std::chrono::microseconds read_time() const { return std::chrono::microseconds(read_us_.load(std::memory_order_relaxed)); }
+        std::chrono::microseconds last_read_time() const { return std::chrono::microseconds(last_read_us_.load(std::memory_order_relaxed)); }
+
+    private:
+        void enter_failed(clock::time_point now);
+
+        const void *device_;
+        std::string name_;
+        std::function<bool()> reprobe_;
+        health_policy policy_;
+
+        std::atomic<health_state> state_{health_state::healthy};
+        std::atomic<uint32_t> failures_{0};
+        std::atomic<uint32_t> recoveries_{0};
+        std::atomic<uint64_t> errors_{0};
+        std::atomic<uint64_t> reads_{0};
+        std::atomic<uint64_t> read_us_{0};
+        std::atomic<uint64_t> last_read_us_{0};
+
+        // Written by whichever side currently owns the device (see state_)
+        std::chrono::milliseconds backoff_{0};
+        clock::time_point next_probe_{};
+    };
+
+    // Owns the health records and the background re-probe thread. Records can
+    // be added and removed while it runs (config reload); a record's address
+    // stays valid until it is removed.
+    class health_monitor
+    {
+    public:
+        explicit health_monitor(std::chrono::milliseconds tick = std::chrono::milliseconds(500));
+        ~health_monitor();
+
+        health_monitor(const health_monitor &) = delete;
+        health_monitor &operator=(const health_monitor &) = delete;
+
+        peripheral_health &add(const void *device, std::string name, std::function<bool()> reprobe,
+                               const health_policy &policy = {});
+
+        // Drops the record; waits for a re-probe of it that is in progress, so
+        // the device can be destroyed right after
+        bool remove(const void *device);
+
+        void start();
+        void stop();
+
+        peripheral_health *find(const void *device);
+        size_t size() const;
+
+        // Visits every record under the lock; f must not call back into the monitor
+        template <typename F>
+        void for_each(F &&f) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto &entry : entries_)
+                f(entry);
+        }
+
+    private:
+        void loop(std::stop_token stop);
+
+        std::chrono::milliseconds tick_;
+
+        mutable std::mutex mutex_; // entries_ and probing_; not held during a re-probe
+        std::list<peripheral_health> entries_;
+        const peripheral_health *probing_ = nullptr;
+        std::condition_variable_any cv_;       // wakes the worker on stop
+        std::condition_variable_any probed_;   // wakes remove() when a re-probe ends
+        std::jthread worker_;
+    };
+
+} // namespace app
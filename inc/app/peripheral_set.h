@@ -0,0 +1,92 @@
+/**
+ * @file peripheral_set.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Running peripherals as swappable snapshots, diffed on config reload
+ * @version 0.1
+ * @date 2026-01-29
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "config/config_loader.h"
+#include "connections/connection_iface.h"
+#include "connections/gpio_line.h"
+#include "peripheral/peripheral_iface.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace app
+{
+    // One configured device with everything it owns. Exactly one of the device
+    // pointers is set. Tear-down is the destructor: device first, then its bus.
+    struct peripheral_slot
+    {
+        config::PeripheralSpec spec;
+        std::unique_ptr<connections::connection_iface<uint8_t>> connection;
+        std::unique_ptr<connections::gpio_line> dc_line;
+
+        std::unique_ptr<peripherals::environmental_sensor_iface> environmental;
+        std::unique_ptr<peripherals::gas_sensor_iface> gas;
+        std::unique_ptr<peripherals::display_iface> display;
+        std::unique_ptr<peripherals::rtc_iface> rtc;
+
+        peripheral_slot() = default;
+        ~peripheral_slot();
+        peripheral_slot(const peripheral_slot &) = delete;
+        peripheral_slot &operator=(const peripheral_slot &) = delete;
+
+        // The device as the health monitor keys it
+        const void *device() const;
+    };
+
+    // Same (connection, device, address, type) and the same options: the running
+    // slot can stand for the new entry as is
+    bool same_peripheral(const config::PeripheralSpec &a, const config::PeripheralSpec &b);
+
+    // Same bus and address: at most one of the two can be up at a time
+    bool same_address(const config::PeripheralSpec &a, const config::PeripheralSpec &b);
+
+    // Immutable snapshot the poll loop works on for a whole tick. Slots that
+    // survive a reload are shared between the old and the new snapshot.
+    struct peripheral_set
+    {
+        uint64_t generation = 0;
+        config::AppConfig config; // the config it was built from
+
+        std::vector<std::shared_ptr<peripheral_slot>> slots;
+
+        // Typed views into slots, in config order
+        std::vector<peripherals::environmental_sensor_iface *> environmental_sensors;
+        std::vector<peripherals::gas_sensor_iface *> gas_sensors;
+        std::vector<peripherals::display_iface *> displays;
+        std::vector<peripherals::rtc_iface *> rtcs;
+
+        void index();
+    };
+
+    // Brings up one config entry; nullptr if it cannot be created at all
+    using slot_factory = std::function<std::shared_ptr<peripheral_slot>(const config::PeripheralSpec &)>;
+
+    struct peripheral_diff
+    {
+        std::shared_ptr<peripheral_set> next;
+        std::vector<std::shared_ptr<peripheral_slot>> added;   // created by make
+        std::vector<std::shared_ptr<peripheral_slot>> removed; // still alive, owned here
+    };
+
+    // Next snapshot for cfg: each entry reuses an unused running slot that is the
+    // same peripheral, otherwise it is created with make. current may be null.
+    peripheral_diff diff_peripherals(const peripheral_set *current, const config::AppConfig &cfg,
+                                     const slot_factory &make);
+
+    // First step of a reload that replaces a device in place: current without the
+    // running slots cfg drops whose bus address a new entry takes (removed). They
+    // must be torn down before diff_peripherals() brings up their replacements.
+    peripheral_diff evict_replaced(const peripheral_set &current, const config::AppConfig &cfg);
+
+} // namespace app
@@ -0,0 +1,58 @@
+/**
+ * @file raw_capture.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Binary capture of raw BME280 ADC words for offline compensation
+ * @version 0.1
+ * @date 2026-01-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "peripheral/bme280.h"
+#include "peripheral/bme280_compensation.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace app
+{
+    // File layout (little-endian):
+    //   header: "ATRAWBME" | u32 flags (bit0 = humidity) | calibration, 33 bytes in field order
+    //   record: i64 unix time ms | i32 raw_t | i32 raw_p | i32 raw_h   (20 bytes)
+    // The calibration is stored once, so a record is 20 bytes instead of a CSV line.
+    class raw_capture_writer
+    {
+    public:
+        // Appends to an existing capture of the same sensor; a capture with other
+        // trimming data is moved aside to <path>.old first
+        raw_capture_writer(const std::string &path, const peripherals::bme280_calibration &calib,
+                           bool has_humidity);
+
+        bool is_open() const { return file_.is_open(); }
+        bool append(int64_t timestamp_ms, const peripherals::bme280_raw_sample &sample);
+
+    private:
+        std::ofstream file_;
+    };
+
+    // Whole capture transposed into columns, ready for bme280_compensate_batch()
+    struct raw_capture
+    {
+        peripherals::bme280_calibration calib;
+        bool has_humidity = true;
+        std::vector<int64_t> timestamp_ms;
+        std::vector<int32_t> raw_t;
+        std::vector<int32_t> raw_p;
+        std::vector<int32_t> raw_h;
+
+        size_t size() const { return timestamp_ms.size(); }
+    };
+
+    // A truncated trailing record is ignored
+    bool load_raw_capture(const std::string &path, raw_capture &out);
+
+} // namespace app
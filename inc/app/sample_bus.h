@@ -0,0 +1,138 @@
+/**
+ * @file sample_bus.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  In-process publish/subscribe bus for measurement frames
+ * @version 0.1
+ * @date 2026-01-23
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/seqlock.h"
+#include "app/spsc_queue.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+
+namespace app
+{
+    enum class channel : uint8_t
+    {
+        co2_ppm = 0,
+        temperature_c,
+        humidity_rh,
+        pressure_pa,
+        voc_index,
+        nox_index,
+    };
+
+    inline constexpr size_t CHANNEL_COUNT = 6;
+
+    const char *channel_name(channel ch);
+
+    // One acquisition cycle. A channel is present only if its bit is set in valid;
+    // absent channels carry no value (no -1/-999 sentinels).
+    struct sample_frame
+    {
+        int64_t wall_ns = 0;
+        uint32_t valid = 0;
+        std::array<double, CHANNEL_COUNT> values{};
+
+        void set(channel ch, double value)
+        {
+            values[static_cast<size_t>(ch)] = value;
+            valid |= 1u << static_cast<unsigned>(ch);
+        }
+
+        bool has(channel ch) const { return valid & (1u << static_cast<unsigned>(ch)); }
+        double get(channel ch) const { return values[static_cast<size_t>(ch)]; }
+        bool empty() const { return valid == 0; }
+
+        // Takes the channels this frame does not have yet
+        void merge_missing(const sample_frame &other)
+        {
+            for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+                if (!has(channel(i)) && other.has(channel(i)))
+                    set(channel(i), other.values[i]);
+        }
+    };
+
+    // Latest value per channel in a seqlock (readers never block the producer) and
+    // a private SPSC queue per subscriber, so the display, the logger and exporters
+    // each consume at their own rate. publish() is called from one thread only.
+    class sample_bus
+    {
+    public:
+        static constexpr size_t QUEUE_CAPACITY = 256;
+        static constexpr size_t MAX_SUBSCRIBERS = 8;
+
+        struct latest_value
+        {
+            double value = 0.0;
+            int64_t wall_ns = 0;
+            bool valid = false;
+        };
+
+        class subscription
+        {
+        public:
+            explicit subscription(std::string name) : name_(std::move(name)) {}
+
+            bool try_pop(sample_frame &frame) { return queue_.try_pop(frame); }
+
+            // Blocks until a frame arrives, stop is requested or the timeout expires
+            bool wait_pop(sample_frame &frame, std::stop_token stop, std::chrono::milliseconds timeout);
+
+            // Frames lost because this subscriber fell QUEUE_CAPACITY frames behind
+            uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+            // Frames waiting for this subscriber
+            size_t depth() const { return queue_.size(); }
+            const std::string &name() const { return name_; }
+
+        private:
+            friend class sample_bus;
+            void deliver(const sample_frame &frame);
+
+            std::string name_;
+            spsc_queue<sample_frame, QUEUE_CAPACITY> queue_;
+            std::atomic<uint64_t> dropped_{0};
+            std::mutex mutex_;
+            std::condition_variable_any cv_;
+        };
+
+        void publish(const sample_frame &frame);
+
+        latest_value latest(channel ch) const { return latest_[static_cast<size_t>(ch)].load(); }
+        // Changes whenever a frame carrying the channel is published
+        uint32_t version(channel ch) const { return latest_[static_cast<size_t>(ch)].version(); }
+
+        // The bus owns subscriptions and must outlive their consumers; nullptr when full
+        subscription *subscribe(std::string name);
+
+        // Visits the current subscriptions without locking (they are never removed)
+        template <typename F>
+        void for_each_subscriber(F &&f) const
+        {
+            const size_t count = subscriber_count_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i)
+                f(static_cast<const subscription &>(*subscribers_[i]));
+        }
+
+    private:
+        std::array<seqlock<latest_value>, CHANNEL_COUNT> latest_;
+
+        std::mutex subscribe_mutex_;
+        std::array<std::unique_ptr<subscription>, MAX_SUBSCRIBERS> subscribers_;
+        std::atomic<size_t> subscriber_count_{0};
+    };
+
+} // namespace app
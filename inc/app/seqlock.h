@@ -0,0 +1,77 @@
+/**
+ * @file seqlock.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Single-writer sequence lock for small trivially copyable values
+ * @version 0.1
+ * @date 2026-01-22
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace app
+{
+    // Readers never block and never write shared memory; they retry while a store
+    // is in progress. One writer at a time. The payload is kept in relaxed atomic
+    // words so concurrent reads are well defined; T goes in and out of them as a
+    // byte array (bit_cast), so a T with member initializers is fine too.
+    template <typename T>
+    class seqlock
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "seqlock payload must be trivially copyable");
+        static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    public:
+        seqlock() { store(T{}); }
+        explicit seqlock(const T &value) { store(value); }
+
+        void store(const T &value)
+        {
+            const auto bytes = std::bit_cast<std::array<unsigned char, sizeof(T)>>(value);
+            std::array<uint64_t, WORDS> words{};
+            std::memcpy(words.data(), bytes.data(), sizeof(T));
+
+            const uint32_t seq = seq_.load(std::memory_order_relaxed);
+            seq_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORDS; ++i)
+                data_[i].store(words[i], std::memory_order_relaxed);
+            seq_.store(seq + 2, std::memory_order_release);
+        }
+
+        T load() const
+        {
+            std::array<uint64_t, WORDS> words;
+            uint32_t before, after;
+            do
+            {
+                before = seq_.load(std::memory_order_acquire);
+                for (size_t i = 0; i < WORDS; ++i)
+                    words[i] = data_[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = seq_.load(std::memory_order_relaxed);
+            } while ((before & 1) || before != after);
+
+            std::array<unsigned char, sizeof(T)> bytes;
+            std::memcpy(bytes.data(), words.data(), sizeof(T));
+            return std::bit_cast<T>(bytes);
+        }
+
+        // Number of completed stores, usable as a change counter
+        uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+    private:
+        std::atomic<uint32_t> seq_{0};
+        std::array<std::atomic<uint64_t>, WORDS> data_{};
+    };
+
+} // namespace app
@@ -0,0 +1,54 @@
+/**
+ * @file shm_publisher.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Latest sample per channel in POSIX shared memory for local readers
+ * @version 0.1
+ * @date 2026-01-31
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/sample_bus.h"
+#include "atmolyt_shm.h"
+#include <string>
+#include <thread>
+
+namespace app
+{
+    static_assert(CHANNEL_COUNT <= ATMOLYT_SHM_MAX_CHANNELS, "shared-memory layout has no record for every channel");
+    static_assert(sizeof(atmolyt_shm_record) == 64, "shared-memory record layout changed");
+
+    // Writes every frame into a segment laid out as in atmolyt_shm.h. The segment
+    // outlives the process: readers keep their mapping and the last values (with
+    // their timestamps) across restarts, and a restart continues the sequence.
+    class shm_publisher
+    {
+    public:
+        explicit shm_publisher(const std::string &name = ATMOLYT_SHM_DEFAULT_NAME);
+        ~shm_publisher();
+
+        shm_publisher(const shm_publisher &) = delete;
+        shm_publisher &operator=(const shm_publisher &) = delete;
+
+        bool is_open() const { return segment_ != nullptr; }
+        const std::string &name() const { return name_; }
+
+        // Single writer: the bus thread (attach) or the caller, not both
+        void publish(const sample_frame &frame);
+
+        // Publish every frame from the bus on an own thread
+        bool attach(sample_bus &bus);
+
+    private:
+        void publish_loop(std::stop_token stop);
+
+        std::string name_;
+        atmolyt_shm_segment *segment_ = nullptr;
+        sample_bus::subscription *feed_ = nullptr;
+        std::jthread worker_;
+    };
+
+} // namespace app
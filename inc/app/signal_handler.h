@@ -13,6 +13,8 @@
 
 #include <atomic>
 #include <functional>
+#include <mutex>
+#include <stop_token>
 
 namespace app {
 
@@ -24,12 +26,25 @@ public:
     static void set_user_callback(std::function<void(int)> cb);
     static void poll_and_handle();
 
+    // Requested once a termination signal arrives; lets sleeps and reads end at once
+    static std::stop_token stop_token();
+
+    // SIGHUP does not stop the process: cb runs on the watcher thread for each
+    // one and should only hand the work off (it delays shutdown handling)
+    static void set_reload_callback(std::function<void()> cb);
+
 private:
     static void handle_signal(int signo) noexcept;
+    static void watch_pipe();
 
     static inline std::atomic<bool> requested_{false};
     static inline std::atomic<int> last_signal_{0};
     static inline std::function<void(int)> user_cb_{};
+    static inline std::atomic<bool> reload_requested_{false};
+    static inline std::mutex reload_mutex_{};
+    static inline std::function<void()> reload_cb_{};
+    static inline std::stop_source stop_source_{};
+    static inline int pipe_[2] = {-1, -1};
 };
 
 } // namespace app
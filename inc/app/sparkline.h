@@ -0,0 +1,68 @@
+/**
+ * @file sparkline.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Scrolling min/max trend graph for display_iface
+ * @version 0.1
+ * @date 2026-01-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "peripheral/peripheral_iface.h"
+#include <array>
+
+namespace app
+{
+    // One column's value range
+    struct minmax_pair
+    {
+        float min;
+        float max;
+    };
+
+    // Each column is a vertical min..max bar. append() scrolls the plot by one
+    // column and only touches pixels whose state changes, then flushes.
+    class sparkline
+    {
+    public:
+        static constexpr int MAX_WIDTH = 128;
+
+        sparkline(peripherals::display_iface *display, int x, int y, int width, int height,
+                  float range_lo, float range_hi);
+
+        peripherals::Status append(const minmax_pair &bucket);
+
+        // Repaint the whole plot area, e.g. after the display was cleared
+        peripherals::Status redraw();
+
+        int width() const { return width_; }
+
+    private:
+        struct column
+        {
+            int top;    // screen row of max
+            int bottom; // screen row of min; top > bottom -> empty column
+        };
+
+        column to_column(const minmax_pair &bucket) const;
+        int to_row(float value) const;
+        void update_column(int sx, const column &before, const column &after);
+        void draw_span(int sx, int r0, int r1, int color);
+
+        peripherals::display_iface *display_;
+        int x_;
+        int y_;
+        int width_;
+        int height_;
+        float lo_;
+        float hi_;
+
+        // Ring of plotted columns; cols_[(start_ + i) % width_] is at screen column i
+        std::array<column, MAX_WIDTH> cols_;
+        int start_ = 0;
+    };
+
+} // namespace app
@@ -0,0 +1,73 @@
+/**
+ * @file spsc_queue.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Bounded lock-free single-producer/single-consumer ring
+ * @version 0.1
+ * @date 2026-01-23
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace app
+{
+    // Storage is preallocated. The producer owns head_, the consumer owns tail_;
+    // each only reads the other's index, so neither side ever waits. A full queue
+    // rejects the push instead of blocking the producer.
+    template <typename T, size_t Capacity>
+    class spsc_queue
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        bool try_push(const T &value)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_.load(std::memory_order_acquire) == Capacity)
+                return false;
+            slots_[head & (Capacity - 1)] = value;
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T &value)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == head_.load(std::memory_order_acquire))
+                return false;
+            value = slots_[tail & (Capacity - 1)];
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const
+        {
+            return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+        }
+
+        // Safe from a third thread (e.g. metrics): tail_ is read first, so head_ read
+        // after it is never behind it; both may move in between, hence the clamp
+        size_t size() const
+        {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            const size_t head = head_.load(std::memory_order_acquire);
+            return std::min(head - tail, Capacity);
+        }
+
+        static constexpr size_t capacity() { return Capacity; }
+
+    private:
+        // Separate cache lines: producer and consumer don't invalidate each other's index
+        alignas(64) std::atomic<size_t> head_{0};
+        alignas(64) std::atomic<size_t> tail_{0};
+        std::array<T, Capacity> slots_{};
+    };
+
+} // namespace app
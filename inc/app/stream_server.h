@@ -0,0 +1,136 @@
+/**
+ * @file stream_server.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Live sample stream to local clients over a Unix-domain socket
+ * @version 0.1
+ * @date 2026-02-01
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/sample_bus.h"
+#include "app/spsc_queue.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace app
+{
+    // Wire format, native little-endian: header, then one float per channel bit
+    // set in mask, lowest channel first. seq counts the frames queued for this
+    // client, so a gap means frames were dropped for it.
+    struct stream_frame_header
+    {
+        static constexpr uint16_t MAGIC = 0x5341; // "AS"
+        static constexpr uint8_t VERSION = 1;
+
+        uint16_t magic;
+        uint8_t version;
+        uint8_t count; // floats that follow
+        uint32_t mask; // 1 << channel
+        uint64_t seq;
+        int64_t wall_ns;
+    };
+    static_assert(sizeof(stream_frame_header) == 24, "stream header layout changed");
+
+    inline constexpr size_t STREAM_FRAME_MAX = sizeof(stream_frame_header) + CHANNEL_COUNT * sizeof(float);
+
+    // Channels of frame that are in mask; returns the encoded size (header only if none)
+    size_t encode_stream_frame(const sample_frame &frame, uint32_t mask, uint64_t seq, uint8_t *out);
+
+    // Inverse of encode_stream_frame; 0 if data does not start with a whole frame
+    size_t decode_stream_frame(const uint8_t *data, size_t size, sample_frame &frame, uint64_t &seq);
+
+    // Client request, one text line, any time: "SUB <channels|*> [<every>]\n",
+    // e.g. "SUB co2_ppm,temperature_c 12" - only those channels, every 12th frame
+    // that has one of them. Until then a client gets every frame in full.
+    struct stream_filter
+    {
+        uint32_t mask = (1u << CHANNEL_COUNT) - 1;
+        uint32_t every = 1;
+    };
+    bool parse_stream_request(std::string_view line, stream_filter &filter);
+
+    // Frames come off an own bus subscription into the epoll thread, which fans
+    // them out. Each client has a fixed ring of encoded frames; a client that does
+    // not drain it loses its oldest frames, never holding up anybody else.
+    class stream_server
+    {
+    public:
+        static constexpr size_t CLIENT_QUEUE = 64; // frames
+        static constexpr size_t MAX_CLIENTS = 64;
+
+        stream_server(const std::string &path, sample_bus &bus);
+        ~stream_server();
+
+        stream_server(const stream_server &) = delete;
+        stream_server &operator=(const stream_server &) = delete;
+
+        bool listening() const { return listen_fd_ >= 0; }
+        const std::string &path() const { return path_; }
+
+        size_t clients() const { return client_count_.load(std::memory_order_relaxed); }
+        // Frames dropped for slow clients, all clients together
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        struct encoded_frame
+        {
+            std::array<uint8_t, STREAM_FRAME_MAX> bytes;
+            uint8_t size;
+        };
+
+        struct client
+        {
+            stream_filter filter;
+            uint64_t matched = 0; // frames that passed the channel filter
+            uint64_t seq = 0;
+            std::array<encoded_frame, CLIENT_QUEUE> ring;
+            size_t head = 0; // next frame to send
+            size_t size = 0;
+            size_t offset = 0; // bytes of ring[head] already sent
+            bool writing = false;     // EPOLLOUT is registered
+            bool read_closed = false; // no more requests, frames still go out
+            std::string in;
+        };
+
+        void feed_loop(std::stop_token stop);
+        void serve_loop(std::stop_token stop);
+
+        void accept_all();
+        void fan_out(const sample_frame &frame);
+        void enqueue(client &c, const sample_frame &frame);
+        // false: the caller closes the client
+        bool on_readable(int fd, client &c);
+        bool flush(int fd, client &c);
+        void update_events(int fd, const client &c);
+        void close_client(int fd);
+
+        std::string path_;
+        sample_bus::subscription *feed_ = nullptr;
+
+        int listen_fd_ = -1;
+        int epoll_fd_ = -1;
+        int wake_fd_ = -1;  // stop
+        int frame_fd_ = -1; // frames waiting in pending_
+
+        // Feed thread -> epoll thread
+        spsc_queue<sample_frame, 64> pending_;
+
+        // epoll thread only
+        std::unordered_map<int, client> clients_;
+        std::atomic<size_t> client_count_{0};
+        std::atomic<uint64_t> dropped_{0};
+
+        std::jthread serve_worker_;
+        std::jthread feed_worker_;
+    };
+
+} // namespace app
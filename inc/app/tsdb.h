@@ -0,0 +1,149 @@
+/**
+ * @file tsdb.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  In-memory time-series store with 1 min / 1 h rollups
+ * @version 0.1
+ * @date 2026-01-25
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/sample_bus.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace app
+{
+    struct tsdb_settings
+    {
+        size_t raw_capacity = 720;     // raw samples per channel (1 h at 5 s)
+        size_t minute_capacity = 1440; // 24 h of 1 min rollups
+        size_t hour_capacity = 720;    // 30 days of 1 h rollups
+    };
+
+    struct tsdb_point
+    {
+        int64_t wall_ns;
+        float value;
+    };
+
+    struct tsdb_rollup
+    {
+        int64_t start_ns = 0;
+        float min = 0.0f;
+        float max = 0.0f;
+        double sum = 0.0;
+        uint32_t count = 0;
+
+        double mean() const { return count ? sum / count : 0.0; }
+        void add(float value);
+        void merge(const tsdb_rollup &other);
+    };
+
+    enum class tsdb_tier : uint8_t
+    {
+        minute,
+        hour,
+    };
+
+    // One structure-of-arrays ring per channel and tier, all sized at construction,
+    // so the footprint never changes. Rollups are updated on every append: the
+    // current (open) minute and hour are always queryable. Single writer, any
+    // number of readers. A sample slightly older than the channel's newest one is
+    // dropped; a step back of CLOCK_STEP_NS or more means the wall clock was set
+    // back, so what is stamped after the new time is discarded and the channel
+    // carries on from there instead of dropping everything until it catches up.
+    class tsdb
+    {
+    public:
+        static constexpr int64_t MINUTE_NS = 60LL * 1000000000LL;
+        static constexpr int64_t HOUR_NS = 60 * MINUTE_NS;
+        static constexpr int64_t CLOCK_STEP_NS = 10LL * 1000000000LL;
+
+        explicit tsdb(const tsdb_settings &settings = {});
+        ~tsdb();
+
+        tsdb(const tsdb &) = delete;
+        tsdb &operator=(const tsdb &) = delete;
+
+        void append(const sample_frame &frame);
+
+        // Ingest every frame published on the bus from an own thread
+        bool attach(sample_bus &bus);
+
+        // Points / buckets with from_ns <= time < to_ns, oldest first; returns how many were appended to out
+        size_t query_raw(channel ch, int64_t from_ns, int64_t to_ns, std::vector<tsdb_point> &out) const;
+        size_t query_rollups(channel ch, tsdb_tier tier, int64_t from_ns, int64_t to_ns,
+                             std::vector<tsdb_rollup> &out) const;
+
+        // Aggregate over the range from the finest tier that still covers from_ns;
+        // rollup buckets count if they start inside the range
+        tsdb_rollup summarize(channel ch, int64_t from_ns, int64_t to_ns) const;
+
+        size_t footprint_bytes() const;
+        uint64_t out_of_order() const { return out_of_order_.load(std::memory_order_relaxed); }
+        uint64_t clock_steps() const { return clock_steps_.load(std::memory_order_relaxed); }
+
+    private:
+        struct raw_ring
+        {
+            std::vector<int64_t> time;
+            std::vector<float> value;
+            size_t head = 0;
+            size_t size = 0;
+
+            void push(int64_t t, float v);
+            void pop_back();
+            size_t index(size_t logical) const;
+            size_t lower_bound(int64_t t) const;
+        };
+
+        struct rollup_ring
+        {
+            std::vector<int64_t> start;
+            std::vector<float> min;
+            std::vector<float> max;
+            std::vector<double> sum;
+            std::vector<uint32_t> count;
+            size_t head = 0;
+            size_t size = 0;
+
+            void push(const tsdb_rollup &bucket);
+            tsdb_rollup pop_back();
+            tsdb_rollup at(size_t logical) const;
+            size_t index(size_t logical) const;
+            size_t lower_bound(int64_t t) const;
+        };
+
+        struct channel_store
+        {
+            raw_ring raw;
+            rollup_ring minutes;
+            rollup_ring hours;
+            tsdb_rollup open_minute;
+            tsdb_rollup open_hour;
+            int64_t newest_ns = INT64_MIN;
+        };
+
+        void append_value(channel_store &store, int64_t wall_ns, float value);
+        // Drop everything stamped at or after wall_ns (raw) or in a later bucket (rollups)
+        static void rewind(channel_store &store, int64_t wall_ns);
+        void ingest_loop(std::stop_token stop);
+
+        std::array<channel_store, CHANNEL_COUNT> channels_;
+        mutable std::shared_mutex mutex_;
+        std::atomic<uint64_t> out_of_order_{0};
+        std::atomic<uint64_t> clock_steps_{0};
+
+        sample_bus::subscription *feed_ = nullptr;
+        std::jthread ingest_;
+    };
+
+} // namespace app
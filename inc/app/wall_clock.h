@@ -0,0 +1,97 @@
+/**
+ * @file wall_clock.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  RTC-disciplined wall clock on top of CLOCK_MONOTONIC
+ * @version 0.1
+ * @date 2026-01-22
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/seqlock.h"
+#include "peripheral/peripheral_iface.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace app
+{
+    // Wall time as offset + rate over steady_clock (CLOCK_MONOTONIC, read via vDSO):
+    //   wall = wall_anchor + (mono - mono_anchor) * (1 + rate)
+    // now() costs one clock read and a seqlock load, no syscall and no lock.
+    class wall_clock
+    {
+    public:
+        using mono_point = std::chrono::steady_clock::time_point;
+
+        struct model
+        {
+            int64_t mono_anchor_ns = 0;
+            int64_t wall_anchor_ns = 0;
+            double rate = 0.0; // fractional frequency error of the monotonic clock
+            bool synced = false;
+        };
+
+        // An observation: at monotonic instant mono the reference read wall_ns (unix, UTC)
+        void discipline(mono_point mono, int64_t wall_ns);
+
+        int64_t wall_ns_at(mono_point mono) const;
+        std::chrono::system_clock::time_point now() const;
+
+        bool synced() const { return model_.load().synced; }
+        double rate_ppm() const { return model_.load().rate * 1e6; }
+        model get_model() const { return model_.load(); }
+
+        // Longer baselines than this are needed before the rate is trusted
+        static constexpr auto MIN_RATE_BASELINE = std::chrono::seconds(60);
+        static constexpr double MAX_RATE = 500e-6;
+
+    private:
+        seqlock<model> model_;
+
+        // writer side only
+        bool have_first_ = false;
+        int64_t first_mono_ns_ = 0;
+        int64_t first_wall_ns_ = 0;
+    };
+
+    // Keeps a wall_clock disciplined: reads the RTC (or the system clock when there
+    // is none) at start-up and then every resync interval, all from its own thread,
+    // so constructing one (e.g. on a reload that swaps the RTC) never waits for the
+    // seconds edge. Until the first observation the clock keeps its current model.
+    class timekeeper
+    {
+    public:
+        timekeeper(wall_clock &clock, peripherals::rtc_iface *rtc,
+                   std::chrono::seconds resync_interval = std::chrono::seconds(600));
+        ~timekeeper();
+
+        timekeeper(const timekeeper &) = delete;
+        timekeeper &operator=(const timekeeper &) = delete;
+
+        // One observation. With an RTC it waits for the next seconds edge (up to ~1 s)
+        // so the 1 s register resolution does not limit the anchor; gives up on stop.
+        bool sync_once(std::stop_token stop = {});
+
+    private:
+        void loop(std::stop_token stop);
+
+        wall_clock &clock_;
+        peripherals::rtc_iface *rtc_;
+        std::chrono::seconds resync_interval_;
+
+        std::mutex mutex_;
+        std::condition_variable_any cv_;
+        std::jthread worker_;
+    };
+
+    // Calendar fields (UTC) <-> unix seconds, proleptic Gregorian
+    int64_t to_unix_seconds(const peripherals::time_data &t);
+    peripherals::time_data from_unix_seconds(int64_t seconds);
+
+} // namespace app
@@ -0,0 +1,153 @@
+/**
+ * @file atmolyt_shm.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Layout of the latest-sample shared-memory segment; C header for readers
+ * @version 0.1
+ * @date 2026-01-31
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Self-contained, C99 or C++, GCC/Clang. A reader maps the segment once and then
+ * reads values with plain loads, no system calls:
+ *
+ *     const struct atmolyt_shm_segment *seg = atmolyt_shm_map(ATMOLYT_SHM_DEFAULT_NAME);
+ *     struct atmolyt_shm_sample co2;
+ *     if (seg && atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &co2))
+ *         printf("%.0f ppm\n", co2.value);
+ *
+ * Each record is a seqlock: the writer makes seq odd, writes the fields and makes
+ * it even again; a reader retries while seq is odd or changed under it. Readers
+ * never write to the segment, so any number of them can map it read-only.
+ */
+
+#ifndef ATMOLYT_SHM_H
+#define ATMOLYT_SHM_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ATMOLYT_SHM_DEFAULT_NAME "/atmolyt"
+#define ATMOLYT_SHM_MAGIC 0x48534c41u /* "ALSH" */
+#define ATMOLYT_SHM_VERSION 1u
+#define ATMOLYT_SHM_MAX_CHANNELS 16u
+
+/* Same order as app::channel; new channels are only ever appended */
+enum atmolyt_shm_channel
+{
+    ATMOLYT_SHM_CO2_PPM = 0,
+    ATMOLYT_SHM_TEMPERATURE_C = 1,
+    ATMOLYT_SHM_HUMIDITY_RH = 2,
+    ATMOLYT_SHM_PRESSURE_PA = 3,
+    ATMOLYT_SHM_VOC_INDEX = 4,
+    ATMOLYT_SHM_NOX_INDEX = 5,
+};
+
+/* One cache line per channel, so updating one never disturbs readers of another */
+struct atmolyt_shm_record
+{
+    uint64_t seq;     /* odd while the writer is inside */
+    uint64_t updates; /* values published so far, 0 = never */
+    int64_t wall_ns;  /* sample time, Unix epoch */
+    double value;
+    uint8_t reserved[32];
+} __attribute__((aligned(64)));
+
+struct atmolyt_shm_segment
+{
+    uint32_t magic;         /* written last at creation */
+    uint32_t version;
+    uint32_t size;          /* sizeof(struct atmolyt_shm_segment) of the writer */
+    uint32_t channel_count; /* records in use */
+    int32_t writer_pid;     /* 0 after a clean writer shutdown */
+    uint32_t reserved0;
+    uint64_t frames;        /* bumped after each published frame; poll this to wait for news */
+    uint8_t reserved[32];
+    struct atmolyt_shm_record records[ATMOLYT_SHM_MAX_CHANNELS];
+};
+
+struct atmolyt_shm_sample
+{
+    double value;
+    int64_t wall_ns;
+    uint64_t updates;
+};
+
+/* Writer side; one writer per segment */
+static inline void atmolyt_shm_store(struct atmolyt_shm_record *rec, double value, int64_t wall_ns)
+{
+    const uint64_t seq = __atomic_load_n(&rec->seq, __ATOMIC_RELAXED);
+    const uint64_t updates = __atomic_load_n(&rec->updates, __ATOMIC_RELAXED);
+    __atomic_store_n(&rec->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store(&rec->value, &value, __ATOMIC_RELAXED);
+    __atomic_store_n(&rec->wall_ns, wall_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&rec->updates, updates + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&rec->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* Consistent copy of one record; returns 0 if the channel never had a value */
+static inline int atmolyt_shm_load(const struct atmolyt_shm_record *rec, struct atmolyt_shm_sample *out)
+{
+    uint64_t before, after;
+    do
+    {
+        before = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        __atomic_load(&rec->value, &out->value, __ATOMIC_RELAXED);
+        out->wall_ns = __atomic_load_n(&rec->wall_ns, __ATOMIC_RELAXED);
+        out->updates = __atomic_load_n(&rec->updates, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&rec->seq, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+    return out->updates != 0;
+}
+
+static inline int atmolyt_shm_read(const struct atmolyt_shm_segment *seg, unsigned channel,
+                                   struct atmolyt_shm_sample *out)
+{
+    if (channel >= ATMOLYT_SHM_MAX_CHANNELS)
+        return 0;
+    return atmolyt_shm_load(&seg->records[channel], out);
+}
+
+/* Read-only mapping of a segment; NULL if it is missing or has another layout version.
+   The mapping stays valid for the life of the process, across writer restarts. */
+static inline const struct atmolyt_shm_segment *atmolyt_shm_map(const char *name)
+{
+    const int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return 0;
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(struct atmolyt_shm_segment))
+        p = mmap(0, sizeof(struct atmolyt_shm_segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return 0;
+
+    const struct atmolyt_shm_segment *seg = (const struct atmolyt_shm_segment *)p;
+    if (__atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE) != ATMOLYT_SHM_MAGIC || seg->version != ATMOLYT_SHM_VERSION)
+    {
+        munmap(p, sizeof(struct atmolyt_shm_segment));
+        return 0;
+    }
+    return seg;
+}
+
+static inline void atmolyt_shm_unmap(const struct atmolyt_shm_segment *seg)
+{
+    if (seg)
+        munmap((void *)seg, sizeof(struct atmolyt_shm_segment));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ATMOLYT_SHM_H */
@@ -13,19 +13,46 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <map>
 
 namespace config {
 
 struct PeripheralSpec {
-    std::string connection; // "i2c" or "spi" or "mock"
+    std::string connection; // "i2c", "spi", "fb", "mock" or "replay" (device = recorded log)
     std::string type;       // "bme280", "bmp280", etc
     std::string device;     // e.g. "/dev/i2c-2" for i2c
-    uint8_t address = 0;    // I2C address
+    uint8_t address = 0;    // I2C address (chip-select index for spi)
+    std::map<std::string, std::string> options; // any other scalar keys, e.g. "speed_hz", "dc_line"
+};
+
+// MQTT upload; off while broker is empty
+struct MqttConfig {
+    std::string broker;   // "host:port"
+    std::string client_id = "atmolyt";
+    std::string topic = "atmolyt/samples";
+    std::string username;
+    std::string password;
+    int qos = 1;          // 0 or 1
+    int batch = 1;        // samples per message
+    int max_inflight = 16; // QoS 1 messages awaiting PUBACK
+    int keepalive_s = 30;
+    std::string spool_dir;  // store-and-forward directory, empty = memory only
+    int spool_max_mb = 256;
+    double drain_per_s = 20; // backlog messages per second once the broker is back, 0 = no limit
 };
 
 struct AppConfig {
     std::vector<PeripheralSpec> peripherals;
     std::string log_path = "atmolyt_data.csv";
+    int sparkline_minutes = 30; // CO2 trend window on the display, 0 disables the graph
+    std::string raw_capture_path; // raw BME280 ADC words for offline compensation, empty = off
+    int read_budget_ms = 4000; // longest a poll tick may spend in sensor reads
+    int poll_interval_ms = 5000; // tick spacing; 0 = free-running, the reads pace the loop (replay)
+    int history_minutes = 60; // raw samples kept in memory; 1 min / 1 h rollups go back 24 h / 30 days
+    std::string metrics_listen; // "host:port" of the Prometheus /metrics endpoint, empty = off
+    std::string shm_name; // POSIX shared-memory segment with the latest values (atmolyt_shm.h), empty = off
+    std::string stream_socket; // Unix-domain socket streaming every frame to local clients, empty = off
+    MqttConfig mqtt;
 };
 
 // Load config from file (JSON). Returns true on success and populates out
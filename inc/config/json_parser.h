@@ -4,25 +4,22 @@
  * @brief  Simple JSON parser without boost dependency
  * @version 0.1
  * @date 2025-12-27
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
-#include <optional>
-#include <memory>
 
 namespace json {
 
-class Value;
-using Object = std::map<std::string, std::shared_ptr<Value>>;
-using Array = std::vector<std::shared_ptr<Value>>;
-
-enum class Type {
+enum class Type : uint8_t {
     Null,
     Boolean,
     Number,
@@ -31,54 +28,267 @@ enum class Type {
     Object
 };
 
+// One DOM node, 24 bytes. Strings and keys are offset/length pairs into the
+// document buffer; the direct children of a container sit next to each other
+// in the node arena, so iterating or looking up a member is a linear scan.
+// The root is the last node.
+struct Node {
+    uint32_t key_offset = 0; // member key, object children only
+    uint32_t key_length = 0;
+    union {
+        double number;
+        bool boolean;
+        struct {
+            uint32_t offset;
+            uint32_t length;
+        } string;
+        struct {
+            uint32_t first; // distance back to the first child; children precede their container
+            uint32_t count;
+        } children;
+    };
+    Type type = Type::Null;
+
+    Node() : number(0.0) {}
+};
+
+class Document;
+
+// Non-owning handle to a node; valid while its Document is alive (moving the
+// Document keeps it valid).
+// A default-constructed (or missing) Value is false and reads as null.
 class Value {
 public:
-    Value() : type_(Type::Null) {}
-    explicit Value(bool b) : type_(Type::Boolean), bool_value_(b) {}
-    explicit Value(double n) : type_(Type::Number), number_value_(n) {}
-    explicit Value(int n) : type_(Type::Number), number_value_(static_cast<double>(n)) {}
-    explicit Value(const std::string& s) : type_(Type::String), string_value_(s) {}
-    explicit Value(std::string&& s) : type_(Type::String), string_value_(std::move(s)) {}
-    explicit Value(const Array& a) : type_(Type::Array), array_value_(a) {}
-    explicit Value(Array&& a) : type_(Type::Array), array_value_(std::move(a)) {}
-    explicit Value(const Object& o) : type_(Type::Object), object_value_(o) {}
-    explicit Value(Object&& o) : type_(Type::Object), object_value_(std::move(o)) {}
-
-    Type type() const { return type_; }
-    bool is_null() const { return type_ == Type::Null; }
-    bool is_bool() const { return type_ == Type::Boolean; }
-    bool is_number() const { return type_ == Type::Number; }
-    bool is_string() const { return type_ == Type::String; }
-    bool is_array() const { return type_ == Type::Array; }
-    bool is_object() const { return type_ == Type::Object; }
-
-    bool as_bool() const { return bool_value_; }
-    double as_number() const { return number_value_; }
-    int as_int() const { return static_cast<int>(number_value_); }
-    const std::string& as_string() const { return string_value_; }
-    const Array& as_array() const { return array_value_; }
-    const Object& as_object() const { return object_value_; }
-
-    // Get object value by key with optional default
-    std::shared_ptr<Value> get(const std::string& key) const;
-    std::string get_string(const std::string& key, const std::string& default_val = "") const;
-    int get_int(const std::string& key, int default_val = 0) const;
-    double get_number(const std::string& key, double default_val = 0.0) const;
-    bool get_bool(const std::string& key, bool default_val = false) const;
+    class iterator {
+    public:
+        iterator(const char* text, const Node* node) : text_(text), node_(node) {}
+        Value operator*() const { return Value(text_, node_); }
+        iterator& operator++() { ++node_; return *this; }
+        bool operator!=(const iterator& other) const { return node_ != other.node_; }
+        bool operator==(const iterator& other) const { return node_ == other.node_; }
+
+    private:
+        const char* text_;
+        const Node* node_;
+    };
+
+    Value() = default;
+    Value(const char* text, const Node* node) : text_(text), node_(node) {}
+
+    explicit operator bool() const { return node_ != nullptr; }
+
+    Type type() const { return node_ ? node_->type : Type::Null; }
+    bool is_null() const { return type() == Type::Null; }
+    bool is_bool() const { return type() == Type::Boolean; }
+    bool is_number() const { return type() == Type::Number; }
+    // A number with no fraction that fits int; otherwise as_int() is 0 and get_int() the default
+    bool is_int() const;
+    bool is_string() const { return type() == Type::String; }
+    bool is_array() const { return type() == Type::Array; }
+    bool is_object() const { return type() == Type::Object; }
+
+    bool as_bool() const { return is_bool() && node_->boolean; }
+    double as_number() const { return is_number() ? node_->number : 0.0; }
+    int as_int() const { return is_int() ? static_cast<int>(node_->number) : 0; }
+    std::string_view as_string() const;
+
+    // Key of this value inside its parent object, empty otherwise
+    std::string_view key() const;
+
+    // Arrays and objects: children in document order
+    size_t size() const;
+    iterator begin() const;
+    iterator end() const;
+
+    // Get object value by key; the last one wins for duplicate keys
+    Value get(std::string_view key) const;
+    std::string_view get_string(std::string_view key, std::string_view default_val = {}) const;
+    int get_int(std::string_view key, int default_val = 0) const;
+    double get_number(std::string_view key, double default_val = 0.0) const;
+    bool get_bool(std::string_view key, bool default_val = false) const;
 
 private:
-    Type type_;
-    bool bool_value_ = false;
-    double number_value_ = 0.0;
-    std::string string_value_;
-    Array array_value_;
-    Object object_value_;
+    const Node* children() const { return node_ - node_->children.first; }
+    std::string_view text(uint32_t offset, uint32_t length) const { return {text_ + offset, length}; }
+
+    const char* text_ = nullptr; // document buffer
+    const Node* node_ = nullptr;
+};
+
+// File contents in a writable private buffer: mapped copy-on-write when the
+// file can be mapped (the file itself is never modified), read into memory
+// otherwise. Move-only; the data does not move with the object.
+class FileBuffer {
+public:
+    FileBuffer() = default;
+    ~FileBuffer();
+    FileBuffer(FileBuffer&& other) noexcept;
+    FileBuffer& operator=(FileBuffer&& other) noexcept;
+    FileBuffer(const FileBuffer&) = delete;
+    FileBuffer& operator=(const FileBuffer&) = delete;
+
+    bool load(const std::string& filepath);
+    void assign(std::string_view text);
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    void release();
+
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::unique_ptr<char[]> owned_;
+};
+
+// Parsed JSON: the input buffer (unescaped in place) plus the node arena.
+// Move-only; every Value points into it.
+class Document {
+public:
+    explicit operator bool() const { return !nodes_.empty(); }
+    Value root() const { return nodes_.empty() ? Value() : Value(buffer_.data(), &nodes_.back()); }
+
+    size_t node_count() const { return nodes_.size(); }
+    size_t footprint_bytes() const { return buffer_.size() + nodes_.capacity() * sizeof(Node); }
+
+private:
+    friend Document parse(std::string_view json_str);
+    friend Document parse_file(const std::string& filepath);
+    friend Document parse_buffer(FileBuffer&& buffer);
+
+    FileBuffer buffer_;
+    std::vector<Node> nodes_;
+};
+
+// Parse JSON from string (copied once into the document)
+Document parse(std::string_view json_str);
+
+// Parse JSON from file (mapped privately, no copy)
+Document parse_file(const std::string& filepath);
+
+enum class Token : uint8_t {
+    BeginObject,
+    EndObject,
+    BeginArray,
+    EndArray,
+    Key,
+    String,
+    Number,
+    Boolean,
+    Null,
+    End,   // the root value is complete and only whitespace follows
+    Error, // see Reader::error()
+};
+
+// Pull parser: one token per next(), no tree. Strings without escapes are
+// views into the input; escaped ones are decoded into a scratch buffer that
+// the next string overwrites. The input must outlive the reader.
+class Reader {
+public:
+    explicit Reader(std::string_view input) : input_(input) {}
+
+    Token next();
+
+    std::string_view string() const { return string_; } // Key or String
+    double number() const { return number_; }
+    bool boolean() const { return boolean_; }
+    std::string_view raw() const { return raw_; } // source text of the last Number, Boolean or Null
+
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; } // "line 3, column 14: Expected ':' after key"
+
+    // Each consumes one whole value. A value of another type is skipped and
+    // the target keeps what it had; false only once the input is malformed.
+    bool skip();
+    bool read(std::string& out);
+    bool read(int& out);
+    bool read(double& out);
+    bool read(bool& out);
+
+    // Consumes one value and returns its token; a container is skipped whole
+    // and reported by its Begin token
+    Token read_scalar();
+
+    // If the next value is an object, calls member(key) for each member and
+    // returns true once it is closed. The callback consumes the value (or it
+    // is skipped); the key view only lasts until the value is read.
+    template <typename F>
+    bool object(F&& member);
+
+    // Same for an array, calling element() once per element
+    template <typename F>
+    bool array(F&& element);
+
+private:
+    enum class State : uint8_t {
+        Value,        // a value is expected
+        FirstMember,  // after '{'
+        Member,       // after ',' in an object
+        AfterMember,  // ',' or '}'
+        FirstElement, // after '['
+        AfterElement, // ',' or ']'
+        Done,         // root value complete
+    };
+
+    Token fail(const char* what);
+    Token value();
+    Token key();
+    Token close(Token token);
+    Token scalar(Token token);
+    bool read_string();
+    bool skip_container(); // after Begin*: through the matching End*
+    bool next_element();   // consumes ',' or ']'; true while another element follows
+    void skip_whitespace();
+
+    std::string_view input_;
+    size_t pos_ = 0;
+    State state_ = State::Value;
+    std::vector<char> stack_; // open containers, '{' or '['
+    std::string_view string_;
+    std::string_view raw_;
+    std::string scratch_;
+    double number_ = 0.0;
+    bool boolean_ = false;
+    std::string error_;
 };
 
-// Parse JSON from string
-std::shared_ptr<Value> parse(const std::string& json_str);
+template <typename F>
+bool Reader::object(F&& member) {
+    Token token = next();
+    if (token != Token::BeginObject) {
+        if (token == Token::BeginArray) {
+            skip_container();
+        }
+        return false;
+    }
+    while ((token = next()) == Token::Key) {
+        member(string_);
+        if (state_ == State::Value && !skip()) {
+            return false;
+        }
+    }
+    return token == Token::EndObject;
+}
 
-// Parse JSON from file
-std::shared_ptr<Value> parse_file(const std::string& filepath);
+template <typename F>
+bool Reader::array(F&& element) {
+    Token token = next();
+    if (token != Token::BeginArray) {
+        if (token == Token::BeginObject) {
+            skip_container();
+        }
+        return false;
+    }
+    while (next_element()) {
+        element();
+        if (state_ == State::Value && !skip()) {
+            return false;
+        }
+    }
+    return !failed();
+}
 
 } // namespace json
@@ -0,0 +1,48 @@
+/**
+ * @file gpio_line.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Single output line on a GPIO character device
+ * @version 0.1
+ * @date 2026-01-12
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "connection_iface.h"
+#include <cstdint>
+#include <string>
+
+namespace connections {
+
+// Output line requested through /dev/gpiochipN (uAPI v1 line handle).
+// Used for side-band signals such as the D/C pin of SPI displays.
+class gpio_line {
+public:
+    gpio_line(std::string_view chip_path, uint32_t offset, bool initial_high = false);
+    ~gpio_line();
+
+    gpio_line(const gpio_line&) = delete;
+    gpio_line& operator=(const gpio_line&) = delete;
+
+    Status initialize();
+    void deinitialize();
+    bool is_ready() const;
+
+    // Drive the line; repeated writes of the current level are skipped
+    Status set_value(bool high);
+    bool get_value() const { return value_; }
+
+    std::string_view get_chip_path() const { return chip_path_; }
+    uint32_t get_offset() const { return offset_; }
+
+private:
+    std::string chip_path_;
+    uint32_t offset_;
+    int fd_;
+    bool value_;
+};
+
+} // namespace connections
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "connection_iface.h"
+#include <chrono>
 #include <string>
 
 namespace connections {
@@ -41,8 +42,15 @@ public:
     Status reset() override;
     void flush() override;
 
+    // Adapter-level limit for one transfer (I2C_TIMEOUT, 10 ms units), so a stuck
+    // bus cannot outlast a read deadline; applied on initialize()
+    void set_transfer_timeout(std::chrono::milliseconds timeout) { transfer_timeout_ = timeout; }
+
+    static constexpr std::chrono::milliseconds DEFAULT_TRANSFER_TIMEOUT{100};
+
 private:
     int fd_;
+    std::chrono::milliseconds transfer_timeout_ = DEFAULT_TRANSFER_TIMEOUT;
 };
 
 } // namespace connections
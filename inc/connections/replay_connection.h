@@ -0,0 +1,122 @@
+/**
+ * @file replay_connection.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  A recorded log played back as a sensor bus
+ * @version 0.1
+ * @date 2026-02-08
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "connections/connection_iface.h"
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace connections
+{
+    struct replay_settings
+    {
+        double speed = 1.0;  // recorded seconds per real second; 0 = as fast as possible
+        bool loop = false;   // start over at the end of the recording
+        std::string from;    // "YYYY-MM-DD[ HH:MM[:SS]]" (local time) of the first row, empty = the start
+    };
+
+    // One recorded sample; a field is present only if its bit is set in valid
+    struct replay_row
+    {
+        enum field : uint8_t
+        {
+            co2_ppm = 0,
+            temperature_c,
+            humidity_rh,
+            pressure_pa,
+            voc_index,
+            nox_index,
+            FIELD_COUNT
+        };
+
+        int64_t t_ms = 0; // recording time
+        uint8_t valid = 0;
+        std::array<float, FIELD_COUNT> value{};
+
+        bool has(field f) const { return valid & (1u << f); }
+        float get(field f) const { return value[f]; }
+        void set(field f, float v)
+        {
+            value[f] = v;
+            valid |= static_cast<uint8_t>(1u << f);
+        }
+    };
+
+    // Rows of a recording in order (replay_connection.cpp)
+    class replay_source;
+
+    // The "bus" is a recording: a CSV log (csv_logger, <log>.idx is used to
+    // find `from`) or a raw BME280 capture (raw_capture_writer), told apart by
+    // the capture's magic. The CSV stays mapped and rows are parsed as they are
+    // played. Rows come due at their recorded spacing divided by speed, on a
+    // clock that starts with the first take(). Byte transfers fail.
+    class replay_connection final : public addressable_connection_iface<uint8_t>
+    {
+    public:
+        explicit replay_connection(std::string path, replay_settings settings = {});
+        ~replay_connection() override;
+
+        Status initialize() override;
+        void deinitialize() override;
+        bool is_ready() const override;
+
+        Status read(std::span<uint8_t>) override { return Status::ErrorInvalidParam; }
+        Status write(std::span<const uint8_t>) override { return Status::ErrorInvalidParam; }
+        Status read(uint8_t, std::span<uint8_t>) override { return Status::ErrorInvalidParam; }
+        Status write(uint8_t, std::span<const uint8_t>) override { return Status::ErrorInvalidParam; }
+        Status write_read(uint8_t, std::span<const uint8_t>, std::span<uint8_t>) override
+        {
+            return Status::ErrorInvalidParam;
+        }
+        Status read_register(uint8_t, uint8_t, std::span<uint8_t>) override { return Status::ErrorInvalidParam; }
+        Status write_register(uint8_t, uint8_t, std::span<const uint8_t>) override
+        {
+            return Status::ErrorInvalidParam;
+        }
+
+        // Keeps the position: a device re-probe must not restart the recording
+        Status reset() override { return is_ready() ? Status::Success : initialize(); }
+        void flush() override {}
+
+        // Back to `from`; the clock restarts with the next take()
+        void rewind();
+
+        // When the next row is due, without moving the position or the clock:
+        // now before the clock starts and when a loop is about to start over,
+        // time_point::max() once the recording is over
+        std::chrono::steady_clock::time_point next_due() const;
+
+        // The next row if it is due by now; starts the clock and starts a loop
+        // over. Behind schedule at a finite speed, rows that came due meanwhile
+        // are skipped, as a sensor read late would; at full speed none are.
+        bool take(replay_row &row);
+
+        size_t played() const { return played_; }
+        size_t skipped() const { return skipped_; }
+
+    private:
+        std::chrono::steady_clock::time_point due(const replay_row &row) const;
+
+        std::string path_;
+        replay_settings settings_;
+        std::unique_ptr<replay_source> source_;
+
+        bool started_ = false;
+        std::chrono::steady_clock::time_point base_due_;
+        int64_t base_t_ms_ = 0;
+        size_t played_ = 0;
+        size_t skipped_ = 0;
+    };
+
+} // namespace connections
@@ -42,7 +42,12 @@ public:
                         std::span<uint8_t> buffer) override;
     Status write_register(uint8_t cs_pin, uint8_t reg_addr,
                          std::span<const uint8_t> data) override;
+
+    Status write_read(uint8_t cs_pin, std::span<const uint8_t> write_data,
+                      std::span<uint8_t> read_buffer) override;
     
+    // Full-duplex transfer; an empty rx_data makes it a tx-only transfer.
+    // Chip select is the spidev node's own, cs_pin is not used
     Status transfer(uint8_t cs_pin, std::span<const uint8_t> tx_data,
                    std::span<uint8_t> rx_data);
     
@@ -12,14 +12,41 @@
 #pragma once
 
 #include "peripheral/peripheral_iface.h"
+#include "peripheral/bme280_compensation.h"
 #include <array>
+#include <chrono>
 
 namespace peripherals {
 
-class bme280 : public environmental_sensor_iface
+// One burst of ADC words as read from the data registers
+struct bme280_raw_sample
+{
+    int32_t raw_t = 0;
+    int32_t raw_p = 0;
+    int32_t raw_h = 0;   // 0 on BMP280
+    bool valid = false;
+};
+
+// Measurement setup; oversampling 0 skips the channel
+struct bme280_settings
+{
+    uint8_t oversampling_t = 1;  // 0, 1, 2, 4, 8, 16
+    uint8_t oversampling_p = 1;
+    uint8_t oversampling_h = 1;
+    uint8_t iir_filter = 0;      // IIR coefficient: 0 (off), 2, 4, 8, 16
+    float standby_ms = 0.5f;     // normal mode: 0.5, 62.5, 125, 250, 500, 1000, then 10, 20 (BME280)
+                                 // or 2000, 4000 (BMP280); the nearest the chip has is used
+    bool forced = false;         // forced mode: one conversion per read, sleep in between
+};
+
+// 0, 1, 2, 4, 8 or 16
+bool bme280_oversampling_valid(uint8_t factor);
+
+class bme280 final : public environmental_sensor_iface
 {
 public:
-    bme280(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address);
+    bme280(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+           const bme280_settings &settings = {});
     ~bme280() override = default;
 
     Status initialize() override;
@@ -33,33 +60,43 @@ public:
     Status read_humidity(humidity_data &data) override;
     Status read_pressure(pressure_data &data) override;
 
+    std::optional<std::chrono::steady_clock::time_point> data_ready_at() const override;
+
+    // Forced mode: trigger a conversion now; data_ready_at() tells when it completes
+    Status start_measurement();
+
+    // Datasheet t_measure,max for the configured oversampling (appendix B)
+    std::chrono::microseconds max_measurement_time() const;
+
+    const bme280_settings &get_settings() const { return settings_; }
+    // Normal-mode standby as programmed, standby_ms rounded to the chip's table
+    std::chrono::microseconds standby_time() const { return standby_; }
+
+    // Raw capture: ADC words behind the latest read_data() and the trimming they need
+    const bme280_raw_sample &last_raw() const { return last_raw_; }
+    const bme280_calibration &get_calibration() const { return calib_; }
+    bool has_humidity() const { return chip_id_ != CHIP_ID_BMP280; }
+
 private:
     bool read_calibration();
+    // One burst over the data registers; BMP280 has no humidity word (raw_h = 0)
     bool read_raw(int32_t &raw_t, int32_t &raw_p, int32_t &raw_h);
+    // read_raw() preceded by the forced-mode trigger and wait when needed
+    Status acquire_raw(int32_t &raw_t, int32_t &raw_p, int32_t &raw_h);
+    Status wait_measurement_done();
+    uint8_t ctrl_meas_value(uint8_t mode) const;
+
+    static constexpr uint8_t CHIP_ID_BME280 = 0x60;
+    static constexpr uint8_t CHIP_ID_BMP280 = 0x58;
+
+    bme280_calibration calib_;
+    uint8_t chip_id_ = CHIP_ID_BME280;
 
-    // calibration params
-    uint16_t dig_T1 = 0;
-    int16_t dig_T2 = 0;
-    int16_t dig_T3 = 0;
-
-    uint16_t dig_P1 = 0;
-    int16_t dig_P2 = 0;
-    int16_t dig_P3 = 0;
-    int16_t dig_P4 = 0;
-    int16_t dig_P5 = 0;
-    int16_t dig_P6 = 0;
-    int16_t dig_P7 = 0;
-    int16_t dig_P8 = 0;
-    int16_t dig_P9 = 0;
-
-    uint8_t dig_H1 = 0;
-    int16_t dig_H2 = 0;
-    uint8_t dig_H3 = 0;
-    int16_t dig_H4 = 0;
-    int16_t dig_H5 = 0;
-    int8_t dig_H6 = 0;
-
-    int32_t t_fine = 0;
+    bme280_settings settings_;
+    std::chrono::microseconds standby_{500};
+    bool measurement_pending_ = false;
+    std::chrono::steady_clock::time_point ready_at_{};
+    bme280_raw_sample last_raw_;
 };
 
 } // namespace peripherals
@@ -0,0 +1,102 @@
+/**
+ * @file bme280_compensation.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Bosch integer compensation for BME280/BMP280, scalar and batch
+ * @version 0.1
+ * @date 2026-01-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+namespace peripherals {
+
+// Trimming parameters from NVM (0x88..0xA1, 0xE1..0xE7)
+struct bme280_calibration
+{
+    uint16_t dig_T1 = 0;
+    int16_t dig_T2 = 0;
+    int16_t dig_T3 = 0;
+
+    uint16_t dig_P1 = 0;
+    int16_t dig_P2 = 0;
+    int16_t dig_P3 = 0;
+    int16_t dig_P4 = 0;
+    int16_t dig_P5 = 0;
+    int16_t dig_P6 = 0;
+    int16_t dig_P7 = 0;
+    int16_t dig_P8 = 0;
+    int16_t dig_P9 = 0;
+
+    uint8_t dig_H1 = 0;
+    int16_t dig_H2 = 0;
+    uint8_t dig_H3 = 0;
+    int16_t dig_H4 = 0;
+    int16_t dig_H5 = 0;
+    int8_t dig_H6 = 0;
+
+    bool operator==(const bme280_calibration &) const = default;
+};
+
+// Bosch integer compensation (datasheet section 4.2.3 / 8.2)
+inline int32_t bme280_t_fine(const bme280_calibration &c, int32_t raw_t)
+{
+    int32_t var1 = ((((raw_t >> 3) - (int32_t(c.dig_T1) << 1))) * int32_t(c.dig_T2)) >> 11;
+    int32_t var2 = (((((raw_t >> 4) - int32_t(c.dig_T1)) * ((raw_t >> 4) - int32_t(c.dig_T1))) >> 12) * int32_t(c.dig_T3)) >> 14;
+    return var1 + var2;
+}
+
+// Temperature in 0.01 degC
+inline int32_t bme280_temperature_centi(int32_t t_fine)
+{
+    return (t_fine * 5 + 128) >> 8;
+}
+
+// Pressure in Pa as Q24.8, 0 when the calibration would divide by zero
+inline uint32_t bme280_pressure_q24_8(const bme280_calibration &c, int32_t raw_p, int32_t t_fine)
+{
+    int64_t var1 = int64_t(t_fine) - 128000;
+    int64_t var2 = var1 * var1 * int64_t(c.dig_P6);
+    var2 = var2 + ((var1 * int64_t(c.dig_P5)) << 17);
+    var2 = var2 + (int64_t(c.dig_P4) << 35);
+    var1 = ((var1 * var1 * int64_t(c.dig_P3)) >> 8) + ((var1 * int64_t(c.dig_P2)) << 12);
+    var1 = (((int64_t(1) << 47) + var1) * int64_t(c.dig_P1)) >> 33;
+    if (var1 == 0) return 0; // avoid div by zero
+    int64_t p = 1048576 - raw_p;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (int64_t(c.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (int64_t(c.dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (int64_t(c.dig_P7) << 4);
+    return uint32_t(p);
+}
+
+// Relative humidity in %RH as Q22.10
+inline uint32_t bme280_humidity_q22_10(const bme280_calibration &c, int32_t raw_h, int32_t t_fine)
+{
+    int32_t v_x1_u32r = t_fine - 76800;
+    v_x1_u32r = (((((raw_h << 14) - (int32_t(c.dig_H4) << 20) - (int32_t(c.dig_H5) * v_x1_u32r)) + 16384) >> 15) * (((((((v_x1_u32r * int32_t(c.dig_H6)) >> 10) * (((v_x1_u32r * int32_t(c.dig_H3)) >> 11) + 32768)) >> 10) + 2097152) * int32_t(c.dig_H2) + 8192) >> 14));
+    v_x1_u32r = v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * int32_t(c.dig_H1)) >> 4);
+    v_x1_u32r = (v_x1_u32r < 0) ? 0 : v_x1_u32r;
+    v_x1_u32r = (v_x1_u32r > 419430400) ? 419430400 : v_x1_u32r;
+    return uint32_t(v_x1_u32r >> 12);
+}
+
+// Compensate n samples held as separate columns (structure of arrays). All spans
+// must have the same length; raw_h/humidity may be empty for BMP280 captures.
+// Results are bit-identical to the scalar functions above. Returns false, and
+// writes nothing, if the lengths do not match.
+bool bme280_compensate_batch(const bme280_calibration &c,
+                             std::span<const int32_t> raw_t,
+                             std::span<const int32_t> raw_p,
+                             std::span<const int32_t> raw_h,
+                             std::span<int32_t> temperature_centi,
+                             std::span<uint32_t> pressure_q24_8,
+                             std::span<uint32_t> humidity_q22_10);
+
+} // namespace peripherals
@@ -15,7 +15,7 @@
 
 namespace peripherals {
 
-class ds3231 : public rtc_iface
+class ds3231 final : public rtc_iface
 {
 public:
     ds3231(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address);
@@ -32,6 +32,7 @@ public:
 private:
     Status bcd_to_dec(uint8_t bcd, uint8_t &dec);
     Status dec_to_bcd(uint8_t dec, uint8_t &bcd);
+    static uint8_t day_of_week(int year, int month, int day);
 };
 
 } // namespace peripherals
\ No newline at end of file
@@ -0,0 +1,115 @@
+/**
+ * @file gas_index_algorithm.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Streaming VOC/NOx index from SGP4x raw signals
+ * @version 0.1
+ * @date 2026-01-20
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace peripherals
+{
+    enum class gas_index_type : uint8_t
+    {
+        voc,
+        nox
+    };
+
+    // Adaptive part of the algorithm; enough to resume without the initial learning phase
+    struct gas_index_state
+    {
+        float mean = 0.0f;
+        float std = 0.0f;
+    };
+
+    // Port of Sensirion's gas index algorithm (v3): the raw signal is normalised against
+    // a slowly learned mean/variance, mapped through a sigmoid and smoothed by an
+    // adaptive low-pass. Fixed-size state, O(1) per sample, no allocation.
+    class gas_index_algorithm
+    {
+    public:
+        explicit gas_index_algorithm(gas_index_type type, float sampling_interval_s = 1.0f);
+
+        // One raw sample (SRAW_VOC / SRAW_NOX); returns the index, 0 during the initial blackout
+        int32_t process(int32_t sraw);
+
+        void reset();
+
+        // Learned state. Restoring is meant for short interruptions such as a reboot.
+        gas_index_state get_state() const;
+        void set_state(const gas_index_state &state);
+
+        gas_index_type type() const { return type_; }
+        float uptime_s() const { return uptime_; }
+
+    private:
+        void init_instances();
+
+        // mean/variance estimator
+        void mve_set_parameters();
+        void mve_set_state(float mean, float std, float uptime_gamma);
+        void mve_calculate_gamma();
+        void mve_process(float sraw);
+        float mve_mean() const { return mve_mean_ + mve_sraw_offset_; }
+        static float mve_sigmoid(float x0, float k, float sample);
+
+        float mox_process(float sraw) const;
+        float sigmoid_scaled_process(float sample) const;
+        float lowpass_process(float sample);
+
+        gas_index_type type_;
+        float sampling_interval_;
+
+        // tuning
+        float index_offset_;
+        int32_t sraw_minimum_;
+        float gating_max_duration_minutes_;
+        float init_duration_mean_;
+        float init_duration_variance_;
+        float gating_threshold_;
+        float index_gain_;
+        float tau_mean_hours_;
+        float tau_variance_hours_;
+        float sraw_std_initial_;
+
+        // runtime
+        float uptime_ = 0.0f;
+        float sraw_ = 0.0f;
+        float gas_index_ = 0.0f;
+
+        bool mve_initialized_ = false;
+        float mve_mean_ = 0.0f;
+        float mve_sraw_offset_ = 0.0f;
+        float mve_std_ = 0.0f;
+        float mve_gamma_mean_ = 0.0f;
+        float mve_gamma_variance_ = 0.0f;
+        float mve_gamma_initial_mean_ = 0.0f;
+        float mve_gamma_initial_variance_ = 0.0f;
+        float mve_current_gamma_mean_ = 0.0f;
+        float mve_current_gamma_variance_ = 0.0f;
+        float mve_uptime_gamma_ = 0.0f;
+        float mve_uptime_gating_ = 0.0f;
+        float mve_gating_duration_minutes_ = 0.0f;
+
+        float mox_sraw_std_ = 0.0f;
+        float mox_sraw_mean_ = 0.0f;
+
+        float sigmoid_k_ = 0.0f;
+        float sigmoid_x0_ = 0.0f;
+        float sigmoid_offset_default_ = 0.0f;
+
+        float lp_a1_ = 0.0f;
+        float lp_a2_ = 0.0f;
+        bool lp_initialized_ = false;
+        float lp_x1_ = 0.0f;
+        float lp_x2_ = 0.0f;
+        float lp_x3_ = 0.0f;
+    };
+
+} // namespace peripherals
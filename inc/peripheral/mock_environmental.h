@@ -16,7 +16,7 @@
 namespace peripherals
 {
 
-    class mock_environmental : public environmental_sensor_iface
+    class mock_environmental final : public environmental_sensor_iface
     {
     public:
         mock_environmental(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address)
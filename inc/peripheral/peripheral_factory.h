@@ -12,10 +12,13 @@
 #pragma once
 
 #include "peripheral_iface.h"
+#include "peripheral_options.h"
 #include "connections/connection_iface.h"
+#include "connections/gpio_line.h"
 #include <memory>
 #include <string>
-#include <map>
+#include <array>
+#include <string_view>
 
 namespace peripherals
 {
@@ -33,16 +36,67 @@ namespace peripherals
         DS3231
     };
 
+    struct peripheral_descriptor
+    {
+        std::string_view name;
+        PeripheralType type;
+        uint8_t default_address;
+    };
+
+    // Name, type and default address in one table; lookups are a short linear scan
+    // without allocations and work in constant expressions
+    inline constexpr std::array<peripheral_descriptor, 8> PERIPHERAL_TABLE = {{
+        {"bmp280", PeripheralType::BMP280, 0x76},
+        {"bme280", PeripheralType::BME280, 0x76},
+        {"mpu6050", PeripheralType::MPU6050, 0x68},
+        {"dht22", PeripheralType::DHT22, 0x00},
+        {"sgp41", PeripheralType::SGP41, 0x59},
+        {"scd41", PeripheralType::SCD41, 0x62},
+        {"ssd1306", PeripheralType::SSD1306, 0x3C},
+        {"ds3231", PeripheralType::DS3231, 0x68},
+    }};
+
+    // Case-insensitive
+    constexpr PeripheralType type_from_name(std::string_view name)
+    {
+        for (const auto &entry : PERIPHERAL_TABLE)
+        {
+            if (entry.name.size() != name.size())
+                continue;
+            bool equal = true;
+            for (size_t i = 0; i < name.size() && equal; ++i)
+            {
+                char c = name[i];
+                if (c >= 'A' && c <= 'Z')
+                    c = static_cast<char>(c - 'A' + 'a');
+                equal = c == entry.name[i];
+            }
+            if (equal)
+                return entry.type;
+        }
+        return PeripheralType::Unknown;
+    }
+
+    constexpr const peripheral_descriptor *find_descriptor(PeripheralType type)
+    {
+        for (const auto &entry : PERIPHERAL_TABLE)
+            if (entry.type == type)
+                return &entry;
+        return nullptr;
+    }
+
     class peripheral_factory
     {
     public:
         peripheral_factory() = delete;
 
+        // opts: oversampling_t/_p/_h, iir_filter, standby_ms, mode ("normal" | "forced")
         static std::unique_ptr<environmental_sensor_iface>
         create_environmental_sensor(
             PeripheralType type,
             connections::addressable_connection_iface<uint8_t> *conn,
-            uint8_t address);
+            uint8_t address,
+            const peripheral_options &opts = {});
 
         static std::unique_ptr<imu_iface>
         create_imu(
@@ -50,17 +104,22 @@ namespace peripherals
             connections::addressable_connection_iface<uint8_t> *conn,
             uint8_t address);
 
+        // opts: SCD41 mode ("periodic" | "low_power" | "single_shot" | "single_shot_rht_only"),
+        //       SGP41 state_path, state_max_age_s
         static std::unique_ptr<gas_sensor_iface>
         create_gas_sensor(
             PeripheralType type,
             connections::addressable_connection_iface<uint8_t> *conn,
-            uint8_t address);
+            uint8_t address,
+            const peripheral_options &opts = {});
 
+        // dc_line selects the 4-wire SPI transport for displays that support it
         static std::unique_ptr<display_iface>
         create_display(
             PeripheralType type,
             connections::addressable_connection_iface<uint8_t> *conn,
-            uint8_t address);
+            uint8_t address,
+            connections::gpio_line *dc_line = nullptr);
 
         static std::unique_ptr<rtc_iface>
         create_rtc(
@@ -71,11 +130,6 @@ namespace peripherals
         static PeripheralType string_to_type(const std::string &type_str);
         static std::string type_to_string(PeripheralType type);
         static uint8_t get_default_address(PeripheralType type);
-
-    private:
-        static const std::map<std::string, PeripheralType> type_map_;
-        static const std::map<PeripheralType, std::string> reverse_type_map_;
-        static const std::map<PeripheralType, uint8_t> default_addresses_;
     };
 
 } // namespace peripherals
@@ -15,6 +15,10 @@
 #include <string_view>
 #include <optional>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+#include <thread>
 #include <variant>
 #include <system_error>
 
@@ -28,7 +32,8 @@ namespace peripherals
         ErrorInvalidData,
         ErrorTimeout,
         ErrorCalibration,
-        ErrorOutOfRange
+        ErrorOutOfRange,
+        ErrorDeadline // the read's own budget ran out (or stop was requested), not the device
     };
 
     // Modern error handling: Result<T> = variant<T, Status>
@@ -74,10 +79,39 @@ namespace peripherals
         Status error_;
     };
 
+    // Bounds one read: drivers give up with ErrorDeadline instead of waiting past
+    // the deadline, and return early once stop is requested. ErrorTimeout stays
+    // for a device that did not answer within its own limit.
+    struct read_context
+    {
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        std::stop_token stop;
+    };
+
+    // Sleeps until t unless that is past ctx's deadline (returns false at once) or
+    // stop is requested meanwhile (returns false early). ctx == nullptr: plain sleep.
+    inline bool sleep_until(std::chrono::steady_clock::time_point t, const read_context *ctx)
+    {
+        if (!ctx)
+        {
+            std::this_thread::sleep_until(t);
+            return true;
+        }
+        if (t > ctx->deadline || ctx->stop.stop_requested())
+            return false;
+
+        std::mutex mutex;
+        std::condition_variable_any cv;
+        std::unique_lock<std::mutex> lock(mutex);
+        return !cv.wait_until(lock, ctx->stop, t, [] { return false; }) && !ctx->stop.stop_requested();
+    }
+
     template <typename T>
     class peripheral_iface
     {
     public:
+        using data_type = T;
+
         peripheral_iface(connections::addressable_connection_iface<uint8_t> *conn,
                          uint8_t address)
             : connection_(conn), device_address_(address), initialized_(false) {}
@@ -94,6 +128,21 @@ namespace peripherals
 
         virtual Status read_data(T &data) = 0;
 
+        // read_data() bounded by ctx; the driver's waits go through wait_until()
+        Status read_data_within(T &data, const read_context &ctx)
+        {
+            if (ctx.stop.stop_requested() || std::chrono::steady_clock::now() >= ctx.deadline)
+                return Status::ErrorDeadline;
+            read_ctx_ = &ctx;
+            const Status status = read_data(data);
+            read_ctx_ = nullptr;
+            return status;
+        }
+
+        // When read_data() will have fresh data without waiting on the device;
+        // nullopt if the driver does not track conversion timing
+        virtual std::optional<std::chrono::steady_clock::time_point> data_ready_at() const { return std::nullopt; }
+
         bool is_initialized() const { return initialized_; }
         uint8_t get_address() const { return device_address_; }
 
@@ -105,6 +154,15 @@ namespace peripherals
         bool initialized_;
         std::chrono::steady_clock::time_point last_read_time_;
 
+        // Context of the read in progress (read_data_within), nullptr otherwise
+        const read_context *read_ctx_ = nullptr;
+
+        bool wait_until(std::chrono::steady_clock::time_point t) const { return sleep_until(t, read_ctx_); }
+        bool wait_for(std::chrono::steady_clock::duration d) const
+        {
+            return sleep_until(std::chrono::steady_clock::now() + d, read_ctx_);
+        }
+
         Status write_register(uint8_t reg, uint8_t value)
         {
             auto status = connection_->write_register(device_address_, reg,
@@ -180,6 +238,9 @@ namespace peripherals
         float temperature_c;
         float humidity_rh;
         bool valid;
+        // Sensirion gas indices (1..500), -1 when the sensor has none
+        int32_t voc_index = -1;
+        int32_t nox_index = -1;
     };
     struct time_data
     {
@@ -280,6 +341,9 @@ namespace peripherals
         virtual Status set_cursor(uint8_t x, uint8_t y) = 0;
         virtual void draw_pixel(int x, int y, int color) = 0;
         virtual void draw_line(int x0, int y0, int x1, int y1, int color) = 0;
+
+        // Push pixels buffered by draw_pixel/draw_line to the panel
+        virtual Status flush() { return Status::Success; }
     };
 
     class rtc_iface : public peripheral_iface<time_data>
@@ -0,0 +1,59 @@
+/**
+ * @file peripheral_options.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Driver-specific settings of a peripheral config entry
+ * @version 0.1
+ * @date 2026-01-12
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <cstdlib>
+
+namespace peripherals
+{
+    // Extra keys of a peripheral entry ("speed_hz", "dc_line", ...), values kept as text
+    using peripheral_options = std::map<std::string, std::string>;
+
+    inline std::string option_string(const peripheral_options &opts, const std::string &key,
+                                     const std::string &default_val = "")
+    {
+        auto it = opts.find(key);
+        return it != opts.end() ? it->second : default_val;
+    }
+
+    // Accepts decimal or 0x-prefixed hex
+    inline long option_int(const peripheral_options &opts, const std::string &key, long default_val = 0)
+    {
+        auto it = opts.find(key);
+        if (it == opts.end() || it->second.empty())
+            return default_val;
+        char *end = nullptr;
+        long v = std::strtol(it->second.c_str(), &end, 0);
+        return (end && *end == '\0') ? v : default_val;
+    }
+
+    inline double option_number(const peripheral_options &opts, const std::string &key, double default_val = 0.0)
+    {
+        auto it = opts.find(key);
+        if (it == opts.end() || it->second.empty())
+            return default_val;
+        char *end = nullptr;
+        double v = std::strtod(it->second.c_str(), &end);
+        return (end && *end == '\0') ? v : default_val;
+    }
+
+    inline bool option_bool(const peripheral_options &opts, const std::string &key, bool default_val = false)
+    {
+        auto it = opts.find(key);
+        if (it == opts.end())
+            return default_val;
+        return it->second == "true" || it->second == "1" || it->second == "yes";
+    }
+
+} // namespace peripherals
@@ -0,0 +1,73 @@
+/**
+ * @file replay_sensors.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Gas and environmental sensors that play back a recording
+ * @version 0.1
+ * @date 2026-02-08
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "connections/replay_connection.h"
+#include "peripheral/peripheral_iface.h"
+
+namespace peripherals
+{
+    // read_data() waits (within the read's deadline) for the next row of the
+    // replay_connection and reports it like the real sensor would. A row due
+    // after the deadline is not waited for and data_ready_at() says when it
+    // is; at the end of a recording that does not loop it is never.
+
+    // CO2/T/RH (SCD41) or VOC/NOx indices (SGP41), whichever the row has
+    class replay_gas_sensor final : public gas_sensor_iface
+    {
+    public:
+        explicit replay_gas_sensor(connections::replay_connection *conn)
+            : gas_sensor_iface(conn, 0), replay_(conn) {}
+
+        Status initialize() override;
+        void deinitialize() override { initialized_ = false; }
+        bool is_connected() override { return replay_->is_ready(); }
+        Status reset() override { return initialize(); }
+
+        Status read_data(gas_data &data) override;
+
+        Status set_measurement_mode(uint8_t) override { return Status::Success; }
+        Status read_co2(float &ppm) override;
+        Status read_tvoc(float &ppb) override;
+
+        std::optional<std::chrono::steady_clock::time_point> data_ready_at() const override;
+
+    private:
+        Status next(connections::replay_row &row);
+
+        connections::replay_connection *replay_;
+    };
+
+    // T/P[/RH] (BME280/BMP280)
+    class replay_environmental final : public environmental_sensor_iface
+    {
+    public:
+        explicit replay_environmental(connections::replay_connection *conn)
+            : environmental_sensor_iface(conn, 0), replay_(conn) {}
+
+        Status initialize() override;
+        void deinitialize() override { initialized_ = false; }
+        bool is_connected() override { return replay_->is_ready(); }
+        Status reset() override { return initialize(); }
+
+        Status read_data(combined_env_data &data) override;
+        Status read_temperature(temperature_data &data) override;
+        Status read_humidity(humidity_data &data) override;
+        Status read_pressure(pressure_data &data) override;
+
+        std::optional<std::chrono::steady_clock::time_point> data_ready_at() const override;
+
+    private:
+        connections::replay_connection *replay_;
+    };
+
+} // namespace peripherals
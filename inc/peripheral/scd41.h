@@ -12,13 +12,24 @@
 #pragma once
 
 #include "peripheral/peripheral_iface.h"
+#include <chrono>
 
 namespace peripherals {
 
-class scd41 : public gas_sensor_iface
+// Values accepted by set_measurement_mode()
+enum class scd41_mode : uint8_t
+{
+    periodic = 0,             // 0x21b1, result every 5 s
+    low_power_periodic = 1,   // 0x21ac, result every 30 s
+    single_shot = 2,          // 0x219d, one result 5 s after each trigger
+    single_shot_rht_only = 3  // 0x2196, T/RH only, 50 ms, CO2 word reads 0
+};
+
+class scd41 final : public gas_sensor_iface
 {
 public:
-    scd41(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address);
+    scd41(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+          scd41_mode mode = scd41_mode::periodic);
     ~scd41() override = default;
 
     Status initialize() override;
@@ -32,20 +43,35 @@ public:
     Status read_co2(float &ppm) override;
     Status read_tvoc(float &ppb) override;
 
+    // Periodic modes: next result of the sensor's own cadence.
+    // Single-shot modes: end of the triggered conversion, nullopt when none is pending.
+    std::optional<std::chrono::steady_clock::time_point> data_ready_at() const override;
+
+    // Single-shot modes: trigger a conversion now; read_data() triggers one itself otherwise
+    Status start_measurement();
+
+    scd41_mode get_mode() const { return mode_; }
+
+    // Datasheet command execution / measurement durations
+    static std::chrono::milliseconds measurement_interval(scd41_mode mode);
+
 private:
     Status start_periodic_measurement();
-    Status stop_periodic_measurement();
+    Status stop_periodic_measurement(bool settle = true); // settle: wait until the sensor accepts commands again
+    bool is_periodic() const { return mode_ == scd41_mode::periodic || mode_ == scd41_mode::low_power_periodic; }
     Status get_data_ready_status(bool &ready);
     Status read_measurement(uint16_t &co2_raw, uint16_t &temperature_raw, uint16_t &humidity_raw);
 
-    // CRC calculation for SCD41
-    uint8_t crc8(const uint8_t *data, size_t len);
-    bool check_crc(const uint8_t *data, size_t len, uint8_t crc);
-
     // Conversion functions
     float convert_co2(uint16_t raw);
     float convert_temperature(uint16_t raw);
     float convert_humidity(uint16_t raw);
+
+    scd41_mode mode_;
+    bool periodic_running_ = false;
+    bool single_pending_ = false;
+    std::chrono::steady_clock::time_point cadence_start_{}; // first periodic result is due here
+    std::chrono::steady_clock::time_point ready_at_{};      // pending single-shot result
 };
 
 } // namespace peripherals
\ No newline at end of file
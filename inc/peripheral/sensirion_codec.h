@@ -0,0 +1,126 @@
+/**
+ * @file sensirion_codec.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Sensirion I2C word protocol: command frames and CRC-checked replies
+ * @version 0.1
+ * @date 2026-01-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "peripheral/peripheral_iface.h"
+#include "connections/connection_iface.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// SCD4x, SGP4x, SHT4x: a 16-bit command, optionally followed by argument words;
+// every word on the wire is big-endian and followed by CRC-8 (poly 0x31, init 0xFF).
+namespace peripherals::sensirion
+{
+    inline constexpr uint8_t CRC_INIT = 0xFF;
+    inline constexpr uint8_t CRC_POLY = 0x31;
+
+    constexpr std::array<uint8_t, 256> make_crc_table()
+    {
+        std::array<uint8_t, 256> table{};
+        for (size_t i = 0; i < 256; ++i)
+        {
+            uint8_t crc = static_cast<uint8_t>(i);
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ CRC_POLY) : static_cast<uint8_t>(crc << 1);
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    inline constexpr std::array<uint8_t, 256> crc_table = make_crc_table();
+
+    constexpr uint8_t crc8(uint8_t msb, uint8_t lsb)
+    {
+        return crc_table[crc_table[CRC_INIT ^ msb] ^ lsb];
+    }
+
+    constexpr uint8_t crc8(uint16_t word)
+    {
+        return crc8(static_cast<uint8_t>(word >> 8), static_cast<uint8_t>(word & 0xFF));
+    }
+
+    // Wire size of N words
+    constexpr size_t words_size(size_t n) { return 3 * n; }
+
+    // Command id followed by Args CRC-protected argument words
+    template <uint16_t Id, size_t Args = 0>
+    constexpr std::array<uint8_t, 2 + words_size(Args)> encode(const std::array<uint16_t, Args> &args = {})
+    {
+        std::array<uint8_t, 2 + words_size(Args)> frame{};
+        frame[0] = static_cast<uint8_t>(Id >> 8);
+        frame[1] = static_cast<uint8_t>(Id & 0xFF);
+        for (size_t i = 0; i < Args; ++i)
+        {
+            frame[2 + 3 * i] = static_cast<uint8_t>(args[i] >> 8);
+            frame[3 + 3 * i] = static_cast<uint8_t>(args[i] & 0xFF);
+            frame[4 + 3 * i] = crc8(args[i]);
+        }
+        return frame;
+    }
+
+    // Argument-less frames are fully known at compile time
+    template <uint16_t Id>
+    inline constexpr std::array<uint8_t, 2> command_frame = encode<Id>();
+
+    // False on the first word whose CRC does not match
+    template <size_t N>
+    constexpr bool decode(std::span<const uint8_t, words_size(N)> wire, std::array<uint16_t, N> &words)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            const uint8_t msb = wire[3 * i];
+            const uint8_t lsb = wire[3 * i + 1];
+            if (crc8(msb, lsb) != wire[3 * i + 2])
+                return false;
+            words[i] = static_cast<uint16_t>((msb << 8) | lsb);
+        }
+        return true;
+    }
+
+    // Write-only command (start/stop measurement, settings with arguments)
+    template <uint16_t Id, size_t Args = 0>
+    Status send(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+                const std::array<uint16_t, Args> &args = {})
+    {
+        const auto frame = encode<Id, Args>(args);
+        auto st = conn->write(address, std::span<const uint8_t>(frame.data(), frame.size()));
+        return st == connections::Status::Success ? Status::Success : Status::ErrorCommunication;
+    }
+
+    // Command followed by a read of N words; one stack buffer per transaction
+    template <uint16_t Id, size_t N>
+    Status read_words(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+                      std::array<uint16_t, N> &words)
+    {
+        static constexpr auto frame = command_frame<Id>;
+        std::array<uint8_t, words_size(N)> wire;
+        auto st = conn->write_read(address, std::span<const uint8_t>(frame.data(), frame.size()),
+                                   std::span<uint8_t>(wire.data(), wire.size()));
+        if (st != connections::Status::Success)
+            return Status::ErrorCommunication;
+        return decode<N>(wire, words) ? Status::Success : Status::ErrorInvalidData;
+    }
+
+    // Plain read of N words, for commands that need a wait between write and read
+    template <size_t N>
+    Status receive(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+                   std::array<uint16_t, N> &words)
+    {
+        std::array<uint8_t, words_size(N)> wire;
+        if (conn->read(address, std::span<uint8_t>(wire.data(), wire.size())) != connections::Status::Success)
+            return Status::ErrorCommunication;
+        return decode<N>(wire, words) ? Status::Success : Status::ErrorInvalidData;
+    }
+
+} // namespace peripherals::sensirion
@@ -0,0 +1,83 @@
+/**
+ * @file sensor_concepts.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Concept-based driver model for builds with a fixed sensor set
+ * @version 0.1
+ * @date 2026-01-24
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "peripheral/peripheral_iface.h"
+#include <concepts>
+#include <tuple>
+#include <type_traits>
+
+namespace peripherals
+{
+    // Anything that reads one typed sample. The concrete drivers are `final`, so a
+    // call through the driver type binds statically; the *_iface classes satisfy the
+    // concept too and stay the adapter for configs resolved at run time.
+    template <typename D>
+    concept sensor_driver = requires(D &d, typename D::data_type &out) {
+        typename D::data_type;
+        { d.initialize() } -> std::same_as<Status>;
+        { d.is_connected() } -> std::convertible_to<bool>;
+        { d.read_data(out) } -> std::same_as<Status>;
+    };
+
+    template <typename D, typename T>
+    concept sensor_driver_of = sensor_driver<D> && std::same_as<typename D::data_type, T>;
+
+    // A compile-time sensor set: drivers are referenced (they are not movable and
+    // usually live as statics), initialized and polled through fold expressions.
+    template <sensor_driver... Drivers>
+    class sensor_set
+    {
+    public:
+        explicit sensor_set(Drivers &...drivers) : drivers_(drivers...) {}
+
+        static constexpr size_t size() { return sizeof...(Drivers); }
+
+        // Initializes every driver in order, even after one fails (one absent sensor
+        // must not keep the others down), and returns the first failure
+        Status initialize_all()
+        {
+            Status result = Status::Success;
+            std::apply([&](auto &...d) {
+                (([&] {
+                     const Status status = d.initialize();
+                     if (result == Status::Success)
+                         result = status;
+                 }()),
+                 ...);
+            }, drivers_);
+            return result;
+        }
+
+        // Reads every driver once; fn(driver, status, data) sees each result
+        template <typename Fn>
+        void poll(Fn &&fn)
+        {
+            std::apply([&](auto &...d) { (poll_one(d, fn), ...); }, drivers_);
+        }
+
+        template <size_t I>
+        auto &get() { return std::get<I>(drivers_); }
+
+    private:
+        template <typename D, typename Fn>
+        static void poll_one(D &driver, Fn &fn)
+        {
+            typename D::data_type data{};
+            const Status status = driver.read_data(data);
+            fn(driver, status, data);
+        }
+
+        std::tuple<Drivers &...> drivers_;
+    };
+
+} // namespace peripherals
@@ -0,0 +1,92 @@
+/**
+ * @file sgp41.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  SGP41 VOC/NOx sensor interface
+ * @version 0.1
+ * @date 2026-01-20
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "peripheral/peripheral_iface.h"
+#include "peripheral/gas_index_algorithm.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace peripherals {
+
+struct sgp41_settings
+{
+    std::string state_path = "sgp41_state.txt";      // learned index state, empty = not persisted
+    std::chrono::seconds state_max_age{600};         // older state is discarded (sensor was off too long)
+    bool sampling_thread = true;                     // false: the caller drives sample() at 1 Hz
+};
+
+// Indices come from a 1 Hz sampler: the first CONDITIONING_SAMPLES steps condition
+// the NOx pixel, then every step measures both raw signals and feeds the algorithms.
+class sgp41 final : public gas_sensor_iface
+{
+public:
+    sgp41(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+          const sgp41_settings &settings = {});
+    ~sgp41() override;
+
+    Status initialize() override;
+    void deinitialize() override;
+    bool is_connected() override;
+    Status reset() override;
+
+    // Latest indices; co2_ppm is -1 and valid stays false until the VOC index is available
+    Status read_data(gas_data &data) override;
+
+    Status set_measurement_mode(uint8_t mode) override;
+    Status read_co2(float &ppm) override;
+    Status read_tvoc(float &ppb) override;
+
+    // Humidity/temperature compensation for the raw signals (e.g. from SCD41)
+    void set_compensation(float temperature_c, float humidity_rh);
+
+    // One 1 Hz step: conditioning or measure_raw_signals + algorithm update
+    Status sample();
+
+    bool is_conditioning() const { return conditioning_left_ > 0; }
+    bool state_restored() const { return state_restored_; }
+
+    // Called by the sampler (hourly) and by deinitialize(); not concurrently with sample().
+    // A file error is logged and returns false: it is not a fault of the sensor
+    bool save_state() const;
+
+    static constexpr int CONDITIONING_SAMPLES = 10;
+    static constexpr auto SAMPLING_INTERVAL = std::chrono::seconds(1);
+
+private:
+    bool load_state();
+    void sampler_loop(std::stop_token stop);
+
+    sgp41_settings settings_;
+    gas_index_algorithm voc_;
+    gas_index_algorithm nox_;
+
+    int conditioning_left_ = CONDITIONING_SAMPLES;
+    uint32_t samples_ = 0;
+    bool state_restored_ = false;
+
+    std::atomic<uint16_t> rh_ticks_{0x8000};   // 50 %RH
+    std::atomic<uint16_t> t_ticks_{0x6666};    // 25 degC
+    std::atomic<int32_t> voc_index_{0};
+    std::atomic<int32_t> nox_index_{0};
+    std::atomic<bool> sampling_ok_{true};
+
+    std::mutex sampler_mutex_;
+    std::condition_variable_any sampler_cv_;
+    std::jthread sampler_;
+};
+
+} // namespace peripherals
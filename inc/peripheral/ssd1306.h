@@ -12,13 +12,18 @@
 #pragma once
 
 #include "peripheral/peripheral_iface.h"
+#include "connections/gpio_line.h"
+#include <array>
 
 namespace peripherals {
 
-class ssd1306 : public display_iface
+class ssd1306 final : public display_iface
 {
 public:
-    ssd1306(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address);
+    // conn == nullptr -> /dev/fb0; dc_line != nullptr -> 4-wire SPI (address is the CS index),
+    // otherwise I2C with control-byte framing
+    ssd1306(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+            connections::gpio_line *dc_line = nullptr);
     ~ssd1306() override;
 
     Status initialize() override;
@@ -33,15 +38,32 @@ public:
     Status set_cursor(uint8_t x, uint8_t y) override;
     void draw_pixel(int x, int y, int color) override;
     void draw_line(int x0, int y0, int x1, int y1, int color) override;
+    Status flush() override;
+
+    static constexpr int WIDTH = 128;
+    static constexpr int HEIGHT = 64;
+    static constexpr int PAGES = HEIGHT / 8;
 
 private:
     Status send_command(uint8_t cmd);
+    Status send_commands(std::span<const uint8_t> cmds);
     Status send_data(const uint8_t *data, size_t len);
     Status init_display();
+    void mark_dirty(int page_lo, int page_hi, int col_lo, int col_hi);
+
+    connections::gpio_line *dc_line_;
 
     uint8_t cursor_x_;
     uint8_t cursor_y_;
 
+    // I2C/SPI: shadow of the panel GDDRAM and the rectangle not yet sent
+    std::array<uint8_t, WIDTH * PAGES> gddram_{};
+    bool dirty_ = false;
+    int dirty_page_lo_ = 0;
+    int dirty_page_hi_ = 0;
+    int dirty_col_lo_ = 0;
+    int dirty_col_hi_ = 0;
+
     // Framebuffer fields
     int fb_fd_;
     char* fb_ptr_;
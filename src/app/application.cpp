@@ -10,13 +10,19 @@
  */
 
 #include "app/application.h"
+#include "app/log_query.h"
 
 #include "config/config_loader.h"
 #include "connections/i2c_connection.h"
+#include "connections/spi_connection.h"
+#include "connections/gpio_line.h"
 #include "connections/mock_connection.h"
+#include "connections/replay_connection.h"
 #include "peripheral/bme280.h"
 #include "peripheral/peripheral_factory.h"
 #include "peripheral/peripheral_iface.h"
+#include "peripheral/peripheral_options.h"
+#include "peripheral/replay_sensors.h"
 #include "self_test/self_test.h"
 
 #ifdef USE_BOOST
@@ -25,19 +31,22 @@
     #include "config/cmdline_parser.h"
 #endif
 
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <cerrno>
+#include <utility>
 
 using namespace peripherals;
 
 namespace app
 {
     atmolyt::atmolyt(int argc, char *argv[])
-        : should_run_(true)
+        : should_run_(true), set_(std::make_shared<peripheral_set>())
     {
         int rc = parse_inarg(argc, argv);
         
-        // rc = 1 means --help/--view/--st was shown, don't run main loop
+        // rc = 1 means --help/--view/--st/--query was handled, don't run main loop
         // rc = 0 means normal operation, initialize peripherals
         // rc < 0 means error
         if (rc == 1)
@@ -51,6 +60,8 @@ namespace app
             should_run_ = true;
             if (!load_and_create_peripherals())
                 std::cerr << "Warning: failed to create peripherals from config" << std::endl;
+            // A broken config can be fixed and reloaded without a restart
+            reload_worker_ = std::jthread([this](std::stop_token stop) { reload_loop(stop); });
         }
         else
         {
@@ -61,32 +72,17 @@ namespace app
 
     atmolyt::~atmolyt()
     {
-        // ensure proper deinitialization
-        for (auto &sensor : environmental_sensors_)
+        if (reload_worker_.joinable())
         {
-            if (sensor)
-                sensor->deinitialize();
-        }
-        for (auto &sensor : gas_sensors_)
-        {
-            if (sensor)
-                sensor->deinitialize();
-        }
-        for (auto &display : displays_)
-        {
-            if (display)
-                display->deinitialize();
-        }
-        for (auto &rtc : rtcs_)
-        {
-            if (rtc)
-                rtc->deinitialize();
-        }
-        for (auto &conn : connections_)
-        {
-            if (conn)
-                conn->deinitialize();
+            reload_worker_.request_stop();
+            reload_worker_.join();
         }
+
+        // the re-probe thread must not touch devices being torn down
+        health_.stop();
+
+        // slots deinitialize their device, then its bus
+        publish(nullptr);
     }
 
     int atmolyt::parse_inarg(int argc, char **argv)
@@ -104,7 +100,14 @@ namespace app
             ("config,c", po::value<std::string>()->default_value("./config/atmolyt.json"), "path to config file")
             ("st,s", po::bool_switch()->default_value(false), "begin self testing hardware")
             ("st-config", po::value<std::string>()->default_value("./config/atmolyt.json"), "path to config for self-test")
-            ("st-json", po::bool_switch()->default_value(false), "output self-test results as JSON");
+            ("st-json", po::bool_switch()->default_value(false), "output self-test results as JSON")
+            ("query", po::value<std::string>(), "aggregate a channel of the CSV log, e.g. --query co2_ppm")
+            ("from", po::value<std::string>()->default_value(""), "query start: YYYY-MM-DD[ HH:MM[:SS]] or -7d/-12h/-30m")
+            ("to", po::value<std::string>()->default_value(""), "query end (exclusive), same forms as --from")
+            ("bucket", po::value<std::string>()->default_value("1h"), "query bucket: 15m, 1h, 1d or all")
+            ("log", po::value<std::string>()->default_value(""), "CSV log to query (default: log_path from the config)")
+            ("threads", po::value<unsigned>()->default_value(0), "query threads, 0 = one per core")
+            ("percentiles", po::value<std::string>()->default_value("50,95,99"), "query percentiles, comma-separated");
 
         po::variables_map vm;
         try
@@ -149,6 +152,19 @@ namespace app
             return 1;
         }
 
+        if (vm.count("query"))
+        {
+            query_command cmd;
+            cmd.channel = vm["query"].as<std::string>();
+            cmd.log_path = vm["log"].as<std::string>();
+            cmd.from = vm["from"].as<std::string>();
+            cmd.to = vm["to"].as<std::string>();
+            cmd.bucket = vm["bucket"].as<std::string>();
+            cmd.percentiles = vm["percentiles"].as<std::string>();
+            cmd.threads = vm["threads"].as<unsigned>();
+            return run_query(cmd);
+        }
+
 #else  // Fallback without boost
 
         cmdline::OptionsDescription desc("Allowed options");
@@ -158,6 +174,13 @@ namespace app
         desc.add_option("st", "s", "begin self testing hardware", "flag");
         desc.add_option("st-config", "", "path to config for self-test", "value", "./config/atmolyt.json");
         desc.add_option("st-json", "", "output self-test results as JSON", "flag");
+        desc.add_option("query", "", "aggregate a channel of the CSV log, e.g. --query co2_ppm", "value");
+        desc.add_option("from", "", "query start: YYYY-MM-DD[ HH:MM[:SS]] or -7d/-12h/-30m", "value", "");
+        desc.add_option("to", "", "query end (exclusive), same forms as --from", "value", "");
+        desc.add_option("bucket", "", "query bucket: 15m, 1h, 1d or all", "value", "1h");
+        desc.add_option("log", "", "CSV log to query (default: log_path from the config)", "value", "");
+        desc.add_option("threads", "", "query threads, 0 = one per core", "value", "0");
+        desc.add_option("percentiles", "", "query percentiles, comma-separated", "value", "50,95,99");
 
         cmdline::CommandLineParser parser(desc);
         cmdline::VariablesMap vm;
@@ -195,11 +218,40 @@ namespace app
             return 1;
         }
 
+        if (vm.has("query"))
+        {
+            query_command cmd;
+            cmd.channel = vm.get_string("query");
+            cmd.log_path = vm.get_string("log");
+            cmd.from = vm.get_string("from");
+            cmd.to = vm.get_string("to");
+            cmd.bucket = vm.get_string("bucket", "1h");
+            cmd.percentiles = vm.get_string("percentiles", "50,95,99");
+            cmd.threads = static_cast<unsigned>(vm.get_int("threads", 0));
+            return run_query(cmd);
+        }
+
 #endif
 
         return 0;
     }
 
+    int atmolyt::run_query(query_command cmd)
+    {
+        if (cmd.log_path.empty())
+        {
+            config::AppConfig cfg;
+            if (!config::load_config(config_path_, cfg))
+            {
+                std::cerr << "Failed to load config from " << config_path_ << " (or pass --log)" << std::endl;
+                return -EINVAL;
+            }
+            cmd.log_path = cfg.log_path;
+        }
+        const int rc = run_query_command(cmd, std::cout, std::cerr);
+        return rc == 0 ? 1 : rc;
+    }
+
     bool atmolyt::load_and_create_peripherals()
     {
         // try the specified config path
@@ -209,141 +261,344 @@ namespace app
             return false;
         }
 
-        for (auto &p : config_.peripherals)
+        auto diff = diff_peripherals(nullptr, config_, [this](const config::PeripheralSpec &p) { return make_slot(p); });
+
+        // Display initialization success message
+        for (auto *display : diff.next->displays) {
+            display->display_text("Initialization successful", 0, 0);
+        }
+
+        for (auto &slot : diff.added)
+            watch(*slot);
+        health_.start();
+        publish(std::move(diff.next));
+        return true;
+    }
+
+    std::shared_ptr<peripheral_slot> atmolyt::make_slot(const config::PeripheralSpec &p)
+    {
+        auto slot = std::make_shared<peripheral_slot>();
+        std::string conn = p.connection;
+        std::string type = p.type;
+        uint8_t addr = p.address;
+
+        // A recorded log through the same sensor interfaces, on any target
+        if (conn == "replay")
         {
-            std::string conn = p.connection;
-            std::string type = p.type;
-            uint8_t addr = p.address;
+            connections::replay_settings settings;
+            settings.speed = option_number(p.options, "speed", settings.speed);
+            settings.loop = option_bool(p.options, "loop", settings.loop);
+            settings.from = option_string(p.options, "from");
+            auto replay = std::make_unique<connections::replay_connection>(p.device, settings);
+            if (replay->initialize() != connections::Status::Success)
+                return nullptr;
+            auto *source = replay.get();
+            slot->connection = std::move(replay);
+
+            const peripherals::PeripheralType ptype = peripheral_factory::string_to_type(type);
+            if (ptype == peripherals::PeripheralType::SCD41 || ptype == peripherals::PeripheralType::SGP41)
+            {
+                slot->gas = std::make_unique<peripherals::replay_gas_sensor>(source);
+                slot->gas->initialize();
+            }
+            else if (ptype == peripherals::PeripheralType::BME280 || ptype == peripherals::PeripheralType::BMP280)
+            {
+                slot->environmental = std::make_unique<peripherals::replay_environmental>(source);
+                slot->environmental->initialize();
+            }
+            else
+            {
+                std::cerr << "replay plays gas (scd41, sgp41) and environmental (bme280, bmp280) sensors, not " << type
+                          << std::endl;
+                return nullptr;
+            }
+            return slot;
+        }
 
 #if TARGET_HOST
-            // use mock connection for host
-            auto mock = std::make_unique<connections::mock_addressable_connection>("mock");
-            mock->initialize();
-            connections_.push_back(std::move(mock));
-            auto *conn_ptr = connections_.back().get();
-            try {
-                peripherals::PeripheralType ptype = peripheral_factory::string_to_type(type);
-                if (ptype == peripherals::PeripheralType::BME280 ||
-                    ptype == peripherals::PeripheralType::BMP280 ||
-                    ptype == peripherals::PeripheralType::DHT22) {
-                    auto sensor = peripheral_factory::create_environmental_sensor(ptype, static_cast<connections::addressable_connection_iface<uint8_t>*>(conn_ptr), addr);
-                    if (sensor)
-                    {
-                        sensor->initialize();
-                        environmental_sensors_.push_back(std::move(sensor));
-                    }
-                } else if (ptype == peripherals::PeripheralType::SCD41 ||
-                           ptype == peripherals::PeripheralType::SGP41) {
-                    auto sensor = peripheral_factory::create_gas_sensor(ptype, static_cast<connections::addressable_connection_iface<uint8_t>*>(conn_ptr), addr);
-                    if (sensor)
-                    {
-                        sensor->initialize();
-                        gas_sensors_.push_back(std::move(sensor));
-                    }
-                } else if (ptype == peripherals::PeripheralType::SSD1306) {
-                    std::cout << "SSD1306 conn: " << conn << std::endl;
-                    connections::addressable_connection_iface<uint8_t>* display_conn = nullptr;
-                    if (conn != "fb") {
-                        // I2C mode
-                        auto i2c = std::make_unique<connections::i2c_connection>(p.device.empty() ? "/dev/i2c-2" : p.device);
-                        if (i2c->initialize() != connections::Status::Success) {
-                            std::cerr << "Failed to init i2c for display: " << p.device << std::endl;
-                            continue;
-                        }
-                        connections_.push_back(std::move(i2c));
-                        display_conn = connections_.back().get();
-                    }
-                    // For fb, display_conn remains nullptr
-                    auto display = peripheral_factory::create_display(ptype, display_conn, addr);
-                    if (display)
-                    {
-                        display->initialize();
-                        displays_.push_back(std::move(display));
-                    }
-                } else if (ptype == peripherals::PeripheralType::DS3231) {
-                    auto rtc = peripheral_factory::create_rtc(ptype, static_cast<connections::addressable_connection_iface<uint8_t>*>(conn_ptr), addr);
-                    if (rtc)
-                    {
-                        rtc->initialize();
-                        rtcs_.push_back(std::move(rtc));
+        // use mock connection for host
+        auto mock = std::make_unique<connections::mock_addressable_connection>("mock");
+        mock->initialize();
+        slot->connection = std::move(mock);
+        auto *conn_ptr = slot->connection.get();
+        try {
+            peripherals::PeripheralType ptype = peripheral_factory::string_to_type(type);
+            if (ptype == peripherals::PeripheralType::BME280 ||
+                ptype == peripherals::PeripheralType::BMP280 ||
+                ptype == peripherals::PeripheralType::DHT22) {
+                auto sensor = peripheral_factory::create_environmental_sensor(ptype, static_cast<connections::addressable_connection_iface<uint8_t>*>(conn_ptr), addr, p.options);
+                if (sensor)
+                {
+                    sensor->initialize();
+                    slot->environmental = std::move(sensor);
+                }
+            } else if (ptype == peripherals::PeripheralType::SCD41 ||
+                       ptype == peripherals::PeripheralType::SGP41) {
+                auto sensor = peripheral_factory::create_gas_sensor(ptype, static_cast<connections::addressable_connection_iface<uint8_t>*>(conn_ptr), addr, p.options);
+                if (sensor)
+                {
+                    sensor->initialize();
+                    slot->gas = std::move(sensor);
+                }
+            } else if (ptype == peripherals::PeripheralType::SSD1306) {
+                std::cout << "SSD1306 conn: " << conn << std::endl;
+                connections::addressable_connection_iface<uint8_t>* display_conn = nullptr;
+                if (conn != "fb") {
+                    // I2C mode
+                    auto i2c = std::make_unique<connections::i2c_connection>(p.device.empty() ? "/dev/i2c-2" : p.device);
+                    if (i2c->initialize() != connections::Status::Success) {
+                        std::cerr << "Failed to init i2c for display: " << p.device << std::endl;
+                        return nullptr;
                     }
-                } else {
-                    std::cerr << "Unsupported sensor type: " << type << std::endl;
+                    slot->connection = std::move(i2c);
+                    display_conn = static_cast<connections::addressable_connection_iface<uint8_t>*>(slot->connection.get());
+                }
+                // For fb, display_conn remains nullptr
+                auto display = peripheral_factory::create_display(ptype, display_conn, addr);
+                if (display)
+                {
+                    display->initialize();
+                    slot->display = std::move(display);
+                }
+            } else if (ptype == peripherals::PeripheralType::DS3231) {
+                auto rtc = peripheral_factory::create_rtc(ptype, static_cast<connections::addressable_connection_iface<uint8_t>*>(conn_ptr), addr);
+                if (rtc)
+                {
+                    rtc->initialize();
+                    slot->rtc = std::move(rtc);
                 }
-            } catch(...) {
-                std::cerr << "Failed to create sensor: " << type << std::endl;
+            } else {
+                std::cerr << "Unsupported sensor type: " << type << std::endl;
+                return nullptr;
             }
+        } catch(...) {
+            std::cerr << "Failed to create sensor: " << type << std::endl;
+            return nullptr;
+        }
 #else
-            connections::addressable_connection_iface<uint8_t>* conn_ptr = nullptr;
-            if (conn == "i2c")
+        connections::addressable_connection_iface<uint8_t>* conn_ptr = nullptr;
+        connections::gpio_line* dc_ptr = nullptr;
+        if (conn == "i2c")
+        {
+            auto i2c = std::make_unique<connections::i2c_connection>(p.device.empty() ? "/dev/i2c-1" : p.device);
+            i2c->set_transfer_timeout(std::chrono::milliseconds(option_int(p.options, "i2c_timeout_ms",
+                connections::i2c_connection::DEFAULT_TRANSFER_TIMEOUT.count())));
+            if (i2c->initialize() != connections::Status::Success)
             {
-                auto i2c = std::make_unique<connections::i2c_connection>(p.device.empty() ? "/dev/i2c-1" : p.device);
-                if (i2c->initialize() != connections::Status::Success)
-                {
-                    std::cerr << "Failed to init i2c: " << p.device << std::endl;
-                    continue;
-                }
-                connections_.push_back(std::move(i2c));
-                conn_ptr = static_cast<connections::addressable_connection_iface<uint8_t>*>(connections_.back().get());
+                std::cerr << "Failed to init i2c: " << p.device << std::endl;
+                return nullptr;
             }
-            else if (conn == "fb")
+            slot->connection = std::move(i2c);
+            conn_ptr = static_cast<connections::addressable_connection_iface<uint8_t>*>(slot->connection.get());
+        }
+        else if (conn == "spi")
+        {
+            // spidev owns chip-select; displays additionally need a D/C line
+            const bool is_display = peripheral_factory::string_to_type(type) == peripherals::PeripheralType::SSD1306;
+            connections::spi_config spi_cfg;
+            spi_cfg.speed_hz = static_cast<uint32_t>(option_int(p.options, "speed_hz", is_display ? 8000000 : spi_cfg.speed_hz));
+            spi_cfg.mode = static_cast<uint8_t>(option_int(p.options, "spi_mode", spi_cfg.mode));
+
+            auto spi = std::make_unique<connections::spi_connection>(p.device.empty() ? "/dev/spidev0.0" : p.device, spi_cfg);
+            if (spi->initialize() != connections::Status::Success)
             {
-                // framebuffer, no connection
-                conn_ptr = nullptr;
+                std::cerr << "Failed to init spi: " << p.device << std::endl;
+                return nullptr;
             }
-            else
+            slot->connection = std::move(spi);
+            conn_ptr = static_cast<connections::addressable_connection_iface<uint8_t>*>(slot->connection.get());
+
+            long dc = option_int(p.options, "dc_line", -1);
+            if (dc >= 0)
             {
-                std::cerr << "Unsupported connection type: " << conn << std::endl;
-                continue;
+                auto line = std::make_unique<connections::gpio_line>(option_string(p.options, "gpio_chip", "/dev/gpiochip0"),
+                                                                     static_cast<uint32_t>(dc));
+                if (line->initialize() != connections::Status::Success)
+                {
+                    std::cerr << "Failed to request D/C line " << dc << " on " << option_string(p.options, "gpio_chip", "/dev/gpiochip0") << std::endl;
+                    return nullptr;
+                }
+                slot->dc_line = std::move(line);
+                dc_ptr = slot->dc_line.get();
             }
-            try {
-                peripherals::PeripheralType ptype = peripheral_factory::string_to_type(type);
-                if (ptype == peripherals::PeripheralType::BME280 ||
-                    ptype == peripherals::PeripheralType::BMP280 ||
-                    ptype == peripherals::PeripheralType::DHT22) {
-                    auto sensor = peripheral_factory::create_environmental_sensor(ptype, conn_ptr, addr);
-                    if (sensor)
-                    {
-                        sensor->initialize();
-                        environmental_sensors_.push_back(std::move(sensor));
-                    }
-                } else if (ptype == peripherals::PeripheralType::SCD41 ||
-                           ptype == peripherals::PeripheralType::SGP41) {
-                    auto sensor = peripheral_factory::create_gas_sensor(ptype, conn_ptr, addr);
-                    if (sensor)
-                    {
-                        sensor->initialize();
-                        gas_sensors_.push_back(std::move(sensor));
-                    }
-                } else if (ptype == peripherals::PeripheralType::SSD1306) {
-                    auto display = peripheral_factory::create_display(ptype, conn_ptr, addr);
-                    if (display)
-                    {
-                        display->initialize();
-                        displays_.push_back(std::move(display));
-                    }
-                } else if (ptype == peripherals::PeripheralType::DS3231) {
-                    auto rtc = peripheral_factory::create_rtc(ptype, conn_ptr, addr);
-                    if (rtc)
-                    {
-                        rtc->initialize();
-                        rtcs_.push_back(std::move(rtc));
-                    }
-                } else {
-                    std::cerr << "Unsupported sensor type: " << type << std::endl;
+            else if (is_display)
+            {
+                std::cerr << "SPI display requires \"dc_line\": " << p.device << std::endl;
+                return nullptr;
+            }
+        }
+        else if (conn == "fb")
+        {
+            // framebuffer, no connection
+            conn_ptr = nullptr;
+        }
+        else
+        {
+            std::cerr << "Unsupported connection type: " << conn << std::endl;
+            return nullptr;
+        }
+        try {
+            peripherals::PeripheralType ptype = peripheral_factory::string_to_type(type);
+            if (ptype == peripherals::PeripheralType::BME280 ||
+                ptype == peripherals::PeripheralType::BMP280 ||
+                ptype == peripherals::PeripheralType::DHT22) {
+                auto sensor = peripheral_factory::create_environmental_sensor(ptype, conn_ptr, addr, p.options);
+                if (sensor)
+                {
+                    sensor->initialize();
+                    slot->environmental = std::move(sensor);
                 }
-            } catch(...) {
-                std::cerr << "Failed to create sensor: " << type << std::endl;
+            } else if (ptype == peripherals::PeripheralType::SCD41 ||
+                       ptype == peripherals::PeripheralType::SGP41) {
+                auto sensor = peripheral_factory::create_gas_sensor(ptype, conn_ptr, addr, p.options);
+                if (sensor)
+                {
+                    sensor->initialize();
+                    slot->gas = std::move(sensor);
+                }
+            } else if (ptype == peripherals::PeripheralType::SSD1306) {
+                auto display = peripheral_factory::create_display(ptype, conn_ptr, addr, dc_ptr);
+                if (display)
+                {
+                    display->initialize();
+                    slot->display = std::move(display);
+                }
+            } else if (ptype == peripherals::PeripheralType::DS3231) {
+                auto rtc = peripheral_factory::create_rtc(ptype, conn_ptr, addr);
+                if (rtc)
+                {
+                    rtc->initialize();
+                    slot->rtc = std::move(rtc);
+                }
+            } else {
+                std::cerr << "Unsupported sensor type: " << type << std::endl;
+                return nullptr;
             }
+        } catch(...) {
+            std::cerr << "Failed to create sensor: " << type << std::endl;
+            return nullptr;
+        }
 #endif
+
+        // the factory knows the type but could not build it
+        if (!slot->device())
+            return nullptr;
+        return slot;
+    }
+
+    void atmolyt::watch(const peripheral_slot &slot)
+    {
+        auto watch_device = [this](auto *raw, const char *kind) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%s@0x%02x", kind, raw->get_address());
+            auto &health = health_.add(raw, name, [raw] {
+                raw->deinitialize();
+                return raw->initialize() == peripherals::Status::Success;
+            });
+            // Devices that did not come up are retried in the background, not dropped
+            if (!raw->is_initialized())
+                health.mark_failed();
+        };
+
+        if (slot.environmental)
+            watch_device(slot.environmental.get(), "env");
+        else if (slot.gas)
+            watch_device(slot.gas.get(), "gas");
+        else if (slot.display)
+            watch_device(slot.display.get(), "display");
+    }
+
+    std::shared_ptr<const peripheral_set> atmolyt::get_peripherals() const
+    {
+        std::lock_guard<std::mutex> lock(set_mutex_);
+        return set_;
+    }
+
+    void atmolyt::publish(std::shared_ptr<const peripheral_set> set)
+    {
+        std::shared_ptr<const peripheral_set> old;
+        {
+            std::lock_guard<std::mutex> lock(set_mutex_);
+            old = std::exchange(set_, std::move(set));
         }
+        // the old snapshot (if last) is released outside the lock
+    }
 
-        // Display initialization success message
-        for (auto& display : displays_) {
-            display->display_text("Initialization successful", 0, 0);
+    void atmolyt::request_reload()
+    {
+        {
+            std::lock_guard<std::mutex> lock(reload_mutex_);
+            reload_pending_ = true;
         }
+        reload_cv_.notify_one();
+    }
 
-        return true;
+    void atmolyt::reload_loop(std::stop_token stop)
+    {
+        while (!stop.stop_requested())
+        {
+            {
+                std::unique_lock<std::mutex> lock(reload_mutex_);
+                if (!reload_cv_.wait(lock, stop, [this] { return reload_pending_; }))
+                    return;
+                reload_pending_ = false;
+            }
+            reload();
+        }
     }
 
+    void atmolyt::retire(const std::weak_ptr<const peripheral_set> &old,
+                         std::vector<std::shared_ptr<peripheral_slot>> &removed)
+    {
+        // The poll loop lets go of the old snapshot by the end of its tick
+        const std::stop_token stop = reload_worker_.get_stop_token();
+        while (!old.expired() && !stop.stop_requested())
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (auto &slot : removed)
+            health_.remove(slot->device());
+        removed.clear();
+    }
+
+    bool atmolyt::reload()
+    {
+        config::AppConfig cfg;
+        if (!config::load_config(config_path_, cfg))
+        {
+            std::cerr << "reload: keeping the running configuration" << std::endl;
+            return false;
+        }
+
+        // A replacement on the bus address of a running device (e.g. new options)
+        // comes up only after the old one is down: an SCD41 stopped or an SGP41
+        // state saved afterwards would undo the new device's setup
+        size_t replaced = 0;
+        {
+            auto current = get_peripherals();
+            auto evicted = evict_replaced(*current, cfg);
+            replaced = evicted.removed.size();
+            if (replaced)
+            {
+                std::weak_ptr<const peripheral_set> old = current;
+                current.reset();
+                publish(std::move(evicted.next));
+                retire(old, evicted.removed);
+            }
+        }
+
+        // New devices come up here, off the poll loop, which keeps sampling the old set
+        std::weak_ptr<const peripheral_set> old;
+        auto diff = [&] {
+            auto current = get_peripherals();
+            old = current;
+            return diff_peripherals(current.get(), cfg, [this](const config::PeripheralSpec &p) { return make_slot(p); });
+        }();
+        for (auto &slot : diff.added)
+            watch(*slot);
+
+        std::cerr << "reload: " << diff.next->slots.size() - diff.added.size() << " kept, " << diff.added.size()
+                  << " added, " << diff.removed.size() + replaced << " removed" << std::endl;
+        publish(std::move(diff.next));
+        retire(old, diff.removed);
+        return true;
+    }
 }
\ No newline at end of file
@@ -4,93 +4,110 @@
  * @brief  Implementation of the csv_logger class
  * @version 0.1
  * @date 2025-12-23
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 
 #include "app/csv_logger.h"
+#include "app/log_query.h"
+#include <cstdio>
+#include <ctime>
 #include <iostream>
 
 namespace app
 {
-    csv_logger::csv_logger(const std::string& filename)
+    static constexpr channel COLUMNS[] = {
+        channel::co2_ppm, channel::temperature_c, channel::pressure_pa,
+        channel::humidity_rh, channel::voc_index, channel::nox_index,
+    };
+
+    csv_logger::csv_logger(const std::string& filename, sample_bus& bus)
     {
+        // A log written with another column set is moved aside, not appended to
+        {
+            std::ifstream existing(filename);
+            std::string first_line;
+            if (existing && std::getline(existing, first_line) && first_line != HEADER) {
+                existing.close();
+                std::rename(filename.c_str(), (filename + ".old").c_str());
+                std::rename(log_index_path(filename).c_str(), log_index_path(filename + ".old").c_str());
+            }
+        }
+
         file_.open(filename, std::ios::app);
         if (!file_.is_open()) {
             std::cerr << "Failed to open CSV log file: " << filename << std::endl;
             return;
         }
-        
+
         file_.seekp(0, std::ios::end);
         if (file_.tellp() == 0) {
-            file_ << "timestamp,co2_ppm,temperature_c,pressure_pa,humidity_rh\n";
+            file_ << HEADER << "\n";
         }
+        file_.flush();
+        index_.open(filename);
 
-        worker_ = std::thread(&csv_logger::worker_thread, this);
+        feed_ = bus.subscribe("csv_logger");
+        if (!feed_) {
+            std::cerr << "CSV logger: sample bus has no free subscription" << std::endl;
+            return;
+        }
+        worker_ = std::jthread([this](std::stop_token stop) { worker_thread(stop); });
     }
 
     csv_logger::~csv_logger()
     {
-        stop_ = true;
-        cv_.notify_one();
-        
         if (worker_.joinable()) {
+            worker_.request_stop();
             worker_.join();
         }
-        
+
         if (file_.is_open()) {
             file_.close();
         }
     }
 
-    void csv_logger::log(double co2_ppm, double temp_c, double press_pa, double humidity_rh, const std::string& timestamp)
+    void csv_logger::worker_thread(std::stop_token stop)
     {
-        if (file_.is_open()) {
-            file_ << timestamp << "," << co2_ppm << "," << temp_c << "," << press_pa << "," << humidity_rh << "\n";
-            file_.flush();
+        sample_frame frame;
+        while (!stop.stop_requested()) {
+            if (feed_->wait_pop(frame, stop, std::chrono::milliseconds(1000))) {
+                write_frame(frame);
+            }
         }
-    }
 
-    void csv_logger::log_async(double co2_ppm, double temp_c, double press_pa, double humidity_rh, const std::string& timestamp)
-    {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push({co2_ppm, temp_c, press_pa, humidity_rh, timestamp});
+        while (feed_->try_pop(frame)) {
+            write_frame(frame);
         }
-        cv_.notify_one();
     }
 
-    void csv_logger::worker_thread()
+    void csv_logger::write_frame(const sample_frame& frame)
     {
-        while (!stop_) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            cv_.wait(lock, [this] { return !queue_.empty() || stop_; });
+        if (!file_.is_open()) {
+            return;
+        }
+
+        const std::time_t seconds = static_cast<std::time_t>(frame.wall_ns / 1000000000LL);
+        std::tm local_tm{};
+        localtime_r(&seconds, &local_tm);
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local_tm);
 
-            while (!queue_.empty()) {
-                LogEntry entry = queue_.front();
-                queue_.pop();
-                lock.unlock();
-                
-                write_entry(entry);
-                
-                lock.lock();
+        const auto offset = static_cast<uint64_t>(file_.tellp());
+        file_ << timestamp;
+        for (channel ch : COLUMNS) {
+            file_ << ',';
+            if (frame.has(ch)) {
+                file_ << frame.get(ch);
             }
         }
-        
-        while (!queue_.empty()) {
-            write_entry(queue_.front());
-            queue_.pop();
-        }
-    }
+        file_ << "\n";
+        file_.flush();
 
-    void csv_logger::write_entry(const LogEntry& entry)
-    {
-        if (file_.is_open()) {
-            file_ << entry.timestamp << "," << entry.co2_ppm << "," 
-                  << entry.temp_c << "," << entry.press_pa << "," 
-                  << entry.humidity_rh << "\n";
-            file_.flush();
-        }
+        // After the flush, so an entry never points past the rows on disk
+        index_.add(civil_seconds(local_tm.tm_year + 1900, local_tm.tm_mon + 1, local_tm.tm_mday, local_tm.tm_hour,
+                                 local_tm.tm_min, local_tm.tm_sec),
+                   offset);
     }
 }
@@ -0,0 +1,415 @@
+/**
+ * @file disk_spool.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Disk-backed FIFO of opaque records for store-and-forward sinks
+ * @version 0.1
+ * @date 2026-02-03
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/disk_spool.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <array>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace app
+{
+    namespace
+    {
+        constexpr size_t HEADER_SIZE = 8;
+
+        constexpr std::array<uint32_t, 256> make_crc32_table()
+        {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+                table[i] = crc;
+            }
+            return table;
+        }
+
+        constexpr std::array<uint32_t, 256> crc32_table = make_crc32_table();
+
+        uint32_t crc32(std::string_view data)
+        {
+            uint32_t crc = 0xffffffffu;
+            for (char c : data)
+                crc = crc32_table[(crc ^ static_cast<uint8_t>(c)) & 0xff] ^ (crc >> 8);
+            return crc ^ 0xffffffffu;
+        }
+
+        bool before(const spool_position &a, const spool_position &b)
+        {
+            return a.segment < b.segment || (a.segment == b.segment && a.offset < b.offset);
+        }
+
+        // "<16 hex digits>.seg"
+        bool parse_segment_name(const char *name, uint64_t &id)
+        {
+            if (std::strlen(name) != 20 || std::strcmp(name + 16, ".seg") != 0)
+                return false;
+            id = 0;
+            for (int i = 0; i < 16; ++i)
+            {
+                const char c = name[i];
+                const int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+                if (digit < 0)
+                    return false;
+                id = id << 4 | static_cast<uint64_t>(digit);
+            }
+            return id != 0;
+        }
+
+        bool read_exact(int fd, void *out, size_t size, uint64_t offset)
+        {
+            auto *p = static_cast<char *>(out);
+            while (size)
+            {
+                const ssize_t n = pread(fd, p, size, static_cast<off_t>(offset));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                p += n;
+                size -= static_cast<size_t>(n);
+                offset += static_cast<uint64_t>(n);
+            }
+            return true;
+        }
+
+        // One record at offset; false if it is cut off, oversized or fails its CRC
+        bool read_record(int fd, uint64_t offset, uint64_t limit, std::string &record)
+        {
+            if (offset + HEADER_SIZE > limit)
+                return false;
+            uint32_t header[2];
+            if (!read_exact(fd, header, sizeof(header), offset))
+                return false;
+            if (header[0] > disk_spool::MAX_RECORD || offset + HEADER_SIZE + header[0] > limit)
+                return false;
+            record.resize(header[0]);
+            return read_exact(fd, record.data(), record.size(), offset + HEADER_SIZE) && crc32(record) == header[1];
+        }
+    } // namespace
+
+    disk_spool::disk_spool(const std::string &dir, const spool_settings &settings) : dir_(dir), settings_(settings)
+    {
+        if (mkdir(dir_.c_str(), 0755) < 0 && errno != EEXIST)
+        {
+            std::cerr << "spool: cannot create " << dir_ << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+        DIR *d = opendir(dir_.c_str());
+        if (!d)
+        {
+            std::cerr << "spool: cannot open " << dir_ << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        // Only the id range and the total size are kept, however many segments there are
+        uint64_t last = 0;
+        while (dirent *entry = readdir(d))
+        {
+            uint64_t id;
+            if (!parse_segment_name(entry->d_name, id))
+                continue;
+            struct stat st{};
+            if (stat(segment_path(id).c_str(), &st) != 0)
+                continue;
+            bytes_ += static_cast<uint64_t>(st.st_size);
+            if (!first_segment_ || id < first_segment_)
+                first_segment_ = id;
+            last = std::max(last, id);
+        }
+        closedir(d);
+
+        if (!last)
+        {
+            first_segment_ = last = 1;
+            write_ = {1, 0};
+        }
+        else
+        {
+            write_ = {last, recover_tail(last)};
+        }
+        if (!open_write_segment(last))
+            return;
+
+        load_cursor();
+        read_ = committed_;
+        delete_before(committed_.segment);
+        last_sync_ = std::chrono::steady_clock::now();
+    }
+
+    disk_spool::~disk_spool()
+    {
+        if (write_fd_ >= 0)
+        {
+            sync();
+            close(write_fd_);
+        }
+        if (read_fd_ >= 0)
+            close(read_fd_);
+    }
+
+    std::string disk_spool::segment_path(uint64_t id) const
+    {
+        char name[24];
+        std::snprintf(name, sizeof(name), "%016" PRIx64 ".seg", id);
+        return dir_ + "/" + name;
+    }
+
+    bool disk_spool::open_write_segment(uint64_t id)
+    {
+        const int fd = open(segment_path(id).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            std::cerr << "spool: cannot open " << segment_path(id) << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (write_fd_ >= 0)
+            close(write_fd_);
+        write_fd_ = fd;
+        return true;
+    }
+
+    bool disk_spool::open_read_segment(uint64_t id)
+    {
+        if (read_fd_ >= 0 && read_fd_segment_ == id)
+            return true;
+        if (read_fd_ >= 0)
+            close(read_fd_);
+        read_fd_ = open(segment_path(id).c_str(), O_RDONLY | O_CLOEXEC);
+        read_fd_segment_ = id;
+        return read_fd_ >= 0;
+    }
+
+    uint64_t disk_spool::recover_tail(uint64_t id)
+    {
+        const int fd = open(segment_path(id).c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0)
+            return 0;
+        struct stat st{};
+        fstat(fd, &st);
+        const auto size = static_cast<uint64_t>(st.st_size);
+
+        // A write cut short by a crash or power loss leaves a record that does not check out
+        std::string record;
+        uint64_t end = 0;
+        while (read_record(fd, end, size, record))
+            end += HEADER_SIZE + record.size();
+        if (end < size)
+        {
+            ++corrupt_records_;
+            bytes_ -= size - end;
+            [[maybe_unused]] int rc = ftruncate(fd, static_cast<off_t>(end));
+            fdatasync(fd);
+        }
+        close(fd);
+        return end;
+    }
+
+    void disk_spool::load_cursor()
+    {
+        committed_ = {first_segment_, 0};
+
+        const int fd = open((dir_ + "/cursor").c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        char buf[96] = {};
+        const ssize_t n = ::read(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        unsigned long long segment = 0, offset = 0;
+        int version = 0;
+        if (n <= 0 || std::sscanf(buf, "atmolyt-spool %d %llu %llu", &version, &segment, &offset) != 3 || version != 1)
+            return;
+
+        const spool_position saved{segment, offset};
+        if (before(saved, committed_))
+            return; // its segment was dropped meanwhile
+        // Past the end: the tail it pointed into was cut off, nothing there to resend
+        committed_ = before(write_, saved) ? write_ : saved;
+    }
+
+    void disk_spool::save_cursor()
+    {
+        // Written aside and renamed, so a power cut leaves the old cursor or the new one
+        const std::string path = dir_ + "/cursor";
+        const std::string tmp = path + ".tmp";
+        char buf[96];
+        const int len = std::snprintf(buf, sizeof(buf), "atmolyt-spool 1 %" PRIu64 " %" PRIu64 "\n",
+                                      committed_.segment, committed_.offset);
+        const int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return;
+        const bool written = write(fd, buf, static_cast<size_t>(len)) == len && fsync(fd) == 0;
+        close(fd);
+        if (!written || std::rename(tmp.c_str(), path.c_str()) != 0)
+            return;
+        cursor_dirty_ = false;
+    }
+
+    bool disk_spool::append(std::string_view record)
+    {
+        if (write_fd_ < 0 || record.size() > MAX_RECORD)
+            return false;
+        const uint64_t need = HEADER_SIZE + record.size();
+
+        if (write_.offset && write_.offset + need > settings_.segment_bytes)
+        {
+            fdatasync(write_fd_);
+            data_dirty_ = false;
+            if (!open_write_segment(write_.segment + 1))
+                return false;
+            write_ = {write_.segment + 1, 0};
+        }
+        while (bytes_ + need > settings_.max_bytes && first_segment_ < write_.segment)
+            drop_oldest();
+
+        const uint32_t header[2] = {static_cast<uint32_t>(record.size()), crc32(record)};
+        iovec parts[2] = {{const_cast<uint32_t *>(header), sizeof(header)},
+                          {const_cast<char *>(record.data()), record.size()}};
+        ssize_t n;
+        do
+            n = writev(write_fd_, parts, 2);
+        while (n < 0 && errno == EINTR);
+        if (n != static_cast<ssize_t>(need))
+        {
+            // Disk full or failing: leave no half record behind
+            if (n > 0)
+            {
+                [[maybe_unused]] int rc = ftruncate(write_fd_, static_cast<off_t>(write_.offset));
+            }
+            return false;
+        }
+        write_.offset += need;
+        bytes_ += need;
+        data_dirty_ = true;
+        sync_if_due();
+        return true;
+    }
+
+    bool disk_spool::read(std::string &record, spool_position &next)
+    {
+        while (before(read_, write_))
+        {
+            const bool tail = read_.segment == write_.segment;
+            const uint64_t limit = tail ? write_.offset : UINT64_MAX;
+            if (open_read_segment(read_.segment) && read_record(read_fd_, read_.offset, limit, record))
+            {
+                read_.offset += HEADER_SIZE + record.size();
+                next = read_;
+                return true;
+            }
+
+            // End of a closed segment (or it is gone): on to the next one. Anything
+            // else is damage, and the rest of that segment cannot be framed.
+            struct stat st{};
+            if (read_fd_ >= 0 && (fstat(read_fd_, &st) != 0 || static_cast<uint64_t>(st.st_size) != read_.offset))
+                ++corrupt_records_;
+            if (tail)
+            {
+                read_ = write_;
+                break;
+            }
+            read_ = {read_.segment + 1, 0};
+        }
+        return false;
+    }
+
+    void disk_spool::ack(const spool_position &pos)
+    {
+        if (!before(committed_, pos))
+            return;
+        committed_ = pos;
+        if (before(read_, committed_))
+            read_ = committed_;
+        cursor_dirty_ = true;
+
+        if (committed_.segment > first_segment_)
+        {
+            // Cursor first: a crash in between then only re-reads, never skips
+            save_cursor();
+            delete_before(committed_.segment);
+        }
+        sync_if_due();
+    }
+
+    uint64_t disk_spool::backlog_bytes() const
+    {
+        return bytes_ - (committed_.segment == first_segment_ ? committed_.offset : 0);
+    }
+
+    void disk_spool::sync()
+    {
+        if (data_dirty_ && write_fd_ >= 0)
+            fdatasync(write_fd_);
+        data_dirty_ = false;
+        if (cursor_dirty_)
+            save_cursor();
+        last_sync_ = std::chrono::steady_clock::now();
+    }
+
+    void disk_spool::sync_if_due()
+    {
+        if ((data_dirty_ || cursor_dirty_) && std::chrono::steady_clock::now() - last_sync_ >= settings_.sync_interval)
+            sync();
+    }
+
+    void disk_spool::drop_oldest()
+    {
+        struct stat st{};
+        if (stat(segment_path(first_segment_).c_str(), &st) == 0)
+        {
+            unlink(segment_path(first_segment_).c_str());
+            bytes_ -= static_cast<uint64_t>(st.st_size);
+            if (++dropped_segments_ == 1)
+                std::cerr << "spool: " << dir_ << " is full, dropping its oldest segments" << std::endl;
+        }
+        if (read_fd_ >= 0 && read_fd_segment_ == first_segment_)
+        {
+            close(read_fd_);
+            read_fd_ = -1;
+        }
+        ++first_segment_;
+
+        if (before(committed_, {first_segment_, 0}))
+        {
+            committed_ = {first_segment_, 0};
+            cursor_dirty_ = true;
+        }
+        if (before(read_, committed_))
+            read_ = committed_;
+    }
+
+    void disk_spool::delete_before(uint64_t segment)
+    {
+        for (; first_segment_ < segment; ++first_segment_)
+        {
+            struct stat st{};
+            if (stat(segment_path(first_segment_).c_str(), &st) != 0)
+                continue;
+            unlink(segment_path(first_segment_).c_str());
+            bytes_ -= static_cast<uint64_t>(st.st_size);
+        }
+        if (read_fd_ >= 0 && read_fd_segment_ < first_segment_)
+        {
+            close(read_fd_);
+            read_fd_ = -1;
+        }
+    }
+
+} // namespace app
@@ -0,0 +1,201 @@
+/**
+ * @file log_index.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Sparse (time, offset) sidecar index of the CSV log
+ * @version 0.1
+ * @date 2026-02-06
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/log_index.h"
+#include "app/log_query.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace app
+{
+    static_assert(sizeof(log_index_entry) == 16, "entries are read straight from the mapping");
+
+    namespace
+    {
+        // The entry names a line of log stamped with its time
+        bool entry_matches(std::string_view log, const log_index_entry &e)
+        {
+            if (e.offset >= log.size() || (e.offset > 0 && log[e.offset - 1] != '\n'))
+                return false;
+            int64_t t;
+            return parse_log_timestamp(log.substr(e.offset, 19), t) && t == e.t;
+        }
+    } // namespace
+
+    std::string log_index_path(const std::string &log_path)
+    {
+        return log_path + ".idx";
+    }
+
+    log_index::log_index(const std::string &log_path, std::string_view log)
+    {
+        const int fd = open(log_index_path(log_path).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= LOG_INDEX_HEADER + sizeof(log_index_entry))
+        {
+            map_size_ = static_cast<size_t>(st.st_size);
+            map_ = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (map_ == MAP_FAILED)
+                map_ = nullptr;
+        }
+        ::close(fd);
+        if (!map_)
+            return;
+
+        // A torn last entry is ignored; an index of another (rotated or rewritten) log is not used
+        const auto *base = static_cast<const char *>(map_);
+        const auto *entries = reinterpret_cast<const log_index_entry *>(base + LOG_INDEX_HEADER);
+        const size_t count = (map_size_ - LOG_INDEX_HEADER) / sizeof(log_index_entry);
+        if (std::memcmp(base, LOG_INDEX_MAGIC, sizeof(LOG_INDEX_MAGIC)) == 0 && entry_matches(log, entries[0]) &&
+            entry_matches(log, entries[count - 1]))
+        {
+            entries_ = entries;
+            count_ = count;
+        }
+    }
+
+    log_index::~log_index()
+    {
+        if (map_)
+            munmap(map_, map_size_);
+    }
+
+    std::pair<size_t, size_t> log_index::window(int64_t t, size_t log_size) const
+    {
+        const log_index_entry *end = entries_ + count_;
+        const log_index_entry *first = std::partition_point(entries_, end, [t](const log_index_entry &e) { return e.t < t; });
+        const size_t lo = first == entries_ ? 0 : static_cast<size_t>(first[-1].offset);
+        const size_t hi = first == end ? log_size : static_cast<size_t>(first->offset);
+        return {lo, hi};
+    }
+
+    log_index_writer::~log_index_writer()
+    {
+        close();
+    }
+
+    bool log_index_writer::open(const std::string &log_path)
+    {
+        close();
+        entries_ = 0;
+        last_t_ = 0;
+        rows_since_ = 0;
+        const mapped_log log(log_path);
+        if (!log.ok())
+            return false;
+        const std::string_view text = log.text();
+
+        const std::string path = log_index_path(log_path);
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            std::cerr << "log index: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        // Keep what still matches the log and index only the rows after its last entry
+        size_t resume = std::min(text.size(), text.find('\n') + 1);
+        bool reuse = false;
+        struct stat st{};
+        char magic[sizeof(LOG_INDEX_MAGIC)];
+        if (fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) >= LOG_INDEX_HEADER &&
+            pread(fd_, magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic)) &&
+            std::memcmp(magic, LOG_INDEX_MAGIC, sizeof(magic)) == 0)
+        {
+            const size_t count = (static_cast<size_t>(st.st_size) - LOG_INDEX_HEADER) / sizeof(log_index_entry);
+            log_index_entry first{}, last{};
+            if (count == 0)
+            {
+                reuse = true;
+            }
+            else if (pread(fd_, &first, sizeof(first), LOG_INDEX_HEADER) == sizeof(first) &&
+                     pread(fd_, &last, sizeof(last), static_cast<off_t>(LOG_INDEX_HEADER + (count - 1) * sizeof(last))) ==
+                         sizeof(last) &&
+                     entry_matches(text, first) && entry_matches(text, last))
+            {
+                reuse = true;
+                entries_ = count;
+                last_t_ = last.t;
+                const size_t eol = text.find('\n', last.offset);
+                resume = eol == std::string_view::npos ? text.size() : eol + 1;
+            }
+            if (reuse && ftruncate(fd_, static_cast<off_t>(LOG_INDEX_HEADER + count * sizeof(log_index_entry))) != 0)
+                reuse = false;
+        }
+        if (!reuse)
+        {
+            entries_ = 0;
+            last_t_ = 0;
+            char header[LOG_INDEX_HEADER] = {};
+            std::memcpy(header, LOG_INDEX_MAGIC, sizeof(LOG_INDEX_MAGIC));
+            if (ftruncate(fd_, 0) != 0 || write(fd_, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)))
+            {
+                std::cerr << "log index: cannot write " << path << ": " << std::strerror(errno) << std::endl;
+                close();
+                return false;
+            }
+        }
+
+        for (size_t pos = resume; pos < text.size();)
+        {
+            size_t eol = text.find('\n', pos);
+            if (eol == std::string_view::npos)
+                break; // a row being written; it is added when the logger appends
+            int64_t t;
+            if (parse_log_timestamp(text.substr(pos, eol - pos), t))
+                add(t, pos);
+            pos = eol + 1;
+        }
+        return fd_ >= 0;
+    }
+
+    void log_index_writer::close()
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+        fd_ = -1;
+    }
+
+    void log_index_writer::add(int64_t t, uint64_t offset)
+    {
+        if (fd_ < 0)
+            return;
+        const bool due = entries_ == 0 || (t >= last_t_ && (rows_since_ + 1 >= EVERY_ROWS || t - last_t_ >= EVERY_SECONDS));
+        if (due && append(t, offset))
+            rows_since_ = 0;
+        else
+            ++rows_since_;
+    }
+
+    bool log_index_writer::append(int64_t t, uint64_t offset)
+    {
+        const log_index_entry e{t, offset};
+        if (write(fd_, &e, sizeof(e)) != static_cast<ssize_t>(sizeof(e)))
+        {
+            // Drop a partial entry so the file stays a whole number of entries
+            if (ftruncate(fd_, static_cast<off_t>(LOG_INDEX_HEADER + entries_ * sizeof(e))) != 0)
+                close();
+            return false;
+        }
+        ++entries_;
+        last_t_ = t;
+        return true;
+    }
+
+} // namespace app
@@ -0,0 +1,559 @@
+/**
+ * @file log_query.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Grouped aggregates over the CSV log: mmap, time-range bisection, parallel parse
+ * @version 0.1
+ * @date 2026-02-04
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/log_query.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+namespace app
+{
+    namespace
+    {
+        // Howard Hinnant's days_from_civil / civil_from_days
+        int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+        {
+            y -= m <= 2;
+            const int64_t era = (y >= 0 ? y : y - 399) / 400;
+            const unsigned yoe = static_cast<unsigned>(y - era * 400);
+            const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + static_cast<int64_t>(doe) - 719468;
+        }
+
+        void civil_from_days(int64_t z, int64_t &y, unsigned &m, unsigned &d)
+        {
+            z += 719468;
+            const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+            const unsigned doe = static_cast<unsigned>(z - era * 146097);
+            const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const unsigned mp = (5 * doy + 2) / 153;
+            d = doy - (153 * mp + 2) / 5 + 1;
+            m = mp < 10 ? mp + 3 : mp - 9;
+            y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+        }
+
+        int64_t floor_div(int64_t a, int64_t b)
+        {
+            return a / b - (a % b != 0 && (a < 0) != (b < 0));
+        }
+
+        bool digits(std::string_view text, size_t pos, size_t count, int &out)
+        {
+            int value = 0;
+            for (size_t i = pos; i < pos + count; ++i)
+            {
+                const unsigned digit = static_cast<unsigned>(text[i] - '0');
+                if (digit > 9)
+                    return false;
+                value = value * 10 + static_cast<int>(digit);
+            }
+            out = value;
+            return true;
+        }
+
+        size_t line_end(std::string_view text, size_t pos)
+        {
+            const void *nl = std::memchr(text.data() + pos, '\n', text.size() - pos);
+            return nl ? static_cast<size_t>(static_cast<const char *>(nl) - text.data()) : text.size();
+        }
+
+        // First line start at or after pos
+        size_t line_start(std::string_view text, size_t pos)
+        {
+            if (pos == 0 || pos >= text.size() || text[pos - 1] == '\n')
+                return std::min(pos, text.size());
+            const size_t eol = line_end(text, pos);
+            return eol < text.size() ? eol + 1 : text.size();
+        }
+
+        // Per chunk and bucket; the parallel parts are concatenated in chunk order
+        struct partial
+        {
+            int64_t key = 0;
+            int64_t first = 0;
+            uint64_t count = 0;
+            double min = 0;
+            double max = 0;
+            double sum = 0;
+            std::vector<float> values;
+        };
+
+        struct chunk_result
+        {
+            std::vector<partial> parts;
+            uint64_t rows = 0;
+        };
+
+        void scan_chunk(std::string_view log, size_t begin, size_t end, size_t column, const query_spec &spec,
+                        chunk_result &out)
+        {
+            constexpr int64_t SINGLE = std::numeric_limits<int64_t>::min();
+            const bool keep_values = !spec.percentiles.empty();
+            partial *current = nullptr;
+
+            size_t pos = begin;
+            while (pos < end)
+            {
+                const size_t eol = line_end(log, pos);
+                const std::string_view line = log.substr(pos, eol - pos);
+                pos = eol + 1;
+
+                int64_t t;
+                if (!parse_log_timestamp(line, t) || t < spec.from || t >= spec.to)
+                    continue;
+                ++out.rows;
+
+                // Walk to the column; a row without the channel leaves it empty
+                size_t field = 19;
+                for (size_t c = 0; c < column && field < line.size(); ++c)
+                {
+                    const size_t comma = line.find(',', field);
+                    field = comma == std::string_view::npos ? line.size() : comma + 1;
+                }
+                if (field >= line.size())
+                    continue;
+                const char *first = line.data() + field;
+                const char *last = line.data() + line.size();
+                if (const void *comma = std::memchr(first, ',', static_cast<size_t>(last - first)))
+                    last = static_cast<const char *>(comma);
+                double value;
+                const auto parsed = std::from_chars(first, last, value);
+                if (parsed.ec != std::errc() || parsed.ptr == first)
+                    continue;
+
+                const int64_t key = spec.bucket_s > 0 ? floor_div(t, spec.bucket_s) * spec.bucket_s : SINGLE;
+                if (!current || current->key != key)
+                {
+                    current = &out.parts.emplace_back();
+                    current->key = key;
+                    current->first = t;
+                    current->min = current->max = value;
+                }
+                ++current->count;
+                current->min = std::min(current->min, value);
+                current->max = std::max(current->max, value);
+                current->sum += value;
+                if (keep_values)
+                    current->values.push_back(static_cast<float>(value));
+            }
+        }
+
+        double percentile(const std::vector<float> &sorted, double p)
+        {
+            if (sorted.empty())
+                return 0;
+            const double rank = std::clamp(p, 0.0, 100.0) / 100 * static_cast<double>(sorted.size() - 1);
+            const size_t lo = static_cast<size_t>(rank);
+            const size_t hi = std::min(lo + 1, sorted.size() - 1);
+            return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - static_cast<double>(lo));
+        }
+    } // namespace
+
+    int64_t civil_seconds(int year, int month, int day, int hour, int minute, int second)
+    {
+        return days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+               hour * 3600 + minute * 60 + second;
+    }
+
+    bool parse_log_timestamp(std::string_view text, int64_t &civil)
+    {
+        int y, mo, d, h, mi, s;
+        if (text.size() < 19 || text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' ||
+            text[16] != ':')
+            return false;
+        if (!digits(text, 0, 4, y) || !digits(text, 5, 2, mo) || !digits(text, 8, 2, d) || !digits(text, 11, 2, h) ||
+            !digits(text, 14, 2, mi) || !digits(text, 17, 2, s))
+            return false;
+        if (mo < 1 || mo > 12 || d < 1 || d > 31)
+            return false;
+        civil = civil_seconds(y, mo, d, h, mi, s);
+        return true;
+    }
+
+    bool parse_query_duration(std::string_view text, int64_t &seconds)
+    {
+        if (text == "all" || text == "0")
+        {
+            seconds = 0;
+            return true;
+        }
+        int64_t n = 0;
+        const auto parsed = std::from_chars(text.data(), text.data() + text.size(), n);
+        if (parsed.ec != std::errc() || n <= 0)
+            return false;
+        const std::string_view unit(parsed.ptr, static_cast<size_t>(text.data() + text.size() - parsed.ptr));
+        int64_t scale;
+        if (unit.empty() || unit == "s")
+            scale = 1;
+        else if (unit == "m")
+            scale = 60;
+        else if (unit == "h")
+            scale = 3600;
+        else if (unit == "d")
+            scale = 86400;
+        else if (unit == "w")
+            scale = 7 * 86400;
+        else
+            return false;
+        seconds = n * scale;
+        return true;
+    }
+
+    bool parse_query_time(std::string_view text, int64_t now_civil, int64_t &civil)
+    {
+        if (!text.empty() && text[0] == '-')
+        {
+            int64_t back;
+            if (!parse_query_duration(text.substr(1), back) || back == 0)
+                return false;
+            civil = now_civil - back;
+            return true;
+        }
+
+        int y, mo, d, h = 0, mi = 0, s = 0;
+        if ((text.size() != 10 && text.size() != 16 && text.size() != 19) || text[4] != '-' || text[7] != '-' ||
+            !digits(text, 0, 4, y) || !digits(text, 5, 2, mo) || !digits(text, 8, 2, d))
+            return false;
+        if (text.size() >= 16 && ((text[10] != ' ' && text[10] != 'T') || text[13] != ':' || !digits(text, 11, 2, h) ||
+                                  !digits(text, 14, 2, mi)))
+            return false;
+        if (text.size() == 19 && (text[16] != ':' || !digits(text, 17, 2, s)))
+            return false;
+        if (mo < 1 || mo > 12 || d < 1 || d > 31)
+            return false;
+        civil = civil_seconds(y, mo, d, h, mi, s);
+        return true;
+    }
+
+    std::string format_civil(int64_t civil)
+    {
+        int64_t y;
+        unsigned m, d;
+        const int64_t days = floor_div(civil, 86400);
+        const int64_t rest = civil - days * 86400;
+        civil_from_days(days, y, m, d);
+        char buf[128]; // room for every field at its type's widest, not just a real date
+        std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02u %02lld:%02lld:%02lld", static_cast<long long>(y), m, d,
+                      static_cast<long long>(rest / 3600), static_cast<long long>(rest / 60 % 60),
+                      static_cast<long long>(rest % 60));
+        return buf;
+    }
+
+    int64_t civil_now()
+    {
+        const std::time_t now = std::time(nullptr);
+        std::tm local{};
+        localtime_r(&now, &local);
+        return civil_seconds(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min,
+                             local.tm_sec);
+    }
+
+    mapped_log::mapped_log(const std::string &path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            if (st.st_size == 0)
+            {
+                ok_empty_ = true;
+            }
+            else
+            {
+                void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED)
+                {
+                    data_ = static_cast<const char *>(p);
+                    size_ = static_cast<size_t>(st.st_size);
+                }
+            }
+        }
+        close(fd);
+    }
+
+    mapped_log::~mapped_log()
+    {
+        if (data_)
+            munmap(const_cast<char *>(data_), size_);
+    }
+
+    size_t find_log_time(std::string_view body, size_t begin, int64_t t, size_t end)
+    {
+        // Timestamp of the first parsable row at or after line start pos, and where that row starts
+        auto probe = [&](size_t pos, size_t limit, int64_t &ts) {
+            while (pos < limit)
+            {
+                const size_t eol = line_end(body, pos);
+                if (parse_log_timestamp(body.substr(pos, eol - pos), ts))
+                    return pos;
+                pos = eol + 1;
+            }
+            return limit;
+        };
+
+        size_t lo = line_start(body, begin);                     // every row before lo is earlier than t
+        size_t hi = std::max(lo, std::min(end, body.size())); // a line start; the row there (if any) is at t or later
+        while (hi - lo > 512)
+        {
+            const size_t mid = line_start(body, lo + (hi - lo) / 2);
+            if (mid >= hi)
+                break; // one long line left
+            int64_t ts;
+            const size_t row = probe(mid, hi, ts);
+            if (row >= hi)
+            {
+                hi = mid; // nothing parsable past mid
+                continue;
+            }
+            if (ts < t)
+                lo = line_start(body, row + 1);
+            else
+                hi = row;
+        }
+        // The last few rows one by one
+        while (lo < hi)
+        {
+            int64_t ts;
+            const size_t row = probe(lo, hi, ts);
+            if (row >= hi || ts >= t)
+                return row;
+            lo = line_start(body, row + 1);
+        }
+        return hi;
+    }
+
+    query_result run_log_query(std::string_view log, const query_spec &spec, const log_index *index)
+    {
+        query_result result;
+
+        const size_t header_end = line_end(log, 0);
+        const std::string_view header = log.substr(0, header_end);
+        const std::string_view name = channel_name(spec.ch);
+        size_t column = 0;
+        bool found = false;
+        for (size_t pos = 0, col = 0; pos <= header.size(); ++col)
+        {
+            size_t comma = header.find(',', pos);
+            if (comma == std::string_view::npos)
+                comma = header.size();
+            if (header.substr(pos, comma - pos) == name)
+            {
+                column = col;
+                found = true;
+                break;
+            }
+            pos = comma + 1;
+        }
+        if (!found || column == 0)
+        {
+            result.error = "the log has no column " + std::string(name);
+            return result;
+        }
+
+        // The log grows in time order: the range is two bisections away, over
+        // the index if there is one and then within the few rows it brackets
+        const size_t body = line_start(log, header_end + 1);
+        auto locate = [&](int64_t t, size_t from) {
+            if (!index)
+                return find_log_time(log, from, t);
+            const auto [lo, hi] = index->window(t, log.size());
+            return find_log_time(log, std::max(lo, from), t, std::max(hi, from));
+        };
+        result.indexed = index != nullptr;
+        const size_t begin = spec.from == std::numeric_limits<int64_t>::min() ? body : locate(spec.from, body);
+        const size_t end = spec.to == std::numeric_limits<int64_t>::max() ? log.size() : locate(spec.to, begin);
+        result.bytes = end > begin ? end - begin : 0;
+
+        // One chunk per core but none under 1 MiB unless asked for, cut at line starts
+        unsigned threads = spec.threads;
+        if (threads == 0)
+            threads = static_cast<unsigned>(
+                std::clamp<size_t>(result.bytes >> 20, 1, std::max(1u, std::thread::hardware_concurrency())));
+        threads = static_cast<unsigned>(std::clamp<size_t>(result.bytes >> 12, 1, threads));
+        result.threads = threads;
+        std::vector<size_t> cuts(threads + 1);
+        cuts[0] = begin;
+        cuts[threads] = std::max(begin, end);
+        for (unsigned i = 1; i < threads; ++i)
+            cuts[i] = std::min(line_start(log, begin + result.bytes * i / threads), cuts[threads]);
+
+        std::vector<chunk_result> chunks(threads);
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned i = 1; i < threads; ++i)
+                workers.emplace_back([&, i] { scan_chunk(log, cuts[i], cuts[i + 1], column, spec, chunks[i]); });
+            scan_chunk(log, cuts[0], cuts[1], column, spec, chunks[0]);
+        }
+
+        // Stitch: a bucket cut by a chunk boundary arrives in two parts; a clock
+        // step back can bring an earlier bucket again, hence the sort
+        std::vector<partial> parts;
+        for (chunk_result &c : chunks)
+        {
+            result.rows += c.rows;
+            for (partial &p : c.parts)
+                parts.push_back(std::move(p));
+        }
+        std::stable_sort(parts.begin(), parts.end(), [](const partial &a, const partial &b) { return a.key < b.key; });
+
+        for (size_t i = 0; i < parts.size();)
+        {
+            partial merged = std::move(parts[i]);
+            for (++i; i < parts.size() && parts[i].key == merged.key; ++i)
+            {
+                merged.count += parts[i].count;
+                merged.min = std::min(merged.min, parts[i].min);
+                merged.max = std::max(merged.max, parts[i].max);
+                merged.sum += parts[i].sum;
+                merged.first = std::min(merged.first, parts[i].first);
+                merged.values.insert(merged.values.end(), parts[i].values.begin(), parts[i].values.end());
+            }
+
+            query_bucket bucket;
+            bucket.start = spec.bucket_s > 0 ? merged.key : merged.first;
+            bucket.count = merged.count;
+            bucket.min = merged.min;
+            bucket.max = merged.max;
+            bucket.mean = merged.sum / static_cast<double>(merged.count);
+            if (!spec.percentiles.empty())
+            {
+                std::sort(merged.values.begin(), merged.values.end());
+                for (double p : spec.percentiles)
+                    bucket.percentiles.push_back(percentile(merged.values, p));
+            }
+            result.buckets.push_back(std::move(bucket));
+        }
+        result.ok = true;
+        return result;
+    }
+
+    void print_query_result(const query_result &result, const query_spec &spec, std::ostream &out)
+    {
+        char buf[64];
+        out << "bucket,count,min,max,mean";
+        for (double p : spec.percentiles)
+        {
+            std::snprintf(buf, sizeof(buf), ",p%g", p);
+            out << buf;
+        }
+        out << '\n';
+        for (const query_bucket &b : result.buckets)
+        {
+            out << format_civil(b.start) << ',' << b.count;
+            for (double v : {b.min, b.max, b.mean})
+            {
+                std::snprintf(buf, sizeof(buf), ",%.6g", v);
+                out << buf;
+            }
+            for (double v : b.percentiles)
+            {
+                std::snprintf(buf, sizeof(buf), ",%.6g", v);
+                out << buf;
+            }
+            out << '\n';
+        }
+    }
+
+    int run_query_command(const query_command &cmd, std::ostream &out, std::ostream &err)
+    {
+        query_spec spec;
+        bool known = false;
+        for (size_t i = 0; i < CHANNEL_COUNT && !known; ++i)
+        {
+            if (cmd.channel == channel_name(channel(i)))
+            {
+                spec.ch = channel(i);
+                known = true;
+            }
+        }
+        if (!known)
+        {
+            err << "query: unknown channel '" << cmd.channel << "'\n";
+            return -EINVAL;
+        }
+
+        const int64_t now = civil_now();
+        if (!cmd.from.empty() && !parse_query_time(cmd.from, now, spec.from))
+        {
+            err << "query: bad --from '" << cmd.from << "'\n";
+            return -EINVAL;
+        }
+        if (!cmd.to.empty() && !parse_query_time(cmd.to, now, spec.to))
+        {
+            err << "query: bad --to '" << cmd.to << "'\n";
+            return -EINVAL;
+        }
+        if (!parse_query_duration(cmd.bucket, spec.bucket_s))
+        {
+            err << "query: bad --bucket '" << cmd.bucket << "'\n";
+            return -EINVAL;
+        }
+        spec.percentiles.clear();
+        for (size_t pos = 0; pos < cmd.percentiles.size();)
+        {
+            size_t comma = cmd.percentiles.find(',', pos);
+            if (comma == std::string::npos)
+                comma = cmd.percentiles.size();
+            double p;
+            const char *first = cmd.percentiles.data() + pos;
+            const char *last = cmd.percentiles.data() + comma;
+            const auto parsed = std::from_chars(first, last, p);
+            if (parsed.ec != std::errc() || parsed.ptr != last || p < 0 || p > 100)
+            {
+                err << "query: bad --percentiles '" << cmd.percentiles << "'\n";
+                return -EINVAL;
+            }
+            spec.percentiles.push_back(p);
+            pos = comma + 1;
+        }
+        spec.threads = cmd.threads;
+
+        const mapped_log log(cmd.log_path);
+        if (!log.ok())
+        {
+            err << "query: cannot read " << cmd.log_path << ": " << std::strerror(errno) << "\n";
+            return -EIO;
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        const log_index index(cmd.log_path, log.text());
+        const query_result result = run_log_query(log.text(), spec, index.ok() ? &index : nullptr);
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started);
+        if (!result.ok)
+        {
+            err << "query: " << result.error << "\n";
+            return -EINVAL;
+        }
+        print_query_result(result, spec, out);
+
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "query: %llu rows, %.1f MB in %.1f ms on %u thread(s)%s\n",
+                      static_cast<unsigned long long>(result.rows), static_cast<double>(result.bytes) / 1e6,
+                      elapsed.count(), result.threads, result.indexed ? ", indexed" : "");
+        err << buf;
+        return 0;
+    }
+
+} // namespace app
@@ -0,0 +1,547 @@
+/**
+ * @file metrics_server.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Prometheus text exposition over a minimal HTTP/1.1 listener
+ * @version 0.1
+ * @date 2026-01-30
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/metrics_server.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace app
+{
+    static void appendf(std::string &out, const char *fmt, ...)
+    {
+        char buf[256];
+        va_list args;
+        va_start(args, fmt);
+        int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        if (n > 0)
+            out.append(buf, std::min<size_t>(static_cast<size_t>(n), sizeof(buf) - 1));
+    }
+
+    static void append_value(std::string &out, double value)
+    {
+        if (std::isnan(value))
+            out += "NaN";
+        else if (std::isinf(value))
+            out += value > 0 ? "+Inf" : "-Inf";
+        else
+            appendf(out, "%.10g", value);
+    }
+
+    static void append_label(std::string &out, const char *name, const std::string &value)
+    {
+        out += '{';
+        out += name;
+        out += "=\"";
+        for (char c : value)
+        {
+            if (c == '\\' || c == '"')
+                out += '\\';
+            if (c == '\n')
+            {
+                out += "\\n";
+                continue;
+            }
+            out += c;
+        }
+        out += "\"}";
+    }
+
+    static void append_family(std::string &out, const char *name, const char *type, const char *help)
+    {
+        appendf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    static void append_sample(std::string &out, const char *name, const char *label, const std::string &label_value,
+                              double value)
+    {
+        out += name;
+        append_label(out, label, label_value);
+        out += ' ';
+        append_value(out, value);
+        out += '\n';
+    }
+
+    void render_metrics(const sample_bus &bus, const health_monitor *health, std::string &out)
+    {
+        std::array<sample_bus::latest_value, CHANNEL_COUNT> latest;
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+            latest[i] = bus.latest(channel(i));
+
+        append_family(out, "atmolyt_reading", "gauge", "Latest value per measurement channel.");
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+            if (latest[i].valid)
+                append_sample(out, "atmolyt_reading", "channel", channel_name(channel(i)), latest[i].value);
+
+        append_family(out, "atmolyt_reading_timestamp_seconds", "gauge", "Wall time of the latest value per channel.");
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+            if (latest[i].valid)
+                append_sample(out, "atmolyt_reading_timestamp_seconds", "channel", channel_name(channel(i)),
+                              static_cast<double>(latest[i].wall_ns) / 1e9);
+
+        // Copied out under the monitor's lock, written without it
+        struct device_row
+        {
+            std::string name;
+            bool up;
+            uint32_t consecutive_failures;
+            uint64_t errors;
+            uint32_t recoveries;
+            uint64_t reads;
+            double read_seconds;
+            double last_read_seconds;
+        };
+        std::vector<device_row> devices;
+        if (health)
+        {
+            health->for_each([&devices](const peripheral_health &entry) {
+                devices.push_back({entry.name(), entry.usable(), entry.consecutive_failures(), entry.errors(),
+                                   entry.recoveries(), entry.reads(),
+                                   static_cast<double>(entry.read_time().count()) / 1e6,
+                                   static_cast<double>(entry.last_read_time().count()) / 1e6});
+            });
+        }
+
+        append_family(out, "atmolyt_peripheral_up", "gauge",
+                      "1 while the device is polled, 0 while it is failed and re-probed.");
+        for (const auto &d : devices)
+            append_sample(out, "atmolyt_peripheral_up", "device", d.name, d.up ? 1 : 0);
+
+        append_family(out, "atmolyt_peripheral_consecutive_failures", "gauge", "Bus errors since the last good read.");
+        for (const auto &d : devices)
+            append_sample(out, "atmolyt_peripheral_consecutive_failures", "device", d.name, d.consecutive_failures);
+
+        append_family(out, "atmolyt_peripheral_errors_total", "counter", "Reads that failed on the bus.");
+        for (const auto &d : devices)
+            append_sample(out, "atmolyt_peripheral_errors_total", "device", d.name, static_cast<double>(d.errors));
+
+        append_family(out, "atmolyt_peripheral_recoveries_total", "counter", "Failed devices brought back by a re-probe.");
+        for (const auto &d : devices)
+            append_sample(out, "atmolyt_peripheral_recoveries_total", "device", d.name, d.recoveries);
+
+        append_family(out, "atmolyt_peripheral_read_duration_seconds", "summary", "Time spent in device reads.");
+        for (const auto &d : devices)
+        {
+            append_sample(out, "atmolyt_peripheral_read_duration_seconds_sum", "device", d.name, d.read_seconds);
+            append_sample(out, "atmolyt_peripheral_read_duration_seconds_count", "device", d.name,
+                          static_cast<double>(d.reads));
+        }
+
+        append_family(out, "atmolyt_peripheral_last_read_duration_seconds", "gauge", "Duration of the latest read.");
+        for (const auto &d : devices)
+            append_sample(out, "atmolyt_peripheral_last_read_duration_seconds", "device", d.name, d.last_read_seconds);
+
+        append_family(out, "atmolyt_subscriber_queue_depth", "gauge", "Frames waiting in a sample bus subscriber queue.");
+        bus.for_each_subscriber([&out](const sample_bus::subscription &sub) {
+            append_sample(out, "atmolyt_subscriber_queue_depth", "subscriber", sub.name(), static_cast<double>(sub.depth()));
+        });
+
+        append_family(out, "atmolyt_subscriber_dropped_total", "counter", "Frames lost by a subscriber that fell behind.");
+        bus.for_each_subscriber([&out](const sample_bus::subscription &sub) {
+            append_sample(out, "atmolyt_subscriber_dropped_total", "subscriber", sub.name(), static_cast<double>(sub.dropped()));
+        });
+    }
+
+    bool parse_listen_address(const std::string &listen, std::string &host, uint16_t &port)
+    {
+        const size_t colon = listen.rfind(':');
+        if (colon == std::string::npos || colon + 1 == listen.size())
+            return false;
+        unsigned long value = 0;
+        for (size_t i = colon + 1; i < listen.size(); ++i)
+        {
+            if (listen[i] < '0' || listen[i] > '9')
+                return false;
+            value = value * 10 + static_cast<unsigned long>(listen[i] - '0');
+            if (value > 65535)
+                return false;
+        }
+        host = listen.substr(0, colon);
+        port = static_cast<uint16_t>(value);
+        return true;
+    }
+
+    static std::shared_ptr<const std::string> make_response(const char *status, std::string_view body)
+    {
+        std::string response;
+        response.reserve(body.size() + 128);
+        appendf(response,
+                "HTTP/1.1 %s\r\n"
+                "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                "Content-Length: %zu\r\n"
+                "\r\n",
+                status, body.size());
+        response += body;
+        return std::make_shared<const std::string>(std::move(response));
+    }
+
+    metrics_server::metrics_server(const std::string &host, uint16_t port, sample_bus &bus,
+                                   const health_monitor *health)
+        : bus_(bus), health_(health)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        const std::string ip = host == "localhost" ? "127.0.0.1" : host;
+        if (ip.empty() || ip == "*")
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        else if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1)
+        {
+            std::cerr << "metrics: not an IPv4 address: " << host << std::endl;
+            return;
+        }
+
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            std::cerr << "metrics: socket: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 128) < 0)
+        {
+            std::cerr << "metrics: cannot listen on " << host << ":" << port << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+            return;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd_ < 0 || wake_fd_ < 0)
+        {
+            std::cerr << "metrics: epoll: " << std::strerror(errno) << std::endl;
+            close(fd);
+            return;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        ev.data.fd = wake_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+        listen_fd_ = fd;
+
+        // Served until the first frame arrives: no readings yet, counters as they are
+        render();
+        feed_ = bus.subscribe("metrics");
+        if (feed_)
+            render_worker_ = std::jthread([this](std::stop_token stop) { render_loop(stop); });
+        else
+            std::cerr << "metrics: sample bus has no free subscription, readings will not update" << std::endl;
+        serve_worker_ = std::jthread([this](std::stop_token stop) { serve_loop(stop); });
+    }
+
+    metrics_server::~metrics_server()
+    {
+        if (serve_worker_.joinable())
+        {
+            serve_worker_.request_stop();
+            serve_worker_.join();
+        }
+        if (render_worker_.joinable())
+        {
+            render_worker_.request_stop();
+            render_worker_.join();
+        }
+        for (auto &entry : connections_)
+            close(entry.first);
+        connections_.clear();
+        if (listen_fd_ >= 0)
+            close(listen_fd_);
+        if (wake_fd_ >= 0)
+            close(wake_fd_);
+        if (epoll_fd_ >= 0)
+            close(epoll_fd_);
+    }
+
+    void metrics_server::render()
+    {
+        std::string body;
+        body.reserve(4096);
+        render_metrics(bus_, health_, body);
+        std::atomic_store(&response_, make_response("200 OK", body));
+        renders_.fetch_add(1, std::memory_order_release);
+    }
+
+    void metrics_server::render_loop(std::stop_token stop)
+    {
+        sample_frame frame;
+        while (!stop.stop_requested())
+        {
+            if (!feed_->wait_pop(frame, stop, std::chrono::milliseconds(1000)))
+                continue;
+            // A backlog is rendered once, from the bus's latest values
+            while (feed_->try_pop(frame))
+            {
+            }
+            render();
+        }
+    }
+
+    void metrics_server::serve_loop(std::stop_token stop)
+    {
+        std::stop_callback wake(stop, [this] {
+            const uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = write(wake_fd_, &one, sizeof(one));
+        });
+
+        epoll_event events[64];
+        while (!stop.stop_requested())
+        {
+            const int n = epoll_wait(epoll_fd_, events, 64, -1);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "metrics: epoll_wait: " << std::strerror(errno) << std::endl;
+                return;
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                const int fd = events[i].data.fd;
+                if (fd == wake_fd_)
+                    return;
+                if (fd == listen_fd_)
+                {
+                    accept_all();
+                    continue;
+                }
+
+                auto it = connections_.find(fd);
+                if (it == connections_.end())
+                    continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    close_connection(fd);
+                    continue;
+                }
+                if ((events[i].events & EPOLLIN) && !on_readable(fd, it->second))
+                    continue;
+                if (events[i].events & EPOLLOUT)
+                    handle_requests(fd, it->second);
+            }
+        }
+    }
+
+    void metrics_server::accept_all()
+    {
+        for (;;)
+        {
+            const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                return; // EAGAIN, or out of descriptors until some close
+            }
+            if (connections_.size() >= MAX_CONNECTIONS)
+            {
+                close(fd);
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0)
+            {
+                close(fd);
+                continue;
+            }
+            connections_.emplace(fd, connection{});
+        }
+    }
+
+    bool metrics_server::on_readable(int fd, connection &conn)
+    {
+        bool peer_closed = false;
+        char buf[4096];
+        while (conn.in.size() <= MAX_REQUEST_SIZE)
+        {
+            const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n > 0)
+            {
+                conn.in.append(buf, static_cast<size_t>(n));
+                continue;
+            }
+            if (n == 0)
+            {
+                peer_closed = true;
+                break;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            close_connection(fd);
+            return false;
+        }
+
+        if (!handle_requests(fd, conn))
+            return false;
+        if (peer_closed)
+        {
+            // Answer what was asked, then hang up
+            if (!conn.out)
+            {
+                close_connection(fd);
+                return false;
+            }
+            conn.close_after = true;
+        }
+        return true;
+    }
+
+    bool metrics_server::handle_requests(int fd, connection &conn)
+    {
+        static const auto not_found = make_response("404 Not Found", "Only /metrics is served here\n");
+        static const auto bad_method = make_response("405 Method Not Allowed", "Only GET is supported\n");
+        static const auto bad_request = make_response("400 Bad Request", "");
+
+        for (;;)
+        {
+            // Pending output first; pipelined requests wait behind it
+            while (conn.out && conn.out_pos < conn.out_end)
+            {
+                const ssize_t n = send(fd, conn.out->data() + conn.out_pos, conn.out_end - conn.out_pos, MSG_NOSIGNAL);
+                if (n > 0)
+                {
+                    conn.out_pos += static_cast<size_t>(n);
+                    continue;
+                }
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    epoll_event ev{};
+                    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+                    ev.data.fd = fd;
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+                    conn.writing = true;
+                    return true;
+                }
+                close_connection(fd);
+                return false;
+            }
+            if (conn.out)
+            {
+                conn.out.reset();
+                if (conn.close_after)
+                {
+                    close_connection(fd);
+                    return false;
+                }
+                if (conn.writing)
+                {
+                    epoll_event ev{};
+                    ev.events = EPOLLIN | EPOLLRDHUP;
+                    ev.data.fd = fd;
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+                    conn.writing = false;
+                }
+            }
+
+            const size_t head_end = conn.in.find("\r\n\r\n");
+            if (head_end == std::string::npos)
+            {
+                if (conn.in.size() <= MAX_REQUEST_SIZE)
+                    return true;
+                conn.in.clear();
+                conn.out = bad_request;
+                conn.close_after = true;
+            }
+            else
+            {
+                const std::string_view head(conn.in.data(), head_end);
+                const std::string_view line = head.substr(0, head.find("\r\n"));
+                const size_t sp1 = line.find(' ');
+                const size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+                const std::string_view method = line.substr(0, sp1);
+                const std::string_view target =
+                    sp2 == std::string_view::npos ? std::string_view() : line.substr(sp1 + 1, sp2 - sp1 - 1);
+                const std::string_view version = sp2 == std::string_view::npos ? std::string_view() : line.substr(sp2 + 1);
+
+                // HTTP/1.1 keeps the connection unless asked not to, 1.0 only when asked
+                bool keep_alive = version == "HTTP/1.1";
+                bool has_body = false;
+                size_t pos = line.size();
+                while (pos < head.size())
+                {
+                    pos += 2;
+                    size_t eol = head.find("\r\n", pos);
+                    if (eol == std::string_view::npos)
+                        eol = head.size();
+                    std::string header(head.substr(pos, eol - pos));
+                    for (char &c : header)
+                        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                    if (header.rfind("connection:", 0) == 0)
+                    {
+                        if (header.find("close") != std::string::npos)
+                            keep_alive = false;
+                        else if (header.find("keep-alive") != std::string::npos)
+                            keep_alive = true;
+                    }
+                    else if ((header.rfind("content-length:", 0) == 0 && header.find_first_not_of(" 0", 15) != std::string::npos) ||
+                             header.rfind("transfer-encoding:", 0) == 0)
+                    {
+                        has_body = true;
+                    }
+                    pos = eol;
+                }
+
+                if (version.rfind("HTTP/1.", 0) != 0 || has_body)
+                {
+                    // Not parsed past this point: drop the rest with the connection
+                    conn.out = bad_request;
+                    keep_alive = false;
+                }
+                else if (method != "GET")
+                    conn.out = bad_method;
+                else if (target == "/metrics" || target.rfind("/metrics?", 0) == 0)
+                    conn.out = std::atomic_load(&response_);
+                else
+                    conn.out = not_found;
+                conn.close_after = !keep_alive;
+                conn.in.erase(0, head_end + 4);
+            }
+            conn.out_pos = 0;
+            conn.out_end = conn.out->size();
+        }
+    }
+
+    void metrics_server::close_connection(int fd)
+    {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections_.erase(fd);
+    }
+
+} // namespace app
@@ -0,0 +1,805 @@
+/**
+ * @file mqtt_sink.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  MQTT 3.1.1 publisher fed by the sample bus
+ * @version 0.1
+ * @date 2026-02-02
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/mqtt_sink.h"
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace app
+{
+    namespace
+    {
+        constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(10);
+        constexpr size_t OUT_LIMIT = 64 * 1024;   // QoS 0 stops taking payloads past this much unsent
+        constexpr size_t PACKET_LIMIT = 64 * 1024; // the broker only sends us acks
+
+        void append_u16(std::string &out, uint16_t value)
+        {
+            out.push_back(static_cast<char>(value >> 8));
+            out.push_back(static_cast<char>(value & 0xff));
+        }
+
+        void append_string(std::string &out, std::string_view s)
+        {
+            append_u16(out, static_cast<uint16_t>(s.size()));
+            out.append(s);
+        }
+
+        std::string packet(uint8_t header, const std::string &body)
+        {
+            std::string out;
+            out.reserve(body.size() + 5);
+            out.push_back(static_cast<char>(header));
+            mqtt_append_length(out, body.size());
+            out += body;
+            return out;
+        }
+
+        void append_number(std::string &out, double value)
+        {
+            char buf[32];
+            const int n = std::snprintf(buf, sizeof(buf), "%.10g", value);
+            out.append(buf, static_cast<size_t>(n));
+        }
+
+        void append_frame(std::string &out, const sample_frame &frame)
+        {
+            char t[32];
+            const long long ms = frame.wall_ns / 1000000;
+            const int n = std::snprintf(t, sizeof(t), "{\"t\":%lld.%03lld", ms / 1000, ms % 1000);
+            out.append(t, static_cast<size_t>(n));
+            for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+            {
+                if (!frame.has(channel(i)))
+                    continue;
+                out += ",\"";
+                out += channel_name(channel(i));
+                out += "\":";
+                append_number(out, frame.values[i]);
+            }
+            out.push_back('}');
+        }
+    } // namespace
+
+    void mqtt_append_length(std::string &out, size_t length)
+    {
+        do
+        {
+            uint8_t digit = length % 128;
+            length /= 128;
+            if (length)
+                digit |= 0x80;
+            out.push_back(static_cast<char>(digit));
+        } while (length);
+    }
+
+    std::string mqtt_connect(std::string_view client_id, uint16_t keepalive_s, std::string_view username,
+                             std::string_view password)
+    {
+        // Clean session: the broker keeps nothing for us between connections;
+        // unacknowledged publishes are resent by the sink itself
+        uint8_t flags = 0x02;
+        if (!username.empty())
+            flags |= password.empty() ? 0x80 : 0xc0;
+
+        std::string body;
+        append_string(body, "MQTT");
+        body.push_back(4); // protocol level 3.1.1
+        body.push_back(static_cast<char>(flags));
+        append_u16(body, keepalive_s);
+        append_string(body, client_id);
+        if (!username.empty())
+        {
+            append_string(body, username);
+            if (!password.empty())
+                append_string(body, password);
+        }
+        return packet(static_cast<uint8_t>(mqtt_packet::connect) << 4, body);
+    }
+
+    std::string mqtt_publish(std::string_view topic, std::string_view payload, int qos, uint16_t packet_id, bool dup)
+    {
+        uint8_t header = static_cast<uint8_t>(mqtt_packet::publish) << 4 | static_cast<uint8_t>(qos << 1);
+        if (dup && qos > 0)
+            header |= 0x08;
+
+        std::string body;
+        body.reserve(topic.size() + payload.size() + 4);
+        append_string(body, topic);
+        if (qos > 0)
+            append_u16(body, packet_id);
+        body.append(payload);
+        return packet(header, body);
+    }
+
+    std::string mqtt_puback(uint16_t packet_id)
+    {
+        std::string body;
+        append_u16(body, packet_id);
+        return packet(static_cast<uint8_t>(mqtt_packet::puback) << 4, body);
+    }
+
+    mqtt_parse mqtt_take_packet(std::string &in, uint8_t &header, std::string &body)
+    {
+        size_t length = 0;
+        size_t pos = 1;
+        for (unsigned shift = 0;; shift += 7, ++pos)
+        {
+            if (pos >= in.size())
+                return mqtt_parse::incomplete;
+            if (pos > 4)
+                return mqtt_parse::malformed;
+            const uint8_t digit = static_cast<uint8_t>(in[pos]);
+            length |= static_cast<size_t>(digit & 0x7f) << shift;
+            if (!(digit & 0x80))
+                break;
+        }
+        ++pos;
+        if (length > PACKET_LIMIT)
+            return mqtt_parse::malformed;
+        if (in.size() < pos + length)
+            return mqtt_parse::incomplete;
+
+        header = static_cast<uint8_t>(in[0]);
+        body.assign(in, pos, length);
+        in.erase(0, pos + length);
+        return mqtt_parse::complete;
+    }
+
+    std::string mqtt_payload(const std::vector<sample_frame> &frames)
+    {
+        std::string out;
+        out.reserve(frames.size() * 128);
+        if (frames.size() == 1)
+        {
+            append_frame(out, frames[0]);
+            return out;
+        }
+        out.push_back('[');
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            if (i)
+                out.push_back(',');
+            append_frame(out, frames[i]);
+        }
+        out.push_back(']');
+        return out;
+    }
+
+    mqtt_sink::mqtt_sink(const mqtt_settings &settings, sample_bus &bus) : settings_(settings)
+    {
+        settings_.qos = std::clamp(settings_.qos, 0, 1);
+        settings_.batch = std::max<size_t>(settings_.batch, 1);
+        settings_.max_inflight = std::clamp<size_t>(settings_.max_inflight, 1, 65535);
+        settings_.max_queued = std::max<size_t>(settings_.max_queued, 1);
+        settings_.reconnect_min = std::max(settings_.reconnect_min, std::chrono::milliseconds(1));
+        settings_.reconnect_max = std::max(settings_.reconnect_max, settings_.reconnect_min);
+        backoff_ = settings_.reconnect_min;
+        batch_.reserve(settings_.batch);
+        settings_.drain_rate = std::max(settings_.drain_rate, 0.0);
+
+        if (settings_.host.empty() || settings_.topic.empty())
+        {
+            std::cerr << "mqtt: broker host and topic are required" << std::endl;
+            return;
+        }
+
+        if (!settings_.spool_dir.empty())
+        {
+            spool_settings spool;
+            spool.max_bytes = settings_.spool_max_bytes;
+            spool_.emplace(settings_.spool_dir, spool);
+            if (!spool_->ok())
+            {
+                std::cerr << "mqtt: spool unusable, keeping payloads in memory only" << std::endl;
+                spool_.reset();
+            }
+            else
+            {
+                backlog_bytes_.store(spool_->backlog_bytes(), std::memory_order_relaxed);
+            }
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        frame_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        feed_ = bus.subscribe("mqtt");
+        if (epoll_fd_ < 0 || wake_fd_ < 0 || frame_fd_ < 0 || !feed_)
+        {
+            std::cerr << "mqtt: " << (feed_ ? std::strerror(errno) : "sample bus has no free subscription")
+                      << std::endl;
+            return;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        for (int watched : {wake_fd_, frame_fd_})
+        {
+            ev.data.fd = watched;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, watched, &ev);
+        }
+
+        io_worker_ = std::jthread([this](std::stop_token stop) { io_loop(stop); });
+        feed_worker_ = std::jthread([this](std::stop_token stop) { feed_loop(stop); });
+    }
+
+    mqtt_sink::~mqtt_sink()
+    {
+        if (feed_worker_.joinable())
+        {
+            feed_worker_.request_stop();
+            feed_worker_.join();
+        }
+        if (io_worker_.joinable())
+        {
+            io_worker_.request_stop();
+            io_worker_.join();
+        }
+        if (sock_ >= 0)
+            close(sock_);
+        for (int fd : {wake_fd_, frame_fd_, epoll_fd_})
+            if (fd >= 0)
+                close(fd);
+    }
+
+    void mqtt_sink::feed_loop(std::stop_token stop)
+    {
+        sample_frame frame;
+        const uint64_t one = 1;
+        while (!stop.stop_requested())
+        {
+            if (!feed_->wait_pop(frame, stop, std::chrono::milliseconds(1000)))
+                continue;
+            if (!pending_.try_push(frame))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            [[maybe_unused]] ssize_t n = write(frame_fd_, &one, sizeof(one));
+        }
+    }
+
+    void mqtt_sink::io_loop(std::stop_token stop)
+    {
+        std::stop_callback wake(stop, [this] {
+            const uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = write(wake_fd_, &one, sizeof(one));
+        });
+
+        deadline_ = clock::now(); // first attempt right away
+        epoll_event events[8];
+        while (!stop.stop_requested())
+        {
+            const auto wake_at = state_ == link::up ? std::min(deadline_, drain_at_) : deadline_;
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(wake_at - clock::now()).count();
+            const int n = epoll_wait(epoll_fd_, events, 8, static_cast<int>(std::clamp<long long>(wait, 0, 60000)));
+            if (n < 0 && errno != EINTR)
+            {
+                std::cerr << "mqtt: epoll_wait: " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            auto now = clock::now();
+            bool stopping = false;
+            for (int i = 0; i < n; ++i)
+            {
+                const int fd = events[i].data.fd;
+                if (fd == wake_fd_)
+                {
+                    stopping = true;
+                }
+                else if (fd == frame_fd_)
+                {
+                    uint64_t count;
+                    [[maybe_unused]] ssize_t r = read(frame_fd_, &count, sizeof(count));
+                    sample_frame frame;
+                    while (pending_.try_pop(frame))
+                        add_frame(frame);
+                }
+                else if (fd == sock_)
+                {
+                    on_socket(events[i].events, now);
+                }
+            }
+            if (stopping)
+                break;
+
+            now = clock::now();
+            if (now >= deadline_)
+                on_timeout(now);
+            pump(now);
+            if (spool_)
+            {
+                spool_->sync_if_due();
+                backlog_bytes_.store(spool_->backlog_bytes(), std::memory_order_relaxed);
+            }
+        }
+
+        if (spool_)
+        {
+            // Everything not yet acknowledged is on disk for the next run; what was
+            // read from the spool is still there past its cursor
+            for (const message &m : inflight_)
+                if (!m.spool_seq)
+                    spill(m.payload);
+            inflight_.clear();
+            for (const message &m : queue_)
+                spill(m.payload);
+            queue_.clear();
+            if (!batch_.empty())
+                spill(mqtt_payload(batch_));
+            batch_.clear();
+            spool_->sync();
+        }
+        else if (state_ == link::up)
+        {
+            // Best effort on the way out: whatever fits into the socket buffer now
+            if (!batch_.empty())
+            {
+                enqueue(mqtt_payload(batch_));
+                batch_.clear();
+            }
+            pump(clock::now());
+        }
+        if (state_ == link::up)
+        {
+            out_ += static_cast<char>(static_cast<uint8_t>(mqtt_packet::disconnect) << 4);
+            out_.push_back(0);
+            flush();
+        }
+        connected_.store(false, std::memory_order_release);
+    }
+
+    void mqtt_sink::add_frame(const sample_frame &frame)
+    {
+        batch_.push_back(frame);
+        if (batch_.size() < settings_.batch)
+            return;
+        enqueue(mqtt_payload(batch_));
+        batch_.clear();
+    }
+
+    void mqtt_sink::enqueue(std::string payload)
+    {
+        if (spool_ && (state_ != link::up || queue_.size() >= settings_.max_queued))
+        {
+            spill(payload);
+            return;
+        }
+        // Offline for long: keep the newest payloads
+        if (queue_.size() >= settings_.max_queued)
+        {
+            queue_.pop_front();
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue_.push_back(message{std::move(payload), 0, false});
+    }
+
+    void mqtt_sink::spill(std::string_view payload)
+    {
+        if (spool_->append(payload))
+            spooled_.fetch_add(1, std::memory_order_relaxed);
+        else
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void mqtt_sink::drain(clock::time_point now)
+    {
+        drain_at_ = clock::time_point::max();
+        if (!spool_ || spool_->empty())
+            return;
+
+        // Token bucket, a tenth of a second deep
+        const double burst = std::max(1.0, settings_.drain_rate / 10);
+        if (settings_.drain_rate > 0)
+        {
+            const double elapsed = std::chrono::duration<double>(now - drain_refill_).count();
+            drain_tokens_ = std::min(burst, drain_tokens_ + elapsed * settings_.drain_rate);
+        }
+        drain_refill_ = now;
+
+        const size_t window = std::max<size_t>(1, settings_.max_inflight / 2);
+        std::string payload;
+        spool_position next;
+        while (out_.size() - out_pos_ < OUT_LIMIT)
+        {
+            if (settings_.qos == 1 && (inflight_.size() >= settings_.max_inflight || spool_reads_.size() >= window))
+                return;
+            if (settings_.drain_rate > 0 && drain_tokens_ < 1)
+            {
+                drain_at_ = now + std::chrono::duration_cast<clock::duration>(
+                                      std::chrono::duration<double>((1 - drain_tokens_) / settings_.drain_rate));
+                return;
+            }
+            if (!spool_->read(payload, next))
+                return;
+            drain_tokens_ -= 1;
+
+            message m{payload, 0, false, ++spool_seq_};
+            if (settings_.qos == 1)
+                m.packet_id = next_packet_id();
+            out_ += mqtt_publish(settings_.topic, m.payload, settings_.qos, m.packet_id, false);
+            published_.fetch_add(1, std::memory_order_relaxed);
+            if (settings_.qos == 1)
+            {
+                spool_reads_.push_back({m.spool_seq, next, false});
+                inflight_.push_back(std::move(m));
+            }
+            else
+            {
+                spool_->ack(next);
+            }
+        }
+    }
+
+    void mqtt_sink::spool_acked(uint64_t seq)
+    {
+        for (spool_read &r : spool_reads_)
+            if (r.seq == seq)
+                r.acked = true;
+        // The cursor only moves over a contiguous acknowledged prefix
+        spool_position done;
+        bool any = false;
+        while (!spool_reads_.empty() && spool_reads_.front().acked)
+        {
+            done = spool_reads_.front().next;
+            spool_reads_.pop_front();
+            any = true;
+        }
+        if (any)
+            spool_->ack(done);
+    }
+
+    void mqtt_sink::start_connect(clock::time_point now)
+    {
+        // Name lookup blocks, but only this thread; the bus keeps the frames meanwhile
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *found = nullptr;
+        const std::string port = std::to_string(settings_.port);
+        const int rc = getaddrinfo(settings_.host.c_str(), port.c_str(), &hints, &found);
+        if (rc != 0)
+        {
+            drop_link(gai_strerror(rc), now);
+            return;
+        }
+
+        int fd = -1;
+        int err = 0;
+        bool pending = false;
+        for (addrinfo *ai = found; ai && fd < 0; ai = ai->ai_next)
+        {
+            fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd < 0)
+                continue;
+            if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS)
+            {
+                pending = true;
+                break;
+            }
+            err = errno;
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(found);
+        if (!pending)
+        {
+            drop_link(std::strerror(err ? err : errno), now);
+            return;
+        }
+
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        sock_ = fd;
+        state_ = link::connecting;
+        deadline_ = now + CONNECT_TIMEOUT;
+        want_write_ = true;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.fd = sock_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sock_, &ev);
+    }
+
+    void mqtt_sink::on_socket(uint32_t events, clock::time_point now)
+    {
+        if (state_ == link::connecting)
+        {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (getsockopt(sock_, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+                err = errno;
+            if (err)
+            {
+                drop_link(std::strerror(err), now);
+                return;
+            }
+            if (!(events & EPOLLOUT))
+                return;
+            state_ = link::handshake;
+            const auto keepalive = static_cast<uint16_t>(std::min<long long>(settings_.keepalive.count(), 65535));
+            send_packet(mqtt_connect(settings_.client_id, keepalive, settings_.username, settings_.password), now);
+            return;
+        }
+
+        if (events & EPOLLIN)
+        {
+            char buf[4096];
+            for (;;)
+            {
+                const ssize_t n = recv(sock_, buf, sizeof(buf), 0);
+                if (n > 0)
+                {
+                    in_.append(buf, static_cast<size_t>(n));
+                    continue;
+                }
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    break;
+                drop_link(n == 0 ? "broker closed the connection" : std::strerror(errno), now);
+                return;
+            }
+
+            uint8_t header;
+            std::string body;
+            for (;;)
+            {
+                const mqtt_parse parsed = mqtt_take_packet(in_, header, body);
+                if (parsed == mqtt_parse::incomplete)
+                    break;
+                if (parsed == mqtt_parse::malformed)
+                {
+                    drop_link("malformed packet from the broker", now);
+                    return;
+                }
+                handle_packet(header, body, now);
+                if (state_ == link::down)
+                    return;
+            }
+        }
+        else if (events & (EPOLLERR | EPOLLHUP))
+        {
+            drop_link("connection lost", now);
+            return;
+        }
+
+        if ((events & EPOLLOUT) && !flush())
+            drop_link(std::strerror(errno), now);
+    }
+
+    void mqtt_sink::on_timeout(clock::time_point now)
+    {
+        switch (state_)
+        {
+        case link::down:
+            start_connect(now);
+            break;
+        case link::connecting:
+        case link::handshake:
+            drop_link("no answer from the broker", now);
+            break;
+        case link::up:
+            if (ping_outstanding_)
+            {
+                drop_link("broker stopped answering", now);
+                break;
+            }
+            ping_outstanding_ = true;
+            send_packet(std::string{static_cast<char>(static_cast<uint8_t>(mqtt_packet::pingreq) << 4), 0}, now);
+            break;
+        }
+    }
+
+    void mqtt_sink::handle_packet(uint8_t header, const std::string &body, clock::time_point now)
+    {
+        const auto type = static_cast<mqtt_packet>(header >> 4);
+        if (state_ == link::handshake)
+        {
+            if (type != mqtt_packet::connack || body.size() != 2)
+            {
+                drop_link("expected CONNACK", now);
+                return;
+            }
+            const auto rc = static_cast<uint8_t>(body[1]);
+            if (rc != 0)
+            {
+                const std::string why = "broker refused the connection, code " + std::to_string(rc);
+                drop_link(why.c_str(), now);
+                return;
+            }
+            state_ = link::up;
+            backoff_ = settings_.reconnect_min;
+            ping_outstanding_ = false;
+            deadline_ = settings_.keepalive.count() ? last_sent_ + settings_.keepalive : clock::time_point::max();
+            connected_.store(true, std::memory_order_release);
+            connects_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "mqtt: connected to " << settings_.host << ":" << settings_.port << std::endl;
+            return;
+        }
+
+        switch (type)
+        {
+        case mqtt_packet::puback:
+        {
+            if (body.size() != 2)
+                break;
+            const uint16_t id = static_cast<uint16_t>(static_cast<uint8_t>(body[0]) << 8 | static_cast<uint8_t>(body[1]));
+            // Acks come in publish order, so this is nearly always the front
+            auto it = std::find_if(inflight_.begin(), inflight_.end(), [id](const message &m) { return m.packet_id == id; });
+            if (it != inflight_.end())
+            {
+                if (it->spool_seq)
+                    spool_acked(it->spool_seq);
+                inflight_.erase(it);
+                acked_.fetch_add(1, std::memory_order_relaxed);
+                in_flight_.store(inflight_.size(), std::memory_order_relaxed);
+            }
+            break;
+        }
+        case mqtt_packet::pingresp:
+            ping_outstanding_ = false;
+            break;
+        default:
+            break; // nothing subscribed, nothing else expected
+        }
+    }
+
+    void mqtt_sink::pump(clock::time_point now)
+    {
+        if (state_ != link::up)
+            return;
+
+        // Live payloads first, then the backlog in what is left of the window
+        const size_t queued = out_.size();
+        while (!queue_.empty() && out_.size() - out_pos_ < OUT_LIMIT)
+        {
+            if (settings_.qos == 1 && inflight_.size() >= settings_.max_inflight)
+                break;
+            message m = std::move(queue_.front());
+            queue_.pop_front();
+            if (settings_.qos == 1 && m.packet_id == 0)
+                m.packet_id = next_packet_id();
+            out_ += mqtt_publish(settings_.topic, m.payload, settings_.qos, m.packet_id, m.dup);
+            published_.fetch_add(1, std::memory_order_relaxed);
+            if (settings_.qos == 1)
+                inflight_.push_back(std::move(m));
+        }
+        drain(now);
+        if (out_.size() == queued)
+            return;
+        in_flight_.store(inflight_.size(), std::memory_order_relaxed);
+        last_sent_ = now;
+        if (!ping_outstanding_ && settings_.keepalive.count())
+            deadline_ = now + settings_.keepalive;
+        if (!flush())
+            drop_link(std::strerror(errno), now);
+    }
+
+    bool mqtt_sink::flush()
+    {
+        while (out_pos_ < out_.size())
+        {
+            const ssize_t n = send(sock_, out_.data() + out_pos_, out_.size() - out_pos_, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                out_pos_ += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                if (out_pos_ > OUT_LIMIT)
+                {
+                    out_.erase(0, out_pos_);
+                    out_pos_ = 0;
+                }
+                watch_socket(true);
+                return true;
+            }
+            return false;
+        }
+        out_.clear();
+        out_pos_ = 0;
+        watch_socket(false);
+        return true;
+    }
+
+    void mqtt_sink::send_packet(const std::string &packet, clock::time_point now)
+    {
+        out_ += packet;
+        last_sent_ = now;
+        if (state_ == link::up && settings_.keepalive.count())
+            deadline_ = now + settings_.keepalive;
+        if (!flush())
+            drop_link(std::strerror(errno), now);
+    }
+
+    void mqtt_sink::drop_link(const char *why, clock::time_point now)
+    {
+        // One line per outage, not per retry
+        if (state_ == link::up || backoff_ == settings_.reconnect_min)
+            std::cerr << "mqtt: " << settings_.host << ":" << settings_.port << ": " << why << std::endl;
+
+        if (sock_ >= 0)
+        {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, sock_, nullptr);
+            close(sock_);
+            sock_ = -1;
+        }
+        state_ = link::down;
+        connected_.store(false, std::memory_order_release);
+        in_.clear();
+        out_.clear();
+        out_pos_ = 0;
+        want_write_ = false;
+        ping_outstanding_ = false;
+
+        if (spool_)
+        {
+            // Offline everything waits on disk: live payloads are spilled, those
+            // read from the spool are read again from its cursor
+            for (const message &m : inflight_)
+                if (!m.spool_seq)
+                    spill(m.payload);
+            for (const message &m : queue_)
+                spill(m.payload);
+            queue_.clear();
+            spool_reads_.clear();
+            spool_->rewind();
+        }
+        else
+        {
+            // Unacknowledged publishes go first on the next connection, same ids, DUP set
+            for (auto it = inflight_.rbegin(); it != inflight_.rend(); ++it)
+            {
+                it->dup = true;
+                queue_.push_front(std::move(*it));
+            }
+        }
+        inflight_.clear();
+        in_flight_.store(0, std::memory_order_relaxed);
+
+        deadline_ = now + backoff_;
+        backoff_ = std::min(backoff_ * 2, settings_.reconnect_max);
+    }
+
+    void mqtt_sink::watch_socket(bool want_write)
+    {
+        if (want_write == want_write_ || sock_ < 0)
+            return;
+        want_write_ = want_write;
+        epoll_event ev{};
+        ev.events = EPOLLIN | (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = sock_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, sock_, &ev);
+    }
+
+    uint16_t mqtt_sink::next_packet_id()
+    {
+        // 0 is not a valid packet identifier
+        if (++last_packet_id_ == 0)
+            last_packet_id_ = 1;
+        return last_packet_id_;
+    }
+
+} // namespace app
@@ -0,0 +1,204 @@
+/**
+ * @file peripheral_health.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Per-peripheral health state with backoff re-probing
+ * @version 0.1
+ * @date 2026-01-26
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/peripheral_health.h"
+#include <algorithm>
+#include <iostream>
+
+namespace app
+{
+    const char *health_state_name(health_state state)
+    {
+        switch (state)
+        {
+        case health_state::healthy:
+            return "healthy";
+        case health_state::degraded:
+            return "degraded";
+        case health_state::failed:
+            return "failed";
+        }
+        return "unknown";
+    }
+
+    peripheral_health::peripheral_health(const void *device, std::string name, std::function<bool()> reprobe,
+                                         const health_policy &policy)
+        : device_(device), name_(std::move(name)), reprobe_(std::move(reprobe)), policy_(policy)
+    {
+    }
+
+    bool peripheral_health::is_failure(peripherals::Status status)
+    {
+        return status == peripherals::Status::ErrorCommunication ||
+               status == peripherals::Status::ErrorTimeout ||
+               status == peripherals::Status::ErrorNotInitialized;
+    }
+
+    health_state peripheral_health::report(peripherals::Status status, clock::time_point now)
+    {
+        if (state() == health_state::failed)
+            return health_state::failed;
+
+        // Cut short by the tick's budget: says nothing about the device either way
+        if (status == peripherals::Status::ErrorDeadline)
+            return state();
+
+        if (!is_failure(status))
+        {
+            failures_.store(0, std::memory_order_relaxed);
+            state_.store(health_state::healthy, std::memory_order_release);
+            return health_state::healthy;
+        }
+
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        const uint32_t failures = failures_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (failures < policy_.fail_after)
+        {
+            state_.store(health_state::degraded, std::memory_order_release);
+            return health_state::degraded;
+        }
+
+        backoff_ = policy_.initial_backoff;
+        enter_failed(now);
+        return health_state::failed;
+    }
+
+    void peripheral_health::record_read(std::chrono::microseconds took)
+    {
+        const uint64_t us = static_cast<uint64_t>(std::max<int64_t>(took.count(), 0));
+        reads_.fetch_add(1, std::memory_order_relaxed);
+        read_us_.fetch_add(us, std::memory_order_relaxed);
+        last_read_us_.store(us, std::memory_order_relaxed);
+    }
+
+    void peripheral_health::mark_failed(clock::time_point now)
+    {
+        if (state() == health_state::failed)
+            return;
+        backoff_ = policy_.initial_backoff;
+        enter_failed(now);
+    }
+
+    void peripheral_health::enter_failed(clock::time_point now)
+    {
+        next_probe_ = now + backoff_;
+        std::cerr << name_ << ": failed, re-probe in " << backoff_.count() << " ms" << std::endl;
+        // Publishes backoff_/next_probe_ to the monitor together with the device
+        state_.store(health_state::failed, std::memory_order_release);
+    }
+
+    bool peripheral_health::probe_if_due(clock::time_point now)
+    {
+        if (state() != health_state::failed || now < next_probe_)
+            return false;
+
+        if (reprobe_ && reprobe_())
+        {
+            failures_.store(0, std::memory_order_relaxed);
+            recoveries_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << name_ << ": recovered" << std::endl;
+            state_.store(health_state::healthy, std::memory_order_release);
+            return true;
+        }
+
+        backoff_ = std::min(backoff_ * 2, policy_.max_backoff);
+        next_probe_ = now + backoff_;
+        return false;
+    }
+
+    health_monitor::health_monitor(std::chrono::milliseconds tick) : tick_(tick)
+    {
+    }
+
+    health_monitor::~health_monitor()
+    {
+        stop();
+    }
+
+    peripheral_health &health_monitor::add(const void *device, std::string name, std::function<bool()> reprobe,
+                                           const health_policy &policy)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.emplace_back(device, std::move(name), std::move(reprobe), policy);
+    }
+
+    bool health_monitor::remove(const void *device)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end(); ++it)
+        {
+            if (it->device() != device)
+                continue;
+            const peripheral_health *entry = &*it;
+            probed_.wait(lock, [&] { return probing_ != entry; });
+            entries_.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+    size_t health_monitor::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    void health_monitor::start()
+    {
+        if (!worker_.joinable())
+            worker_ = std::jthread([this](std::stop_token stop) { loop(stop); });
+    }
+
+    void health_monitor::stop()
+    {
+        if (worker_.joinable())
+        {
+            worker_.request_stop();
+            cv_.notify_all();
+            worker_.join();
+        }
+    }
+
+    peripheral_health *health_monitor::find(const void *device)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &entry : entries_)
+            if (entry.device() == device)
+                return &entry;
+        return nullptr;
+    }
+
+    void health_monitor::loop(std::stop_token stop)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop.stop_requested())
+        {
+            // The lock is dropped around each re-probe (it may take a while);
+            // remove() waits for probing_ to clear, so the iterator stays valid
+            for (auto it = entries_.begin(); it != entries_.end(); ++it)
+            {
+                if (stop.stop_requested())
+                    return;
+                if (it->state() != health_state::failed)
+                    continue;
+                probing_ = &*it;
+                lock.unlock();
+                it->probe_if_due();
+                lock.lock();
+                probing_ = nullptr;
+                probed_.notify_all();
+            }
+
+            cv_.wait_for(lock, stop, tick_, [] { return false; });
+        }
+    }
+
+} // namespace app
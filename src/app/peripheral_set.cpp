@@ -0,0 +1,155 @@
+/**
+ * @file peripheral_set.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Running peripherals as swappable snapshots, diffed on config reload
+ * @version 0.1
+ * @date 2026-01-29
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/peripheral_set.h"
+#include <algorithm>
+
+namespace app
+{
+    peripheral_slot::~peripheral_slot()
+    {
+        if (environmental)
+            environmental->deinitialize();
+        if (gas)
+            gas->deinitialize();
+        if (display)
+            display->deinitialize();
+        if (rtc)
+            rtc->deinitialize();
+        environmental.reset();
+        gas.reset();
+        display.reset();
+        rtc.reset();
+
+        if (dc_line)
+            dc_line->deinitialize();
+        if (connection)
+            connection->deinitialize();
+    }
+
+    const void *peripheral_slot::device() const
+    {
+        if (environmental)
+            return environmental.get();
+        if (gas)
+            return gas.get();
+        if (display)
+            return display.get();
+        return rtc.get();
+    }
+
+    bool same_peripheral(const config::PeripheralSpec &a, const config::PeripheralSpec &b)
+    {
+        return a.connection == b.connection && a.device == b.device && a.address == b.address &&
+               a.type == b.type && a.options == b.options;
+    }
+
+    bool same_address(const config::PeripheralSpec &a, const config::PeripheralSpec &b)
+    {
+        return a.connection == b.connection && a.device == b.device && a.address == b.address;
+    }
+
+    void peripheral_set::index()
+    {
+        environmental_sensors.clear();
+        gas_sensors.clear();
+        displays.clear();
+        rtcs.clear();
+        for (auto &slot : slots)
+        {
+            if (slot->environmental)
+                environmental_sensors.push_back(slot->environmental.get());
+            if (slot->gas)
+                gas_sensors.push_back(slot->gas.get());
+            if (slot->display)
+                displays.push_back(slot->display.get());
+            if (slot->rtc)
+                rtcs.push_back(slot->rtc.get());
+        }
+    }
+
+    // Takes the first slot in unused that is the same peripheral as spec; each
+    // running slot can be claimed once (two identical entries are two devices)
+    static std::shared_ptr<peripheral_slot> claim(std::vector<std::shared_ptr<peripheral_slot>> &unused,
+                                                  const config::PeripheralSpec &spec)
+    {
+        for (auto it = unused.begin(); it != unused.end(); ++it)
+        {
+            if (same_peripheral((*it)->spec, spec))
+            {
+                auto slot = std::move(*it);
+                unused.erase(it);
+                return slot;
+            }
+        }
+        return nullptr;
+    }
+
+    peripheral_diff diff_peripherals(const peripheral_set *current, const config::AppConfig &cfg,
+                                     const slot_factory &make)
+    {
+        peripheral_diff diff;
+        diff.next = std::make_shared<peripheral_set>();
+        diff.next->generation = current ? current->generation + 1 : 0;
+        diff.next->config = cfg;
+
+        std::vector<std::shared_ptr<peripheral_slot>> unused;
+        if (current)
+            unused = current->slots;
+
+        for (const auto &spec : cfg.peripherals)
+        {
+            std::shared_ptr<peripheral_slot> slot = claim(unused, spec);
+
+            if (!slot)
+            {
+                slot = make(spec);
+                if (!slot)
+                    continue;
+                slot->spec = spec;
+                diff.added.push_back(slot);
+            }
+            diff.next->slots.push_back(std::move(slot));
+        }
+
+        diff.removed = std::move(unused);
+        diff.next->index();
+        return diff;
+    }
+
+    peripheral_diff evict_replaced(const peripheral_set &current, const config::AppConfig &cfg)
+    {
+        // Same claiming as diff_peripherals(): what is left unused is dropped, the
+        // entries that found no slot will be created
+        std::vector<std::shared_ptr<peripheral_slot>> unused = current.slots;
+        std::vector<const config::PeripheralSpec *> created;
+        for (const auto &spec : cfg.peripherals)
+        {
+            if (!claim(unused, spec))
+                created.push_back(&spec);
+        }
+
+        peripheral_diff diff;
+        diff.next = std::make_shared<peripheral_set>();
+        diff.next->generation = current.generation + 1;
+        diff.next->config = current.config;
+        for (const auto &slot : current.slots)
+        {
+            const bool dropped = std::find(unused.begin(), unused.end(), slot) != unused.end();
+            const bool taken = std::any_of(created.begin(), created.end(),
+                                           [&](const config::PeripheralSpec *spec) { return same_address(slot->spec, *spec); });
+            (dropped && taken ? diff.removed : diff.next->slots).push_back(slot);
+        }
+        diff.next->index();
+        return diff;
+    }
+
+} // namespace app
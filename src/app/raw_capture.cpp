@@ -0,0 +1,161 @@
+/**
+ * @file raw_capture.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Binary capture of raw BME280 ADC words for offline compensation
+ * @version 0.1
+ * @date 2026-01-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/raw_capture.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace app
+{
+    static constexpr char MAGIC[8] = {'A', 'T', 'R', 'A', 'W', 'B', 'M', 'E'};
+    static constexpr size_t CALIB_SIZE = 33;
+    static constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 4 + CALIB_SIZE;
+    static constexpr size_t RECORD_SIZE = 20;
+    static constexpr uint32_t FLAG_HUMIDITY = 0x01;
+
+    using header_bytes = std::array<uint8_t, HEADER_SIZE>;
+
+    template <typename T>
+    static uint8_t *put(uint8_t *p, T v)
+    {
+        std::memcpy(p, &v, sizeof(T));
+        return p + sizeof(T);
+    }
+
+    template <typename T>
+    static const uint8_t *get(const uint8_t *p, T &v)
+    {
+        std::memcpy(&v, p, sizeof(T));
+        return p + sizeof(T);
+    }
+
+    static header_bytes make_header(const peripherals::bme280_calibration &c, bool has_humidity)
+    {
+        header_bytes h{};
+        uint8_t *p = h.data();
+        std::memcpy(p, MAGIC, sizeof(MAGIC));
+        p += sizeof(MAGIC);
+        p = put<uint32_t>(p, has_humidity ? FLAG_HUMIDITY : 0);
+        p = put(p, c.dig_T1); p = put(p, c.dig_T2); p = put(p, c.dig_T3);
+        p = put(p, c.dig_P1); p = put(p, c.dig_P2); p = put(p, c.dig_P3);
+        p = put(p, c.dig_P4); p = put(p, c.dig_P5); p = put(p, c.dig_P6);
+        p = put(p, c.dig_P7); p = put(p, c.dig_P8); p = put(p, c.dig_P9);
+        p = put(p, c.dig_H1); p = put(p, c.dig_H2); p = put(p, c.dig_H3);
+        p = put(p, c.dig_H4); p = put(p, c.dig_H5); p = put(p, c.dig_H6);
+        return h;
+    }
+
+    static bool parse_header(const header_bytes &h, peripherals::bme280_calibration &c, bool &has_humidity)
+    {
+        if (std::memcmp(h.data(), MAGIC, sizeof(MAGIC)) != 0)
+            return false;
+        const uint8_t *p = h.data() + sizeof(MAGIC);
+        uint32_t flags = 0;
+        p = get(p, flags);
+        has_humidity = (flags & FLAG_HUMIDITY) != 0;
+        p = get(p, c.dig_T1); p = get(p, c.dig_T2); p = get(p, c.dig_T3);
+        p = get(p, c.dig_P1); p = get(p, c.dig_P2); p = get(p, c.dig_P3);
+        p = get(p, c.dig_P4); p = get(p, c.dig_P5); p = get(p, c.dig_P6);
+        p = get(p, c.dig_P7); p = get(p, c.dig_P8); p = get(p, c.dig_P9);
+        p = get(p, c.dig_H1); p = get(p, c.dig_H2); p = get(p, c.dig_H3);
+        p = get(p, c.dig_H4); p = get(p, c.dig_H5); p = get(p, c.dig_H6);
+        return true;
+    }
+
+    raw_capture_writer::raw_capture_writer(const std::string &path, const peripherals::bme280_calibration &calib,
+                                           bool has_humidity)
+    {
+        const header_bytes header = make_header(calib, has_humidity);
+
+        bool append = false;
+        {
+            std::ifstream existing(path, std::ios::binary);
+            if (existing)
+            {
+                header_bytes old{};
+                existing.read(reinterpret_cast<char *>(old.data()), old.size());
+                append = existing.gcount() == static_cast<std::streamsize>(old.size()) && old == header;
+                if (!append && std::rename(path.c_str(), (path + ".old").c_str()) != 0)
+                    std::cerr << "Failed to move aside raw capture file: " << path << std::endl;
+            }
+        }
+
+        file_.open(path, std::ios::binary | std::ios::app);
+        if (!file_.is_open())
+        {
+            std::cerr << "Failed to open raw capture file: " << path << std::endl;
+            return;
+        }
+
+        if (!append)
+        {
+            file_.write(reinterpret_cast<const char *>(header.data()), header.size());
+            file_.flush();
+        }
+    }
+
+    bool raw_capture_writer::append(int64_t timestamp_ms, const peripherals::bme280_raw_sample &sample)
+    {
+        if (!file_.is_open() || !sample.valid)
+            return false;
+
+        std::array<uint8_t, RECORD_SIZE> rec;
+        uint8_t *p = put(rec.data(), timestamp_ms);
+        p = put(p, sample.raw_t);
+        p = put(p, sample.raw_p);
+        put(p, sample.raw_h);
+
+        file_.write(reinterpret_cast<const char *>(rec.data()), rec.size());
+        file_.flush();
+        return file_.good();
+    }
+
+    bool load_raw_capture(const std::string &path, raw_capture &out)
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+            return false;
+
+        const auto file_size = static_cast<size_t>(in.tellg());
+        if (file_size < HEADER_SIZE)
+            return false;
+        in.seekg(0);
+
+        header_bytes header{};
+        in.read(reinterpret_cast<char *>(header.data()), header.size());
+        if (!in || !parse_header(header, out.calib, out.has_humidity))
+            return false;
+
+        const size_t count = (file_size - HEADER_SIZE) / RECORD_SIZE;
+        std::vector<uint8_t> body(count * RECORD_SIZE);
+        in.read(reinterpret_cast<char *>(body.data()), body.size());
+        if (!in)
+            return false;
+
+        out.timestamp_ms.resize(count);
+        out.raw_t.resize(count);
+        out.raw_p.resize(count);
+        out.raw_h.resize(count);
+
+        const uint8_t *p = body.data();
+        for (size_t i = 0; i < count; ++i)
+        {
+            p = get(p, out.timestamp_ms[i]);
+            p = get(p, out.raw_t[i]);
+            p = get(p, out.raw_p[i]);
+            p = get(p, out.raw_h[i]);
+        }
+        return true;
+    }
+
+} // namespace app
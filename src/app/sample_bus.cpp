@@ -0,0 +1,87 @@
+/**
+ * @file sample_bus.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  In-process publish/subscribe bus for measurement frames
+ * @version 0.1
+ * @date 2026-01-23
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/sample_bus.h"
+
+namespace app
+{
+    const char *channel_name(channel ch)
+    {
+        switch (ch)
+        {
+        case channel::co2_ppm:
+            return "co2_ppm";
+        case channel::temperature_c:
+            return "temperature_c";
+        case channel::humidity_rh:
+            return "humidity_rh";
+        case channel::pressure_pa:
+            return "pressure_pa";
+        case channel::voc_index:
+            return "voc_index";
+        case channel::nox_index:
+            return "nox_index";
+        }
+        return "unknown";
+    }
+
+    bool sample_bus::subscription::wait_pop(sample_frame &frame, std::stop_token stop,
+                                            std::chrono::milliseconds timeout)
+    {
+        if (queue_.try_pop(frame))
+            return true;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, stop, timeout, [this] { return !queue_.empty(); });
+        return queue_.try_pop(frame);
+    }
+
+    void sample_bus::subscription::deliver(const sample_frame &frame)
+    {
+        if (!queue_.try_push(frame))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Empty critical section orders the push against a consumer that is about
+        // to sleep; the consumer never holds the mutex for longer than its check.
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        cv_.notify_one();
+    }
+
+    void sample_bus::publish(const sample_frame &frame)
+    {
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+        {
+            if (frame.has(channel(i)))
+                latest_[i].store({frame.values[i], frame.wall_ns, true});
+        }
+
+        const size_t count = subscriber_count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i)
+            subscribers_[i]->deliver(frame);
+    }
+
+    sample_bus::subscription *sample_bus::subscribe(std::string name)
+    {
+        std::lock_guard<std::mutex> lock(subscribe_mutex_);
+        const size_t count = subscriber_count_.load(std::memory_order_relaxed);
+        if (count == MAX_SUBSCRIBERS)
+            return nullptr;
+
+        subscribers_[count] = std::make_unique<subscription>(std::move(name));
+        subscriber_count_.store(count + 1, std::memory_order_release);
+        return subscribers_[count].get();
+    }
+
+} // namespace app
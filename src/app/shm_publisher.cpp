@@ -0,0 +1,125 @@
+/**
+ * @file shm_publisher.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Latest sample per channel in POSIX shared memory for local readers
+ * @version 0.1
+ * @date 2026-01-31
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/shm_publisher.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace app
+{
+    shm_publisher::shm_publisher(const std::string &name) : name_(name)
+    {
+        const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            std::cerr << "shm: cannot open " << name << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) < 0 ||
+            (static_cast<size_t>(st.st_size) != sizeof(atmolyt_shm_segment) && ftruncate(fd, 0) < 0) ||
+            ftruncate(fd, sizeof(atmolyt_shm_segment)) < 0)
+        {
+            std::cerr << "shm: cannot size " << name << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+            return;
+        }
+        void *p = mmap(nullptr, sizeof(atmolyt_shm_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED)
+        {
+            std::cerr << "shm: cannot map " << name << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+        segment_ = static_cast<atmolyt_shm_segment *>(p);
+
+        // A segment left by an earlier run with this layout is taken over, so
+        // sequence numbers never go back under a reader; anything else starts over
+        if (__atomic_load_n(&segment_->magic, __ATOMIC_ACQUIRE) == ATMOLYT_SHM_MAGIC &&
+            segment_->version == ATMOLYT_SHM_VERSION && segment_->size == sizeof(atmolyt_shm_segment))
+        {
+            // A writer that died inside a store left its seq odd; every later store
+            // would keep it odd and readers would retry forever
+            for (auto &record : segment_->records)
+            {
+                const uint64_t seq = __atomic_load_n(&record.seq, __ATOMIC_RELAXED);
+                if (seq & 1)
+                    __atomic_store_n(&record.seq, seq + 1, __ATOMIC_RELEASE);
+            }
+        }
+        else
+        {
+            __atomic_store_n(&segment_->magic, 0u, __ATOMIC_RELAXED);
+            std::memset(reinterpret_cast<char *>(segment_) + sizeof(segment_->magic), 0,
+                        sizeof(atmolyt_shm_segment) - sizeof(segment_->magic));
+            segment_->version = ATMOLYT_SHM_VERSION;
+            segment_->size = sizeof(atmolyt_shm_segment);
+            segment_->channel_count = CHANNEL_COUNT;
+            __atomic_store_n(&segment_->magic, ATMOLYT_SHM_MAGIC, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&segment_->writer_pid, static_cast<int32_t>(getpid()), __ATOMIC_RELEASE);
+    }
+
+    shm_publisher::~shm_publisher()
+    {
+        if (worker_.joinable())
+        {
+            worker_.request_stop();
+            worker_.join();
+        }
+        if (segment_)
+        {
+            // Not unlinked: readers keep the last values and see the writer is gone
+            __atomic_store_n(&segment_->writer_pid, 0, __ATOMIC_RELEASE);
+            munmap(segment_, sizeof(atmolyt_shm_segment));
+        }
+    }
+
+    void shm_publisher::publish(const sample_frame &frame)
+    {
+        if (!segment_)
+            return;
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+        {
+            if (frame.has(channel(i)))
+                atmolyt_shm_store(&segment_->records[i], frame.values[i], frame.wall_ns);
+        }
+        __atomic_fetch_add(&segment_->frames, 1, __ATOMIC_RELEASE);
+    }
+
+    bool shm_publisher::attach(sample_bus &bus)
+    {
+        if (feed_)
+            return true;
+        if (!segment_)
+            return false;
+        feed_ = bus.subscribe("shm");
+        if (!feed_)
+        {
+            std::cerr << "shm: sample bus has no free subscription" << std::endl;
+            return false;
+        }
+        worker_ = std::jthread([this](std::stop_token stop) { publish_loop(stop); });
+        return true;
+    }
+
+    void shm_publisher::publish_loop(std::stop_token stop)
+    {
+        sample_frame frame;
+        while (!stop.stop_requested())
+        {
+            if (feed_->wait_pop(frame, stop, std::chrono::milliseconds(1000)))
+                publish(frame);
+        }
+    }
+
+} // namespace app
@@ -12,14 +12,26 @@
 #include "app/signal_handler.h"
 
 #include <csignal>
+#include <fcntl.h>
 #include <unistd.h>
 #include <iostream>
 #include <cstring>
+#include <cerrno>
+#include <thread>
 
 namespace app {
 
 void signal_handler::install()
 {
+	// request_stop() runs callbacks and is not async-signal-safe: the handler only
+	// writes a byte, a watcher thread turns it into the stop request
+	if (pipe_[0] < 0 && ::pipe2(pipe_, O_CLOEXEC) == 0)
+	{
+		// The handler must never block on a full pipe
+		::fcntl(pipe_[1], F_SETFL, ::fcntl(pipe_[1], F_GETFL) | O_NONBLOCK);
+		std::thread(&signal_handler::watch_pipe).detach();
+	}
+
 	std::signal(SIGINT, [](int s){ signal_handler::handle_signal(s); });
 	std::signal(SIGTERM, [](int s){ signal_handler::handle_signal(s); });
 	std::signal(SIGHUP, [](int s){ signal_handler::handle_signal(s); });
@@ -27,6 +39,35 @@ void signal_handler::install()
 	std::signal(SIGABRT, [](int s){ signal_handler::handle_signal(s); });
 }
 
+std::stop_token signal_handler::stop_token()
+{
+	return stop_source_.get_token();
+}
+
+void signal_handler::watch_pipe()
+{
+	for (;;)
+	{
+		char byte;
+		const ssize_t n = ::read(pipe_[0], &byte, 1);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (requested_.load(std::memory_order_acquire))
+		{
+			stop_source_.request_stop();
+			return;
+		}
+		if (n <= 0)
+			return;
+		if (reload_requested_.exchange(false, std::memory_order_acq_rel))
+		{
+			std::lock_guard<std::mutex> lock(reload_mutex_);
+			if (reload_cb_)
+				reload_cb_();
+		}
+	}
+}
+
 bool signal_handler::shutdown_requested()
 {
 	return requested_.load(std::memory_order_acquire);
@@ -37,13 +78,35 @@ void signal_handler::set_user_callback(std::function<void(int)> cb)
 	user_cb_ = std::move(cb);
 }
 
+void signal_handler::set_reload_callback(std::function<void()> cb)
+{
+	std::lock_guard<std::mutex> lock(reload_mutex_);
+	reload_cb_ = std::move(cb);
+}
+
 void signal_handler::handle_signal(int signo) noexcept
 {
-	requested_.store(true, std::memory_order_release);
 	last_signal_.store(signo, std::memory_order_release);
 
 	const char *msg = "termination signal received\n";
+	if (signo == SIGHUP)
+	{
+		reload_requested_.store(true, std::memory_order_release);
+		msg = "reload signal received\n";
+	}
+	else
+	{
+		requested_.store(true, std::memory_order_release);
+	}
 	::write(STDERR_FILENO, msg, std::strlen(msg));
+
+	if (pipe_[1] >= 0)
+	{
+		const int saved = errno;
+		const char byte = static_cast<char>(signo);
+		::write(pipe_[1], &byte, 1);
+		errno = saved;
+	}
 }
 
 void signal_handler::poll_and_handle()
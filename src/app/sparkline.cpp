@@ -0,0 +1,110 @@
+/**
+ * @file sparkline.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Scrolling min/max trend graph for display_iface
+ * @version 0.1
+ * @date 2026-01-14
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/sparkline.h"
+#include <algorithm>
+#include <cmath>
+
+namespace app
+{
+    static constexpr int EMPTY_TOP = 1;
+    static constexpr int EMPTY_BOTTOM = 0;
+
+    sparkline::sparkline(peripherals::display_iface *display, int x, int y, int width, int height,
+                         float range_lo, float range_hi)
+        : display_(display), x_(x), y_(y),
+          width_(std::clamp(width, 1, MAX_WIDTH)), height_(std::max(height, 2)),
+          lo_(range_lo), hi_(range_hi > range_lo ? range_hi : range_lo + 1.0f)
+    {
+        cols_.fill({EMPTY_TOP, EMPTY_BOTTOM});
+    }
+
+    int sparkline::to_row(float value) const
+    {
+        float norm = (value - lo_) / (hi_ - lo_);
+        norm = std::clamp(norm, 0.0f, 1.0f);
+        return y_ + (height_ - 1) - static_cast<int>(std::lround(norm * (height_ - 1)));
+    }
+
+    sparkline::column sparkline::to_column(const minmax_pair &bucket) const
+    {
+        return {to_row(bucket.max), to_row(bucket.min)};
+    }
+
+    void sparkline::draw_span(int sx, int r0, int r1, int color)
+    {
+        if (r0 > r1)
+            return;
+        display_->draw_line(x_ + sx, r0, x_ + sx, r1, color);
+    }
+
+    void sparkline::update_column(int sx, const column &before, const column &after)
+    {
+        const bool had = before.top <= before.bottom;
+        const bool has = after.top <= after.bottom;
+
+        if (!has)
+        {
+            if (had)
+                draw_span(sx, before.top, before.bottom, 0);
+            return;
+        }
+        if (!had)
+        {
+            draw_span(sx, after.top, after.bottom, 1);
+            return;
+        }
+
+        // Erase the parts of the old bar outside the new one, then extend to the new bar
+        draw_span(sx, before.top, std::min(before.bottom, after.top - 1), 0);
+        draw_span(sx, std::max(before.top, after.bottom + 1), before.bottom, 0);
+        draw_span(sx, after.top, std::min(after.bottom, before.top - 1), 1);
+        draw_span(sx, std::max(after.top, before.bottom + 1), after.bottom, 1);
+    }
+
+    peripherals::Status sparkline::append(const minmax_pair &bucket)
+    {
+        if (!display_)
+            return peripherals::Status::ErrorNotInitialized;
+
+        const column incoming = to_column(bucket);
+
+        // Screen column i takes over what column i + 1 showed; the newest goes to the right edge
+        for (int i = 0; i < width_; ++i)
+        {
+            const column &before = cols_[(start_ + i) % width_];
+            const column &after = (i + 1 < width_) ? cols_[(start_ + i + 1) % width_] : incoming;
+            update_column(i, before, after);
+        }
+
+        cols_[start_] = incoming;
+        start_ = (start_ + 1) % width_;
+
+        return display_->flush();
+    }
+
+    peripherals::Status sparkline::redraw()
+    {
+        if (!display_)
+            return peripherals::Status::ErrorNotInitialized;
+
+        for (int i = 0; i < width_; ++i)
+        {
+            draw_span(i, y_, y_ + height_ - 1, 0);
+            const column &c = cols_[(start_ + i) % width_];
+            if (c.top <= c.bottom)
+                draw_span(i, c.top, c.bottom, 1);
+        }
+
+        return display_->flush();
+    }
+
+} // namespace app
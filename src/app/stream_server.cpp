@@ -0,0 +1,440 @@
+/**
+ * @file stream_server.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Live sample stream to local clients over a Unix-domain socket
+ * @version 0.1
+ * @date 2026-02-01
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/stream_server.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace app
+{
+    size_t encode_stream_frame(const sample_frame &frame, uint32_t mask, uint64_t seq, uint8_t *out)
+    {
+        stream_frame_header header{stream_frame_header::MAGIC, stream_frame_header::VERSION, 0, 0, seq, frame.wall_ns};
+        uint8_t *p = out + sizeof(header);
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+        {
+            if (!frame.has(channel(i)) || !(mask & (1u << i)))
+                continue;
+            const float value = static_cast<float>(frame.values[i]);
+            std::memcpy(p, &value, sizeof(value));
+            p += sizeof(value);
+            header.mask |= 1u << i;
+            ++header.count;
+        }
+        std::memcpy(out, &header, sizeof(header));
+        return static_cast<size_t>(p - out);
+    }
+
+    size_t decode_stream_frame(const uint8_t *data, size_t size, sample_frame &frame, uint64_t &seq)
+    {
+        stream_frame_header header;
+        if (size < sizeof(header))
+            return 0;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != stream_frame_header::MAGIC || header.version != stream_frame_header::VERSION ||
+            static_cast<unsigned>(__builtin_popcount(header.mask)) != header.count)
+            return 0;
+        const size_t total = sizeof(header) + header.count * sizeof(float);
+        if (size < total)
+            return 0;
+
+        frame = sample_frame{};
+        frame.wall_ns = header.wall_ns;
+        seq = header.seq;
+        const uint8_t *p = data + sizeof(header);
+        for (unsigned bit = 0; bit < 32; ++bit)
+        {
+            if (!(header.mask & (1u << bit)))
+                continue;
+            float value;
+            std::memcpy(&value, p, sizeof(value));
+            p += sizeof(value);
+            // Channels newer than this build are skipped
+            if (bit < CHANNEL_COUNT)
+                frame.set(channel(bit), value);
+        }
+        return total;
+    }
+
+    bool parse_stream_request(std::string_view line, stream_filter &filter)
+    {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+            line.remove_suffix(1);
+        if (line.substr(0, 4) != "SUB ")
+            return false;
+        line.remove_prefix(4);
+
+        const size_t space = line.find(' ');
+        std::string_view channels = line.substr(0, space);
+        std::string_view every = space == std::string_view::npos ? std::string_view() : line.substr(space + 1);
+
+        stream_filter parsed;
+        if (channels != "*")
+        {
+            parsed.mask = 0;
+            while (!channels.empty())
+            {
+                const size_t comma = channels.find(',');
+                const std::string_view name = channels.substr(0, comma);
+                bool known = false;
+                for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+                {
+                    if (name == channel_name(channel(i)))
+                    {
+                        parsed.mask |= 1u << i;
+                        known = true;
+                    }
+                }
+                if (!known)
+                    return false;
+                channels = comma == std::string_view::npos ? std::string_view() : channels.substr(comma + 1);
+            }
+            if (!parsed.mask)
+                return false;
+        }
+        if (!every.empty())
+        {
+            uint32_t n = 0;
+            for (char c : every)
+            {
+                if (c < '0' || c > '9' || n > 1000000)
+                    return false;
+                n = n * 10 + static_cast<uint32_t>(c - '0');
+            }
+            if (n == 0)
+                return false;
+            parsed.every = n;
+        }
+        filter = parsed;
+        return true;
+    }
+
+    stream_server::stream_server(const std::string &path, sample_bus &bus) : path_(path)
+    {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        {
+            std::cerr << "stream: socket path is empty or too long: " << path << std::endl;
+            return;
+        }
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        // A socket left by an earlier run is replaced; anything else at the path is not ours
+        struct stat st{};
+        if (lstat(path.c_str(), &st) == 0)
+        {
+            if (!S_ISSOCK(st.st_mode))
+            {
+                std::cerr << "stream: " << path << " exists and is not a socket" << std::endl;
+                return;
+            }
+            unlink(path.c_str());
+        }
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            std::cerr << "stream: socket: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0)
+        {
+            std::cerr << "stream: cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+            return;
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        frame_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        feed_ = bus.subscribe("stream");
+        if (epoll_fd_ < 0 || wake_fd_ < 0 || frame_fd_ < 0 || !feed_)
+        {
+            std::cerr << "stream: " << (feed_ ? std::strerror(errno) : "sample bus has no free subscription")
+                      << std::endl;
+            close(fd);
+            unlink(path.c_str());
+            return;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        for (int watched : {fd, wake_fd_, frame_fd_})
+        {
+            ev.data.fd = watched;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, watched, &ev);
+        }
+        listen_fd_ = fd;
+
+        serve_worker_ = std::jthread([this](std::stop_token stop) { serve_loop(stop); });
+        feed_worker_ = std::jthread([this](std::stop_token stop) { feed_loop(stop); });
+    }
+
+    stream_server::~stream_server()
+    {
+        if (feed_worker_.joinable())
+        {
+            feed_worker_.request_stop();
+            feed_worker_.join();
+        }
+        if (serve_worker_.joinable())
+        {
+            serve_worker_.request_stop();
+            serve_worker_.join();
+        }
+        for (auto &entry : clients_)
+            close(entry.first);
+        clients_.clear();
+        if (listen_fd_ >= 0)
+        {
+            close(listen_fd_);
+            unlink(path_.c_str());
+        }
+        for (int fd : {wake_fd_, frame_fd_, epoll_fd_})
+            if (fd >= 0)
+                close(fd);
+    }
+
+    void stream_server::feed_loop(std::stop_token stop)
+    {
+        sample_frame frame;
+        const uint64_t one = 1;
+        while (!stop.stop_requested())
+        {
+            if (!feed_->wait_pop(frame, stop, std::chrono::milliseconds(1000)))
+                continue;
+            // The epoll thread is behind by a whole queue: nobody gets this frame
+            if (!pending_.try_push(frame))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            [[maybe_unused]] ssize_t n = write(frame_fd_, &one, sizeof(one));
+        }
+    }
+
+    void stream_server::serve_loop(std::stop_token stop)
+    {
+        std::stop_callback wake(stop, [this] {
+            const uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = write(wake_fd_, &one, sizeof(one));
+        });
+
+        epoll_event events[32];
+        while (!stop.stop_requested())
+        {
+            const int n = epoll_wait(epoll_fd_, events, 32, -1);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "stream: epoll_wait: " << std::strerror(errno) << std::endl;
+                return;
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                const int fd = events[i].data.fd;
+                if (fd == wake_fd_)
+                    return;
+                if (fd == listen_fd_)
+                {
+                    accept_all();
+                    continue;
+                }
+                if (fd == frame_fd_)
+                {
+                    uint64_t count;
+                    [[maybe_unused]] ssize_t r = read(frame_fd_, &count, sizeof(count));
+                    sample_frame frame;
+                    while (pending_.try_pop(frame))
+                        fan_out(frame);
+                    continue;
+                }
+
+                auto it = clients_.find(fd);
+                if (it == clients_.end())
+                    continue;
+                const bool ok = !(events[i].events & (EPOLLERR | EPOLLHUP)) &&
+                                (!(events[i].events & EPOLLIN) || on_readable(fd, it->second)) &&
+                                (!(events[i].events & EPOLLOUT) || flush(fd, it->second));
+                if (!ok)
+                    close_client(fd);
+            }
+        }
+    }
+
+    void stream_server::accept_all()
+    {
+        for (;;)
+        {
+            const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                return;
+            }
+            if (clients_.size() >= MAX_CLIENTS)
+            {
+                close(fd);
+                continue;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0)
+            {
+                close(fd);
+                continue;
+            }
+            clients_.try_emplace(fd);
+            client_count_.store(clients_.size(), std::memory_order_relaxed);
+        }
+    }
+
+    void stream_server::fan_out(const sample_frame &frame)
+    {
+        std::vector<int> broken;
+        for (auto &[fd, c] : clients_)
+        {
+            enqueue(c, frame);
+            if (c.size && !c.writing && !flush(fd, c))
+                broken.push_back(fd);
+        }
+        for (int fd : broken)
+            close_client(fd);
+    }
+
+    void stream_server::enqueue(client &c, const sample_frame &frame)
+    {
+        if (!(frame.valid & c.filter.mask))
+            return;
+        if (c.matched++ % c.filter.every != 0)
+            return;
+
+        if (c.size == CLIENT_QUEUE)
+        {
+            // Drop the oldest frame; one that is half written stays at the head
+            const size_t next = (c.head + 1) % CLIENT_QUEUE;
+            if (c.offset)
+                c.ring[next] = c.ring[c.head];
+            c.head = next;
+            --c.size;
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        encoded_frame &slot = c.ring[(c.head + c.size) % CLIENT_QUEUE];
+        slot.size = static_cast<uint8_t>(encode_stream_frame(frame, c.filter.mask, c.seq++, slot.bytes.data()));
+        ++c.size;
+    }
+
+    bool stream_server::on_readable(int fd, client &c)
+    {
+        char buf[512];
+        for (;;)
+        {
+            const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n > 0)
+            {
+                c.in.append(buf, static_cast<size_t>(n));
+                continue;
+            }
+            if (n == 0)
+            {
+                // Done sending requests (e.g. piped through socat); keep streaming
+                c.read_closed = true;
+                update_events(fd, c);
+                break;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+
+        size_t eol;
+        while ((eol = c.in.find('\n')) != std::string::npos)
+        {
+            stream_filter filter;
+            if (parse_stream_request(std::string_view(c.in).substr(0, eol), filter))
+            {
+                c.filter = filter;
+                c.matched = 0;
+            }
+            c.in.erase(0, eol + 1);
+        }
+        // Requests are one short line; anything longer is not a client of ours
+        return c.in.size() <= 256;
+    }
+
+    bool stream_server::flush(int fd, client &c)
+    {
+        while (c.size)
+        {
+            const encoded_frame &f = c.ring[c.head];
+            const ssize_t n = send(fd, f.bytes.data() + c.offset, f.size - c.offset, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                c.offset += static_cast<size_t>(n);
+                if (c.offset == f.size)
+                {
+                    c.offset = 0;
+                    c.head = (c.head + 1) % CLIENT_QUEUE;
+                    --c.size;
+                }
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                if (!c.writing)
+                {
+                    c.writing = true;
+                    update_events(fd, c);
+                }
+                return true;
+            }
+            return false;
+        }
+        if (c.writing)
+        {
+            c.writing = false;
+            update_events(fd, c);
+        }
+        return true;
+    }
+
+    void stream_server::update_events(int fd, const client &c)
+    {
+        epoll_event ev{};
+        ev.events = (c.read_closed ? 0u : static_cast<uint32_t>(EPOLLIN)) | (c.writing ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    void stream_server::close_client(int fd)
+    {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        clients_.erase(fd);
+        client_count_.store(clients_.size(), std::memory_order_relaxed);
+    }
+
+} // namespace app
@@ -0,0 +1,342 @@
+/**
+ * @file tsdb.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  In-memory time-series store with 1 min / 1 h rollups
+ * @version 0.1
+ * @date 2026-01-25
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/tsdb.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+namespace app
+{
+    static int64_t floor_to(int64_t t, int64_t period)
+    {
+        int64_t q = t / period;
+        if (t % period < 0)
+            --q;
+        return q * period;
+    }
+
+    void tsdb_rollup::add(float value)
+    {
+        if (count == 0)
+        {
+            min = max = value;
+        }
+        else
+        {
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+        sum += value;
+        ++count;
+    }
+
+    void tsdb_rollup::merge(const tsdb_rollup &other)
+    {
+        if (other.count == 0)
+            return;
+        if (count == 0)
+        {
+            *this = other;
+            return;
+        }
+        start_ns = std::min(start_ns, other.start_ns);
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        sum += other.sum;
+        count += other.count;
+    }
+
+    // ---- rings: logical index 0 is the oldest entry ----
+
+    void tsdb::raw_ring::push(int64_t t, float v)
+    {
+        time[head] = t;
+        value[head] = v;
+        head = (head + 1) % time.size();
+        size = std::min(size + 1, time.size());
+    }
+
+    void tsdb::raw_ring::pop_back()
+    {
+        head = (head + time.size() - 1) % time.size();
+        --size;
+    }
+
+    size_t tsdb::raw_ring::index(size_t logical) const
+    {
+        return (head + time.size() - size + logical) % time.size();
+    }
+
+    size_t tsdb::raw_ring::lower_bound(int64_t t) const
+    {
+        size_t lo = 0, hi = size;
+        while (lo < hi)
+        {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (time[index(mid)] < t)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    void tsdb::rollup_ring::push(const tsdb_rollup &bucket)
+    {
+        start[head] = bucket.start_ns;
+        min[head] = bucket.min;
+        max[head] = bucket.max;
+        sum[head] = bucket.sum;
+        count[head] = bucket.count;
+        head = (head + 1) % start.size();
+        size = std::min(size + 1, start.size());
+    }
+
+    tsdb_rollup tsdb::rollup_ring::pop_back()
+    {
+        const tsdb_rollup bucket = at(size - 1);
+        head = (head + start.size() - 1) % start.size();
+        --size;
+        return bucket;
+    }
+
+    tsdb_rollup tsdb::rollup_ring::at(size_t logical) const
+    {
+        const size_t i = index(logical);
+        return {start[i], min[i], max[i], sum[i], count[i]};
+    }
+
+    size_t tsdb::rollup_ring::index(size_t logical) const
+    {
+        return (head + start.size() - size + logical) % start.size();
+    }
+
+    size_t tsdb::rollup_ring::lower_bound(int64_t t) const
+    {
+        size_t lo = 0, hi = size;
+        while (lo < hi)
+        {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (start[index(mid)] < t)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    // ---- store ----
+
+    tsdb::tsdb(const tsdb_settings &settings)
+    {
+        auto resize_rollups = [](rollup_ring &ring, size_t n) {
+            n = std::max<size_t>(n, 1);
+            ring.start.resize(n);
+            ring.min.resize(n);
+            ring.max.resize(n);
+            ring.sum.resize(n);
+            ring.count.resize(n);
+        };
+
+        for (auto &store : channels_)
+        {
+            const size_t raw = std::max<size_t>(settings.raw_capacity, 1);
+            store.raw.time.resize(raw);
+            store.raw.value.resize(raw);
+            resize_rollups(store.minutes, settings.minute_capacity);
+            resize_rollups(store.hours, settings.hour_capacity);
+        }
+    }
+
+    tsdb::~tsdb()
+    {
+        if (ingest_.joinable())
+        {
+            ingest_.request_stop();
+            ingest_.join();
+        }
+    }
+
+    void tsdb::rewind(channel_store &store, int64_t wall_ns)
+    {
+        while (store.raw.size && store.raw.time[store.raw.index(store.raw.size - 1)] >= wall_ns)
+            store.raw.pop_back();
+
+        // The bucket holding wall_ns is kept (reopened if it was closed) and goes on
+        // collecting; only later buckets are dropped
+        auto rewind_rollups = [](rollup_ring &ring, tsdb_rollup &open, int64_t bucket) {
+            if (open.count && open.start_ns > bucket)
+                open = {};
+            while (ring.size && ring.at(ring.size - 1).start_ns > bucket)
+                ring.pop_back();
+            if (!open.count && ring.size && ring.at(ring.size - 1).start_ns == bucket)
+                open = ring.pop_back();
+        };
+        rewind_rollups(store.minutes, store.open_minute, floor_to(wall_ns, MINUTE_NS));
+        rewind_rollups(store.hours, store.open_hour, floor_to(wall_ns, HOUR_NS));
+        store.newest_ns = wall_ns;
+    }
+
+    void tsdb::append_value(channel_store &store, int64_t wall_ns, float value)
+    {
+        if (wall_ns < store.newest_ns)
+        {
+            out_of_order_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        store.newest_ns = wall_ns;
+        store.raw.push(wall_ns, value);
+
+        const int64_t minute = floor_to(wall_ns, MINUTE_NS);
+        if (store.open_minute.count && store.open_minute.start_ns != minute)
+        {
+            store.minutes.push(store.open_minute);
+            store.open_minute = {};
+        }
+        store.open_minute.start_ns = minute;
+        store.open_minute.add(value);
+
+        const int64_t hour = floor_to(wall_ns, HOUR_NS);
+        if (store.open_hour.count && store.open_hour.start_ns != hour)
+        {
+            store.hours.push(store.open_hour);
+            store.open_hour = {};
+        }
+        store.open_hour.start_ns = hour;
+        store.open_hour.add(value);
+    }
+
+    void tsdb::append(const sample_frame &frame)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        bool stepped = false;
+        for (size_t i = 0; i < CHANNEL_COUNT; ++i)
+        {
+            if (!frame.has(channel(i)))
+                continue;
+            channel_store &store = channels_[i];
+            if (store.newest_ns != INT64_MIN && store.newest_ns - frame.wall_ns >= CLOCK_STEP_NS)
+            {
+                rewind(store, frame.wall_ns);
+                stepped = true;
+            }
+            append_value(store, frame.wall_ns, static_cast<float>(frame.values[i]));
+        }
+        if (stepped)
+        {
+            clock_steps_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "tsdb: wall clock stepped back, dropping samples stamped after it" << std::endl;
+        }
+    }
+
+    bool tsdb::attach(sample_bus &bus)
+    {
+        if (feed_)
+            return true;
+        feed_ = bus.subscribe("tsdb");
+        if (!feed_)
+        {
+            std::cerr << "tsdb: sample bus has no free subscription" << std::endl;
+            return false;
+        }
+        ingest_ = std::jthread([this](std::stop_token stop) { ingest_loop(stop); });
+        return true;
+    }
+
+    void tsdb::ingest_loop(std::stop_token stop)
+    {
+        sample_frame frame;
+        while (!stop.stop_requested())
+        {
+            if (feed_->wait_pop(frame, stop, std::chrono::milliseconds(1000)))
+                append(frame);
+        }
+    }
+
+    size_t tsdb::query_raw(channel ch, int64_t from_ns, int64_t to_ns, std::vector<tsdb_point> &out) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const raw_ring &ring = channels_[static_cast<size_t>(ch)].raw;
+        const size_t before = out.size();
+        for (size_t i = ring.lower_bound(from_ns); i < ring.size; ++i)
+        {
+            const size_t k = ring.index(i);
+            if (ring.time[k] >= to_ns)
+                break;
+            out.push_back({ring.time[k], ring.value[k]});
+        }
+        return out.size() - before;
+    }
+
+    size_t tsdb::query_rollups(channel ch, tsdb_tier tier, int64_t from_ns, int64_t to_ns,
+                               std::vector<tsdb_rollup> &out) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const channel_store &store = channels_[static_cast<size_t>(ch)];
+        const rollup_ring &ring = tier == tsdb_tier::minute ? store.minutes : store.hours;
+        const tsdb_rollup &open = tier == tsdb_tier::minute ? store.open_minute : store.open_hour;
+
+        const size_t before = out.size();
+        for (size_t i = ring.lower_bound(from_ns); i < ring.size; ++i)
+        {
+            tsdb_rollup bucket = ring.at(i);
+            if (bucket.start_ns >= to_ns)
+                return out.size() - before;
+            out.push_back(bucket);
+        }
+        if (open.count && open.start_ns >= from_ns && open.start_ns < to_ns)
+            out.push_back(open);
+        return out.size() - before;
+    }
+
+    tsdb_rollup tsdb::summarize(channel ch, int64_t from_ns, int64_t to_ns) const
+    {
+        const channel_store &store = channels_[static_cast<size_t>(ch)];
+        tsdb_tier tier = tsdb_tier::hour;
+        bool raw = false;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto oldest_minute = store.minutes.size ? store.minutes.at(0).start_ns : store.open_minute.start_ns;
+            if (store.raw.size && store.raw.time[store.raw.index(0)] <= from_ns)
+                raw = true;
+            else if ((store.minutes.size || store.open_minute.count) && oldest_minute <= from_ns)
+                tier = tsdb_tier::minute;
+        }
+
+        tsdb_rollup result;
+        if (raw)
+        {
+            std::vector<tsdb_point> points;
+            query_raw(ch, from_ns, to_ns, points);
+            for (const auto &p : points)
+                result.add(p.value);
+            result.start_ns = points.empty() ? from_ns : points.front().wall_ns;
+            return result;
+        }
+
+        std::vector<tsdb_rollup> buckets;
+        query_rollups(ch, tier, from_ns, to_ns, buckets);
+        for (const auto &b : buckets)
+            result.merge(b);
+        return result;
+    }
+
+    size_t tsdb::footprint_bytes() const
+    {
+        const auto &store = channels_[0];
+        const size_t raw = store.raw.time.size() * (sizeof(int64_t) + sizeof(float));
+        const size_t per_bucket = sizeof(int64_t) + 2 * sizeof(float) + sizeof(double) + sizeof(uint32_t);
+        const size_t rollups = (store.minutes.start.size() + store.hours.start.size()) * per_bucket;
+        return sizeof(*this) + CHANNEL_COUNT * (raw + rollups);
+    }
+
+} // namespace app
@@ -0,0 +1,193 @@
+/**
+ * @file wall_clock.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  RTC-disciplined wall clock on top of CLOCK_MONOTONIC
+ * @version 0.1
+ * @date 2026-01-22
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "app/wall_clock.h"
+#include <cmath>
+#include <iostream>
+
+namespace app
+{
+    static int64_t to_ns(wall_clock::mono_point t)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    void wall_clock::discipline(mono_point mono, int64_t wall_ns)
+    {
+        const int64_t mono_ns = to_ns(mono);
+        model m = model_.load();
+
+        if (have_first_)
+        {
+            const int64_t mono_span = mono_ns - first_mono_ns_;
+            const int64_t wall_span = wall_ns - first_wall_ns_;
+            const int64_t min_span = std::chrono::duration_cast<std::chrono::nanoseconds>(MIN_RATE_BASELINE).count();
+            if (mono_span >= min_span)
+            {
+                // Measured over the whole baseline, so the anchor jitter shrinks with uptime
+                const double rate = double(wall_span - mono_span) / double(mono_span);
+                if (std::fabs(rate) <= MAX_RATE)
+                {
+                    m.rate = rate;
+                }
+                else
+                {
+                    // Reference was stepped: start a new baseline
+                    first_mono_ns_ = mono_ns;
+                    first_wall_ns_ = wall_ns;
+                    m.rate = 0.0;
+                }
+            }
+        }
+        else
+        {
+            have_first_ = true;
+            first_mono_ns_ = mono_ns;
+            first_wall_ns_ = wall_ns;
+        }
+
+        m.mono_anchor_ns = mono_ns;
+        m.wall_anchor_ns = wall_ns;
+        m.synced = true;
+        model_.store(m);
+    }
+
+    int64_t wall_clock::wall_ns_at(mono_point mono) const
+    {
+        const model m = model_.load();
+        if (!m.synced)
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count();
+
+        const int64_t elapsed = to_ns(mono) - m.mono_anchor_ns;
+        return m.wall_anchor_ns + elapsed + static_cast<int64_t>(std::llround(double(elapsed) * m.rate));
+    }
+
+    std::chrono::system_clock::time_point wall_clock::now() const
+    {
+        const auto ns = std::chrono::nanoseconds(wall_ns_at(std::chrono::steady_clock::now()));
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(ns));
+    }
+
+    timekeeper::timekeeper(wall_clock &clock, peripherals::rtc_iface *rtc, std::chrono::seconds resync_interval)
+        : clock_(clock), rtc_(rtc), resync_interval_(resync_interval)
+    {
+        worker_ = std::jthread([this](std::stop_token stop) { loop(stop); });
+    }
+
+    timekeeper::~timekeeper()
+    {
+        worker_.request_stop();
+        cv_.notify_all();
+    }
+
+    bool timekeeper::sync_once(std::stop_token stop)
+    {
+        if (!rtc_)
+        {
+            clock_.discipline(std::chrono::steady_clock::now(),
+                              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch()).count());
+            return true;
+        }
+
+        peripherals::time_data first{};
+        if (rtc_->read_data(first) != peripherals::Status::Success || !first.valid)
+        {
+            if (!clock_.synced())
+                clock_.discipline(std::chrono::steady_clock::now(),
+                                  std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::system_clock::now().time_since_epoch()).count());
+            return false;
+        }
+
+        // Poll for the seconds edge; the edge lies between the last two reads
+        auto before = std::chrono::steady_clock::now();
+        const auto deadline = before + std::chrono::milliseconds(1100);
+        while (std::chrono::steady_clock::now() < deadline && !stop.stop_requested())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            peripherals::time_data t{};
+            if (rtc_->read_data(t) != peripherals::Status::Success || !t.valid)
+                return false;
+            const auto after = std::chrono::steady_clock::now();
+            if (t.second != first.second)
+            {
+                const auto edge = before + (after - before) / 2;
+                clock_.discipline(edge, to_unix_seconds(t) * 1000000000LL);
+                return true;
+            }
+            before = after;
+        }
+        return false;
+    }
+
+    void timekeeper::loop(std::stop_token stop)
+    {
+        if (!sync_once(stop) && !stop.stop_requested())
+            std::cerr << "timekeeper: initial RTC read failed, using system clock" << std::endl;
+        while (!stop.stop_requested())
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_for(lock, stop, resync_interval_, [] { return false; });
+            }
+            if (stop.stop_requested())
+                return;
+            sync_once(stop);
+        }
+    }
+
+    // days_from_civil / civil_from_days (H. Hinnant)
+    int64_t to_unix_seconds(const peripherals::time_data &t)
+    {
+        const int64_t y = t.year - (t.month <= 2 ? 1 : 0);
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const int64_t yoe = y - era * 400;
+        const int64_t mp = (t.month + 9) % 12;
+        const int64_t doy = (153 * mp + 2) / 5 + t.day - 1;
+        const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        const int64_t days = era * 146097 + doe - 719468;
+        return days * 86400 + t.hour * 3600 + t.minute * 60 + t.second;
+    }
+
+    peripherals::time_data from_unix_seconds(int64_t seconds)
+    {
+        int64_t days = seconds / 86400;
+        int64_t rem = seconds % 86400;
+        if (rem < 0)
+        {
+            rem += 86400;
+            --days;
+        }
+
+        const int64_t z = days + 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const int64_t doe = z - era * 146097;
+        const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const int64_t mp = (5 * doy + 2) / 153;
+        const int64_t d = doy - (153 * mp + 2) / 5 + 1;
+        const int64_t m = mp < 10 ? mp + 3 : mp - 9;
+
+        peripherals::time_data t{};
+        t.year = static_cast<int>(yoe + era * 400 + (m <= 2 ? 1 : 0));
+        t.month = static_cast<int>(m);
+        t.day = static_cast<int>(d);
+        t.hour = static_cast<int>(rem / 3600);
+        t.minute = static_cast<int>((rem % 3600) / 60);
+        t.second = static_cast<int>(rem % 60);
+        t.valid = true;
+        return t;
+    }
+
+} // namespace app
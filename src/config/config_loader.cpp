@@ -4,123 +4,205 @@
  * @brief  Configuration loader for the application
  * @version 0.1
  * @date 2025-12-23
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 
 #include "config/config_loader.h"
+#include "config/json_parser.h"
 
-#ifdef USE_BOOST
-    #include <boost/property_tree/ptree.hpp>
-    #include <boost/property_tree/json_parser.hpp>
-#else
-    #include "config/json_parser.h"
-#endif
-
+#include <charconv>
 #include <iostream>
+#include <cmath>
 
 namespace config {
 
-#ifdef USE_BOOST
-using boost::property_tree::ptree;
+static bool is_core_key(std::string_view key)
+{
+    return key == "connection" || key == "type" || key == "device" || key == "address";
+}
 
-bool load_config(const std::string &path, AppConfig &out)
+// "0x76" / "118", or a plain number; false (and the load fails) unless it is an
+// integer 0..255. A value of another type keeps the default.
+static bool read_address(json::Reader &in, int &address, std::string &text)
 {
-    ptree root;
-    try {
-        boost::property_tree::read_json(path, root);
-    }
-    catch (const std::exception &e) {
-        std::cerr << "Failed to read config: " << e.what() << std::endl;
-        return false;
+    json::Token token = in.read_scalar();
+    if (token == json::Token::Number) {
+        const double n = in.number();
+        text = in.raw();
+        if (!(n >= 0 && n <= 255) || n != std::floor(n))
+            return false;
+        address = static_cast<int>(n);
+    } else if (token == json::Token::String) {
+        text = in.string();
+        std::string_view digits = text;
+        int base = 10;
+        if (digits.starts_with("0x") || digits.starts_with("0X")) {
+            digits.remove_prefix(2);
+            base = 16;
+        }
+        unsigned value = 0;
+        auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value, base);
+        if (digits.empty() || ec != std::errc() || end != digits.data() + digits.size() || value > 255)
+            return false;
+        address = static_cast<int>(value);
     }
+    return true;
+}
 
-    out.peripherals.clear();
-    out.log_path = root.get<std::string>("log_path", "atmolyt_data.csv");
-    
-    for (auto &item : root.get_child("peripherals")) {
-        PeripheralSpec spec;
-        ptree node = item.second;
-        try {
-            spec.connection = node.get<std::string>("connection", "i2c");
-            spec.type = node.get<std::string>("type", "bme280");
-            spec.device = node.get<std::string>("device", "");
-            std::string addr = node.get<std::string>("address", "0x76");
-            try {
-                if (addr.rfind("0x", 0) == 0 || addr.rfind("0X", 0) == 0)
-                    spec.address = static_cast<uint8_t>(std::stoul(addr, nullptr, 16));
-                else
-                    spec.address = static_cast<uint8_t>(std::stoul(addr));
-            } catch (...) { spec.address = 0x76; }
-
-            out.peripherals.push_back(spec);
-        }
-        catch (...) {
-            // skip invalid entry
-        }
+// Scalars become option strings; nested objects/arrays and nulls are ignored
+static void read_option(json::Reader &in, PeripheralSpec &spec, std::string key)
+{
+    switch (in.read_scalar()) {
+    case json::Token::String:
+        spec.options[std::move(key)] = in.string();
+        break;
+    case json::Token::Boolean:
+        spec.options[std::move(key)] = in.boolean() ? "true" : "false";
+        break;
+    case json::Token::Number: {
+        double n = in.number();
+        if (std::floor(n) == n && std::fabs(n) < 9.0e15)
+            spec.options[std::move(key)] = std::to_string(static_cast<long long>(n));
+        else
+            spec.options[std::move(key)] = in.raw();
+        break;
+    }
+    default:
+        break;
     }
+}
 
-    return true;
+// error is set (and the entry dropped) for an address the bus cannot have
+static void read_peripheral(json::Reader &in, AppConfig &cfg, std::string &error)
+{
+    PeripheralSpec spec;
+    spec.connection = "i2c";
+    spec.type = "bme280";
+    int address = 0x76;
+    bool address_ok = true;
+    std::string address_text;
+
+    bool is_object = in.object([&](std::string_view key) {
+        if (key == "connection")
+            in.read(spec.connection);
+        else if (key == "type")
+            in.read(spec.type);
+        else if (key == "device")
+            in.read(spec.device);
+        else if (key == "address")
+            address_ok = read_address(in, address, address_text);
+        else if (!is_core_key(key))
+            read_option(in, spec, std::string(key)); // copy: the key view dies with the next string
+    });
+
+    if (!is_object)
+        return; // skip invalid entry
+
+    // 7-bit addressing on I2C; the connection may come after the address
+    if (!address_ok || (spec.connection == "i2c" && address > 0x7F)) {
+        if (error.empty())
+            error = spec.type + ": invalid address " + address_text +
+                    (spec.connection == "i2c" ? " (expected 0..0x7F)" : " (expected 0..0xFF)");
+        return;
+    }
+    spec.address = static_cast<uint8_t>(address);
+    cfg.peripherals.push_back(std::move(spec));
 }
 
-#else  // Fallback JSON parser without boost
+static void read_mqtt(json::Reader &in, MqttConfig &mqtt)
+{
+    in.object([&](std::string_view key) {
+        if (key == "broker")
+            in.read(mqtt.broker);
+        else if (key == "client_id")
+            in.read(mqtt.client_id);
+        else if (key == "topic")
+            in.read(mqtt.topic);
+        else if (key == "username")
+            in.read(mqtt.username);
+        else if (key == "password")
+            in.read(mqtt.password);
+        else if (key == "qos")
+            in.read(mqtt.qos);
+        else if (key == "batch")
+            in.read(mqtt.batch);
+        else if (key == "max_inflight")
+            in.read(mqtt.max_inflight);
+        else if (key == "keepalive_s")
+            in.read(mqtt.keepalive_s);
+        else if (key == "spool_dir")
+            in.read(mqtt.spool_dir);
+        else if (key == "spool_max_mb")
+            in.read(mqtt.spool_max_mb);
+        else if (key == "drain_per_s")
+            in.read(mqtt.drain_per_s);
+    });
+}
 
+// Single pass over the mapped file straight into AppConfig, no DOM
 bool load_config(const std::string &path, AppConfig &out)
 {
-    auto root = json::parse_file(path);
-    if (!root) {
+    json::FileBuffer file;
+    if (!file.load(path)) {
         std::cerr << "Failed to read config: " << path << std::endl;
         return false;
     }
 
-    if (!root->is_object()) {
+    AppConfig cfg;
+    bool have_peripherals = false;
+    std::string invalid;
+    json::Reader in(file.view());
+
+    bool is_object = in.object([&](std::string_view key) {
+        if (key == "log_path")
+            in.read(cfg.log_path);
+        else if (key == "sparkline_minutes")
+            in.read(cfg.sparkline_minutes);
+        else if (key == "raw_capture_path")
+            in.read(cfg.raw_capture_path);
+        else if (key == "history_minutes")
+            in.read(cfg.history_minutes);
+        else if (key == "read_budget_ms")
+            in.read(cfg.read_budget_ms);
+        else if (key == "poll_interval_ms")
+            in.read(cfg.poll_interval_ms);
+        else if (key == "metrics_listen")
+            in.read(cfg.metrics_listen);
+        else if (key == "shm_name")
+            in.read(cfg.shm_name);
+        else if (key == "stream_socket")
+            in.read(cfg.stream_socket);
+        else if (key == "mqtt")
+            read_mqtt(in, cfg.mqtt);
+        else if (key == "peripherals") {
+            cfg.peripherals.clear();
+            have_peripherals = in.array([&] { read_peripheral(in, cfg, invalid); });
+        }
+    });
+    if (is_object)
+        in.next(); // must be the end of input
+
+    if (in.failed()) {
+        std::cerr << "Failed to read config: " << path << ": " << in.error() << std::endl;
+        return false;
+    }
+    if (!is_object) {
         std::cerr << "Config root must be an object" << std::endl;
         return false;
     }
-
-    out.peripherals.clear();
-    out.log_path = root->get_string("log_path", "atmolyt_data.csv");
-    
-    auto peripherals_val = root->get("peripherals");
-    if (!peripherals_val || !peripherals_val->is_array()) {
-        std::cerr << "Missing or invalid 'peripherals' array in config" << std::endl;
+    if (!invalid.empty()) {
+        std::cerr << "Invalid config: " << path << ": " << invalid << std::endl;
         return false;
     }
-
-    const auto& peripherals = peripherals_val->as_array();
-    for (const auto& item : peripherals) {
-        if (!item || !item->is_object()) {
-            // skip invalid entry
-            continue;
-        }
-
-        PeripheralSpec spec;
-        try {
-            spec.connection = item->get_string("connection", "i2c");
-            spec.type = item->get_string("type", "bme280");
-            spec.device = item->get_string("device", "");
-            
-            std::string addr = item->get_string("address", "0x76");
-            try {
-                if (addr.rfind("0x", 0) == 0 || addr.rfind("0X", 0) == 0)
-                    spec.address = static_cast<uint8_t>(std::stoul(addr, nullptr, 16));
-                else
-                    spec.address = static_cast<uint8_t>(std::stoul(addr));
-            } catch (...) { 
-                spec.address = 0x76; 
-            }
-
-            out.peripherals.push_back(spec);
-        }
-        catch (...) {
-            // skip invalid entry
-        }
+    if (!have_peripherals) {
+        std::cerr << "Missing or invalid 'peripherals' array in config" << std::endl;
+        return false;
     }
 
+    out = std::move(cfg);
     return true;
 }
 
-#endif
-
 } // namespace config
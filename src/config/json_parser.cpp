@@ -4,92 +4,313 @@
  * @brief  Simple JSON parser implementation
  * @version 0.1
  * @date 2025-12-27
- * 
+ *
  * @copyright Copyright (c) 2025
- * 
+ *
  */
 
 #include "config/json_parser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <sstream>
-#include <cctype>
 #include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace json {
 
+static constexpr size_t MAX_DEPTH = 256;
+
+// "line L, column C" of a byte offset, both 1-based; only computed for errors
+static std::string describe_position(std::string_view text, size_t offset) {
+    offset = std::min(offset, text.size());
+    size_t line = 1, line_start = 0;
+    for (size_t i = 0; i < offset; i++) {
+        if (text[i] == '\n') {
+            line++;
+            line_start = i + 1;
+        }
+    }
+    return "line " + std::to_string(line) + ", column " + std::to_string(offset - line_start + 1);
+}
+
+static bool is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// From just past the opening quote to the closing one (size if unterminated)
+static size_t find_string_end(const char* data, size_t size, size_t pos, bool& escaped) {
+    escaped = false;
+    while (pos < size) {
+        if (data[pos] == '"') {
+            return pos;
+        }
+        if (data[pos] == '\\') {
+            escaped = true;
+            pos++;
+        }
+        pos++;
+    }
+    return size;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(const char* in, size_t len, size_t pos, uint32_t& code) {
+    if (len - pos < 4) {
+        return false;
+    }
+    code = 0;
+    for (size_t i = 0; i < 4; i++) {
+        int digit = hex_digit(in[pos + i]);
+        if (digit < 0) {
+            return false;
+        }
+        code = (code << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+static char* put_utf8(char* out, uint32_t code) {
+    if (code < 0x80) {
+        *out++ = static_cast<char>(code);
+    } else if (code < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (code >> 6));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (code >> 12));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (code >> 18));
+        *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    }
+    return out;
+}
+
+// Decodes the escapes of a string body into out, which may alias in (the
+// result is never longer). Unknown escapes keep the character, as before.
+// On a malformed \u escape returns false with bad set to its offset.
+static bool unescape(const char* in, size_t len, char* out, size_t& out_len, size_t& bad) {
+    char* const out_start = out;
+    size_t pos = 0;
+    while (pos < len) {
+        char c = in[pos++];
+        if (c != '\\' || pos == len) {
+            *out++ = c;
+            continue;
+        }
+        c = in[pos++];
+        switch (c) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!read_hex4(in, len, pos, code)) {
+                    bad = pos - 2;
+                    return false;
+                }
+                pos += 4;
+                uint32_t low;
+                if (code >= 0xD800 && code < 0xDC00 && len - pos >= 6 && in[pos] == '\\' && in[pos + 1] == 'u' &&
+                    read_hex4(in, len, pos + 2, low) && low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    pos += 6;
+                }
+                out = put_utf8(out, code);
+                break;
+            }
+            default: *out++ = c; // '"', '\\', '/' and anything unknown
+        }
+    }
+    out_len = static_cast<size_t>(out - out_start);
+    return true;
+}
+
+// Scans a number token at pos and advances past it
+static bool scan_number(const char* data, size_t size, size_t& pos, double& value) {
+    const size_t start = pos;
+    if (pos < size && data[pos] == '-') {
+        pos++;
+    }
+
+    bool integral = true;
+    while (pos < size) {
+        char c = data[pos];
+        if (c >= '0' && c <= '9') {
+            pos++;
+        } else if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+            integral = false;
+            pos++;
+        } else {
+            break;
+        }
+    }
+
+    const size_t len = pos - start;
+    const char* text = data + start;
+
+    // Integers that fit a double exactly skip strtod
+    const size_t digits = len - (text[0] == '-' ? 1 : 0);
+    if (integral && digits > 0 && digits <= 15) {
+        int64_t number = 0;
+        for (size_t i = len - digits; i < len; i++) {
+            number = number * 10 + (text[i] - '0');
+        }
+        value = static_cast<double>(text[0] == '-' ? -number : number);
+        return true;
+    }
+
+    // The buffer is not NUL-terminated (a mapped file may end on a page boundary)
+    char buf[64];
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+    std::memcpy(buf, text, len);
+    buf[len] = '\0';
+    char* end = nullptr;
+    value = std::strtod(buf, &end);
+    return end == buf + len;
+}
+
+static bool match_word(const char* data, size_t size, size_t& pos, const char* word, size_t len) {
+    if (size - pos >= len && std::memcmp(data + pos, word, len) == 0) {
+        pos += len;
+        return true;
+    }
+    return false;
+}
+
+// Single pass over a writable buffer. Finished children are parked on a
+// scratch stack and moved into the arena as one block when their container
+// closes; escaped strings are decoded in place.
 class Parser {
 public:
-    explicit Parser(const std::string& str) : input_(str), pos_(0) {}
+    Parser(char* data, size_t size, std::vector<Node>& nodes) : data_(data), size_(size), nodes_(nodes) {}
 
-    std::shared_ptr<Value> parse() {
+    void parse() {
+        Node root = parse_value(0);
         skip_whitespace();
-        return parse_value();
+        if (pos_ != size_) {
+            fail("Trailing characters after JSON value");
+        }
+        place(root);
     }
 
 private:
-    std::string input_;
-    size_t pos_;
+    char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    std::vector<Node>& nodes_;
+    std::vector<Node> stack_;
 
-    char current() const { return pos_ < input_.length() ? input_[pos_] : '\0'; }
-    
-    char peek(int offset = 1) const {
-        return pos_ + offset < input_.length() ? input_[pos_ + offset] : '\0';
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(describe_position({data_, size_}, pos_) + ": " + what);
     }
 
+    char current() const { return pos_ < size_ ? data_[pos_] : '\0'; }
+
     void advance() { pos_++; }
 
     void skip_whitespace() {
-        while (pos_ < input_.length() && std::isspace(input_[pos_])) {
+        while (pos_ < size_ && is_whitespace(data_[pos_])) {
             pos_++;
         }
     }
 
-    std::shared_ptr<Value> parse_value() {
+    // Appends a node to the arena; containers turn the absolute index of
+    // their first child into the distance back from their own slot
+    void place(Node node) {
+        if (node.type == Type::Array || node.type == Type::Object) {
+            node.children.first = static_cast<uint32_t>(nodes_.size()) - node.children.first;
+        }
+        nodes_.push_back(node);
+    }
+
+    Node close(Type type, size_t base) {
+        Node node;
+        node.type = type;
+        node.children.count = static_cast<uint32_t>(stack_.size() - base);
+        node.children.first = static_cast<uint32_t>(nodes_.size());
+        for (size_t i = base; i < stack_.size(); ++i) {
+            place(stack_[i]);
+        }
+        stack_.resize(base);
+        return node;
+    }
+
+    Node parse_value(size_t depth) {
         skip_whitespace();
-        
+
         char c = current();
         if (c == '{') {
-            return parse_object();
+            return parse_object(depth + 1);
         } else if (c == '[') {
-            return parse_array();
+            return parse_array(depth + 1);
         } else if (c == '"') {
-            return std::make_shared<Value>(parse_string());
+            Node node;
+            node.type = Type::String;
+            parse_string(node.string.offset, node.string.length);
+            return node;
         } else if (c == 't' || c == 'f') {
             return parse_bool();
         } else if (c == 'n') {
             return parse_null();
-        } else if (c == '-' || std::isdigit(c)) {
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
             return parse_number();
         }
-        throw std::runtime_error("Invalid JSON value");
+        fail("Invalid JSON value");
     }
 
-    std::shared_ptr<Value> parse_object() {
-        Object obj;
+    Node parse_object(size_t depth) {
+        if (depth > MAX_DEPTH) {
+            fail("JSON nested too deeply");
+        }
+        const size_t base = stack_.size();
         advance(); // skip '{'
         skip_whitespace();
 
         if (current() == '}') {
             advance();
-            return std::make_shared<Value>(obj);
+            return close(Type::Object, base);
         }
 
         while (true) {
             skip_whitespace();
             if (current() != '"') {
-                throw std::runtime_error("Expected string key in object");
+                fail("Expected string key in object");
             }
-            std::string key = parse_string();
-            
+            uint32_t key_offset, key_length;
+            parse_string(key_offset, key_length);
+
             skip_whitespace();
             if (current() != ':') {
-                throw std::runtime_error("Expected ':' after key");
+                fail("Expected ':' after key");
             }
             advance();
-            
-            auto value = parse_value();
-            obj[key] = value;
-            
+
+            Node value = parse_value(depth);
+            value.key_offset = key_offset;
+            value.key_length = key_length;
+            stack_.push_back(value);
+
             skip_whitespace();
             if (current() == '}') {
                 advance();
@@ -97,188 +318,541 @@ private:
             } else if (current() == ',') {
                 advance();
             } else {
-                throw std::runtime_error("Expected ',' or '}' in object");
+                fail("Expected ',' or '}' in object");
             }
         }
-        return std::make_shared<Value>(obj);
+        return close(Type::Object, base);
     }
 
-    std::shared_ptr<Value> parse_array() {
-        Array arr;
+    Node parse_array(size_t depth) {
+        if (depth > MAX_DEPTH) {
+            fail("JSON nested too deeply");
+        }
+        const size_t base = stack_.size();
         advance(); // skip '['
         skip_whitespace();
 
         if (current() == ']') {
             advance();
-            return std::make_shared<Value>(arr);
+            return close(Type::Array, base);
         }
 
         while (true) {
-            arr.push_back(parse_value());
+            stack_.push_back(parse_value(depth));
             skip_whitespace();
-            
+
             if (current() == ']') {
                 advance();
                 break;
             } else if (current() == ',') {
                 advance();
             } else {
-                throw std::runtime_error("Expected ',' or ']' in array");
+                fail("Expected ',' or ']' in array");
             }
         }
-        return std::make_shared<Value>(arr);
+        return close(Type::Array, base);
     }
 
-    std::string parse_string() {
-        std::string result;
+    void parse_string(uint32_t& offset, uint32_t& length) {
         advance(); // skip opening '"'
-        
-        while (pos_ < input_.length() && current() != '"') {
-            if (current() == '\\') {
-                advance();
-                if (pos_ >= input_.length()) {
-                    throw std::runtime_error("Unexpected end of string");
-                }
-                char c = current();
-                switch (c) {
-                    case '"': result += '"'; break;
-                    case '\\': result += '\\'; break;
-                    case '/': result += '/'; break;
-                    case 'b': result += '\b'; break;
-                    case 'f': result += '\f'; break;
-                    case 'n': result += '\n'; break;
-                    case 'r': result += '\r'; break;
-                    case 't': result += '\t'; break;
-                    case 'u': {
-                        // Simple unicode escape - just skip for now
-                        advance();
-                        for (int i = 0; i < 3 && pos_ < input_.length(); i++) {
-                            advance();
-                        }
-                        continue;
-                    }
-                    default: result += c;
-                }
-                advance();
-            } else {
-                result += current();
-                advance();
-            }
+        const size_t start = pos_;
+        bool escaped;
+        const size_t end = find_string_end(data_, size_, start, escaped);
+        if (end == size_) {
+            fail("Unterminated string");
         }
-        
-        if (current() != '"') {
-            throw std::runtime_error("Unterminated string");
+
+        size_t decoded = end - start;
+        size_t bad;
+        if (escaped && !unescape(data_ + start, end - start, data_ + start, decoded, bad)) {
+            pos_ = start + bad;
+            fail("Invalid unicode escape");
         }
-        advance(); // skip closing '"'
-        return result;
+        pos_ = end + 1; // skip closing '"'
+        offset = static_cast<uint32_t>(start);
+        length = static_cast<uint32_t>(decoded);
     }
 
-    std::shared_ptr<Value> parse_number() {
-        std::string num_str;
-        if (current() == '-') {
-            num_str += current();
-            advance();
-        }
-        
-        while (pos_ < input_.length() && (std::isdigit(current()) || current() == '.' || 
-               current() == 'e' || current() == 'E' || current() == '+' || current() == '-')) {
-            num_str += current();
-            advance();
-        }
-        
-        try {
-            double value = std::stod(num_str);
-            return std::make_shared<Value>(value);
-        } catch (...) {
-            throw std::runtime_error("Invalid number: " + num_str);
+    Node parse_number() {
+        Node node;
+        node.type = Type::Number;
+        const size_t start = pos_;
+        if (!scan_number(data_, size_, pos_, node.number)) {
+            pos_ = start;
+            fail("Invalid number");
         }
+        return node;
     }
 
-    std::shared_ptr<Value> parse_bool() {
-        if (input_.substr(pos_, 4) == "true") {
-            pos_ += 4;
-            return std::make_shared<Value>(true);
-        } else if (input_.substr(pos_, 5) == "false") {
-            pos_ += 5;
-            return std::make_shared<Value>(false);
+    Node parse_bool() {
+        Node node;
+        node.type = Type::Boolean;
+        if (match_word(data_, size_, pos_, "true", 4)) {
+            node.boolean = true;
+            return node;
+        } else if (match_word(data_, size_, pos_, "false", 5)) {
+            node.boolean = false;
+            return node;
         }
-        throw std::runtime_error("Invalid boolean");
+        fail("Invalid boolean");
     }
 
-    std::shared_ptr<Value> parse_null() {
-        if (input_.substr(pos_, 4) == "null") {
-            pos_ += 4;
-            return std::make_shared<Value>();
+    Node parse_null() {
+        if (match_word(data_, size_, pos_, "null", 4)) {
+            return Node();
         }
-        throw std::runtime_error("Invalid null");
+        fail("Invalid null");
     }
 };
 
-std::shared_ptr<Value> Value::get(const std::string& key) const {
-    if (type_ != Type::Object) {
-        return nullptr;
+std::string_view Value::as_string() const {
+    return is_string() ? text(node_->string.offset, node_->string.length) : std::string_view();
+}
+
+std::string_view Value::key() const {
+    return node_ ? text(node_->key_offset, node_->key_length) : std::string_view();
+}
+
+size_t Value::size() const {
+    return is_array() || is_object() ? node_->children.count : 0;
+}
+
+Value::iterator Value::begin() const {
+    return size() ? iterator(text_, children()) : iterator(text_, nullptr);
+}
+
+Value::iterator Value::end() const {
+    return size() ? iterator(text_, children() + node_->children.count) : iterator(text_, nullptr);
+}
+
+Value Value::get(std::string_view key) const {
+    if (!is_object()) {
+        return Value();
     }
-    auto it = object_value_.find(key);
-    if (it != object_value_.end()) {
-        return it->second;
+    const Node* first = children();
+    for (const Node* n = first + node_->children.count; n != first;) {
+        --n;
+        if (n->key_length == key.size() && std::memcmp(text_ + n->key_offset, key.data(), key.size()) == 0) {
+            return Value(text_, n);
+        }
     }
-    return nullptr;
+    return Value();
 }
 
-std::string Value::get_string(const std::string& key, const std::string& default_val) const {
+std::string_view Value::get_string(std::string_view key, std::string_view default_val) const {
     auto val = get(key);
-    if (val && val->is_string()) {
-        return val->as_string();
+    if (val.is_string()) {
+        return val.as_string();
     }
     return default_val;
 }
 
-int Value::get_int(const std::string& key, int default_val) const {
+bool Value::is_int() const {
+    // The cast is undefined outside int; a fraction would be silently dropped
+    return is_number() && node_->number >= std::numeric_limits<int>::min() &&
+           node_->number <= std::numeric_limits<int>::max() && node_->number == std::trunc(node_->number);
+}
+
+int Value::get_int(std::string_view key, int default_val) const {
     auto val = get(key);
-    if (val && val->is_number()) {
-        return val->as_int();
+    if (val.is_int()) {
+        return val.as_int();
     }
     return default_val;
 }
 
-double Value::get_number(const std::string& key, double default_val) const {
+double Value::get_number(std::string_view key, double default_val) const {
     auto val = get(key);
-    if (val && val->is_number()) {
-        return val->as_number();
+    if (val.is_number()) {
+        return val.as_number();
     }
     return default_val;
 }
 
-bool Value::get_bool(const std::string& key, bool default_val) const {
+bool Value::get_bool(std::string_view key, bool default_val) const {
     auto val = get(key);
-    if (val && val->is_bool()) {
-        return val->as_bool();
+    if (val.is_bool()) {
+        return val.as_bool();
     }
     return default_val;
 }
 
-std::shared_ptr<Value> parse(const std::string& json_str) {
-    try {
-        Parser parser(json_str);
-        return parser.parse();
-    } catch (const std::exception& e) {
-        std::cerr << "JSON parse error: " << e.what() << std::endl;
-        return nullptr;
+FileBuffer::~FileBuffer() {
+    release();
+}
+
+FileBuffer::FileBuffer(FileBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+FileBuffer& FileBuffer::operator=(FileBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        mapped_ = other.mapped_;
+        owned_ = std::move(other.owned_);
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void FileBuffer::release() {
+    if (mapped_ && data_) {
+        munmap(data_, size_);
     }
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    owned_.reset();
 }
 
-std::shared_ptr<Value> parse_file(const std::string& filepath) {
+void FileBuffer::assign(std::string_view text) {
+    release();
+    owned_ = std::make_unique<char[]>(text.size() + 1);
+    std::memcpy(owned_.get(), text.data(), text.size());
+    data_ = owned_.get();
+    size_ = text.size();
+}
+
+bool FileBuffer::load(const std::string& filepath) {
+    release();
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Cannot open file: " << filepath << std::endl;
+        return false;
+    }
+
+    struct stat st{};
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        // Private and writable: strings are unescaped in place, the file stays untouched
+        map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+
+    if (map != MAP_FAILED) {
+        data_ = static_cast<char*>(map);
+        size_ = static_cast<size_t>(st.st_size);
+        mapped_ = true;
+        return true;
+    }
+
+    // Empty files, pipes, procfs and the like: read it the plain way
     std::ifstream file(filepath);
     if (!file.is_open()) {
         std::cerr << "Cannot open file: " << filepath << std::endl;
-        return nullptr;
+        return false;
     }
-
     std::stringstream buffer;
     buffer << file.rdbuf();
-    file.close();
+    assign(buffer.str());
+    return true;
+}
 
-    return parse(buffer.str());
+Document parse_buffer(FileBuffer&& buffer) {
+    Document doc;
+    doc.buffer_ = std::move(buffer);
+    try {
+        const size_t size = doc.buffer_.size();
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Input larger than 4 GiB");
+        }
+        // Pretty-printed configs run 30-50 bytes per node; saves most regrowth
+        doc.nodes_.reserve(size / 32 + 1);
+        Parser parser(doc.buffer_.data(), size, doc.nodes_);
+        parser.parse();
+    } catch (const std::exception& e) {
+        std::cerr << "JSON parse error: " << e.what() << std::endl;
+        return Document();
+    }
+    return doc;
+}
+
+Document parse(std::string_view json_str) {
+    FileBuffer buffer;
+    buffer.assign(json_str);
+    return parse_buffer(std::move(buffer));
+}
+
+Document parse_file(const std::string& filepath) {
+    FileBuffer buffer;
+    if (!buffer.load(filepath)) {
+        return Document();
+    }
+    return parse_buffer(std::move(buffer));
+}
+
+// ---- pull reader ----
+
+Token Reader::fail(const char* what) {
+    if (error_.empty()) {
+        error_ = describe_position(input_, pos_) + ": " + what;
+    }
+    return Token::Error;
+}
+
+void Reader::skip_whitespace() {
+    while (pos_ < input_.size() && is_whitespace(input_[pos_])) {
+        pos_++;
+    }
+}
+
+Token Reader::scalar(Token token) {
+    if (stack_.empty()) {
+        state_ = State::Done;
+    } else {
+        state_ = stack_.back() == '{' ? State::AfterMember : State::AfterElement;
+    }
+    return token;
+}
+
+Token Reader::close(Token token) {
+    pos_++;
+    stack_.pop_back();
+    return scalar(token);
+}
+
+bool Reader::read_string() {
+    const size_t start = pos_ + 1;
+    bool escaped;
+    const size_t end = find_string_end(input_.data(), input_.size(), start, escaped);
+    if (end == input_.size()) {
+        fail("Unterminated string");
+        return false;
+    }
+
+    if (escaped) {
+        scratch_.resize(end - start);
+        size_t decoded, bad;
+        if (!unescape(input_.data() + start, end - start, scratch_.data(), decoded, bad)) {
+            pos_ = start + bad;
+            fail("Invalid unicode escape");
+            return false;
+        }
+        string_ = std::string_view(scratch_.data(), decoded);
+    } else {
+        string_ = input_.substr(start, end - start);
+    }
+    pos_ = end + 1;
+    return true;
+}
+
+Token Reader::key() {
+    if (pos_ >= input_.size() || input_[pos_] != '"') {
+        return fail("Expected string key in object");
+    }
+    if (!read_string()) {
+        return Token::Error;
+    }
+    skip_whitespace();
+    if (pos_ >= input_.size() || input_[pos_] != ':') {
+        return fail("Expected ':' after key");
+    }
+    pos_++;
+    state_ = State::Value;
+    return Token::Key;
+}
+
+Token Reader::value() {
+    skip_whitespace();
+    const char c = pos_ < input_.size() ? input_[pos_] : '\0';
+    const size_t start = pos_;
+
+    if (c == '{' || c == '[') {
+        if (stack_.size() >= MAX_DEPTH) {
+            return fail("JSON nested too deeply");
+        }
+        pos_++;
+        stack_.push_back(c);
+        state_ = c == '{' ? State::FirstMember : State::FirstElement;
+        return c == '{' ? Token::BeginObject : Token::BeginArray;
+    } else if (c == '"') {
+        return read_string() ? scalar(Token::String) : Token::Error;
+    } else if (c == 't' || c == 'f') {
+        if (match_word(input_.data(), input_.size(), pos_, "true", 4)) {
+            boolean_ = true;
+        } else if (match_word(input_.data(), input_.size(), pos_, "false", 5)) {
+            boolean_ = false;
+        } else {
+            return fail("Invalid boolean");
+        }
+        raw_ = input_.substr(start, pos_ - start);
+        return scalar(Token::Boolean);
+    } else if (c == 'n') {
+        if (!match_word(input_.data(), input_.size(), pos_, "null", 4)) {
+            return fail("Invalid null");
+        }
+        raw_ = input_.substr(start, 4);
+        return scalar(Token::Null);
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        if (!scan_number(input_.data(), input_.size(), pos_, number_)) {
+            pos_ = start;
+            return fail("Invalid number");
+        }
+        raw_ = input_.substr(start, pos_ - start);
+        return scalar(Token::Number);
+    }
+    return fail("Invalid JSON value");
+}
+
+Token Reader::next() {
+    if (failed()) {
+        return Token::Error;
+    }
+    skip_whitespace();
+    const char c = pos_ < input_.size() ? input_[pos_] : '\0';
+
+    switch (state_) {
+        case State::Value:
+            return value();
+        case State::FirstMember:
+            if (c == '}') {
+                return close(Token::EndObject);
+            }
+            return key();
+        case State::Member:
+            return key();
+        case State::AfterMember:
+            if (c == ',') {
+                pos_++;
+                skip_whitespace();
+                return key();
+            } else if (c == '}') {
+                return close(Token::EndObject);
+            }
+            return fail("Expected ',' or '}' in object");
+        case State::FirstElement:
+            if (c == ']') {
+                return close(Token::EndArray);
+            }
+            return value();
+        case State::AfterElement:
+            if (c == ',') {
+                pos_++;
+                return value();
+            } else if (c == ']') {
+                return close(Token::EndArray);
+            }
+            return fail("Expected ',' or ']' in array");
+        case State::Done:
+            if (pos_ != input_.size()) {
+                return fail("Trailing characters after JSON value");
+            }
+            return Token::End;
+    }
+    return fail("Invalid reader state");
+}
+
+bool Reader::next_element() {
+    if (failed()) {
+        return false;
+    }
+    skip_whitespace();
+    const char c = pos_ < input_.size() ? input_[pos_] : '\0';
+
+    if (state_ == State::FirstElement || state_ == State::AfterElement) {
+        if (c == ']') {
+            close(Token::EndArray);
+            return false;
+        }
+        if (state_ == State::AfterElement) {
+            if (c != ',') {
+                fail("Expected ',' or ']' in array");
+                return false;
+            }
+            pos_++;
+        }
+        state_ = State::Value;
+        return true;
+    }
+    fail("Expected array element");
+    return false;
+}
+
+bool Reader::skip_container() {
+    size_t depth = 1;
+    while (depth) {
+        switch (next()) {
+            case Token::BeginObject:
+            case Token::BeginArray:
+                depth++;
+                break;
+            case Token::EndObject:
+            case Token::EndArray:
+                depth--;
+                break;
+            case Token::Error:
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+bool Reader::skip() {
+    Token token = next();
+    if (token == Token::BeginObject || token == Token::BeginArray) {
+        return skip_container();
+    }
+    return token != Token::Error;
+}
+
+Token Reader::read_scalar() {
+    Token token = next();
+    if ((token == Token::BeginObject || token == Token::BeginArray) && !skip_container()) {
+        return Token::Error;
+    }
+    return token;
+}
+
+bool Reader::read(std::string& out) {
+    Token token = next();
+    if (token == Token::String) {
+        out.assign(string_);
+    } else if (token == Token::BeginObject || token == Token::BeginArray) {
+        return skip_container();
+    }
+    return token != Token::Error;
+}
+
+bool Reader::read(int& out) {
+    Token token = next();
+    if (token == Token::Number) {
+        // The cast is undefined outside int; a fraction would be silently dropped
+        if (!(number_ >= std::numeric_limits<int>::min() && number_ <= std::numeric_limits<int>::max()) ||
+            number_ != std::trunc(number_)) {
+            fail("Expected an integer within int range");
+            return false;
+        }
+        out = static_cast<int>(number_);
+    } else if (token == Token::BeginObject || token == Token::BeginArray) {
+        return skip_container();
+    }
+    return token != Token::Error;
+}
+
+bool Reader::read(double& out) {
+    Token token = next();
+    if (token == Token::Number) {
+        out = number_;
+    } else if (token == Token::BeginObject || token == Token::BeginArray) {
+        return skip_container();
+    }
+    return token != Token::Error;
+}
+
+bool Reader::read(bool& out) {
+    Token token = next();
+    if (token == Token::Boolean) {
+        out = boolean_;
+    } else if (token == Token::BeginObject || token == Token::BeginArray) {
+        return skip_container();
+    }
+    return token != Token::Error;
 }
 
 } // namespace json
@@ -0,0 +1,103 @@
+/**
+ * @file gpio_line.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Single output line on a GPIO character device
+ * @version 0.1
+ * @date 2026-01-12
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "connections/gpio_line.h"
+#include <linux/gpio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <cstring>
+
+namespace connections
+{
+
+    gpio_line::gpio_line(std::string_view chip_path, uint32_t offset, bool initial_high)
+        : chip_path_(chip_path), offset_(offset), fd_(-1), value_(initial_high)
+    {
+    }
+
+    gpio_line::~gpio_line()
+    {
+        deinitialize();
+    }
+
+    Status gpio_line::initialize()
+    {
+        if (fd_ >= 0)
+        {
+            return Status::Success;
+        }
+
+        int chip_fd = open(chip_path_.c_str(), O_RDWR | O_CLOEXEC);
+        if (chip_fd < 0)
+        {
+            return Status::ErrorHardware;
+        }
+
+        struct gpiohandle_request req;
+        memset(&req, 0, sizeof(req));
+        req.lineoffsets[0] = offset_;
+        req.flags = GPIOHANDLE_REQUEST_OUTPUT;
+        req.default_values[0] = value_ ? 1 : 0;
+        req.lines = 1;
+        strncpy(req.consumer_label, "atmolyt", sizeof(req.consumer_label) - 1);
+
+        int rc = ioctl(chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &req);
+        close(chip_fd);
+        if (rc < 0 || req.fd < 0)
+        {
+            return Status::ErrorHardware;
+        }
+
+        fd_ = req.fd;
+        return Status::Success;
+    }
+
+    void gpio_line::deinitialize()
+    {
+        if (fd_ >= 0)
+        {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool gpio_line::is_ready() const
+    {
+        return fd_ >= 0;
+    }
+
+    Status gpio_line::set_value(bool high)
+    {
+        if (!is_ready())
+        {
+            return Status::ErrorNotInitialized;
+        }
+
+        if (high == value_)
+        {
+            return Status::Success;
+        }
+
+        struct gpiohandle_data data;
+        memset(&data, 0, sizeof(data));
+        data.values[0] = high ? 1 : 0;
+
+        if (ioctl(fd_, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) < 0)
+        {
+            return Status::ErrorHardware;
+        }
+
+        value_ = high;
+        return Status::Success;
+    }
+
+} // namespace connections
@@ -15,6 +15,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <vector>
@@ -48,6 +49,12 @@ namespace connections
             return Status::Success;
         }
 
+        const long ticks = std::max<long>(1, static_cast<long>(transfer_timeout_.count() / 10));
+        if (ioctl(fd_, I2C_TIMEOUT, ticks) < 0)
+        {
+            std::cerr << "Warning: I2C_TIMEOUT not supported on " << config_path_ << std::endl;
+        }
+
         initialized_ = true;
         return Status::Success;
     }
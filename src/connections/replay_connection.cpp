@@ -0,0 +1,342 @@
+/**
+ * @file replay_connection.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  A recorded log played back as a sensor bus
+ * @version 0.1
+ * @date 2026-02-08
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "connections/replay_connection.h"
+#include "app/log_index.h"
+#include "app/log_query.h"
+#include "app/raw_capture.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace connections
+{
+    class replay_source
+    {
+    public:
+        virtual ~replay_source() = default;
+
+        // The current row, false at the end; does not move the position
+        virtual bool peek(replay_row &row) const = 0;
+        virtual void advance() = 0;
+        virtual void rewind() = 0;
+    };
+
+    namespace
+    {
+        // csv_logger's log, parsed a row at a time straight from the mapping
+        class csv_source final : public replay_source
+        {
+        public:
+            bool open(const std::string &path, const std::string &from)
+            {
+                log_ = std::make_unique<app::mapped_log>(path);
+                if (!log_->ok())
+                    return false;
+                const std::string_view text = log_->text();
+
+                // Columns by name, so a log of another column order plays too
+                const size_t header_end = std::min(text.find('\n'), text.size());
+                const std::string_view header = text.substr(0, header_end);
+                for (size_t pos = 0; pos <= header.size();)
+                {
+                    size_t comma = header.find(',', pos);
+                    if (comma == std::string_view::npos)
+                        comma = header.size();
+                    const std::string_view name = header.substr(pos, comma - pos);
+                    int field = -1;
+                    for (int f = 0; f < replay_row::FIELD_COUNT; ++f)
+                        if (name == FIELD_NAMES[f])
+                            field = f;
+                    columns_.push_back(field);
+                    pos = comma + 1;
+                }
+
+                start_ = std::min(header_end + 1, text.size());
+                if (!from.empty())
+                {
+                    int64_t t;
+                    if (!app::parse_query_time(from, app::civil_now(), t))
+                        return false;
+                    const app::log_index index(path, text);
+                    if (index.ok())
+                    {
+                        const auto [lo, hi] = index.window(t, text.size());
+                        start_ = app::find_log_time(text, std::max(lo, start_), t, std::max(hi, start_));
+                    }
+                    else
+                    {
+                        start_ = app::find_log_time(text, start_, t);
+                    }
+                }
+                rewind();
+                return true;
+            }
+
+            // Lines that are not rows are stepped over and the parsed row is cached;
+            // neither changes which row is current
+            bool peek(replay_row &row) const override
+            {
+                const std::string_view text = log_->text();
+                while (!cached_ && pos_ < text.size())
+                {
+                    size_t eol = text.find('\n', pos_);
+                    if (eol == std::string_view::npos)
+                        eol = text.size();
+                    cached_ = parse(text.substr(pos_, eol - pos_), row_);
+                    next_ = eol + 1;
+                    if (!cached_)
+                        pos_ = next_;
+                }
+                if (cached_)
+                    row = row_;
+                return cached_;
+            }
+
+            void advance() override
+            {
+                replay_row row;
+                if (peek(row))
+                {
+                    pos_ = next_;
+                    cached_ = false;
+                }
+            }
+
+            void rewind() override
+            {
+                pos_ = start_;
+                cached_ = false;
+            }
+
+        private:
+            static constexpr const char *FIELD_NAMES[replay_row::FIELD_COUNT] = {
+                "co2_ppm", "temperature_c", "humidity_rh", "pressure_pa", "voc_index", "nox_index",
+            };
+
+            bool parse(std::string_view line, replay_row &row) const
+            {
+                int64_t t;
+                if (!app::parse_log_timestamp(line, t))
+                    return false;
+                row = replay_row{};
+                row.t_ms = t * 1000;
+
+                size_t pos = line.find(',');
+                for (size_t column = 1; pos != std::string_view::npos && column < columns_.size(); ++column)
+                {
+                    const size_t first = pos + 1;
+                    pos = line.find(',', first);
+                    const size_t last = pos == std::string_view::npos ? line.size() : pos;
+                    float value;
+                    if (columns_[column] < 0 || first >= last)
+                        continue;
+                    const auto parsed = std::from_chars(line.data() + first, line.data() + last, value);
+                    if (parsed.ec == std::errc())
+                        row.set(static_cast<replay_row::field>(columns_[column]), value);
+                }
+                return true;
+            }
+
+            std::unique_ptr<app::mapped_log> log_;
+            std::vector<int> columns_; // field per column, -1 = not replayed
+            size_t start_ = 0;
+            mutable size_t pos_ = 0;
+            mutable size_t next_ = 0;
+            mutable bool cached_ = false;
+            mutable replay_row row_;
+        };
+
+        // raw_capture_writer's file, compensated in one batch on open
+        class capture_source final : public replay_source
+        {
+        public:
+            bool open(const std::string &path, const std::string &from)
+            {
+                app::raw_capture capture;
+                if (!app::load_raw_capture(path, capture))
+                    return false;
+                const size_t n = capture.size();
+                t_ms_ = std::move(capture.timestamp_ms);
+                temperature_.resize(n);
+                pressure_.resize(n);
+                humidity_.resize(capture.has_humidity ? n : 0);
+                if (!peripherals::bme280_compensate_batch(capture.calib, capture.raw_t, capture.raw_p,
+                                                          capture.has_humidity ? std::span<const int32_t>(capture.raw_h)
+                                                                               : std::span<const int32_t>(),
+                                                          temperature_, pressure_, humidity_))
+                    return false;
+
+                if (!from.empty())
+                {
+                    // Local wall-clock text to Unix time, as the capture is stamped
+                    int64_t civil;
+                    if (!app::parse_query_time(from, app::civil_now(), civil))
+                        return false;
+                    const std::time_t fields = static_cast<std::time_t>(civil);
+                    std::tm tm{};
+                    gmtime_r(&fields, &tm);
+                    tm.tm_isdst = -1;
+                    const int64_t from_ms = static_cast<int64_t>(std::mktime(&tm)) * 1000;
+                    start_ = static_cast<size_t>(std::lower_bound(t_ms_.begin(), t_ms_.end(), from_ms) - t_ms_.begin());
+                }
+                rewind();
+                return true;
+            }
+
+            bool peek(replay_row &row) const override
+            {
+                if (i_ >= t_ms_.size())
+                    return false;
+                row = replay_row{};
+                row.t_ms = t_ms_[i_];
+                row.set(replay_row::temperature_c, static_cast<float>(temperature_[i_]) / 100.0f);
+                row.set(replay_row::pressure_pa, static_cast<float>(pressure_[i_]) / 256.0f);
+                if (!humidity_.empty())
+                    row.set(replay_row::humidity_rh, static_cast<float>(humidity_[i_]) / 1024.0f);
+                return true;
+            }
+
+            void advance() override { i_ += i_ < t_ms_.size(); }
+            void rewind() override { i_ = start_; }
+
+        private:
+            std::vector<int64_t> t_ms_;
+            std::vector<int32_t> temperature_;
+            std::vector<uint32_t> pressure_;
+            std::vector<uint32_t> humidity_;
+            size_t start_ = 0;
+            size_t i_ = 0;
+        };
+
+        bool is_raw_capture(const std::string &path)
+        {
+            char magic[8] = {};
+            std::ifstream in(path, std::ios::binary);
+            return in.read(magic, sizeof(magic)) && std::memcmp(magic, "ATRAWBME", sizeof(magic)) == 0;
+        }
+    } // namespace
+
+    replay_connection::replay_connection(std::string path, replay_settings settings)
+        : addressable_connection_iface<uint8_t>(path), path_(std::move(path)), settings_(std::move(settings))
+    {
+    }
+
+    replay_connection::~replay_connection() = default;
+
+    Status replay_connection::initialize()
+    {
+        bool opened;
+        if (is_raw_capture(path_))
+        {
+            auto capture = std::make_unique<capture_source>();
+            opened = capture->open(path_, settings_.from);
+            source_ = std::move(capture);
+        }
+        else
+        {
+            auto csv = std::make_unique<csv_source>();
+            opened = csv->open(path_, settings_.from);
+            source_ = std::move(csv);
+        }
+        if (!opened)
+        {
+            std::cerr << "replay: cannot play " << path_ << (settings_.from.empty() ? "" : " from " + settings_.from)
+                      << std::endl;
+            source_.reset();
+            return Status::ErrorInvalidParam;
+        }
+        started_ = false;
+        played_ = skipped_ = 0;
+        return Status::Success;
+    }
+
+    void replay_connection::deinitialize()
+    {
+        source_.reset();
+    }
+
+    bool replay_connection::is_ready() const
+    {
+        return source_ != nullptr;
+    }
+
+    void replay_connection::rewind()
+    {
+        if (source_)
+            source_->rewind();
+        started_ = false;
+    }
+
+    std::chrono::steady_clock::time_point replay_connection::due(const replay_row &row) const
+    {
+        if (settings_.speed <= 0)
+            return base_due_;
+        const std::chrono::duration<double, std::milli> offset(static_cast<double>(row.t_ms - base_t_ms_) / settings_.speed);
+        return base_due_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset);
+    }
+
+    std::chrono::steady_clock::time_point replay_connection::next_due() const
+    {
+        replay_row row;
+        if (!source_)
+            return std::chrono::steady_clock::time_point::max();
+        if (!source_->peek(row))
+        {
+            // A loop starts over on a fresh clock: its first row is due at once
+            if (!settings_.loop || played_ == 0)
+                return std::chrono::steady_clock::time_point::max();
+            return std::chrono::steady_clock::now();
+        }
+        return started_ ? due(row) : std::chrono::steady_clock::now();
+    }
+
+    bool replay_connection::take(replay_row &row)
+    {
+        if (!source_)
+            return false;
+        if (!source_->peek(row))
+        {
+            if (!settings_.loop || played_ == 0)
+                return false;
+            rewind();
+            if (!source_->peek(row))
+                return false;
+        }
+        if (!started_)
+        {
+            started_ = true;
+            base_due_ = std::chrono::steady_clock::now();
+            base_t_ms_ = row.t_ms;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (due(row) > now)
+            return false;
+        source_->advance();
+        if (settings_.speed > 0)
+        {
+            replay_row later;
+            while (source_->peek(later) && due(later) <= now)
+            {
+                row = later;
+                source_->advance();
+                ++skipped_;
+            }
+        }
+        ++played_;
+        return true;
+    }
+
+} // namespace connections
@@ -101,7 +101,7 @@ namespace connections
         return Status::ErrorInvalidParam;
     }
 
-    Status spi_connection::transfer(uint8_t cs_pin, std::span<const uint8_t> tx_data,
+    Status spi_connection::transfer([[maybe_unused]] uint8_t cs_pin, std::span<const uint8_t> tx_data,
                                     std::span<uint8_t> rx_data)
     {
         if (!is_ready())
@@ -109,7 +109,7 @@ namespace connections
             return Status::ErrorNotInitialized;
         }
 
-        if (tx_data.size() != rx_data.size())
+        if (!rx_data.empty() && tx_data.size() != rx_data.size())
         {
             return Status::ErrorInvalidParam;
         }
@@ -118,7 +118,7 @@ namespace connections
         memset(&xfer, 0, sizeof(xfer));
 
         xfer.tx_buf = reinterpret_cast<uintptr_t>(tx_data.data());
-        xfer.rx_buf = reinterpret_cast<uintptr_t>(rx_data.data());
+        xfer.rx_buf = reinterpret_cast<uintptr_t>(rx_data.data()); // 0 -> rx discarded by spidev
         xfer.len = tx_data.size();
         xfer.speed_hz = config_.speed_hz;
         xfer.bits_per_word = config_.bits_per_word;
@@ -139,8 +139,39 @@ namespace connections
 
     Status spi_connection::write(uint8_t cs_pin, std::span<const uint8_t> data)
     {
-        std::vector<uint8_t> rx_dummy(data.size());
-        return transfer(cs_pin, data, rx_dummy);
+        return transfer(cs_pin, data, {});
+    }
+
+    // cs_pin is unused as in transfer(): the spidev node is one chip select, which
+    // the kernel holds asserted across both segments of the message
+    Status spi_connection::write_read([[maybe_unused]] uint8_t cs_pin, std::span<const uint8_t> write_data,
+                                      std::span<uint8_t> read_buffer)
+    {
+        if (!is_ready())
+        {
+            return Status::ErrorNotInitialized;
+        }
+
+        // Two segments under one chip-select: command phase, then read phase
+        struct spi_ioc_transfer xfer[2];
+        memset(xfer, 0, sizeof(xfer));
+
+        xfer[0].tx_buf = reinterpret_cast<uintptr_t>(write_data.data());
+        xfer[0].len = write_data.size();
+        xfer[0].speed_hz = config_.speed_hz;
+        xfer[0].bits_per_word = config_.bits_per_word;
+
+        xfer[1].rx_buf = reinterpret_cast<uintptr_t>(read_buffer.data());
+        xfer[1].len = read_buffer.size();
+        xfer[1].speed_hz = config_.speed_hz;
+        xfer[1].bits_per_word = config_.bits_per_word;
+
+        if (ioctl(fd_, SPI_IOC_MESSAGE(2), xfer) < 0)
+        {
+            return Status::ErrorHardware;
+        }
+
+        return Status::Success;
     }
 
     Status spi_connection::read_register(uint8_t cs_pin, uint8_t reg_addr,
@@ -176,12 +207,11 @@ namespace connections
         }
 
         std::vector<uint8_t> tx_data(1 + data.size());
-        std::vector<uint8_t> rx_data(1 + data.size());
 
         tx_data[0] = reg_addr & 0x7F;
         std::copy(data.begin(), data.end(), tx_data.begin() + 1);
 
-        return transfer(cs_pin, tx_data, rx_data);
+        return transfer(cs_pin, tx_data, {});
     }
 
     Status spi_connection::reset()
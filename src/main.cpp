@@ -12,60 +12,126 @@
 #include "app/application.h"
 #include "app/signal_handler.h"
 #include "app/csv_logger.h"
+#include "app/sample_bus.h"
+#include "app/tsdb.h"
+#include "app/metrics_server.h"
+#include "app/shm_publisher.h"
+#include "app/stream_server.h"
+#include "app/mqtt_sink.h"
+#include "app/sparkline.h"
+#include "app/raw_capture.h"
+#include "app/wall_clock.h"
+#include "peripheral/bme280.h"
+#include "peripheral/sgp41.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
 #include <future>
 #include <optional>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
 
 using app::signal_handler;
 
-struct sensor_data {
-    double co2_ppm = -1;
-    double temp_c = -999;
-    double humidity_rh = -1;
-    double press_pa = -1;
-    bool valid = false;
-};
+// Sample spacing that sizes the raw history; a free-running loop
+// (poll_interval_ms = 0, replay) is sized as if it polled at the default rate
+static int sample_spacing_ms(int poll_interval_ms)
+{
+    return poll_interval_ms > 0 ? poll_interval_ms : config::AppConfig{}.poll_interval_ms;
+}
+
+// CO2 trend graph below the four text rows
+static constexpr int SPARK_Y = 34;
+static constexpr int SPARK_HEIGHT = 30;
+static constexpr float SPARK_CO2_LO = 400.0f;
+static constexpr float SPARK_CO2_HI = 2000.0f;
+
+// Reads one device within ctx unless it is failed (then the re-probe thread owns
+// it) and feeds the outcome back into its health record
+template <typename Device, typename Data>
+static peripherals::Status read_tracked(app::atmolyt& application, Device& device, Data& data,
+                                        const peripherals::read_context& ctx)
+{
+    app::peripheral_health *health = application.health_of(&device);
+    if (health && !health->usable()) {
+        return peripherals::Status::ErrorNotInitialized;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    auto status = device.read_data_within(data, ctx);
+    // Cut short by shutdown: says nothing about the device
+    if (health && !ctx.stop.stop_requested()) {
+        health->record_read(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started));
+        health->report(status);
+    }
+    return status;
+}
 
-std::optional<sensor_data> read_gas_sensors_async(
-    const std::vector<std::unique_ptr<peripherals::gas_sensor_iface>>& sensors)
+// Fills the gas channels; a sensor whose result is due after the read deadline
+// is skipped (low-power cadences) and the bus keeps its previous value
+app::sample_frame read_gas_sensors_async(app::atmolyt& application, const app::peripheral_set& devices,
+                                         const peripherals::read_context& ctx)
 {
-    for (auto& sensor : sensors) {
+    app::sample_frame frame;
+    for (auto* sensor : devices.gas_sensors) {
+        app::peripheral_health *health = application.health_of(sensor);
+        if (health && !health->usable()) {
+            continue;
+        }
+
+        auto ready = sensor->data_ready_at();
+        if (ready && *ready > ctx.deadline) {
+            continue;
+        }
+
         peripherals::gas_data data;
-        auto result = sensor->read_data(data);
-        if (result == peripherals::Status::Success) {
-            return sensor_data{
-                data.co2_ppm,
-                data.temperature_c,
-                data.humidity_rh,
-                -1,
-                true
-            };
+        if (read_tracked(application, *sensor, data, ctx) != peripherals::Status::Success) {
+            continue;
         }
+
+        // First sensor reporting a channel wins; index-only sensors (SGP41) report co2_ppm < 0
+        app::sample_frame own;
+        if (data.co2_ppm >= 0) {
+            own.set(app::channel::co2_ppm, data.co2_ppm);
+            own.set(app::channel::temperature_c, data.temperature_c);
+            own.set(app::channel::humidity_rh, data.humidity_rh);
+        }
+        if (data.voc_index >= 0) own.set(app::channel::voc_index, data.voc_index);
+        if (data.nox_index >= 0) own.set(app::channel::nox_index, data.nox_index);
+        frame.merge_missing(own);
     }
-    return std::nullopt;
+    return frame;
 }
 
-std::optional<sensor_data> read_env_sensors_async(
-    const std::vector<std::unique_ptr<peripherals::environmental_sensor_iface>>& sensors)
+// The first environmental sensor that read successfully this tick, and what it read
+struct env_reading
+{
+    app::sample_frame frame;
+    const peripherals::environmental_sensor_iface *source = nullptr;
+};
+
+env_reading read_env_sensors_async(app::atmolyt& application, const app::peripheral_set& devices,
+                                   const peripherals::read_context& ctx)
 {
-    for (auto& sensor : sensors) {
+    env_reading reading;
+    app::sample_frame &frame = reading.frame;
+    for (auto* sensor : devices.environmental_sensors) {
+        auto ready = sensor->data_ready_at();
+        if (ready && *ready > ctx.deadline) {
+            continue;
+        }
+
         peripherals::combined_env_data data;
-        auto result = sensor->read_data(data);
-        if (result == peripherals::Status::Success) {
-            return sensor_data{
-                -1,
-                data.temperature.celsius,
-                -1,
-                data.pressure.pascals,
-                true
-            };
+        if (read_tracked(application, *sensor, data, ctx) == peripherals::Status::Success) {
+            frame.set(app::channel::temperature_c, data.temperature.celsius);
+            frame.set(app::channel::pressure_pa, data.pressure.pascals);
+            if (data.humidity.valid) frame.set(app::channel::humidity_rh, data.humidity.relative_humidity);
+            reading.source = sensor;
+            return reading;
         }
     }
-    return std::nullopt;
+    return reading;
 }
 
 int main(int argc, char **argv)
@@ -84,86 +150,293 @@ int main(int argc, char **argv)
         return 0;
     }
 
-    // Initialize CSV logger
-    app::csv_logger logger(application.get_log_path());
+    // SIGHUP re-reads the config on the application's reload thread; the loop
+    // picks the new set up at its next tick
+    signal_handler::set_reload_callback([&application] { application.request_reload(); });
+
+    // Acquisition publishes frames; the display and the logger consume them independently
+    app::sample_bus bus;
+    app::csv_logger logger(application.get_log_path(), bus);
 
-    // Clear display on startup
-    if (!application.get_displays().empty()) {
-        application.get_displays()[0]->clear();
+    // In-memory history: raw window plus 1 min / 1 h rollups. The loop appends each
+    // frame itself, so a graph column read right after a tick sees all of it
+    app::tsdb_settings history_settings;
+    history_settings.raw_capacity = static_cast<size_t>(std::max(application.get_history_minutes(), 1)) * 60000 /
+                                    static_cast<size_t>(sample_spacing_ms(application.get_poll_interval_ms()));
+    app::tsdb history(history_settings);
+
+    // Latest values for other local processes, read straight from shared memory
+    std::optional<app::shm_publisher> shm;
+    if (!application.get_shm_name().empty()) {
+        shm.emplace(application.get_shm_name());
+        shm->attach(bus);
+    }
+
+    // Live frames to local subscribers; a slow one loses its oldest frames
+    std::optional<app::stream_server> stream;
+    if (!application.get_stream_socket().empty()) {
+        stream.emplace(application.get_stream_socket(), bus);
+    }
+
+    // Fleet upload; the broker's speed or absence never reaches the poll loop
+    std::optional<app::mqtt_sink> mqtt;
+    if (const config::MqttConfig &cfg = application.get_mqtt(); !cfg.broker.empty()) {
+        app::mqtt_settings settings;
+        if (app::parse_listen_address(cfg.broker, settings.host, settings.port)) {
+            settings.client_id = cfg.client_id;
+            settings.topic = cfg.topic;
+            settings.username = cfg.username;
+            settings.password = cfg.password;
+            settings.qos = cfg.qos;
+            settings.batch = static_cast<size_t>(std::max(cfg.batch, 1));
+            settings.max_inflight = static_cast<size_t>(std::max(cfg.max_inflight, 1));
+            settings.keepalive = std::chrono::seconds(std::max(cfg.keepalive_s, 0));
+            settings.spool_dir = cfg.spool_dir;
+            settings.spool_max_bytes = static_cast<uint64_t>(std::max(cfg.spool_max_mb, 1)) << 20;
+            settings.drain_rate = cfg.drain_per_s;
+            mqtt.emplace(settings, bus);
+        } else {
+            std::cerr << "mqtt.broker must be \"host:port\": " << cfg.broker << std::endl;
+        }
     }
 
+    // Scrapes are answered from a buffer re-rendered per frame, off the poll loop
+    std::optional<app::metrics_server> metrics;
+    if (!application.get_metrics_listen().empty()) {
+        std::string host;
+        uint16_t port = 0;
+        if (app::parse_listen_address(application.get_metrics_listen(), host, port)) {
+            metrics.emplace(host, port, bus, &application.get_health());
+        } else {
+            std::cerr << "metrics_listen must be \"host:port\": " << application.get_metrics_listen() << std::endl;
+        }
+    }
+
+    // Sample timestamps come from the RTC-disciplined model, not a syscall per tick
+    app::wall_clock wall;
+    std::optional<app::timekeeper> keeper;
+    peripherals::rtc_iface *keeper_rtc = nullptr;
+
+    // Raw ADC words of the first BME280/BMP280, compensated offline when needed
+    const peripherals::bme280 *capture_sensor = nullptr;
+    std::optional<app::raw_capture_writer> raw_capture;
+
+    // One graph column per 1/MAX_WIDTH of the configured window, read from the history
+    peripherals::display_iface *display = nullptr;
+    int spark_minutes = 0;
+    std::optional<app::sparkline> co2_spark;
+    int64_t spark_column_ns = 0;
+    int64_t spark_next_ns = 0; // end of the column being collected
+    std::vector<app::tsdb_point> spark_points;
+    std::vector<app::tsdb_rollup> spark_rollups;
+
     // Previous values to detect changes
     std::string prev_co2_value = "";
     std::string prev_temp_value = "";
     std::string prev_hum_value = "";
 
+    // Points everything that holds a device at the current set. Runs before the
+    // previous snapshot is released, so nothing here outlives its device; what
+    // a reload left in place is not touched.
+    auto bind_devices = [&](const app::peripheral_set& devices) {
+        peripherals::rtc_iface *rtc = devices.rtcs.empty() ? nullptr : devices.rtcs[0];
+        if (!keeper || rtc != keeper_rtc) {
+            // A new RTC re-anchors the clock from the keeper's thread; until then the
+            // previous model (or the system clock) stamps the frames
+            keeper.reset();
+            keeper.emplace(wall, rtc);
+            keeper_rtc = rtc;
+        }
+
+        const peripherals::bme280 *bme = nullptr;
+        for (auto* sensor : devices.environmental_sensors) {
+            bme = dynamic_cast<const peripherals::bme280*>(sensor);
+            if (bme) break;
+        }
+        const std::string &capture_path = devices.config.raw_capture_path;
+        if (capture_path.empty() || bme != capture_sensor) {
+            raw_capture.reset();
+            capture_sensor = nullptr;
+        }
+        if (!capture_path.empty() && !raw_capture) {
+            if (bme) {
+                // Same trimming data appends to the existing capture
+                capture_sensor = bme;
+                raw_capture.emplace(capture_path, bme->get_calibration(), bme->has_humidity());
+            } else {
+                std::cerr << "raw_capture_path is set but no BME280/BMP280 is configured" << std::endl;
+            }
+        }
+
+        peripherals::display_iface *first = devices.displays.empty() ? nullptr : devices.displays[0];
+        const int minutes = devices.config.sparkline_minutes;
+        if (first != display || minutes != spark_minutes) {
+            display = first;
+            spark_minutes = minutes;
+            co2_spark.reset();
+            prev_co2_value = prev_temp_value = prev_hum_value = "";
+
+            // Clear display on startup
+            if (display) {
+                display->clear();
+            }
+            if (display && minutes > 0) {
+                co2_spark.emplace(display, 0, SPARK_Y, app::sparkline::MAX_WIDTH, SPARK_HEIGHT,
+                                  SPARK_CO2_LO, SPARK_CO2_HI);
+                // Starts a full window back, so the graph is redrawn from what the history holds
+                spark_column_ns = static_cast<int64_t>(minutes) * 60000000000LL / app::sparkline::MAX_WIDTH;
+                spark_next_ns = 0;
+            }
+        }
+    };
+
+    // Closes every graph column that ended by now_ns: min/max of its raw points,
+    // or of its minute rollups once it is older than the raw window. An empty
+    // column is not drawn, a stall longer than the graph skips to its window.
+    auto spark_advance = [&](int64_t now_ns) {
+        const int64_t oldest = now_ns - now_ns % spark_column_ns - (app::sparkline::MAX_WIDTH - 1) * spark_column_ns;
+        for (spark_next_ns = std::max(spark_next_ns, oldest); spark_next_ns <= now_ns; spark_next_ns += spark_column_ns) {
+            const int64_t from_ns = spark_next_ns - spark_column_ns;
+            app::tsdb_rollup column;
+            spark_points.clear();
+            history.query_raw(app::channel::co2_ppm, from_ns, spark_next_ns, spark_points);
+            for (const auto &p : spark_points)
+                column.add(p.value);
+            if (column.count == 0) {
+                spark_rollups.clear();
+                history.query_rollups(app::channel::co2_ppm, app::tsdb_tier::minute, from_ns, spark_next_ns, spark_rollups);
+                for (const auto &bucket : spark_rollups)
+                    column.merge(bucket);
+            }
+            if (column.count)
+                co2_spark->append({column.min, column.max});
+        }
+    };
+
+    std::shared_ptr<const app::peripheral_set> devices = application.get_peripherals();
+    bind_devices(*devices);
+
+    // Fixed tick grid; reads end at the budget or the next tick, whichever is first,
+    // and everything (reads and the tick sleep) ends at once on a termination signal
+    const std::stop_token stop = signal_handler::stop_token();
+    auto next_tick = std::chrono::steady_clock::now();
+    std::mutex tick_mutex;
+    std::condition_variable_any tick_cv;
+
     while (!signal_handler::shutdown_requested())
     {
         signal_handler::poll_and_handle();
 
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-        std::string timestamp = ss.str();
+        // One snapshot per tick; a reload only ever changes what the next tick sees
+        auto fresh = application.get_peripherals();
+        if (fresh != devices) {
+            bind_devices(*fresh);
+            devices = std::move(fresh);
+        }
+
+        const auto read_budget = std::chrono::milliseconds(std::max(devices->config.read_budget_ms, 1));
+        // Free-running (0): a tick starts as the last one ends and the reads set the pace
+        const auto poll_interval = std::chrono::milliseconds(std::max(devices->config.poll_interval_ms, 0));
+        const bool free_running = poll_interval.count() == 0;
+        const auto tick_start = std::chrono::steady_clock::now();
+        next_tick = free_running ? tick_start + read_budget : next_tick + poll_interval;
+        peripherals::read_context ctx;
+        ctx.deadline = std::min(tick_start + read_budget, next_tick);
+        ctx.stop = stop;
 
-        double co2_ppm = -1, temp_c = -999, press_pa = -1, humidity_rh = -1;
-        
         // Async sensor reading
-        auto gas_future = std::async(std::launch::async, read_gas_sensors_async, 
-                                      std::cref(application.get_gas_sensors()));
-        auto env_future = std::async(std::launch::async, read_env_sensors_async, 
-                                      std::cref(application.get_environmental_sensors()));
-        
-        auto gas_data = gas_future.get();
-        auto env_data = env_future.get();
-        
-        if (gas_data.has_value()) {
-            co2_ppm = gas_data->co2_ppm;
-            temp_c = gas_data->temp_c;
-            humidity_rh = gas_data->humidity_rh;
-        }
-        
-        if (env_data.has_value()) {
-            press_pa = env_data->press_pa;
-            if (temp_c == -999) {
-                temp_c = env_data->temp_c;
+        auto gas_future = std::async(std::launch::async, read_gas_sensors_async, std::ref(application), std::cref(*devices), std::cref(ctx));
+        auto env_future = std::async(std::launch::async, read_env_sensors_async, std::ref(application), std::cref(*devices), std::cref(ctx));
+
+        // Gas sensor T/RH take precedence over the environmental sensor's
+        app::sample_frame frame = gas_future.get();
+        const env_reading env = env_future.get();
+        frame.merge_missing(env.frame);
+        frame.wall_ns = wall.wall_ns_at(std::chrono::steady_clock::now());
+
+        // Nothing due within the budget (a gap in a replay, or its end): idle instead of spinning
+        if (free_running && frame.valid == 0) {
+            std::unique_lock<std::mutex> lock(tick_mutex);
+            tick_cv.wait_until(lock, stop, next_tick, [] { return false; });
+            continue;
+        }
+
+        // SGP41 raw signals are compensated with the CO2 sensor's T/RH
+        if (frame.has(app::channel::co2_ppm)) {
+            for (auto* sensor : devices->gas_sensors) {
+                if (auto *sgp = dynamic_cast<peripherals::sgp41*>(sensor))
+                    sgp->set_compensation(static_cast<float>(frame.get(app::channel::temperature_c)),
+                                          static_cast<float>(frame.get(app::channel::humidity_rh)));
             }
         }
-        
-        if (!application.get_displays().empty()) {
-            auto& display = application.get_displays()[0];
 
-            std::string co2_value = gas_data.has_value() ? 
-                std::to_string(static_cast<int>(co2_ppm)) : "--";
-            std::string temp_value = (temp_c != -999) ? 
-                std::to_string(temp_c).substr(0, 4) : "--";
-            std::string hum_value = gas_data.has_value() ? 
-                std::to_string(static_cast<int>(humidity_rh)) : "--";
+        bus.publish(frame);
+        history.append(frame);
+
+        app::peripheral_health *display_health = display ? application.health_of(display) : nullptr;
+        if (display && (!display_health || display_health->usable())) {
+            auto co2 = bus.latest(app::channel::co2_ppm);
+            auto temp = bus.latest(app::channel::temperature_c);
+            auto hum = bus.latest(app::channel::humidity_rh);
+
+            std::string co2_value = co2.valid ?
+                std::to_string(static_cast<int>(co2.value)) : "--";
+            std::string temp_value = temp.valid ?
+                std::to_string(temp.value).substr(0, 4) : "--";
+            std::string hum_value = hum.valid ?
+                std::to_string(static_cast<int>(hum.value)) : "--";
 
             if (co2_value != prev_co2_value || temp_value != prev_temp_value || hum_value != prev_hum_value) {
-                display->clear();
-                
                 std::string display_text = "CO2\n" + co2_value + "\nT:" + temp_value + "\nH:" + hum_value;
-                display->display_text(display_text, 0, 0, 3, true);
-                
+                if (co2_spark) {
+                    // Text rewrites only its own rows, the graph below stays
+                    display->display_text(display_text, 0, 0, 1, false);
+                } else {
+                    display->clear();
+                    display->display_text(display_text, 0, 0, 3, true);
+                }
+
                 prev_co2_value = co2_value;
                 prev_temp_value = temp_value;
                 prev_hum_value = hum_value;
             }
+
+            if (co2_spark) {
+                spark_advance(frame.wall_ns);
+            }
+        }
+
+        // Only words the capture sensor itself delivered this tick, never a stale repeat
+        if (raw_capture && capture_sensor && env.source == capture_sensor) {
+            raw_capture->append(frame.wall_ns / 1000000, capture_sensor->last_raw());
         }
-        
-        logger.log_async(co2_ppm, temp_c, press_pa, humidity_rh, timestamp);
 
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+        if (stop.stop_requested()) {
+            break;
+        }
+        if (free_running) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(tick_mutex);
+        tick_cv.wait_until(lock, stop, next_tick, [] { return false; });
+        // A tick overran (or the clock jumped): restart the grid instead of bursting
+        if (std::chrono::steady_clock::now() > next_tick + poll_interval) {
+            next_tick = std::chrono::steady_clock::now();
+        }
     }
 
     std::cerr << "Shutting down due to signal" << std::endl;
+    signal_handler::set_reload_callback(nullptr);
 
     // Clear display on shutdown
-    if (!application.get_displays().empty()) {
-        application.get_displays()[0]->clear();
+    if (display) {
+        display->clear();
     }
 
+    // Device users go before the devices
+    keeper.reset();
+    co2_spark.reset();
+    devices.reset();
+
     return 0;
 }
@@ -10,9 +10,12 @@
  */
 
 #include "peripheral/bme280.h"
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <iterator>
 #include <cmath>
+#include <thread>
 
 namespace peripherals {
 
@@ -24,27 +27,120 @@ static constexpr uint8_t REG_CTRL_MEAS = 0xF4;
 static constexpr uint8_t REG_CONFIG = 0xF5;
 static constexpr uint8_t REG_DATA = 0xF7; // pressure(3) + temp(3) + hum(2)
 
-bme280::bme280(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address)
-    : environmental_sensor_iface(conn, address)
+static constexpr uint8_t MODE_SLEEP = 0x00;
+static constexpr uint8_t MODE_FORCED = 0x01;
+static constexpr uint8_t MODE_NORMAL = 0x03;
+static constexpr uint8_t STATUS_MEASURING = 0x08;
+
+// osrs_x field: the code is the index of the factor, 0 = skipped
+static constexpr uint8_t OVERSAMPLING[6] = {0, 1, 2, 4, 8, 16};
+
+bool bme280_oversampling_valid(uint8_t factor)
+{
+    return std::find(std::begin(OVERSAMPLING), std::end(OVERSAMPLING), factor) != std::end(OVERSAMPLING);
+}
+
+// An invalid factor (the factory rejects them) is programmed, and timed, as x1
+static uint8_t encode_oversampling(uint8_t factor)
+{
+    const auto it = std::find(std::begin(OVERSAMPLING), std::end(OVERSAMPLING), factor);
+    return it == std::end(OVERSAMPLING) ? 1 : static_cast<uint8_t>(it - std::begin(OVERSAMPLING));
+}
+
+// The factor the chip actually runs for a setting
+static int64_t programmed_oversampling(uint8_t factor)
+{
+    return OVERSAMPLING[encode_oversampling(factor)];
+}
+
+static uint8_t encode_filter(uint8_t coefficient)
+{
+    switch (coefficient) {
+        case 2: return 1;
+        case 4: return 2;
+        case 8: return 3;
+        case 16: return 4;
+        default: return 0;
+    }
+}
+
+// t_sb field of REG_CONFIG: the two chips differ in codes 6 and 7
+static constexpr float STANDBY_MS_BME280[8] = {0.5f, 62.5f, 125.0f, 250.0f, 500.0f, 1000.0f, 10.0f, 20.0f};
+static constexpr float STANDBY_MS_BMP280[8] = {0.5f, 62.5f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f};
+
+static uint8_t encode_standby(const float (&table)[8], float ms)
+{
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < 8; ++i) {
+        if (std::fabs(table[i] - ms) < std::fabs(table[best] - ms)) best = i;
+    }
+    return best;
+}
+
+static void fill_temperature(temperature_data &data, int32_t t_fine)
+{
+    data.celsius = float(bme280_temperature_centi(t_fine)) / 100.0f;
+    data.valid = true;
+}
+
+static Status fill_pressure(pressure_data &data, const bme280_calibration &c, int32_t raw_p, int32_t t_fine)
+{
+    uint32_t p = bme280_pressure_q24_8(c, raw_p, t_fine);
+    if (p == 0) {
+        data.valid = false;
+        return Status::ErrorCalibration;
+    }
+    data.pascals = float(p) / 256.0f; // p is in Q24.8
+    data.valid = true;
+    return Status::Success;
+}
+
+static void fill_humidity(humidity_data &data, const bme280_calibration &c, int32_t raw_h, int32_t t_fine)
+{
+    float h = bme280_humidity_q22_10(c, raw_h, t_fine);
+    data.relative_humidity = h / 1024.0f;
+    data.valid = true;
+}
+
+bme280::bme280(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+               const bme280_settings &settings)
+    : environmental_sensor_iface(conn, address), settings_(settings)
 {
 }
 
 Status bme280::initialize()
 {
     if (!connection_) return Status::ErrorNotInitialized;
-    if (connection_->read_register(device_address_, REG_ID, std::span<uint8_t>(new uint8_t[1],1)) != connections::Status::Success)
-        ; // fallthrough, we'll read properly below
+
+    if (read_register(REG_ID, chip_id_) != Status::Success)
+        return Status::ErrorCommunication;
 
     if (!read_calibration())
         return Status::ErrorCommunication;
 
-    // set humidity oversampling = 1
-    uint8_t val = 0x01;
-    connection_->write_register(device_address_, REG_CTRL_HUM, std::span<const uint8_t>(&val, 1));
-    // set ctrl_meas: temp and press oversampling = 1, mode = normal
-    val = (0x01 << 5) | (0x01 << 2) | 0x03;
-    connection_->write_register(device_address_, REG_CTRL_MEAS, std::span<const uint8_t>(&val, 1));
+    // config writes may be ignored in normal mode, so go through sleep first
+    if (write_register(REG_CTRL_MEAS, ctrl_meas_value(MODE_SLEEP)) != Status::Success)
+        return Status::ErrorCommunication;
+
+    const auto &standby_table = chip_id_ == CHIP_ID_BMP280 ? STANDBY_MS_BMP280 : STANDBY_MS_BME280;
+    const uint8_t t_sb = encode_standby(standby_table, settings_.standby_ms);
+    standby_ = std::chrono::microseconds(static_cast<int64_t>(standby_table[t_sb] * 1000.0f));
+    uint8_t config = static_cast<uint8_t>((t_sb << 5) |
+                                          (encode_filter(settings_.iir_filter) << 2));
+    if (write_register(REG_CONFIG, config) != Status::Success)
+        return Status::ErrorCommunication;
+
+    // ctrl_hum takes effect with the following ctrl_meas write
+    if (has_humidity() &&
+        write_register(REG_CTRL_HUM, encode_oversampling(settings_.oversampling_h)) != Status::Success)
+        return Status::ErrorCommunication;
 
+    // forced mode stays asleep until start_measurement()
+    if (!settings_.forced &&
+        write_register(REG_CTRL_MEAS, ctrl_meas_value(MODE_NORMAL)) != Status::Success)
+        return Status::ErrorCommunication;
+
+    measurement_pending_ = false;
     initialized_ = true;
     return Status::Success;
 }
@@ -59,7 +155,7 @@ bool bme280::is_connected()
     uint8_t id = 0;
     if (connection_->read_register(device_address_, REG_ID, std::span<uint8_t>(&id,1)) != connections::Status::Success)
         return false;
-    return (id == 0x60 || id == 0x58); // 0x60 = BME280, 0x58 = BMP280
+    return (id == CHIP_ID_BME280 || id == CHIP_ID_BMP280);
 }
 
 Status bme280::reset()
@@ -77,38 +173,139 @@ bool bme280::read_calibration()
     if (connection_->read_register(device_address_, 0x88, std::span<uint8_t>(buf1.data(), buf1.size())) != connections::Status::Success)
         return false;
 
-    dig_T1 = uint16_t(buf1[0]) | (uint16_t(buf1[1]) << 8);
-    dig_T2 = int16_t(uint16_t(buf1[2]) | (uint16_t(buf1[3]) << 8));
-    dig_T3 = int16_t(uint16_t(buf1[4]) | (uint16_t(buf1[5]) << 8));
-
-    dig_P1 = uint16_t(buf1[6]) | (uint16_t(buf1[7]) << 8);
-    dig_P2 = int16_t(uint16_t(buf1[8]) | (uint16_t(buf1[9]) << 8));
-    dig_P3 = int16_t(uint16_t(buf1[10]) | (uint16_t(buf1[11]) << 8));
-    dig_P4 = int16_t(uint16_t(buf1[12]) | (uint16_t(buf1[13]) << 8));
-    dig_P5 = int16_t(uint16_t(buf1[14]) | (uint16_t(buf1[15]) << 8));
-    dig_P6 = int16_t(uint16_t(buf1[16]) | (uint16_t(buf1[17]) << 8));
-    dig_P7 = int16_t(uint16_t(buf1[18]) | (uint16_t(buf1[19]) << 8));
-    dig_P8 = int16_t(uint16_t(buf1[20]) | (uint16_t(buf1[21]) << 8));
-    dig_P9 = int16_t(uint16_t(buf1[22]) | (uint16_t(buf1[23]) << 8));
-    dig_H1 = buf1[25];
+    auto &c = calib_;
+    c.dig_T1 = uint16_t(buf1[0]) | (uint16_t(buf1[1]) << 8);
+    c.dig_T2 = int16_t(uint16_t(buf1[2]) | (uint16_t(buf1[3]) << 8));
+    c.dig_T3 = int16_t(uint16_t(buf1[4]) | (uint16_t(buf1[5]) << 8));
+
+    c.dig_P1 = uint16_t(buf1[6]) | (uint16_t(buf1[7]) << 8);
+    c.dig_P2 = int16_t(uint16_t(buf1[8]) | (uint16_t(buf1[9]) << 8));
+    c.dig_P3 = int16_t(uint16_t(buf1[10]) | (uint16_t(buf1[11]) << 8));
+    c.dig_P4 = int16_t(uint16_t(buf1[12]) | (uint16_t(buf1[13]) << 8));
+    c.dig_P5 = int16_t(uint16_t(buf1[14]) | (uint16_t(buf1[15]) << 8));
+    c.dig_P6 = int16_t(uint16_t(buf1[16]) | (uint16_t(buf1[17]) << 8));
+    c.dig_P7 = int16_t(uint16_t(buf1[18]) | (uint16_t(buf1[19]) << 8));
+    c.dig_P8 = int16_t(uint16_t(buf1[20]) | (uint16_t(buf1[21]) << 8));
+    c.dig_P9 = int16_t(uint16_t(buf1[22]) | (uint16_t(buf1[23]) << 8));
+
+    if (!has_humidity())
+        return true;
+
+    c.dig_H1 = buf1[25];
 
     std::array<uint8_t, 7> buf2{};
     if (connection_->read_register(device_address_, 0xE1, std::span<uint8_t>(buf2.data(), buf2.size())) != connections::Status::Success)
         return false;
 
-    dig_H2 = int16_t(uint16_t(buf2[0]) | (uint16_t(buf2[1]) << 8));
-    dig_H3 = buf2[2];
-    dig_H4 = int16_t((int16_t(buf2[3]) << 4) | (buf2[4] & 0xF));
-    dig_H5 = int16_t((int16_t(buf2[5]) << 4) | (uint8_t)(buf2[4] >> 4));
-    dig_H6 = int8_t(buf2[6]);
+    c.dig_H2 = int16_t(uint16_t(buf2[0]) | (uint16_t(buf2[1]) << 8));
+    c.dig_H3 = buf2[2];
+    c.dig_H4 = int16_t((int16_t(buf2[3]) << 4) | (buf2[4] & 0xF));
+    c.dig_H5 = int16_t((int16_t(buf2[5]) << 4) | (uint8_t)(buf2[4] >> 4));
+    c.dig_H6 = int8_t(buf2[6]);
 
     return true;
 }
 
+uint8_t bme280::ctrl_meas_value(uint8_t mode) const
+{
+    return static_cast<uint8_t>((encode_oversampling(settings_.oversampling_t) << 5) |
+                                (encode_oversampling(settings_.oversampling_p) << 2) | mode);
+}
+
+std::chrono::microseconds bme280::max_measurement_time() const
+{
+    // t_measure,max = 1.25 + 2.3*osrs_t + (2.3*osrs_p + 0.575) + (2.3*osrs_h + 0.575) ms
+    const int64_t osrs_t = programmed_oversampling(settings_.oversampling_t);
+    const int64_t osrs_p = programmed_oversampling(settings_.oversampling_p);
+    const int64_t osrs_h = programmed_oversampling(settings_.oversampling_h);
+    int64_t us = 1250;
+    if (osrs_t)
+        us += 2300 * osrs_t;
+    if (osrs_p)
+        us += 2300 * osrs_p + 575;
+    if (has_humidity() && osrs_h)
+        us += 2300 * osrs_h + 575;
+    return std::chrono::microseconds(us);
+}
+
+std::optional<std::chrono::steady_clock::time_point> bme280::data_ready_at() const
+{
+    if (!initialized_)
+        return std::nullopt;
+
+    if (settings_.forced)
+    {
+        if (measurement_pending_)
+            return ready_at_;
+        return std::nullopt; // nothing started, read_data() will trigger and wait
+    }
+
+    // Normal mode: a new result every t_measure + t_standby after the previous one
+    return last_read_time_ + max_measurement_time() + standby_;
+}
+
+Status bme280::start_measurement()
+{
+    if (!settings_.forced)
+        return Status::Success;
+
+    if (write_register(REG_CTRL_MEAS, ctrl_meas_value(MODE_FORCED)) != Status::Success)
+        return Status::ErrorCommunication;
+
+    ready_at_ = std::chrono::steady_clock::now() + max_measurement_time();
+    measurement_pending_ = true;
+    return Status::Success;
+}
+
+Status bme280::wait_measurement_done()
+{
+    // Out of budget: the conversion keeps running and the next read picks it up
+    if (!wait_until(ready_at_))
+    {
+        measurement_pending_ = true;
+        return Status::ErrorDeadline;
+    }
+
+    // t_measure,max is an upper bound; status only confirms it
+    for (int i = 0; i < 20; ++i)
+    {
+        uint8_t status = 0;
+        if (read_register(REG_STATUS, status) != Status::Success)
+            return Status::ErrorCommunication;
+        if ((status & STATUS_MEASURING) == 0)
+            return Status::Success;
+        if (!wait_for(std::chrono::microseconds(500)))
+        {
+            measurement_pending_ = true;
+            return Status::ErrorDeadline;
+        }
+    }
+    return Status::ErrorTimeout;
+}
+
+Status bme280::acquire_raw(int32_t &raw_t, int32_t &raw_p, int32_t &raw_h)
+{
+    if (settings_.forced)
+    {
+        if (!measurement_pending_)
+        {
+            auto st = start_measurement();
+            if (st != Status::Success) return st;
+        }
+        measurement_pending_ = false;
+        auto st = wait_measurement_done();
+        if (st != Status::Success) return st;
+    }
+
+    if (!read_raw(raw_t, raw_p, raw_h)) return Status::ErrorCommunication;
+    return Status::Success;
+}
+
 bool bme280::read_raw(int32_t &raw_t, int32_t &raw_p, int32_t &raw_h)
 {
     std::array<uint8_t, 8> data{};
-    if (connection_->read_register(device_address_, REG_DATA, std::span<uint8_t>(data.data(), 8)) != connections::Status::Success)
+    const size_t len = has_humidity() ? 8 : 6;
+    if (connection_->read_register(device_address_, REG_DATA, std::span<uint8_t>(data.data(), len)) != connections::Status::Success)
         return false;
 
     raw_p = (int32_t(data[0]) << 12) | (int32_t(data[1]) << 4) | (int32_t(data[2]) >> 4);
@@ -120,74 +317,59 @@ bool bme280::read_raw(int32_t &raw_t, int32_t &raw_p, int32_t &raw_h)
 Status bme280::read_temperature(temperature_data &data)
 {
     int32_t raw_t, raw_p, raw_h;
-    if (!read_raw(raw_t, raw_p, raw_h)) return Status::ErrorCommunication;
+    auto acquired = acquire_raw(raw_t, raw_p, raw_h);
+    if (acquired != Status::Success) return acquired;
 
-    // temperature compensation (Bosch algorithm)
-    int32_t var1 = ((((raw_t >> 3) - (int32_t(dig_T1) << 1))) * int32_t(dig_T2)) >> 11;
-    int32_t var2 = (((((raw_t >> 4) - int32_t(dig_T1)) * ((raw_t >> 4) - int32_t(dig_T1))) >> 12) * int32_t(dig_T3)) >> 14;
-    t_fine = var1 + var2;
-    float T = (t_fine * 5 + 128) >> 8;
-    data.celsius = T / 100.0f;
-    data.valid = true;
+    fill_temperature(data, bme280_t_fine(calib_, raw_t));
     return Status::Success;
 }
 
 Status bme280::read_pressure(pressure_data &data)
 {
     int32_t raw_t, raw_p, raw_h;
-    if (!read_raw(raw_t, raw_p, raw_h)) return Status::ErrorCommunication;
+    auto acquired = acquire_raw(raw_t, raw_p, raw_h);
+    if (acquired != Status::Success) return acquired;
 
-    // compute pressure (uses t_fine from temperature comp)
-    int64_t var1 = int64_t(t_fine) - 128000;
-    int64_t var2 = var1 * var1 * int64_t(dig_P6);
-    var2 = var2 + ((var1 * int64_t(dig_P5)) << 17);
-    var2 = var2 + (int64_t(dig_P4) << 35);
-    var1 = ((var1 * var1 * int64_t(dig_P3)) >> 8) + ((var1 * int64_t(dig_P2)) << 12);
-    var1 = (((int64_t(1) << 47) + var1) * int64_t(dig_P1)) >> 33;
-    if (var1 == 0) return Status::ErrorCalibration; // avoid div by zero
-    int64_t p = 1048576 - raw_p;
-    p = (((p << 31) - var2) * 3125) / var1;
-    var1 = (int64_t(dig_P9) * (p >> 13) * (p >> 13)) >> 25;
-    var2 = (int64_t(dig_P8) * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (int64_t(dig_P7) << 4);
-    data.pascals = float(p) / 256.0f; // p is in Q24.8
-    data.valid = true;
-    return Status::Success;
+    return fill_pressure(data, calib_, raw_p, bme280_t_fine(calib_, raw_t));
 }
 
 Status bme280::read_humidity(humidity_data &data)
 {
+    if (!has_humidity()) {
+        data.valid = false;
+        return Status::ErrorInvalidData;
+    }
+
     int32_t raw_t, raw_p, raw_h;
-    if (!read_raw(raw_t, raw_p, raw_h)) return Status::ErrorCommunication;
+    auto acquired = acquire_raw(raw_t, raw_p, raw_h);
+    if (acquired != Status::Success) return acquired;
 
-    int32_t v_x1_u32r = t_fine - 76800;
-    v_x1_u32r = (((((raw_h << 14) - (int32_t(dig_H4) << 20) - (int32_t(dig_H5) * v_x1_u32r)) + 16384) >> 15) * (((((((v_x1_u32r * int32_t(dig_H6)) >> 10) * (((v_x1_u32r * int32_t(dig_H3)) >> 11) + 32768)) >> 10) + 2097152) * int32_t(dig_H2) + 8192) >> 14));
-    v_x1_u32r = v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * int32_t(dig_H1)) >> 4);
-    v_x1_u32r = (v_x1_u32r < 0) ? 0 : v_x1_u32r;
-    v_x1_u32r = (v_x1_u32r > 419430400) ? 419430400 : v_x1_u32r;
-    float h = (v_x1_u32r >> 12);
-    data.relative_humidity = h / 1024.0f;
-    data.valid = true;
+    fill_humidity(data, calib_, raw_h, bme280_t_fine(calib_, raw_t));
     return Status::Success;
 }
 
 Status bme280::read_data(combined_env_data &data)
 {
-    temperature_data t{};
-    humidity_data h{};
-    pressure_data p{};
-    auto st = read_temperature(t);
-    if (st != Status::Success) return st;
-    st = read_humidity(h);
-    if (st != Status::Success) return st;
-    st = read_pressure(p);
+    // One burst feeds all channels, so they come from the same conversion
+    int32_t raw_t, raw_p, raw_h;
+    auto acquired = acquire_raw(raw_t, raw_p, raw_h);
+    if (acquired != Status::Success) return acquired;
+
+    last_raw_ = {raw_t, raw_p, has_humidity() ? raw_h : 0, true};
+    const int32_t t_fine = bme280_t_fine(calib_, raw_t);
+
+    combined_env_data out{};
+    fill_temperature(out.temperature, t_fine);
+    auto st = fill_pressure(out.pressure, calib_, raw_p, t_fine);
     if (st != Status::Success) return st;
-    data.temperature = t;
-    data.humidity = h;
-    data.pressure = p;
+    if (has_humidity())
+        fill_humidity(out.humidity, calib_, raw_h, t_fine);
+    else
+        out.humidity.valid = false;
+
+    data = out;
+    last_read_time_ = std::chrono::steady_clock::now();
     return Status::Success;
 }
 
-// deinitialize already implemented above
-
 } // namespace peripherals
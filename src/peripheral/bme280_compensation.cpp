@@ -0,0 +1,66 @@
+/**
+ * @file bme280_compensation.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Batch compensation over captured BME280 raw samples
+ * @version 0.1
+ * @date 2026-01-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "peripheral/bme280_compensation.h"
+#include <algorithm>
+#include <array>
+
+namespace peripherals {
+
+// Samples per block; t_fine of a block stays in L1 between the passes
+static constexpr size_t BLOCK = 1024;
+
+bool bme280_compensate_batch(const bme280_calibration &c,
+                             std::span<const int32_t> raw_t,
+                             std::span<const int32_t> raw_p,
+                             std::span<const int32_t> raw_h,
+                             std::span<int32_t> temperature_centi,
+                             std::span<uint32_t> pressure_q24_8,
+                             std::span<uint32_t> humidity_q22_10)
+{
+    const size_t n = raw_t.size();
+    if (raw_p.size() != n || temperature_centi.size() != n || pressure_q24_8.size() != n ||
+        (!raw_h.empty() && raw_h.size() != n) || (!humidity_q22_10.empty() && humidity_q22_10.size() != n))
+        return false;
+    const bool with_humidity = !raw_h.empty() && !humidity_q22_10.empty();
+    std::array<int32_t, BLOCK> t_fine;
+
+    for (size_t base = 0; base < n; base += BLOCK)
+    {
+        const size_t len = std::min(BLOCK, n - base);
+        const int32_t *rt = raw_t.data() + base;
+
+        // Pure int32 passes without branches: the compiler vectorizes these
+        for (size_t i = 0; i < len; ++i)
+            t_fine[i] = bme280_t_fine(c, rt[i]);
+
+        int32_t *t_out = temperature_centi.data() + base;
+        for (size_t i = 0; i < len; ++i)
+            t_out[i] = bme280_temperature_centi(t_fine[i]);
+
+        if (with_humidity)
+        {
+            const int32_t *rh = raw_h.data() + base;
+            uint32_t *h_out = humidity_q22_10.data() + base;
+            for (size_t i = 0; i < len; ++i)
+                h_out[i] = bme280_humidity_q22_10(c, rh[i], t_fine[i]);
+        }
+
+        // 64-bit divide per sample, stays scalar
+        const int32_t *rp = raw_p.data() + base;
+        uint32_t *p_out = pressure_q24_8.data() + base;
+        for (size_t i = 0; i < len; ++i)
+            p_out[i] = bme280_pressure_q24_8(c, rp[i], t_fine[i]);
+    }
+    return true;
+}
+
+} // namespace peripherals
@@ -16,6 +16,11 @@
 
 namespace peripherals {
 
+static constexpr uint8_t REG_SECONDS = 0x00;
+static constexpr uint8_t HOUR_12H = 0x40;
+static constexpr uint8_t HOUR_PM = 0x20;
+static constexpr uint8_t MONTH_CENTURY = 0x80;
+
 ds3231::ds3231(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address)
     : rtc_iface(conn, address)
 {
@@ -29,7 +34,7 @@ Status ds3231::initialize()
 
     // Check if device is present
     uint8_t reg;
-    if (read_register(0x00, reg) != Status::Success) {
+    if (read_register(REG_SECONDS, reg) != Status::Success) {
         return Status::ErrorCommunication;
     }
 
@@ -45,7 +50,7 @@ void ds3231::deinitialize()
 bool ds3231::is_connected()
 {
     uint8_t reg;
-    return read_register(0x00, reg) == Status::Success;
+    return read_register(REG_SECONDS, reg) == Status::Success;
 }
 
 Status ds3231::reset()
@@ -57,57 +62,81 @@ Status ds3231::reset()
 
 Status ds3231::read_data(time_data &data)
 {
+    // One burst over seconds..year, so the fields cannot tear across a rollover
     uint8_t buffer[7];
-    if (read_registers(0x00, std::span(buffer, 7)) != Status::Success) {
+    if (read_registers(REG_SECONDS, std::span(buffer, 7)) != Status::Success) {
         return Status::ErrorCommunication;
     }
 
-    // Convert BCD to decimal
-    uint8_t sec, min, hour, day, date, month, year;
-    if (bcd_to_dec(buffer[0], sec) != Status::Success ||
-        bcd_to_dec(buffer[1], min) != Status::Success ||
-        bcd_to_dec(buffer[2], hour) != Status::Success ||
-        bcd_to_dec(buffer[3], day) != Status::Success ||
-        bcd_to_dec(buffer[4], date) != Status::Success ||
-        bcd_to_dec(buffer[5], month) != Status::Success ||
+    uint8_t sec, min, hour, date, month, year;
+    if (bcd_to_dec(buffer[0] & 0x7F, sec) != Status::Success ||
+        bcd_to_dec(buffer[1] & 0x7F, min) != Status::Success ||
+        bcd_to_dec(buffer[4] & 0x3F, date) != Status::Success ||
+        bcd_to_dec(buffer[5] & 0x1F, month) != Status::Success ||
         bcd_to_dec(buffer[6], year) != Status::Success) {
         return Status::ErrorInvalidData;
     }
 
+    if (buffer[2] & HOUR_12H) {
+        // 12-hour mode: bit 5 is PM
+        if (bcd_to_dec(buffer[2] & 0x1F, hour) != Status::Success) {
+            return Status::ErrorInvalidData;
+        }
+        hour = static_cast<uint8_t>(hour % 12 + ((buffer[2] & HOUR_PM) ? 12 : 0));
+    } else if (bcd_to_dec(buffer[2] & 0x3F, hour) != Status::Success) {
+        return Status::ErrorInvalidData;
+    }
+
     data.second = sec;
     data.minute = min;
     data.hour = hour;
     data.day = date;
     data.month = month;
-    data.year = 2000 + year; // Assuming 21st century
-    data.valid = true;
+    data.year = 2000 + year + ((buffer[5] & MONTH_CENTURY) ? 100 : 0);
+    data.valid = sec < 60 && min < 60 && hour < 24 && date >= 1 && date <= 31 && month >= 1 && month <= 12;
 
-    return Status::Success;
+    return data.valid ? Status::Success : Status::ErrorInvalidData;
 }
 
 Status ds3231::set_time(const time_data &time)
 {
+    // Every field is checked before any conversion: day_of_week() indexes by month
+    if (time.year < 2000 || time.year > 2199 || time.month < 1 || time.month > 12 ||
+        time.day < 1 || time.day > 31 || time.hour < 0 || time.hour > 23 ||
+        time.minute < 0 || time.minute > 59 || time.second < 0 || time.second > 59) {
+        return Status::ErrorOutOfRange;
+    }
+
     uint8_t buffer[7];
 
-    // Convert decimal to BCD
+    // Convert decimal to BCD; hours are written in 24-hour mode
     if (dec_to_bcd(time.second, buffer[0]) != Status::Success ||
         dec_to_bcd(time.minute, buffer[1]) != Status::Success ||
         dec_to_bcd(time.hour, buffer[2]) != Status::Success ||
-        dec_to_bcd(time.day, buffer[3]) != Status::Success ||
-        dec_to_bcd(time.day, buffer[4]) != Status::Success || // Day of week, using day for simplicity
+        dec_to_bcd(day_of_week(time.year, time.month, time.day), buffer[3]) != Status::Success ||
+        dec_to_bcd(time.day, buffer[4]) != Status::Success ||
         dec_to_bcd(time.month, buffer[5]) != Status::Success ||
         dec_to_bcd(time.year % 100, buffer[6]) != Status::Success) {
         return Status::ErrorInvalidData;
     }
-
-    // Write to registers
-    for (size_t i = 0; i < 7; ++i) {
-        if (write_register(0x00 + i, buffer[i]) != Status::Success) {
-            return Status::ErrorCommunication;
-        }
+    if (time.year >= 2100) {
+        buffer[5] |= MONTH_CENTURY;
     }
 
-    return Status::Success;
+    // Single burst: the countdown chain restarts on the seconds write, no partial time visible
+    auto status = connection_->write_register(device_address_, REG_SECONDS, std::span<const uint8_t>(buffer, 7));
+    return status == connections::Status::Success ? Status::Success : Status::ErrorCommunication;
+}
+
+uint8_t ds3231::day_of_week(int year, int month, int day)
+{
+    // Sakamoto; register value 1 = Monday .. 7 = Sunday
+    static const int offsets[12] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+    if (month < 3) {
+        year -= 1;
+    }
+    int dow = (year + year / 4 - year / 100 + year / 400 + offsets[(month - 1) % 12] + day) % 7; // 0 = Sunday
+    return static_cast<uint8_t>(dow == 0 ? 7 : dow);
 }
 
 Status ds3231::bcd_to_dec(uint8_t bcd, uint8_t &dec)
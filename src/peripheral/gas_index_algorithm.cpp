@@ -0,0 +1,322 @@
+/**
+ * @file gas_index_algorithm.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Streaming VOC/NOx index from SGP4x raw signals
+ * @version 0.1
+ * @date 2026-01-20
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "peripheral/gas_index_algorithm.h"
+#include <cmath>
+
+namespace peripherals
+{
+    // Constants of the reference implementation (Sensirion gas-index-algorithm 3.x)
+    static constexpr float INITIAL_BLACKOUT = 45.0f;
+    static constexpr float INDEX_GAIN = 230.0f;
+    static constexpr float SRAW_STD_INITIAL = 50.0f;
+    static constexpr float SRAW_STD_BONUS_VOC = 220.0f;
+    static constexpr float SRAW_STD_NOX = 2000.0f;
+    static constexpr float TAU_MEAN_HOURS = 12.0f;
+    static constexpr float TAU_VARIANCE_HOURS = 12.0f;
+    static constexpr float TAU_INITIAL_MEAN_VOC = 20.0f;
+    static constexpr float TAU_INITIAL_MEAN_NOX = 1200.0f;
+    static constexpr float INIT_DURATION_MEAN_VOC = 3600.0f * 0.75f;
+    static constexpr float INIT_DURATION_MEAN_NOX = 3600.0f * 4.75f;
+    static constexpr float INIT_TRANSITION_MEAN = 0.01f;
+    static constexpr float TAU_INITIAL_VARIANCE = 2500.0f;
+    static constexpr float INIT_DURATION_VARIANCE_VOC = 3600.0f * 1.45f;
+    static constexpr float INIT_DURATION_VARIANCE_NOX = 3600.0f * 5.70f;
+    static constexpr float INIT_TRANSITION_VARIANCE = 0.01f;
+    static constexpr float GATING_THRESHOLD_VOC = 340.0f;
+    static constexpr float GATING_THRESHOLD_NOX = 30.0f;
+    static constexpr float GATING_THRESHOLD_INITIAL = 510.0f;
+    static constexpr float GATING_THRESHOLD_TRANSITION = 0.09f;
+    static constexpr float GATING_VOC_MAX_DURATION_MINUTES = 60.0f * 3.0f;
+    static constexpr float GATING_NOX_MAX_DURATION_MINUTES = 60.0f * 12.0f;
+    static constexpr float GATING_MAX_RATIO = 0.3f;
+    static constexpr float SIGMOID_L = 500.0f;
+    static constexpr float SIGMOID_K_VOC = -0.0065f;
+    static constexpr float SIGMOID_X0_VOC = 213.0f;
+    static constexpr float SIGMOID_K_NOX = -0.0101f;
+    static constexpr float SIGMOID_X0_NOX = 614.0f;
+    static constexpr float VOC_INDEX_OFFSET_DEFAULT = 100.0f;
+    static constexpr float NOX_INDEX_OFFSET_DEFAULT = 1.0f;
+    static constexpr float LP_TAU_FAST = 20.0f;
+    static constexpr float LP_TAU_SLOW = 500.0f;
+    static constexpr float LP_ALPHA = -0.2f;
+    static constexpr int32_t VOC_SRAW_MINIMUM = 20000;
+    static constexpr int32_t NOX_SRAW_MINIMUM = 10000;
+    static constexpr float PERSISTENCE_UPTIME_GAMMA = 3.0f * 3600.0f;
+    static constexpr float MVE_GAMMA_SCALING = 64.0f;
+    static constexpr float MVE_ADDITIONAL_GAMMA_MEAN_SCALING = 8.0f;
+    static constexpr float MVE_FIX16_MAX = 32767.0f;
+
+    gas_index_algorithm::gas_index_algorithm(gas_index_type type, float sampling_interval_s)
+        : type_(type), sampling_interval_(sampling_interval_s)
+    {
+        if (type_ == gas_index_type::nox)
+        {
+            index_offset_ = NOX_INDEX_OFFSET_DEFAULT;
+            sraw_minimum_ = NOX_SRAW_MINIMUM;
+            gating_max_duration_minutes_ = GATING_NOX_MAX_DURATION_MINUTES;
+            init_duration_mean_ = INIT_DURATION_MEAN_NOX;
+            init_duration_variance_ = INIT_DURATION_VARIANCE_NOX;
+            gating_threshold_ = GATING_THRESHOLD_NOX;
+        }
+        else
+        {
+            index_offset_ = VOC_INDEX_OFFSET_DEFAULT;
+            sraw_minimum_ = VOC_SRAW_MINIMUM;
+            gating_max_duration_minutes_ = GATING_VOC_MAX_DURATION_MINUTES;
+            init_duration_mean_ = INIT_DURATION_MEAN_VOC;
+            init_duration_variance_ = INIT_DURATION_VARIANCE_VOC;
+            gating_threshold_ = GATING_THRESHOLD_VOC;
+        }
+        index_gain_ = INDEX_GAIN;
+        tau_mean_hours_ = TAU_MEAN_HOURS;
+        tau_variance_hours_ = TAU_VARIANCE_HOURS;
+        sraw_std_initial_ = SRAW_STD_INITIAL;
+        reset();
+    }
+
+    void gas_index_algorithm::reset()
+    {
+        uptime_ = 0.0f;
+        sraw_ = 0.0f;
+        gas_index_ = 0.0f;
+        init_instances();
+    }
+
+    void gas_index_algorithm::init_instances()
+    {
+        mve_set_parameters();
+        mox_sraw_std_ = mve_std_;
+        mox_sraw_mean_ = mve_mean();
+
+        if (type_ == gas_index_type::nox)
+        {
+            sigmoid_x0_ = SIGMOID_X0_NOX;
+            sigmoid_k_ = SIGMOID_K_NOX;
+            sigmoid_offset_default_ = NOX_INDEX_OFFSET_DEFAULT;
+        }
+        else
+        {
+            sigmoid_x0_ = SIGMOID_X0_VOC;
+            sigmoid_k_ = SIGMOID_K_VOC;
+            sigmoid_offset_default_ = VOC_INDEX_OFFSET_DEFAULT;
+        }
+
+        lp_a1_ = sampling_interval_ / (LP_TAU_FAST + sampling_interval_);
+        lp_a2_ = sampling_interval_ / (LP_TAU_SLOW + sampling_interval_);
+        lp_initialized_ = false;
+    }
+
+    gas_index_state gas_index_algorithm::get_state() const
+    {
+        return {mve_mean(), mve_std_};
+    }
+
+    void gas_index_algorithm::set_state(const gas_index_state &state)
+    {
+        // Restored state counts as already past the initial learning phase
+        mve_set_state(state.mean, state.std, PERSISTENCE_UPTIME_GAMMA);
+        mox_sraw_std_ = mve_std_;
+        mox_sraw_mean_ = mve_mean();
+        sraw_ = state.mean;
+    }
+
+    int32_t gas_index_algorithm::process(int32_t sraw)
+    {
+        if (uptime_ <= INITIAL_BLACKOUT)
+        {
+            uptime_ += sampling_interval_;
+        }
+        else
+        {
+            if (sraw > 0 && sraw < 65000)
+            {
+                if (sraw < sraw_minimum_ + 1)
+                    sraw = sraw_minimum_ + 1;
+                else if (sraw > sraw_minimum_ + 32767)
+                    sraw = sraw_minimum_ + 32767;
+                sraw_ = static_cast<float>(sraw - sraw_minimum_);
+            }
+
+            if (type_ == gas_index_type::voc || mve_initialized_)
+                gas_index_ = sigmoid_scaled_process(mox_process(sraw_));
+            else
+                gas_index_ = index_offset_;
+
+            gas_index_ = lowpass_process(gas_index_);
+            if (gas_index_ < 0.5f)
+                gas_index_ = 0.5f;
+
+            if (sraw_ > 0.0f)
+            {
+                mve_process(sraw_);
+                mox_sraw_std_ = mve_std_;
+                mox_sraw_mean_ = mve_mean();
+            }
+        }
+        return static_cast<int32_t>(gas_index_ + 0.5f);
+    }
+
+    void gas_index_algorithm::mve_set_parameters()
+    {
+        const float interval_h = sampling_interval_ / 3600.0f;
+
+        mve_initialized_ = false;
+        mve_mean_ = 0.0f;
+        mve_sraw_offset_ = 0.0f;
+        mve_std_ = sraw_std_initial_;
+        mve_gamma_mean_ = (MVE_ADDITIONAL_GAMMA_MEAN_SCALING * MVE_GAMMA_SCALING * interval_h) /
+                          (tau_mean_hours_ + interval_h);
+        mve_gamma_variance_ = (MVE_GAMMA_SCALING * interval_h) / (tau_variance_hours_ + interval_h);
+        const float tau_initial_mean = type_ == gas_index_type::nox ? TAU_INITIAL_MEAN_NOX : TAU_INITIAL_MEAN_VOC;
+        mve_gamma_initial_mean_ = (MVE_ADDITIONAL_GAMMA_MEAN_SCALING * MVE_GAMMA_SCALING * sampling_interval_) /
+                                  (tau_initial_mean + sampling_interval_);
+        mve_gamma_initial_variance_ = (MVE_GAMMA_SCALING * sampling_interval_) /
+                                      (TAU_INITIAL_VARIANCE + sampling_interval_);
+        mve_current_gamma_mean_ = 0.0f;
+        mve_current_gamma_variance_ = 0.0f;
+        mve_uptime_gamma_ = 0.0f;
+        mve_uptime_gating_ = 0.0f;
+        mve_gating_duration_minutes_ = 0.0f;
+    }
+
+    void gas_index_algorithm::mve_set_state(float mean, float std, float uptime_gamma)
+    {
+        mve_mean_ = mean;
+        mve_std_ = std;
+        mve_uptime_gamma_ = uptime_gamma;
+        mve_initialized_ = true;
+    }
+
+    float gas_index_algorithm::mve_sigmoid(float x0, float k, float sample)
+    {
+        const float x = k * (sample - x0);
+        if (x < -50.0f)
+            return 1.0f;
+        if (x > 50.0f)
+            return 0.0f;
+        return 1.0f / (1.0f + std::exp(x));
+    }
+
+    void gas_index_algorithm::mve_calculate_gamma()
+    {
+        const float uptime_limit = MVE_FIX16_MAX - sampling_interval_;
+        if (mve_uptime_gamma_ < uptime_limit)
+            mve_uptime_gamma_ += sampling_interval_;
+        if (mve_uptime_gating_ < uptime_limit)
+            mve_uptime_gating_ += sampling_interval_;
+
+        const float sigmoid_gamma_mean = mve_sigmoid(init_duration_mean_, INIT_TRANSITION_MEAN, mve_uptime_gamma_);
+        const float gamma_mean = mve_gamma_mean_ + (mve_gamma_initial_mean_ - mve_gamma_mean_) * sigmoid_gamma_mean;
+        const float gating_threshold_mean =
+            gating_threshold_ + (GATING_THRESHOLD_INITIAL - gating_threshold_) *
+                                    mve_sigmoid(init_duration_mean_, INIT_TRANSITION_MEAN, mve_uptime_gating_);
+        const float sigmoid_gating_mean = mve_sigmoid(gating_threshold_mean, GATING_THRESHOLD_TRANSITION, gas_index_);
+        mve_current_gamma_mean_ = sigmoid_gating_mean * gamma_mean;
+
+        const float sigmoid_gamma_variance =
+            mve_sigmoid(init_duration_variance_, INIT_TRANSITION_VARIANCE, mve_uptime_gamma_);
+        const float gamma_variance = mve_gamma_variance_ + (mve_gamma_initial_variance_ - mve_gamma_variance_) *
+                                                               (sigmoid_gamma_variance - sigmoid_gamma_mean);
+        const float gating_threshold_variance =
+            gating_threshold_ + (GATING_THRESHOLD_INITIAL - gating_threshold_) *
+                                    mve_sigmoid(init_duration_variance_, INIT_TRANSITION_VARIANCE, mve_uptime_gating_);
+        const float sigmoid_gating_variance =
+            mve_sigmoid(gating_threshold_variance, GATING_THRESHOLD_TRANSITION, gas_index_);
+        mve_current_gamma_variance_ = sigmoid_gating_variance * gamma_variance;
+
+        // Long gating (persistent high index) must not freeze learning forever
+        mve_gating_duration_minutes_ +=
+            (sampling_interval_ / 60.0f) *
+            ((1.0f - sigmoid_gating_mean) * (1.0f + GATING_MAX_RATIO) - GATING_MAX_RATIO);
+        if (mve_gating_duration_minutes_ < 0.0f)
+            mve_gating_duration_minutes_ = 0.0f;
+        if (mve_gating_duration_minutes_ > gating_max_duration_minutes_)
+            mve_uptime_gating_ = 0.0f;
+    }
+
+    void gas_index_algorithm::mve_process(float sraw)
+    {
+        if (!mve_initialized_)
+        {
+            mve_initialized_ = true;
+            mve_sraw_offset_ = sraw;
+            mve_mean_ = 0.0f;
+            return;
+        }
+
+        if (mve_mean_ >= 100.0f || mve_mean_ <= -100.0f)
+        {
+            mve_sraw_offset_ += mve_mean_;
+            mve_mean_ = 0.0f;
+        }
+        sraw -= mve_sraw_offset_;
+        mve_calculate_gamma();
+
+        const float delta_sgp = (sraw - mve_mean_) / MVE_GAMMA_SCALING;
+        const float c = delta_sgp < 0.0f ? mve_std_ - delta_sgp : mve_std_ + delta_sgp;
+        float additional_scaling = 1.0f;
+        if (c > 1440.0f)
+            additional_scaling = (c / 1440.0f) * (c / 1440.0f);
+
+        mve_std_ = std::sqrt(additional_scaling * (MVE_GAMMA_SCALING - mve_current_gamma_variance_)) *
+                   std::sqrt(mve_std_ * (mve_std_ / (MVE_GAMMA_SCALING * additional_scaling)) +
+                             ((mve_current_gamma_variance_ * delta_sgp) / additional_scaling) * delta_sgp);
+        mve_mean_ += (mve_current_gamma_mean_ * delta_sgp) / MVE_ADDITIONAL_GAMMA_MEAN_SCALING;
+    }
+
+    float gas_index_algorithm::mox_process(float sraw) const
+    {
+        if (type_ == gas_index_type::nox)
+            return ((sraw - mox_sraw_mean_) / SRAW_STD_NOX) * index_gain_;
+        return ((sraw - mox_sraw_mean_) / (-1.0f * (mox_sraw_std_ + SRAW_STD_BONUS_VOC))) * index_gain_;
+    }
+
+    float gas_index_algorithm::sigmoid_scaled_process(float sample) const
+    {
+        const float x = sigmoid_k_ * (sample - sigmoid_x0_);
+        if (x < -50.0f)
+            return SIGMOID_L;
+        if (x > 50.0f)
+            return 0.0f;
+
+        if (sample >= 0.0f)
+        {
+            const float shift = sigmoid_offset_default_ == 1.0f
+                                    ? (500.0f / 499.0f) * (1.0f - index_offset_)
+                                    : (SIGMOID_L - 5.0f * index_offset_) / 4.0f;
+            return (SIGMOID_L + shift) / (1.0f + std::exp(x)) - shift;
+        }
+        return (index_offset_ / sigmoid_offset_default_) * (SIGMOID_L / (1.0f + std::exp(x)));
+    }
+
+    float gas_index_algorithm::lowpass_process(float sample)
+    {
+        if (!lp_initialized_)
+        {
+            lp_x1_ = sample;
+            lp_x2_ = sample;
+            lp_x3_ = sample;
+            lp_initialized_ = true;
+        }
+        lp_x1_ = (1.0f - lp_a1_) * lp_x1_ + lp_a1_ * sample;
+        lp_x2_ = (1.0f - lp_a2_) * lp_x2_ + lp_a2_ * sample;
+
+        // Fast response to steps, slow tracking while the two filters agree
+        const float abs_delta = std::fabs(lp_x1_ - lp_x2_);
+        const float f1 = std::exp(LP_ALPHA * abs_delta);
+        const float tau_a = (LP_TAU_SLOW - LP_TAU_FAST) * f1 + LP_TAU_FAST;
+        const float a3 = sampling_interval_ / (sampling_interval_ + tau_a);
+        lp_x3_ = (1.0f - a3) * lp_x3_ + a3 * sample;
+        return lp_x3_;
+    }
+
+} // namespace peripherals
@@ -15,62 +15,43 @@
 #else
 #include "peripheral/bme280.h"
 #include "peripheral/scd41.h"
+#include "peripheral/sgp41.h"
 #include "peripheral/ssd1306.h"
 #include "peripheral/ds3231.h"
 #endif
 #include <stdexcept>
-#include <algorithm>
 
 namespace peripherals {
 
-const std::map<std::string, PeripheralType> peripheral_factory::type_map_ = {
-    {"bmp280", PeripheralType::BMP280},
-    {"bme280", PeripheralType::BME280},
-    {"mpu6050", PeripheralType::MPU6050},
-    {"dht22", PeripheralType::DHT22},
-    {"sgp41", PeripheralType::SGP41},
-    {"scd41", PeripheralType::SCD41},
-    {"ssd1306", PeripheralType::SSD1306},
-    {"ds3231", PeripheralType::DS3231}
-};
-
-const std::map<PeripheralType, std::string> peripheral_factory::reverse_type_map_ = {
-    {PeripheralType::BMP280, "bmp280"},
-    {PeripheralType::BME280, "bme280"},
-    {PeripheralType::MPU6050, "mpu6050"},
-    {PeripheralType::DHT22, "dht22"},
-    {PeripheralType::SGP41, "sgp41"},
-    {PeripheralType::SCD41, "scd41"},
-    {PeripheralType::SSD1306, "ssd1306"},
-    {PeripheralType::DS3231, "ds3231"}
-};
-
-const std::map<PeripheralType, uint8_t> peripheral_factory::default_addresses_ = {
-    {PeripheralType::BMP280, 0x76},
-    {PeripheralType::BME280, 0x76},
-    {PeripheralType::MPU6050, 0x68},
-    {PeripheralType::DHT22, 0x00},
-    {PeripheralType::SGP41, 0x59},
-    {PeripheralType::SCD41, 0x62},
-    {PeripheralType::SSD1306, 0x3C},
-    {PeripheralType::DS3231, 0x68}
-};
-
 std::unique_ptr<environmental_sensor_iface>
 peripheral_factory::create_environmental_sensor(
     PeripheralType type,
     connections::addressable_connection_iface<uint8_t>* conn,
-    uint8_t address) {
+    uint8_t address,
+    const peripheral_options &opts) {
     #if TARGET_HOST
+    (void)opts;
     return std::make_unique<mock_environmental>(conn, address);
     #else
     switch (type) {
         case PeripheralType::BME280:
-            return std::make_unique<bme280>(conn, address);
-
-        case PeripheralType::BMP280:
-            // BMP280 is not implemented here yet; fallback to BME280-compatible driver if available
-            return std::make_unique<bme280>(conn, address);
+        case PeripheralType::BMP280: {
+            // same driver for both, BMP280 is detected by chip ID
+            bme280_settings settings;
+            const auto oversampling = [&opts](const char *key, uint8_t fallback) {
+                const long factor = option_int(opts, key, fallback);
+                if (factor < 0 || factor > 16 || !bme280_oversampling_valid(static_cast<uint8_t>(factor)))
+                    throw std::runtime_error(std::string("Unsupported BME280 ") + key + ": " + std::to_string(factor));
+                return static_cast<uint8_t>(factor);
+            };
+            settings.oversampling_t = oversampling("oversampling_t", settings.oversampling_t);
+            settings.oversampling_p = oversampling("oversampling_p", settings.oversampling_p);
+            settings.oversampling_h = oversampling("oversampling_h", settings.oversampling_h);
+            settings.iir_filter = static_cast<uint8_t>(option_int(opts, "iir_filter", settings.iir_filter));
+            settings.standby_ms = static_cast<float>(option_number(opts, "standby_ms", settings.standby_ms));
+            settings.forced = option_string(opts, "mode", "normal") == "forced";
+            return std::make_unique<bme280>(conn, address, settings);
+        }
 
         default:
             throw std::runtime_error("Unsupported environmental sensor type");
@@ -97,13 +78,33 @@ std::unique_ptr<gas_sensor_iface>
 peripheral_factory::create_gas_sensor(
     PeripheralType type,
     connections::addressable_connection_iface<uint8_t>* conn,
-    uint8_t address) {
+    uint8_t address,
+    const peripheral_options &opts) {
     #if TARGET_HOST
+    (void)opts;
     return nullptr;
     #else
     switch (type) {
-        case PeripheralType::SCD41:
-            return std::make_unique<scd41>(conn, address);
+        case PeripheralType::SCD41: {
+            static const std::map<std::string, scd41_mode> modes = {
+                {"periodic", scd41_mode::periodic},
+                {"low_power", scd41_mode::low_power_periodic},
+                {"single_shot", scd41_mode::single_shot},
+                {"single_shot_rht_only", scd41_mode::single_shot_rht_only}
+            };
+            auto it = modes.find(option_string(opts, "mode", "periodic"));
+            if (it == modes.end())
+                throw std::runtime_error("Unsupported SCD41 mode");
+            return std::make_unique<scd41>(conn, address, it->second);
+        }
+
+        case PeripheralType::SGP41: {
+            sgp41_settings settings;
+            settings.state_path = option_string(opts, "state_path", settings.state_path);
+            settings.state_max_age = std::chrono::seconds(
+                option_int(opts, "state_max_age_s", settings.state_max_age.count()));
+            return std::make_unique<sgp41>(conn, address, settings);
+        }
 
         default:
             throw std::runtime_error("Unsupported gas sensor type");
@@ -115,13 +116,14 @@ std::unique_ptr<display_iface>
 peripheral_factory::create_display(
     PeripheralType type,
     connections::addressable_connection_iface<uint8_t>* conn,
-    uint8_t address) {
+    uint8_t address,
+    connections::gpio_line* dc_line) {
     #if TARGET_HOST
     return nullptr;
     #else
     switch (type) {
         case PeripheralType::SSD1306:
-            return std::make_unique<ssd1306>(conn, address);
+            return std::make_unique<ssd1306>(conn, address, dc_line);
 
         default:
             throw std::runtime_error("Unsupported display type");
@@ -148,34 +150,17 @@ peripheral_factory::create_rtc(
 }
 
 PeripheralType peripheral_factory::string_to_type(const std::string& type_str) {
-    std::string lower_str = type_str;
-    std::transform(lower_str.begin(), lower_str.end(), lower_str.begin(),
-                   [](unsigned char c){ return std::tolower(c); });
-    
-    auto it = type_map_.find(lower_str);
-    if (it != type_map_.end()) {
-        return it->second;
-    }
-    
-    return PeripheralType::Unknown;
+    return type_from_name(type_str);
 }
 
 std::string peripheral_factory::type_to_string(PeripheralType type) {
-    auto it = reverse_type_map_.find(type);
-    if (it != reverse_type_map_.end()) {
-        return it->second;
-    }
-    
-    return "unknown";
+    const peripheral_descriptor *entry = find_descriptor(type);
+    return entry ? std::string(entry->name) : "unknown";
 }
 
 uint8_t peripheral_factory::get_default_address(PeripheralType type) {
-    auto it = default_addresses_.find(type);
-    if (it != default_addresses_.end()) {
-        return it->second;
-    }
-    
-    return 0x00;
+    const peripheral_descriptor *entry = find_descriptor(type);
+    return entry ? entry->default_address : 0x00;
 }
 
 } // namespace peripherals
@@ -0,0 +1,151 @@
+/**
+ * @file replay_sensors.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Gas and environmental sensors that play back a recording
+ * @version 0.1
+ * @date 2026-02-08
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "peripheral/replay_sensors.h"
+#include <cmath>
+
+namespace peripherals
+{
+    namespace
+    {
+        using connections::replay_row;
+
+        // Next row of the recording, waited for within the current read
+        template <typename Wait>
+        Status next_row(connections::replay_connection *replay, replay_row &row, Wait &&wait_until)
+        {
+            const auto due = replay->next_due();
+            if (due == std::chrono::steady_clock::time_point::max())
+                return Status::ErrorInvalidData; // over; not a fault of the "device"
+            if (!wait_until(due))
+                return Status::ErrorDeadline;
+            return replay->take(row) ? Status::Success : Status::ErrorDeadline;
+        }
+
+        float field_or_nan(const replay_row &row, replay_row::field f)
+        {
+            return row.has(f) ? row.get(f) : std::nanf("");
+        }
+    } // namespace
+
+    Status replay_gas_sensor::initialize()
+    {
+        initialized_ = replay_->is_ready() || replay_->initialize() == connections::Status::Success;
+        return initialized_ ? Status::Success : Status::ErrorNotInitialized;
+    }
+
+    Status replay_gas_sensor::next(replay_row &row)
+    {
+        if (!initialized_)
+            return Status::ErrorNotInitialized;
+        const Status status = next_row(replay_, row, [this](auto t) { return wait_until(t); });
+        if (status == Status::Success)
+            last_read_time_ = std::chrono::steady_clock::now();
+        return status;
+    }
+
+    Status replay_gas_sensor::read_data(gas_data &data)
+    {
+        replay_row row;
+        if (const Status status = next(row); status != Status::Success)
+            return status;
+
+        // Conventions of the real drivers: no CO2 (an index-only SGP41 row) is < 0, no index is -1
+        data.co2_ppm = row.has(replay_row::co2_ppm) ? row.get(replay_row::co2_ppm) : -1.0f;
+        data.tvoc_ppb = 0.0f;
+        data.temperature_c = field_or_nan(row, replay_row::temperature_c);
+        data.humidity_rh = field_or_nan(row, replay_row::humidity_rh);
+        data.voc_index = row.has(replay_row::voc_index) ? static_cast<int32_t>(row.get(replay_row::voc_index)) : -1;
+        data.nox_index = row.has(replay_row::nox_index) ? static_cast<int32_t>(row.get(replay_row::nox_index)) : -1;
+        data.valid = data.co2_ppm >= 0 || data.voc_index >= 0 || data.nox_index >= 0;
+        return data.valid ? Status::Success : Status::ErrorInvalidData;
+    }
+
+    Status replay_gas_sensor::read_co2(float &ppm)
+    {
+        gas_data data;
+        const Status status = read_data(data);
+        if (status == Status::Success)
+            ppm = data.co2_ppm;
+        return status;
+    }
+
+    Status replay_gas_sensor::read_tvoc(float &ppb)
+    {
+        gas_data data;
+        const Status status = read_data(data);
+        if (status == Status::Success)
+            ppb = data.tvoc_ppb;
+        return status;
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> replay_gas_sensor::data_ready_at() const
+    {
+        if (!initialized_)
+            return std::nullopt;
+        return replay_->next_due();
+    }
+
+    Status replay_environmental::initialize()
+    {
+        initialized_ = replay_->is_ready() || replay_->initialize() == connections::Status::Success;
+        return initialized_ ? Status::Success : Status::ErrorNotInitialized;
+    }
+
+    Status replay_environmental::read_data(combined_env_data &data)
+    {
+        if (!initialized_)
+            return Status::ErrorNotInitialized;
+        replay_row row;
+        if (const Status status = next_row(replay_, row, [this](auto t) { return wait_until(t); });
+            status != Status::Success)
+            return status;
+        last_read_time_ = std::chrono::steady_clock::now();
+
+        data.temperature = {field_or_nan(row, replay_row::temperature_c), row.has(replay_row::temperature_c)};
+        data.pressure = {field_or_nan(row, replay_row::pressure_pa), row.has(replay_row::pressure_pa)};
+        data.humidity = {field_or_nan(row, replay_row::humidity_rh), row.has(replay_row::humidity_rh)};
+        // A row without the sensor's channels (a CO2-only log) is not a reading
+        return data.temperature.valid && data.pressure.valid ? Status::Success : Status::ErrorInvalidData;
+    }
+
+    Status replay_environmental::read_temperature(temperature_data &data)
+    {
+        combined_env_data all;
+        const Status status = read_data(all);
+        data = all.temperature;
+        return status;
+    }
+
+    Status replay_environmental::read_humidity(humidity_data &data)
+    {
+        combined_env_data all;
+        const Status status = read_data(all);
+        data = all.humidity;
+        return status;
+    }
+
+    Status replay_environmental::read_pressure(pressure_data &data)
+    {
+        combined_env_data all;
+        const Status status = read_data(all);
+        data = all.pressure;
+        return status;
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> replay_environmental::data_ready_at() const
+    {
+        if (!initialized_)
+            return std::nullopt;
+        return replay_->next_due();
+    }
+
+} // namespace peripherals
@@ -10,6 +10,7 @@
  */
 
 #include "peripheral/scd41.h"
+#include "peripheral/sensirion_codec.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -17,9 +18,31 @@
 
 namespace peripherals {
 
-scd41::scd41(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address)
-    : gas_sensor_iface(conn, address)
+static constexpr uint16_t CMD_START_PERIODIC = 0x21b1;
+static constexpr uint16_t CMD_START_LOW_POWER_PERIODIC = 0x21ac;
+static constexpr uint16_t CMD_STOP_PERIODIC = 0x3f86;
+static constexpr uint16_t CMD_MEASURE_SINGLE_SHOT = 0x219d;
+static constexpr uint16_t CMD_MEASURE_SINGLE_SHOT_RHT_ONLY = 0x2196;
+static constexpr uint16_t CMD_GET_DATA_READY = 0xe4b8;
+static constexpr uint16_t CMD_READ_MEASUREMENT = 0xec05;
+
+// Sensor ignores commands for this long after stop_periodic_measurement
+static constexpr auto STOP_DELAY = std::chrono::milliseconds(500);
+
+scd41::scd41(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address, scd41_mode mode)
+    : gas_sensor_iface(conn, address), mode_(mode)
+{
+}
+
+std::chrono::milliseconds scd41::measurement_interval(scd41_mode mode)
 {
+    switch (mode) {
+        case scd41_mode::low_power_periodic: return std::chrono::milliseconds(30000);
+        case scd41_mode::single_shot_rht_only: return std::chrono::milliseconds(50);
+        case scd41_mode::single_shot:
+        case scd41_mode::periodic:
+        default: return std::chrono::milliseconds(5000);
+    }
 }
 
 Status scd41::initialize()
@@ -28,13 +51,14 @@ Status scd41::initialize()
         return Status::Success;
     }
 
-    // Stop any ongoing measurement
+    // The sensor may still be measuring from a previous run
     stop_periodic_measurement();
 
-    // Start periodic measurement
-    Status status = start_periodic_measurement();
-    if (status != Status::Success) {
-        return status;
+    if (is_periodic()) {
+        Status status = start_periodic_measurement();
+        if (status != Status::Success) {
+            return status;
+        }
     }
 
     initialized_ = true;
@@ -44,7 +68,9 @@ Status scd41::initialize()
 void scd41::deinitialize()
 {
     if (initialized_) {
-        stop_periodic_measurement();
+        if (periodic_running_)
+            stop_periodic_measurement(false); // nothing follows, don't hold up shutdown
+        single_pending_ = false;
         initialized_ = false;
     }
 }
@@ -60,8 +86,8 @@ Status scd41::reset()
 {
     // SCD41 doesn't have a reset command, stop and restart measurement
     stop_periodic_measurement();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    return start_periodic_measurement();
+    single_pending_ = false;
+    return is_periodic() ? start_periodic_measurement() : Status::Success;
 }
 
 Status scd41::read_data(gas_data &data)
@@ -77,7 +103,7 @@ Status scd41::read_data(gas_data &data)
         return status;
     }
 
-    data.co2_ppm = convert_co2(co2_raw);
+    data.co2_ppm = convert_co2(co2_raw); // 0 in RHT-only mode
     data.tvoc_ppb = 0.0f; // SCD41 doesn't measure TVOC
     data.temperature_c = convert_temperature(temp_raw);
     data.humidity_rh = convert_humidity(hum_raw);
@@ -89,16 +115,29 @@ Status scd41::read_data(gas_data &data)
 
 Status scd41::set_measurement_mode(uint8_t mode)
 {
-    // SCD41 has only periodic measurement mode
-    // Mode 0: periodic, others not supported
-    if (mode == 0) {
-        return start_periodic_measurement();
+    if (mode > static_cast<uint8_t>(scd41_mode::single_shot_rht_only)) {
+        return Status::ErrorInvalidData;
     }
-    return Status::ErrorInvalidData;
+
+    // Single-shot commands are only accepted while idle
+    if (periodic_running_) {
+        Status status = stop_periodic_measurement();
+        if (status != Status::Success) {
+            return status;
+        }
+    }
+
+    mode_ = static_cast<scd41_mode>(mode);
+    single_pending_ = false;
+    return is_periodic() ? start_periodic_measurement() : Status::Success;
 }
 
 Status scd41::read_co2(float &ppm)
 {
+    if (mode_ == scd41_mode::single_shot_rht_only) {
+        return Status::ErrorInvalidData;
+    }
+
     gas_data data;
     Status status = read_data(data);
     if (status == Status::Success) {
@@ -114,101 +153,134 @@ Status scd41::read_tvoc(float &ppb)
     return Status::ErrorInvalidData;
 }
 
-Status scd41::start_periodic_measurement()
+std::optional<std::chrono::steady_clock::time_point> scd41::data_ready_at() const
+{
+    if (!initialized_) {
+        return std::nullopt;
+    }
+
+    if (!is_periodic()) {
+        if (single_pending_)
+            return ready_at_;
+        return std::nullopt;
+    }
+
+    // Results appear at cadence_start_ + k * interval; report the first one not fetched yet
+    auto now = std::chrono::steady_clock::now();
+    if (now <= cadence_start_) {
+        return cadence_start_;
+    }
+    auto interval = measurement_interval(mode_);
+    auto latest = cadence_start_ + ((now - cadence_start_) / interval) * interval;
+    return last_read_time_ < latest ? latest : latest + interval;
+}
+
+Status scd41::start_measurement()
 {
-    // Command: 0x21b1
-    uint8_t cmd[2] = {0x21, 0xb1};
-    auto status = connection_->write(device_address_, std::span(cmd, 2));
-    return status == connections::Status::Success ? Status::Success : Status::ErrorCommunication;
+    if (is_periodic()) {
+        return Status::Success;
+    }
+
+    Status status = mode_ == scd41_mode::single_shot
+                        ? sensirion::send<CMD_MEASURE_SINGLE_SHOT>(connection_, device_address_)
+                        : sensirion::send<CMD_MEASURE_SINGLE_SHOT_RHT_ONLY>(connection_, device_address_);
+    if (status != Status::Success) {
+        return status;
+    }
+
+    ready_at_ = std::chrono::steady_clock::now() + measurement_interval(mode_);
+    single_pending_ = true;
+    return Status::Success;
 }
 
-Status scd41::stop_periodic_measurement()
+Status scd41::start_periodic_measurement()
 {
-    // Command: 0x3f86
-    uint8_t cmd[2] = {0x3f, 0x86};
-    auto status = connection_->write(device_address_, std::span(cmd, 2));
-    return status == connections::Status::Success ? Status::Success : Status::ErrorCommunication;
+    Status status = mode_ == scd41_mode::low_power_periodic
+                        ? sensirion::send<CMD_START_LOW_POWER_PERIODIC>(connection_, device_address_)
+                        : sensirion::send<CMD_START_PERIODIC>(connection_, device_address_);
+    if (status != Status::Success) {
+        return status;
+    }
+
+    periodic_running_ = true;
+    cadence_start_ = std::chrono::steady_clock::now() + measurement_interval(mode_);
+    return Status::Success;
 }
 
-Status scd41::get_data_ready_status(bool &ready)
+Status scd41::stop_periodic_measurement(bool settle)
 {
-    // Command: 0xe4b8
-    uint8_t cmd[2] = {0xe4, 0xb8};
-    uint8_t response[3];
-    auto status = connection_->write_read(device_address_, std::span(cmd, 2), std::span(response, 3));
-    if (status != connections::Status::Success) {
-        return Status::ErrorCommunication;
+    Status status = sensirion::send<CMD_STOP_PERIODIC>(connection_, device_address_);
+    periodic_running_ = false;
+    if (settle) {
+        std::this_thread::sleep_for(STOP_DELAY);
     }
+    return status;
+}
 
-    // Check CRC
-    if (!check_crc(response, 2, response[2])) {
-        return Status::ErrorInvalidData;
+Status scd41::get_data_ready_status(bool &ready)
+{
+    std::array<uint16_t, 1> word;
+    Status status = sensirion::read_words<CMD_GET_DATA_READY>(connection_, device_address_, word);
+    if (status != Status::Success) {
+        return status;
     }
 
-    uint16_t status_word = (response[0] << 8) | response[1];
-    ready = (status_word & 0x07FF) != 0;
+    ready = (word[0] & 0x07FF) != 0;
     return Status::Success;
 }
 
 Status scd41::read_measurement(uint16_t &co2_raw, uint16_t &temperature_raw, uint16_t &humidity_raw)
 {
-    // Wait until data is ready
+    if (!is_periodic() && !single_pending_) {
+        Status status = start_measurement();
+        if (status != Status::Success) {
+            return status;
+        }
+    }
+
+    // Sleep through the conversion, the data-ready word only confirms it
+    // A result due after the read's deadline is not waited for; a pending
+    // single shot stays pending for the next read
+    auto expected = data_ready_at();
+    if (expected && !wait_until(*expected)) {
+        return Status::ErrorDeadline;
+    }
+    single_pending_ = false;
+
     bool ready = false;
-    for (int i = 0; i < 10; ++i) { // Timeout after ~5 seconds
+    int polls = 0;
+    for (; polls < 20; ++polls) { // ~1 s of slack for the sensor's own clock
         Status status = get_data_ready_status(ready);
         if (status != Status::Success) {
             return status;
         }
         if (ready) break;
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!wait_for(std::chrono::milliseconds(50))) {
+            single_pending_ = !is_periodic();
+            return Status::ErrorDeadline;
+        }
     }
     if (!ready) {
         return Status::ErrorTimeout;
     }
 
-    // Command: 0xec05
-    uint8_t cmd[2] = {0xec, 0x05};
-    uint8_t response[9];
-    auto status = connection_->write_read(device_address_, std::span(cmd, 2), std::span(response, 9));
-    if (status != connections::Status::Success) {
-        return Status::ErrorCommunication;
+    // Result came later than predicted: re-anchor the periodic cadence on it
+    if (is_periodic() && polls > 0) {
+        cadence_start_ = std::chrono::steady_clock::now();
     }
 
-    // Check CRCs
-    if (!check_crc(response, 2, response[2]) ||
-        !check_crc(response + 3, 2, response[5]) ||
-        !check_crc(response + 6, 2, response[8])) {
-        return Status::ErrorInvalidData;
+    std::array<uint16_t, 3> words;
+    Status status = sensirion::read_words<CMD_READ_MEASUREMENT>(connection_, device_address_, words);
+    if (status != Status::Success) {
+        return status;
     }
 
-    co2_raw = (response[0] << 8) | response[1];
-    temperature_raw = (response[3] << 8) | response[4];
-    humidity_raw = (response[6] << 8) | response[7];
-
+    co2_raw = words[0];
+    temperature_raw = words[1];
+    humidity_raw = words[2];
     return Status::Success;
 }
 
-uint8_t scd41::crc8(const uint8_t *data, size_t len)
-{
-    uint8_t crc = 0xFF;
-    for (size_t i = 0; i < len; ++i) {
-        crc ^= data[i];
-        for (uint8_t bit = 8; bit > 0; --bit) {
-            if (crc & 0x80) {
-                crc = (crc << 1) ^ 0x31;
-            } else {
-                crc = (crc << 1);
-            }
-        }
-    }
-    return crc;
-}
-
-bool scd41::check_crc(const uint8_t *data, size_t len, uint8_t crc)
-{
-    return crc8(data, len) == crc;
-}
-
 float scd41::convert_co2(uint16_t raw)
 {
     return static_cast<float>(raw);
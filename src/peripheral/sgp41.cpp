@@ -0,0 +1,295 @@
+/**
+ * @file sgp41.cpp
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  SGP41 VOC/NOx sensor implementation
+ * @version 0.1
+ * @date 2026-01-20
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "peripheral/sgp41.h"
+#include "peripheral/sensirion_codec.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace peripherals {
+
+static constexpr uint16_t CMD_EXECUTE_CONDITIONING = 0x2612;
+static constexpr uint16_t CMD_MEASURE_RAW_SIGNALS = 0x2619;
+static constexpr uint16_t CMD_TURN_HEATER_OFF = 0x3615;
+static constexpr uint16_t CMD_GET_SERIAL_NUMBER = 0x3682;
+
+// Conditioning and measure_raw_signals both complete within 50 ms
+static constexpr auto MEASUREMENT_DURATION = std::chrono::milliseconds(50);
+
+// Learned state is only worth keeping once the initial learning phase has passed
+static constexpr uint32_t LEARNING_SAMPLES = 3 * 3600;
+static constexpr uint32_t SAVE_EVERY_SAMPLES = 3600;
+
+sgp41::sgp41(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+             const sgp41_settings &settings)
+    : gas_sensor_iface(conn, address), settings_(settings),
+      voc_(gas_index_type::voc), nox_(gas_index_type::nox)
+{
+}
+
+sgp41::~sgp41()
+{
+    deinitialize();
+}
+
+Status sgp41::initialize()
+{
+    if (initialized_) {
+        return Status::Success;
+    }
+
+    if (!is_connected()) {
+        return Status::ErrorCommunication;
+    }
+
+    voc_.reset();
+    nox_.reset();
+    voc_index_ = 0;
+    nox_index_ = 0;
+    samples_ = 0;
+    sampling_ok_ = true;
+    conditioning_left_ = CONDITIONING_SAMPLES;
+    state_restored_ = load_state();
+
+    initialized_ = true;
+    if (settings_.sampling_thread) {
+        sampler_ = std::jthread([this](std::stop_token stop) { sampler_loop(stop); });
+    }
+    return Status::Success;
+}
+
+void sgp41::deinitialize()
+{
+    if (!initialized_) {
+        return;
+    }
+
+    if (sampler_.joinable()) {
+        sampler_.request_stop();
+        sampler_cv_.notify_all();
+        sampler_.join();
+    }
+
+    save_state();
+    sensirion::send<CMD_TURN_HEATER_OFF>(connection_, device_address_);
+    initialized_ = false;
+}
+
+bool sgp41::is_connected()
+{
+    std::array<uint16_t, 3> serial;
+    return sensirion::read_words<CMD_GET_SERIAL_NUMBER>(connection_, device_address_, serial) == Status::Success;
+}
+
+Status sgp41::reset()
+{
+    deinitialize();
+    return initialize();
+}
+
+Status sgp41::read_data(gas_data &data)
+{
+    if (!initialized_) {
+        return Status::ErrorNotInitialized;
+    }
+
+    // A sensor that stopped answering the sampler must not keep serving stale indices
+    if (!sampling_ok_.load()) {
+        return Status::ErrorCommunication;
+    }
+
+    data.co2_ppm = -1.0f;   // no CO2 channel
+    data.tvoc_ppb = 0.0f;
+    data.temperature_c = -999.0f;
+    data.humidity_rh = -1.0f;
+    data.voc_index = voc_index_.load();
+    data.nox_index = nox_index_.load();
+    // Index 0 means the algorithm is still in its start-up blackout
+    data.valid = data.voc_index > 0;
+    if (!data.valid) {
+        return Status::ErrorInvalidData;
+    }
+
+    last_read_time_ = std::chrono::steady_clock::now();
+    return Status::Success;
+}
+
+Status sgp41::set_measurement_mode(uint8_t mode)
+{
+    // Only the 1 Hz raw-signal mode is supported by the index algorithm
+    return mode == 0 ? Status::Success : Status::ErrorInvalidData;
+}
+
+Status sgp41::read_co2(float &ppm)
+{
+    (void)ppm;
+    return Status::ErrorInvalidData;
+}
+
+Status sgp41::read_tvoc(float &ppb)
+{
+    // The VOC index is relative, not a concentration
+    ppb = 0.0f;
+    return Status::ErrorInvalidData;
+}
+
+void sgp41::set_compensation(float temperature_c, float humidity_rh)
+{
+    humidity_rh = std::clamp(humidity_rh, 0.0f, 100.0f);
+    temperature_c = std::clamp(temperature_c, -45.0f, 130.0f);
+    rh_ticks_ = static_cast<uint16_t>(humidity_rh * 65535.0f / 100.0f + 0.5f);
+    t_ticks_ = static_cast<uint16_t>((temperature_c + 45.0f) * 65535.0f / 175.0f + 0.5f);
+}
+
+Status sgp41::sample()
+{
+    const std::array<uint16_t, 2> compensation = {rh_ticks_.load(), t_ticks_.load()};
+
+    if (conditioning_left_ > 0) {
+        // NOx pixel conditioning: heater on, no NOx signal yet
+        Status status = sensirion::send<CMD_EXECUTE_CONDITIONING, 2>(connection_, device_address_, compensation);
+        if (status != Status::Success) {
+            return status;
+        }
+        std::this_thread::sleep_for(MEASUREMENT_DURATION);
+        std::array<uint16_t, 1> sraw_voc;
+        status = sensirion::receive<1>(connection_, device_address_, sraw_voc);
+        if (status != Status::Success) {
+            return status;
+        }
+        --conditioning_left_;
+        return Status::Success;
+    }
+
+    Status status = sensirion::send<CMD_MEASURE_RAW_SIGNALS, 2>(connection_, device_address_, compensation);
+    if (status != Status::Success) {
+        return status;
+    }
+    std::this_thread::sleep_for(MEASUREMENT_DURATION);
+    std::array<uint16_t, 2> sraw;
+    status = sensirion::receive<2>(connection_, device_address_, sraw);
+    if (status != Status::Success) {
+        return status;
+    }
+
+    voc_index_ = voc_.process(sraw[0]);
+    nox_index_ = nox_.process(sraw[1]);
+    ++samples_;
+    return Status::Success;
+}
+
+void sgp41::sampler_loop(std::stop_token stop)
+{
+    auto next = std::chrono::steady_clock::now();
+    while (!stop.stop_requested()) {
+        const bool ok = sample() == Status::Success;
+        if (!ok && sampling_ok_.load()) {
+            std::cerr << "SGP41: sample failed" << std::endl;
+        }
+        sampling_ok_ = ok;
+
+        if (samples_ > 0 && samples_ % SAVE_EVERY_SAMPLES == 0) {
+            save_state();
+        }
+
+        // Fixed 1 Hz grid: the algorithm's time constants assume it
+        next += SAMPLING_INTERVAL;
+        std::unique_lock<std::mutex> lock(sampler_mutex_);
+        sampler_cv_.wait_until(lock, stop, next, [] { return false; });
+    }
+}
+
+bool sgp41::save_state() const
+{
+    if (settings_.state_path.empty() || (!state_restored_ && samples_ < LEARNING_SAMPLES)) {
+        return true;
+    }
+
+    const auto voc = voc_.get_state();
+    const auto nox = nox_.get_state();
+    const long long now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::ostringstream text;
+    text << "sgp41-state 1 " << now << ' ' << voc.mean << ' ' << voc.std << ' '
+         << nox.mean << ' ' << nox.std << '\n';
+    const std::string line = text.str();
+
+    // Write aside, fsync, rename, fsync the directory: after a power cut the
+    // file is either the previous state or the new one, never torn or empty
+    const std::string tmp = settings_.state_path + ".tmp";
+    const auto failed = [&](const char *what) {
+        std::cerr << "sgp41: cannot " << what << " " << tmp << ": " << std::strerror(errno) << std::endl;
+        return false;
+    };
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return failed("open");
+    }
+    const bool written = ::write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size()) && ::fsync(fd) == 0;
+    const int saved_errno = errno;
+    ::close(fd);
+    errno = saved_errno;
+    if (!written) {
+        return failed("write");
+    }
+    if (std::rename(tmp.c_str(), settings_.state_path.c_str()) != 0) {
+        return failed("rename");
+    }
+
+    const auto slash = settings_.state_path.rfind('/');
+    const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : settings_.state_path.substr(0, slash);
+    const int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0 || ::fsync(dir_fd) != 0) {
+        if (dir_fd >= 0) {
+            ::close(dir_fd);
+        }
+        return failed("sync the directory of");
+    }
+    ::close(dir_fd);
+    return true;
+}
+
+bool sgp41::load_state()
+{
+    if (settings_.state_path.empty()) {
+        return false;
+    }
+
+    std::ifstream f(settings_.state_path);
+    std::string tag;
+    int version = 0;
+    long long saved_at = 0;
+    gas_index_state voc, nox;
+    if (!(f >> tag >> version >> saved_at >> voc.mean >> voc.std >> nox.mean >> nox.std) ||
+        tag != "sgp41-state" || version != 1) {
+        return false;
+    }
+
+    const long long now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (now < saved_at || now - saved_at > settings_.state_max_age.count()) {
+        return false;
+    }
+
+    voc_.set_state(voc);
+    nox_.set_state(nox);
+    return true;
+}
+
+} // namespace peripherals
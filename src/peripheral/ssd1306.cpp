@@ -16,6 +16,7 @@
 #include <thread>
 #include <chrono>
 #include <cmath>
+#include <algorithm>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
@@ -122,8 +123,9 @@ static const uint8_t font5x7[95][5] = {
 
 namespace peripherals {
 
-ssd1306::ssd1306(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address)
-    : display_iface(conn, address), cursor_x_(0), cursor_y_(0), fb_fd_(-1), fb_ptr_(nullptr), fb_size_(0), fb_width_(0), fb_height_(0), fb_bpp_(0)
+ssd1306::ssd1306(connections::addressable_connection_iface<uint8_t> *conn, uint8_t address,
+                 connections::gpio_line *dc_line)
+    : display_iface(conn, address), dc_line_(dc_line), cursor_x_(0), cursor_y_(0), fb_fd_(-1), fb_ptr_(nullptr), fb_size_(0), fb_width_(0), fb_height_(0), fb_bpp_(0)
 {
 }
 
@@ -175,7 +177,7 @@ Status ssd1306::initialize()
         initialized_ = true;
         return Status::Success;
     } else {
-        // I2C mode
+        // I2C / SPI mode
         // Wait for display to power up
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
@@ -238,31 +240,10 @@ Status ssd1306::clear()
         memset(fb_ptr_, 0, fb_size_);
         return Status::Success;
     } else {
-        // Set addressing mode to cover entire display
-        Status status = send_command(0x21); // Set column address
-        if (status != Status::Success) return status;
-        status = send_command(0x00); // Start column 0
-        if (status != Status::Success) return status;
-        status = send_command(0x7F); // End column 127
-        if (status != Status::Success) return status;
-        
-        status = send_command(0x22); // Set page address
-        if (status != Status::Success) return status;
-        status = send_command(0x00); // Start page 0
-        if (status != Status::Success) return status;
-        status = send_command(0x07); // End page 7
-        if (status != Status::Success) return status;
-
-        // Clear all 1024 bytes (128x64/8)
-        uint8_t zero_data[128];
-        std::memset(zero_data, 0x00, 128);
-        
-        for (int page = 0; page < 8; ++page) {
-            status = send_data(zero_data, 128);
-            if (status != Status::Success) return status;
-        }
-        
-        return Status::Success;
+        // Clear all 1024 bytes (128x64/8) in one transfer
+        gddram_.fill(0x00);
+        mark_dirty(0, PAGES - 1, 0, WIDTH - 1);
+        return flush();
     }
 }
 
@@ -273,6 +254,18 @@ Status ssd1306::display_text(const std::string &text, uint8_t x, uint8_t y, uint
     
     if (connection_ == nullptr) {
         if (fb_fd_ == -1) return Status::Success;
+
+        // Text replaces the full-width rows it occupies
+        int lines = 1;
+        for (char c : text) {
+            if (c == '\n') ++lines;
+        }
+        for (int row = y; row < y + lines * 8 * scale && row < HEIGHT; ++row) {
+            for (int col = 0; col < WIDTH; ++col) {
+                draw_pixel(col, row, 0);
+            }
+        }
+
         uint8_t current_x = x;
         uint8_t current_y = y;
         for (char c : text) {
@@ -303,36 +296,33 @@ Status ssd1306::display_text(const std::string &text, uint8_t x, uint8_t y, uint
         }
         return Status::Success;
     } else {
-        // I2C mode - render text using font and send data, centered
+        // I2C / SPI mode - render each line centered into full-width page rows
         std::istringstream iss(text);
         std::string line;
-        uint8_t current_y = y;
-        while (std::getline(iss, line)) {
-            // Calculate centered x
-            size_t len = line.length();
-            uint8_t centered_x = (128 - len * 6) / 2;
-            set_cursor(centered_x, current_y);
-
+        int page = y / 8;
+        int first_page = page;
+        while (std::getline(iss, line) && page < PAGES) {
+            uint8_t *row = gddram_.data() + page * WIDTH;
+            std::memset(row, 0x00, WIDTH);
+
+            // 5 glyph columns + 1 space column per char
+            int len = static_cast<int>(line.length());
+            int col = std::max(0, (WIDTH - len * 6) / 2);
             for (char c : line) {
-                if (c >= 32 && c <= 126) {
-                    const uint8_t* char_data = font5x7[c - 32];
-                    // Send 5 bytes for the character
-                    Status status = send_data(char_data, 5);
-                    if (status != Status::Success) {
-                        return status;
-                    }
-                    // Send a space column
-                    uint8_t space = 0x00;
-                    status = send_data(&space, 1);
-                    if (status != Status::Success) {
-                        return status;
-                    }
+                if (c < 32 || c > 126) continue;
+                const uint8_t* char_data = font5x7[c - 32];
+                for (int i = 0; i < 5 && col < WIDTH; ++i) {
+                    row[col++] = char_data[i];
                 }
+                if (col < WIDTH) row[col++] = 0x00;
             }
-            current_y += 8;
+            ++page;
         }
 
-        return Status::Success;
+        if (page > first_page) {
+            mark_dirty(first_page, page - 1, 0, WIDTH - 1);
+        }
+        return flush();
     }
 }
 
@@ -346,35 +336,52 @@ Status ssd1306::set_cursor(uint8_t x, uint8_t y)
         cursor_x_ = x;
         cursor_y_ = y;
 
-        // Set column address
-        Status status = send_command(0x21); // Set column address
-        if (status != Status::Success) return status;
-        status = send_command(x); // Start column
-        if (status != Status::Success) return status;
-        status = send_command(127); // End column
-        if (status != Status::Success) return status;
-
-        // Set page address
-        status = send_command(0x22); // Set page address
-        if (status != Status::Success) return status;
-        status = send_command(y / 8); // Start page
-        if (status != Status::Success) return status;
-        status = send_command(7); // End page
-        if (status != Status::Success) return status;
-
-        return Status::Success;
+        const uint8_t window[] = {
+            0x21, x, 127,                          // Set column address
+            0x22, static_cast<uint8_t>(y / 8), 7   // Set page address
+        };
+        return send_commands(window);
     }
 }
 
 Status ssd1306::send_command(uint8_t cmd)
 {
-    uint8_t buffer[2] = {0x00, cmd}; // 0x00 for command
-    auto status = connection_->write(device_address_, std::span(buffer, 2));
+    return send_commands(std::span(&cmd, 1));
+}
+
+Status ssd1306::send_commands(std::span<const uint8_t> cmds)
+{
+    if (dc_line_ != nullptr) {
+        // SPI: D/C low selects the command register, no control byte
+        if (dc_line_->set_value(false) != connections::Status::Success) {
+            return Status::ErrorCommunication;
+        }
+        auto status = connection_->write(device_address_, cmds);
+        return status == connections::Status::Success ? Status::Success : Status::ErrorCommunication;
+    }
+
+    // I2C: one control byte (Co = 0, D/C# = 0) followed by a command stream
+    uint8_t buffer[1 + 32];
+    if (cmds.size() > sizeof(buffer) - 1) {
+        return Status::ErrorInvalidData;
+    }
+    buffer[0] = 0x00;
+    std::memcpy(buffer + 1, cmds.data(), cmds.size());
+    auto status = connection_->write(device_address_, std::span(buffer, cmds.size() + 1));
     return status == connections::Status::Success ? Status::Success : Status::ErrorCommunication;
 }
 
 Status ssd1306::send_data(const uint8_t *data, size_t len)
 {
+    if (dc_line_ != nullptr) {
+        // SPI: D/C high selects GDDRAM, payload goes out without copying
+        if (dc_line_->set_value(true) != connections::Status::Success) {
+            return Status::ErrorCommunication;
+        }
+        auto status = connection_->write(device_address_, std::span(data, len));
+        return status == connections::Status::Success ? Status::Success : Status::ErrorCommunication;
+    }
+
     std::vector<uint8_t> buffer;
     buffer.reserve(len + 1);
     buffer.push_back(0x40); // 0x40 for data
@@ -415,20 +422,29 @@ Status ssd1306::init_display()
         0xAF  // Display ON
     };
 
-    for (uint8_t cmd : init_commands) {
-        Status status = send_command(cmd);
-        if (status != Status::Success) {
-            return status;
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-
-    return Status::Success;
+    return send_commands(init_commands);
 }
 
 void ssd1306::draw_pixel(int x, int y, int color)
 {
-    if (fb_ptr_ == nullptr || x < 0 || x >= 128 || y < 0 || y >= 64) {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+        return;
+    }
+
+    if (connection_ != nullptr) {
+        // Panel: update the GDDRAM shadow, flush() pushes it out
+        int page = y / 8;
+        uint8_t &cell = gddram_[page * WIDTH + x];
+        uint8_t bit = static_cast<uint8_t>(1u << (y & 7));
+        uint8_t updated = color ? (cell | bit) : (cell & ~bit);
+        if (updated != cell) {
+            cell = updated;
+            mark_dirty(page, page, x, x);
+        }
+        return;
+    }
+
+    if (fb_ptr_ == nullptr) {
         return;
     }
 
@@ -481,4 +497,56 @@ void ssd1306::draw_line(int x0, int y0, int x1, int y1, int color)
     }
 }
 
+void ssd1306::mark_dirty(int page_lo, int page_hi, int col_lo, int col_hi)
+{
+    if (!dirty_) {
+        dirty_page_lo_ = page_lo;
+        dirty_page_hi_ = page_hi;
+        dirty_col_lo_ = col_lo;
+        dirty_col_hi_ = col_hi;
+        dirty_ = true;
+        return;
+    }
+    dirty_page_lo_ = std::min(dirty_page_lo_, page_lo);
+    dirty_page_hi_ = std::max(dirty_page_hi_, page_hi);
+    dirty_col_lo_ = std::min(dirty_col_lo_, col_lo);
+    dirty_col_hi_ = std::max(dirty_col_hi_, col_hi);
+}
+
+Status ssd1306::flush()
+{
+    if (connection_ == nullptr || !dirty_) {
+        return Status::Success;
+    }
+
+    // One address window + one data burst for the dirty rectangle
+    const uint8_t window[] = {
+        0x21, static_cast<uint8_t>(dirty_col_lo_), static_cast<uint8_t>(dirty_col_hi_),
+        0x22, static_cast<uint8_t>(dirty_page_lo_), static_cast<uint8_t>(dirty_page_hi_)
+    };
+    Status status = send_commands(window);
+    if (status != Status::Success) return status;
+
+    const int cols = dirty_col_hi_ - dirty_col_lo_ + 1;
+    const uint8_t *payload = gddram_.data() + dirty_page_lo_ * WIDTH + dirty_col_lo_;
+    size_t len = static_cast<size_t>(cols) * (dirty_page_hi_ - dirty_page_lo_ + 1);
+
+    uint8_t packed[WIDTH * PAGES];
+    if (cols != WIDTH) {
+        // Horizontal addressing wraps inside the column window: pack the page slices
+        uint8_t *out = packed;
+        for (int page = dirty_page_lo_; page <= dirty_page_hi_; ++page) {
+            std::memcpy(out, gddram_.data() + page * WIDTH + dirty_col_lo_, cols);
+            out += cols;
+        }
+        payload = packed;
+    }
+
+    status = send_data(payload, len);
+    if (status == Status::Success) {
+        dirty_ = false;
+    }
+    return status;
+}
+
 } // namespace peripherals
\ No newline at end of file
@@ -15,6 +15,8 @@
 #include "peripheral/peripheral_factory.h"
 #include "connections/mock_connection.h"
 #include "connections/i2c_connection.h"
+#include "connections/spi_connection.h"
+#include "peripheral/peripheral_options.h"
 
 #include <iostream>
 #include <vector>
@@ -43,6 +45,14 @@ namespace st
             auto dev = spec.device.empty() ? std::string("/dev/i2c-2") : spec.device;
             return std::make_unique<connections::i2c_connection>(dev);
         }
+        if (spec.connection == "spi")
+        {
+            auto dev = spec.device.empty() ? std::string("/dev/spidev0.0") : spec.device;
+            connections::spi_config spi_cfg;
+            spi_cfg.speed_hz = static_cast<uint32_t>(peripherals::option_int(spec.options, "speed_hz", spi_cfg.speed_hz));
+            spi_cfg.mode = static_cast<uint8_t>(peripherals::option_int(spec.options, "spi_mode", spi_cfg.mode));
+            return std::make_unique<connections::spi_connection>(dev, spi_cfg);
+        }
 
         return nullptr;
     }
@@ -92,7 +102,7 @@ namespace st
             peripherals::PeripheralType t = peripheral_factory::string_to_type(p.type);
             std::unique_ptr<peripherals::environmental_sensor_iface> sensor;
             try {
-                sensor = peripheral_factory::create_environmental_sensor(t, conn.get(), p.address);
+                sensor = peripheral_factory::create_environmental_sensor(t, conn.get(), p.address, p.options);
             } catch (...) {
                 sensor = nullptr;
             }
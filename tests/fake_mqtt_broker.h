@@ -0,0 +1,229 @@
+/**
+ * @file fake_mqtt_broker.h
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Minimal in-process MQTT 3.1.1 broker for sink tests
+ * @version 0.1
+ * @date 2026-02-02
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "app/mqtt_sink.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One client at a time on 127.0.0.1. Records every PUBLISH and
+// answers CONNECT, PINGREQ and (unless held back) QoS 1 PUBLISH.
+class fake_mqtt_broker
+{
+public:
+    struct publish
+    {
+        std::string topic;
+        std::string payload;
+        int qos = 0;
+        uint16_t packet_id = 0;
+        bool dup = false;
+    };
+
+    // Port 0 picks a free one
+    explicit fake_mqtt_broker(uint16_t port = 0)
+    {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const int one = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), len) == 0 && listen(listen_fd_, 4) == 0 &&
+            getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len) == 0)
+            port_ = ntohs(addr.sin_port);
+        worker_ = std::jthread([this](std::stop_token stop) { run(stop); });
+    }
+
+    ~fake_mqtt_broker()
+    {
+        worker_.request_stop();
+        worker_.join();
+        if (client_fd_ >= 0)
+            close(client_fd_);
+        close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+
+    // While held, PUBACKs are owed; releasing sends them all
+    void hold_acks(bool hold)
+    {
+        std::lock_guard lock(mutex_);
+        hold_ = hold;
+    }
+
+    // Drops the current connection; acks still owed on it are lost
+    void kick()
+    {
+        std::lock_guard lock(mutex_);
+        kick_ = true;
+    }
+
+    std::vector<publish> received()
+    {
+        std::lock_guard lock(mutex_);
+        return received_;
+    }
+
+    size_t connects()
+    {
+        std::lock_guard lock(mutex_);
+        return connects_;
+    }
+
+    size_t disconnects()
+    {
+        std::lock_guard lock(mutex_);
+        return disconnects_;
+    }
+
+    template <typename Pred>
+    bool wait_for(Pred pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(3000))
+    {
+        std::unique_lock lock(mutex_);
+        return changed_.wait_for(lock, timeout, [&] { return pred(*this); });
+    }
+
+    // For wait_for predicates, which run under the lock
+    size_t received_count() const { return received_.size(); }
+    size_t connect_count() const { return connects_; }
+
+private:
+    void run(std::stop_token stop)
+    {
+        while (!stop.stop_requested())
+        {
+            pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {client_fd_, POLLIN, 0}};
+            poll(fds, client_fd_ >= 0 ? 2 : 1, 10);
+
+            std::lock_guard lock(mutex_);
+            if (kick_)
+            {
+                kick_ = false;
+                drop_client();
+            }
+            if (fds[0].revents & POLLIN)
+            {
+                drop_client();
+                client_fd_ = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            }
+            else if (client_fd_ >= 0 && fds[1].revents)
+            {
+                char buf[4096];
+                const ssize_t n = recv(client_fd_, buf, sizeof(buf), 0);
+                if (n <= 0)
+                    drop_client();
+                else
+                    in_.append(buf, static_cast<size_t>(n));
+                uint8_t header;
+                std::string body;
+                while (client_fd_ >= 0 && app::mqtt_take_packet(in_, header, body) == app::mqtt_parse::complete)
+                    handle(header, body);
+            }
+            if (!hold_ && client_fd_ >= 0)
+            {
+                for (uint16_t id : owed_)
+                    reply(app::mqtt_puback(id));
+                owed_.clear();
+            }
+            changed_.notify_all();
+        }
+    }
+
+    void handle(uint8_t header, const std::string &body)
+    {
+        switch (static_cast<app::mqtt_packet>(header >> 4))
+        {
+        case app::mqtt_packet::connect:
+            // "MQTT", level 4
+            if (body.compare(0, 7, std::string("\0\4MQTT\4", 7)) != 0)
+            {
+                drop_client();
+                return;
+            }
+            ++connects_;
+            reply(std::string("\x20\x02\x00\x00", 4));
+            break;
+        case app::mqtt_packet::publish:
+        {
+            publish p;
+            p.qos = (header >> 1) & 3;
+            p.dup = header & 0x08;
+            const size_t topic_len = static_cast<uint8_t>(body[0]) << 8 | static_cast<uint8_t>(body[1]);
+            p.topic = body.substr(2, topic_len);
+            size_t pos = 2 + topic_len;
+            if (p.qos)
+            {
+                p.packet_id = static_cast<uint16_t>(static_cast<uint8_t>(body[pos]) << 8 | static_cast<uint8_t>(body[pos + 1]));
+                pos += 2;
+                owed_.push_back(p.packet_id);
+            }
+            p.payload = body.substr(pos);
+            received_.push_back(std::move(p));
+            break;
+        }
+        case app::mqtt_packet::pingreq:
+            reply(std::string("\xd0\x00", 2));
+            break;
+        case app::mqtt_packet::disconnect:
+            ++disconnects_;
+            drop_client();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void reply(const std::string &packet)
+    {
+        if (client_fd_ >= 0)
+            send(client_fd_, packet.data(), packet.size(), MSG_NOSIGNAL);
+    }
+
+    void drop_client()
+    {
+        if (client_fd_ >= 0)
+            close(client_fd_);
+        client_fd_ = -1;
+        in_.clear();
+        owed_.clear();
+    }
+
+    int listen_fd_ = -1;
+    int client_fd_ = -1;
+    uint16_t port_ = 0;
+    std::string in_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool hold_ = false;
+    bool kick_ = false;
+    std::vector<uint16_t> owed_;
+    std::vector<publish> received_;
+    size_t connects_ = 0;
+    size_t disconnects_ = 0;
+
+    std::jthread worker_;
+};
@@ -0,0 +1,26 @@
+/**
+ * @file shm_reader.c
+ * @author FernandesKA (fernandes.kir@yandex.ru)
+ * @brief  Compiled as C: keeps atmolyt_shm.h usable by plain C readers
+ * @version 0.1
+ * @date 2026-01-31
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "atmolyt_shm.h"
+
+int shm_c_read_co2(const char *name, double *ppm, int64_t *wall_ns)
+{
+    const struct atmolyt_shm_segment *seg = atmolyt_shm_map(name);
+    struct atmolyt_shm_sample sample;
+    int ok = seg && atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &sample);
+    if (ok)
+    {
+        *ppm = sample.value;
+        *wall_ns = sample.wall_ns;
+    }
+    atmolyt_shm_unmap(seg);
+    return ok;
+}
@@ -12,9 +12,11 @@
 #pragma once
 
 #include "connections/connection_iface.h"
+#include <atomic>
 #include <span>
 #include <cstdint>
 #include <map>
+#include <vector>
 
 namespace connections {
 
@@ -36,22 +38,29 @@ public:
 
     Status read(uint8_t device_addr, std::span<uint8_t> buffer) override {
         (void)device_addr;
+        // Reply to the last command word when one is canned
+        if (!commands.empty()) {
+            auto it = responses.find(commands.back());
+            if (it != responses.end()) {
+                for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = i < it->second.size() ? it->second[i] : 0;
+                return Status::Success;
+            }
+        }
         for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = 0xBB;
         return Status::Success;
     }
     Status write(uint8_t device_addr, std::span<const uint8_t> data) override {
-        (void)device_addr; (void)data;
+        (void)device_addr;
+        if (data.size() >= 2) commands.push_back(static_cast<uint16_t>((data[0] << 8) | data[1]));
         return Status::Success;
     }
 
     Status read_register(uint8_t device_addr, uint8_t reg_addr, std::span<uint8_t> buffer) override {
         (void)device_addr;
-        // return mock calibration data for BME280 tests
-        std::map<uint8_t, uint8_t> regs = {
-            {0x88, 0x6A}, {0x89, 0x67}, // dig_T1
-            {0xE1, 0x5C}, {0xE2, 0x00}, // dig_H2
-            {0xD0, 0x60}, // chip ID (BME280)
-        };
+        if (unplugged) return Status::ErrorNack;
+        ++read_register_calls;
+        last_read_reg = reg_addr;
+        last_read_len = buffer.size();
 
         for (size_t i = 0; i < buffer.size(); ++i) {
             auto it = regs.find(reg_addr + i);
@@ -61,18 +70,49 @@ public:
     }
 
     Status write_register(uint8_t device_addr, uint8_t reg_addr, std::span<const uint8_t> data) override {
-        (void)device_addr; (void)reg_addr; (void)data;
+        (void)device_addr;
+        if (unplugged) return Status::ErrorNack;
+        ++write_register_calls;
+        for (size_t i = 0; i < data.size(); ++i) regs[static_cast<uint8_t>(reg_addr + i)] = data[i];
         return Status::Success;
     }
 
     Status write_read(uint8_t device_addr, std::span<const uint8_t> write_data, std::span<uint8_t> read_buffer) override {
-        (void)device_addr; (void)write_data;
+        (void)device_addr;
+        if (write_data.size() >= 2) {
+            uint16_t cmd = static_cast<uint16_t>((write_data[0] << 8) | write_data[1]);
+            commands.push_back(cmd);
+            auto it = responses.find(cmd);
+            if (it != responses.end()) {
+                for (size_t i = 0; i < read_buffer.size(); ++i) read_buffer[i] = i < it->second.size() ? it->second[i] : 0;
+                return Status::Success;
+            }
+        }
         for (size_t i = 0; i < read_buffer.size(); ++i) read_buffer[i] = static_cast<uint8_t>(i & 0xFF);
         return Status::Success;
     }
 
     Status reset() override { return Status::Success; }
     void flush() override {}
+
+    // Register file served by read_register and updated by write_register; mock calibration data for BME280 tests
+    std::map<uint8_t, uint8_t> regs = {
+        {0x88, 0x6A}, {0x89, 0x67}, // dig_T1
+        {0xE1, 0x5C}, {0xE2, 0x00}, // dig_H2
+        {0xD0, 0x60}, // chip ID (BME280)
+    };
+
+    // Sensirion-style command words sent through write()/write_read(), and canned replies per command
+    std::vector<uint16_t> commands;
+    std::map<uint16_t, std::vector<uint8_t>> responses;
+
+    // Register accesses NACK while set, as with the device disconnected
+    std::atomic<bool> unplugged{false};
+
+    size_t read_register_calls = 0;
+    size_t write_register_calls = 0;
+    uint8_t last_read_reg = 0;
+    size_t last_read_len = 0;
 };
 
 } // namespace connections
@@ -10,11 +10,57 @@
  */
 
 #include <iostream>
+#include <fstream>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <csignal>
+#include <filesystem>
+#include <map>
+#include <sstream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 #include "test_connection_mock.h"
+#include "fake_mqtt_broker.h"
 #include "peripheral/bme280.h"
+#include "peripheral/scd41.h"
+#include "peripheral/sgp41.h"
+#include "peripheral/ds3231.h"
+#include "peripheral/gas_index_algorithm.h"
+#include "peripheral/sensirion_codec.h"
 #include "peripheral/peripheral_factory.h"
+#include "peripheral/peripheral_options.h"
+#include "peripheral/sensor_concepts.h"
+#include "peripheral/mock_environmental.h"
+#include "peripheral/replay_sensors.h"
+#include "config/config_loader.h"
+#include "config/json_parser.h"
+#include "app/sparkline.h"
+#include "app/raw_capture.h"
+#include "app/seqlock.h"
+#include "app/wall_clock.h"
+#include "app/sample_bus.h"
+#include "app/csv_logger.h"
+#include "app/tsdb.h"
+#include "app/peripheral_health.h"
+#include "app/peripheral_set.h"
+#include "app/metrics_server.h"
+#include "app/shm_publisher.h"
+#include "app/stream_server.h"
+#include "app/mqtt_sink.h"
+#include "app/disk_spool.h"
+#include "app/log_query.h"
+#include "app/log_index.h"
+#include "app/signal_handler.h"
+#include "peripheral/bme280_compensation.h"
+#include <array>
 
 using namespace peripherals;
 using namespace connections;
@@ -30,6 +76,2056 @@ void test_bme280_initialization()
     std::cout << "✓ test_bme280_initialization passed" << std::endl;
 }
 
+// BMP280 datasheet example: T = 25.08 degC, P = 100653.25 Pa
+static void load_bosch_example(test_connection_mock &conn, uint8_t chip_id)
+{
+    const int16_t words[12] = {27504, 26435, -1000, -29059 /* 36477 */, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+    for (int i = 0; i < 12; ++i) {
+        conn.regs[0x88 + 2 * i] = static_cast<uint8_t>(words[i] & 0xFF);
+        conn.regs[0x88 + 2 * i + 1] = static_cast<uint8_t>((uint16_t(words[i]) >> 8) & 0xFF);
+    }
+    conn.regs[0xD0] = chip_id;
+    // raw_p = 415148, raw_t = 519888
+    conn.regs[0xF7] = 0x65; conn.regs[0xF8] = 0x5A; conn.regs[0xF9] = 0xC0;
+    conn.regs[0xFA] = 0x7E; conn.regs[0xFB] = 0xED; conn.regs[0xFC] = 0x00;
+}
+
+void test_bme280_single_burst_read()
+{
+    test_connection_mock conn;
+    conn.initialize();
+    load_bosch_example(conn, 0x60);
+
+    bme280 sensor(&conn, 0x76);
+    assert(sensor.initialize() == peripherals::Status::Success);
+
+    conn.read_register_calls = 0;
+    combined_env_data data{};
+    assert(sensor.read_data(data) == peripherals::Status::Success);
+    assert(conn.read_register_calls == 1);
+    assert(conn.last_read_reg == 0xF7 && conn.last_read_len == 8);
+    assert(data.temperature.valid && data.pressure.valid && data.humidity.valid);
+    assert(std::fabs(data.temperature.celsius - 25.08f) < 0.01f);
+    assert(std::fabs(data.pressure.pascals - 100653.25f) < 0.5f);
+
+    // BMP280: 6-byte burst, no humidity channel
+    test_connection_mock conn_bmp;
+    conn_bmp.initialize();
+    load_bosch_example(conn_bmp, 0x58);
+    bme280 bmp(&conn_bmp, 0x76);
+    assert(bmp.initialize() == peripherals::Status::Success);
+    conn_bmp.read_register_calls = 0;
+    assert(bmp.read_data(data) == peripherals::Status::Success);
+    assert(conn_bmp.read_register_calls == 1 && conn_bmp.last_read_len == 6);
+    assert(!data.humidity.valid);
+    assert(std::fabs(data.pressure.pascals - 100653.25f) < 0.5f);
+
+    std::cout << "✓ test_bme280_single_burst_read passed" << std::endl;
+}
+
+void test_bme280_forced_mode_settings()
+{
+    test_connection_mock conn;
+    conn.initialize();
+    load_bosch_example(conn, 0x60);
+
+    bme280_settings settings;
+    settings.oversampling_t = 2;
+    settings.oversampling_p = 16;
+    settings.oversampling_h = 1;
+    settings.iir_filter = 4;
+    settings.standby_ms = 125.0f;
+    settings.forced = true;
+    bme280 sensor(&conn, 0x76, settings);
+    assert(sensor.initialize() == peripherals::Status::Success);
+
+    assert(conn.regs[0xF2] == 0x01);                     // osrs_h x1
+    assert(conn.regs[0xF5] == ((2 << 5) | (2 << 2)));    // t_sb 125 ms, filter 4
+    assert(conn.regs[0xF4] == ((2 << 5) | (5 << 2)));    // sleep until triggered
+    // 1.25 + 2.3*2 + (2.3*16 + 0.575) + (2.3*1 + 0.575) ms
+    assert(sensor.max_measurement_time() == std::chrono::microseconds(46100));
+    assert(!sensor.data_ready_at());
+
+    assert(sensor.start_measurement() == peripherals::Status::Success);
+    assert(conn.regs[0xF4] == ((2 << 5) | (5 << 2) | 0x01));
+    auto ready = sensor.data_ready_at();
+    assert(ready && *ready > std::chrono::steady_clock::now());
+
+    combined_env_data data{};
+    assert(sensor.read_data(data) == peripherals::Status::Success);
+    assert(std::chrono::steady_clock::now() >= *ready);
+    assert(std::fabs(data.temperature.celsius - 25.08f) < 0.01f);
+    assert(!sensor.data_ready_at());
+
+    bme280 defaults(&conn, 0x76);
+    assert(defaults.max_measurement_time() == std::chrono::microseconds(9300));
+
+    // Only the chip's factors are accepted; one that slips through is timed as programmed (x1)
+    for (uint8_t factor : {0, 1, 2, 4, 8, 16})
+        assert(bme280_oversampling_valid(factor));
+    assert(!bme280_oversampling_valid(3) && !bme280_oversampling_valid(32));
+    bme280_settings odd;
+    odd.oversampling_t = 3;
+    odd.oversampling_p = 32;
+    bme280 coerced(&conn, 0x76, odd);
+    assert(coerced.initialize() == peripherals::Status::Success);
+    assert(conn.regs[0xF4] == ((1 << 5) | (1 << 2) | 0x03));
+    assert(coerced.max_measurement_time() == defaults.max_measurement_time());
+
+    std::cout << "✓ test_bme280_forced_mode_settings passed" << std::endl;
+}
+
+void test_bme280_standby_per_chip()
+{
+    const auto configure = [](uint8_t chip_id, float standby_ms, test_connection_mock &conn) {
+        conn.initialize();
+        load_bosch_example(conn, chip_id);
+        bme280_settings settings;
+        settings.standby_ms = standby_ms;
+        auto sensor = std::make_unique<bme280>(&conn, 0x76, settings);
+        assert(sensor->initialize() == peripherals::Status::Success);
+        return sensor;
+    };
+
+    // BME280: codes 6 and 7 are 10 and 20 ms, 2000 ms is out of reach
+    test_connection_mock bme;
+    auto sensor = configure(0x60, 10.0f, bme);
+    assert((bme.regs[0xF5] >> 5) == 6);
+    assert(sensor->standby_time() == std::chrono::milliseconds(10));
+    sensor = configure(0x60, 20.0f, bme);
+    assert((bme.regs[0xF5] >> 5) == 7);
+    sensor = configure(0x60, 2000.0f, bme);
+    assert((bme.regs[0xF5] >> 5) == 5);
+    assert(sensor->standby_time() == std::chrono::milliseconds(1000));
+
+    // BMP280: the same codes are 2000 and 4000 ms, 10 ms rounds to 0.5 ms
+    test_connection_mock bmp;
+    sensor = configure(0x58, 2000.0f, bmp);
+    assert((bmp.regs[0xF5] >> 5) == 6);
+    assert(sensor->standby_time() == std::chrono::milliseconds(2000));
+    sensor = configure(0x58, 4000.0f, bmp);
+    assert((bmp.regs[0xF5] >> 5) == 7);
+    combined_env_data data{};
+    assert(sensor->read_data(data) == peripherals::Status::Success);
+    const auto ready = sensor->data_ready_at();
+    assert(ready && *ready - std::chrono::steady_clock::now() > std::chrono::milliseconds(3900));
+    sensor = configure(0x58, 10.0f, bmp);
+    assert((bmp.regs[0xF5] >> 5) == 0);
+    assert(sensor->standby_time() == std::chrono::microseconds(500));
+
+    std::cout << "✓ test_bme280_standby_per_chip passed" << std::endl;
+}
+
+void test_bme280_batch_compensation()
+{
+    test_connection_mock conn;
+    conn.initialize();
+    load_bosch_example(conn, 0x60);
+    // typical humidity trimming: H1 75, H2 362, H3 0, H4 313, H5 50, H6 30
+    conn.regs[0xA1] = 75;
+    conn.regs[0xE1] = 0x6A; conn.regs[0xE2] = 0x01; conn.regs[0xE3] = 0;
+    conn.regs[0xE4] = 0x13; conn.regs[0xE5] = 0x29; conn.regs[0xE6] = 0x03; conn.regs[0xE7] = 30;
+
+    bme280 sensor(&conn, 0x76);
+    assert(sensor.initialize() == peripherals::Status::Success);
+    const bme280_calibration calib = sensor.get_calibration();
+    assert(calib.dig_H4 == 313 && calib.dig_H5 == 50);
+
+    // Reference rows from Bosch's double-precision formulas (datasheet appendix);
+    // the first is the datasheet example, T = 25.08 degC, P = 100653.27 Pa
+    struct reference { int32_t raw_t, raw_p, raw_h; double celsius, pascals, rh; };
+    static constexpr reference refs[] = {
+        {519888, 415148, 31000, 25.082, 100653.27, 60.558},
+        {480000, 380000, 25000, 12.567, 104681.96, 27.389},
+        {560000, 440000, 36000, 37.632, 98215.90, 89.539},
+        {500000, 300000, 28000, 18.847, 119434.64, 43.788},
+    };
+    constexpr size_t REFS = sizeof(refs) / sizeof(refs[0]);
+
+    // Spread over several blocks, not a multiple of the block size
+    const size_t n = 5001;
+    std::vector<int32_t> raw_t(n), raw_p(n), raw_h(n);
+    for (size_t i = 0; i < n; ++i) {
+        raw_t[i] = refs[i % REFS].raw_t;
+        raw_p[i] = refs[i % REFS].raw_p;
+        raw_h[i] = refs[i % REFS].raw_h;
+    }
+
+    std::vector<int32_t> t_out(n);
+    std::vector<uint32_t> p_out(n), h_out(n);
+    assert(bme280_compensate_batch(calib, raw_t, raw_p, raw_h, t_out, p_out, h_out));
+    for (size_t i = 0; i < n; ++i) {
+        const reference &r = refs[i % REFS];
+        assert(std::fabs(t_out[i] / 100.0 - r.celsius) <= 0.01);
+        assert(std::fabs(p_out[i] / 256.0 - r.pascals) <= 0.1); // fixed-point vs double: < 0.1 Pa
+        assert(std::fabs(h_out[i] / 1024.0 - r.rh) <= 0.01);
+    }
+    assert(t_out[0] == 2508);
+
+    // Mismatched lengths are refused without writing
+    std::vector<int32_t> short_t(n - 1, -1);
+    assert(!bme280_compensate_batch(calib, raw_t, raw_p, raw_h, short_t, p_out, h_out));
+    assert(!bme280_compensate_batch(calib, std::span<const int32_t>(raw_t).first(10), raw_p, raw_h, t_out, p_out, h_out));
+    assert(short_t[0] == -1);
+    assert(bme280_compensate_batch(calib, raw_t, raw_p, {}, t_out, p_out, {}));
+
+    // Driver path over the same words: capture, reload, recompute
+    const char *path = "test_raw_capture.bin";
+    std::remove(path);
+    {
+        app::raw_capture_writer writer(path, calib, sensor.has_humidity());
+        assert(writer.is_open());
+        combined_env_data data{};
+        assert(sensor.read_data(data) == peripherals::Status::Success);
+        assert(sensor.last_raw().valid && sensor.last_raw().raw_t == 519888);
+        assert(writer.append(1000, sensor.last_raw()));
+    }
+    {
+        // same sensor: appended after the existing header
+        app::raw_capture_writer writer(path, calib, true);
+        assert(writer.append(2000, {raw_t[1], raw_p[1], raw_h[1], true}));
+    }
+
+    app::raw_capture cap;
+    bool loaded = app::load_raw_capture(path, cap);
+    std::remove(path);
+    std::remove((std::string(path) + ".old").c_str());
+    assert(loaded && cap.size() == 2);
+    assert(cap.calib == calib && cap.has_humidity);
+    assert(cap.timestamp_ms[0] == 1000 && cap.timestamp_ms[1] == 2000);
+    assert(cap.raw_p[0] == 415148 && cap.raw_h[1] == raw_h[1]);
+
+    std::vector<int32_t> t2(2);
+    std::vector<uint32_t> p2(2), h2(2);
+    assert(bme280_compensate_batch(cap.calib, cap.raw_t, cap.raw_p, cap.raw_h, t2, p2, h2));
+    assert(t2[0] == 2508 && p2[1] == p_out[1] && h2[1] == h_out[1]);
+
+    std::cout << "✓ test_bme280_batch_compensation passed" << std::endl;
+}
+
+// Sensirion word: 2 data bytes + CRC-8
+static void push_sensirion_word(std::vector<uint8_t> &out, uint16_t word)
+{
+    out.insert(out.end(), {static_cast<uint8_t>(word >> 8), static_cast<uint8_t>(word & 0xFF), sensirion::crc8(word)});
+}
+
+void test_sensirion_codec()
+{
+    // Datasheet example: CRC(0xBEEF) = 0x92; frames are built at compile time
+    static_assert(sensirion::crc8(uint16_t(0xBEEF)) == 0x92);
+    static_assert(sensirion::command_frame<0x21b1>[0] == 0x21 && sensirion::command_frame<0x21b1>[1] == 0xb1);
+    constexpr auto frame = sensirion::encode<0x241d, 1>({0x01F4});
+    static_assert(frame.size() == 5 && frame[2] == 0x01 && frame[3] == 0xF4 && frame[4] == sensirion::crc8(uint16_t(0x01F4)));
+
+    std::vector<uint8_t> wire;
+    push_sensirion_word(wire, 0xBEEF);
+    push_sensirion_word(wire, 0x1234);
+    std::array<uint16_t, 2> words{};
+    assert(sensirion::decode<2>(std::span<const uint8_t, 6>(wire.data(), 6), words));
+    assert(words[0] == 0xBEEF && words[1] == 0x1234);
+
+    wire[5] ^= 0x01;
+    assert(!sensirion::decode<2>(std::span<const uint8_t, 6>(wire.data(), 6), words));
+
+    // Transactions: one write_read, CRC failure surfaces as ErrorInvalidData
+    test_connection_mock conn;
+    conn.initialize();
+    push_sensirion_word(conn.responses[0xe4b8], 0x8006);
+    std::array<uint16_t, 1> ready{};
+    assert((sensirion::read_words<0xe4b8>(&conn, 0x62, ready) == peripherals::Status::Success));
+    assert(ready[0] == 0x8006);
+    conn.responses[0xe4b8][2] ^= 0xFF;
+    assert((sensirion::read_words<0xe4b8>(&conn, 0x62, ready) == peripherals::Status::ErrorInvalidData));
+    assert((sensirion::send<0x241d, 1>(&conn, 0x62, {0x01F4}) == peripherals::Status::Success));
+    assert(conn.commands.back() == 0x241d);
+
+    std::cout << "✓ test_sensirion_codec passed" << std::endl;
+}
+
+void test_scd41_modes_and_ready_time()
+{
+    using clock = std::chrono::steady_clock;
+    test_connection_mock conn;
+    conn.initialize();
+    push_sensirion_word(conn.responses[0xe4b8], 0x8006);   // data ready
+    push_sensirion_word(conn.responses[0xec05], 0);        // CO2 (0 in RHT-only)
+    push_sensirion_word(conn.responses[0xec05], 0x6667);   // ~25 degC
+    push_sensirion_word(conn.responses[0xec05], 0x8000);   // ~50 %RH
+
+    scd41 sensor(&conn, 0x62, scd41_mode::single_shot_rht_only);
+    assert(sensor.initialize() == peripherals::Status::Success);
+    assert(conn.commands == std::vector<uint16_t>{0x3f86});
+    assert(!sensor.data_ready_at());
+
+    // Trigger, sleep for the 50 ms conversion, confirm once, fetch
+    conn.commands.clear();
+    auto t0 = clock::now();
+    gas_data data{};
+    assert(sensor.read_data(data) == peripherals::Status::Success);
+    assert(clock::now() - t0 >= std::chrono::milliseconds(50));
+    assert((conn.commands == std::vector<uint16_t>{0x2196, 0xe4b8, 0xec05}));
+    assert(data.valid && std::fabs(data.temperature_c - 25.0f) < 0.1f && std::fabs(data.humidity_rh - 50.0f) < 0.1f);
+    float ppm = 0;
+    assert(sensor.read_co2(ppm) == peripherals::Status::ErrorInvalidData);
+
+    // Low-power periodic: the first result is predicted 30 s after the start
+    conn.commands.clear();
+    assert(sensor.set_measurement_mode(1) == peripherals::Status::Success);
+    assert(conn.commands == std::vector<uint16_t>{0x21ac});
+    auto ready = sensor.data_ready_at();
+    assert(ready && *ready - clock::now() > std::chrono::seconds(29));
+
+    assert(sensor.set_measurement_mode(4) == peripherals::Status::ErrorInvalidData);
+    assert(scd41::measurement_interval(scd41_mode::periodic) == std::chrono::milliseconds(5000));
+
+    std::cout << "✓ test_scd41_modes_and_ready_time passed" << std::endl;
+}
+
+void test_gas_index_algorithm_persistence()
+{
+    const int32_t baseline = 30000;
+
+    gas_index_algorithm learned(gas_index_type::voc);
+    for (int i = 0; i < 45; ++i)
+        assert(learned.process(baseline) == 0); // start-up blackout
+    for (int i = 0; i < 4 * 3600; ++i)
+        learned.process(baseline + (i % 7) - 3);
+    assert(std::abs(learned.process(baseline) - 100) <= 2);
+
+    const gas_index_state state = learned.get_state();
+    gas_index_algorithm restored(gas_index_type::voc);
+    restored.set_state(state);
+    gas_index_algorithm fresh(gas_index_type::voc);
+
+    for (int i = 0; i < 46; ++i) {
+        restored.process(baseline);
+        fresh.process(baseline);
+    }
+
+    // A VOC event lowers SRAW. The restored instance reacts like the one that learned for hours;
+    // a fresh one is still in its fast initial adaptation and pulls back towards 100.
+    int32_t idx_learned = 0, idx_restored = 0, idx_fresh = 0;
+    for (int i = 0; i < 300; ++i) {
+        idx_learned = learned.process(baseline - 300);
+        idx_restored = restored.process(baseline - 300);
+        idx_fresh = fresh.process(baseline - 300);
+    }
+    assert(idx_learned > 150);
+    assert(std::abs(idx_restored - idx_learned) <= 5);
+    assert(idx_fresh < idx_learned - 30);
+
+    std::cout << "✓ test_gas_index_algorithm_persistence passed" << std::endl;
+}
+
+void test_sgp41_conditioning_and_state()
+{
+    const char *path = "test_sgp41_state.txt";
+    const long long now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    test_connection_mock conn;
+    conn.initialize();
+    for (uint16_t w : {0x0001, 0x0002, 0x0003}) push_sensirion_word(conn.responses[0x3682], w);
+    push_sensirion_word(conn.responses[0x2612], 30000);
+    push_sensirion_word(conn.responses[0x2619], 30000);
+    push_sensirion_word(conn.responses[0x2619], 16000);
+
+    sgp41_settings settings;
+    settings.state_path = path;
+    settings.sampling_thread = false;
+
+    // Stale state is ignored
+    { std::ofstream f(path); f << "sgp41-state 1 " << (now - 3600) << " 10000 60 6000 40\n"; }
+    {
+        sgp41 sensor(&conn, 0x59, settings);
+        assert(sensor.initialize() == peripherals::Status::Success);
+        assert(!sensor.state_restored());
+    }
+
+    { std::ofstream f(path); f << "sgp41-state 1 " << now << " 10000 60 6000 40\n"; }
+    sgp41 sensor(&conn, 0x59, settings);
+    assert(sensor.initialize() == peripherals::Status::Success);
+    assert(sensor.state_restored());
+
+    conn.commands.clear();
+    for (int i = 0; i < sgp41::CONDITIONING_SAMPLES; ++i)
+        assert(sensor.sample() == peripherals::Status::Success);
+    assert(!sensor.is_conditioning());
+    assert(std::count(conn.commands.begin(), conn.commands.end(), 0x2612) == sgp41::CONDITIONING_SAMPLES);
+
+    gas_data data{};
+    assert(sensor.read_data(data) == peripherals::Status::ErrorInvalidData); // blackout
+    sensor.set_compensation(22.0f, 40.0f);
+    for (int i = 0; i < 50; ++i)
+        assert(sensor.sample() == peripherals::Status::Success);
+    assert(conn.commands.back() == 0x2619);
+    assert(sensor.read_data(data) == peripherals::Status::Success);
+    assert(data.valid && data.voc_index > 0 && data.nox_index > 0 && data.co2_ppm < 0);
+
+    // Shutdown persists the state and turns the heater off
+    sensor.deinitialize();
+    assert(conn.commands.back() == 0x3615);
+    std::ifstream f(path);
+    std::string tag;
+    int version = 0;
+    long long saved_at = 0;
+    f >> tag >> version >> saved_at;
+    assert(tag == "sgp41-state" && version == 1 && saved_at >= now);
+    assert(sensor.save_state());
+    assert(!std::filesystem::exists(std::string(path) + ".tmp"));
+    std::remove(path);
+
+
+    std::cout << "✓ test_sgp41_conditioning_and_state passed" << std::endl;
+}
+
+void test_ds3231_burst_time()
+{
+    test_connection_mock conn;
+    conn.initialize();
+    ds3231 rtc(&conn, 0x68);
+    assert(rtc.initialize() == peripherals::Status::Success);
+
+    time_data t{};
+    t.year = 2026; t.month = 1; t.day = 22; t.hour = 13; t.minute = 45; t.second = 30; t.valid = true;
+    conn.write_register_calls = 0;
+    assert(rtc.set_time(t) == peripherals::Status::Success);
+    assert(conn.write_register_calls == 1);
+    const uint8_t expected[7] = {0x30, 0x45, 0x13, 0x04 /* Thursday */, 0x22, 0x01, 0x26};
+    for (int i = 0; i < 7; ++i)
+        assert(conn.regs[i] == expected[i]);
+
+    conn.read_register_calls = 0;
+    time_data back{};
+    assert(rtc.read_data(back) == peripherals::Status::Success);
+    assert(conn.read_register_calls == 1);
+    assert(back.valid && back.year == 2026 && back.day == 22 && back.hour == 13 && back.second == 30);
+    assert(app::to_unix_seconds(back) == 1769089530);
+
+    // 12-hour mode (1 PM) and the century bit
+    conn.regs[2] = 0x40 | 0x20 | 0x01;
+    conn.regs[5] = 0x80 | 0x01;
+    assert(rtc.read_data(back) == peripherals::Status::Success);
+    assert(back.hour == 13 && back.year == 2126);
+
+    // Fields out of range are refused before anything is converted or written
+    conn.write_register_calls = 0;
+    time_data odd = t;
+    odd.month = 0;
+    assert(rtc.set_time(odd) == peripherals::Status::ErrorOutOfRange);
+    odd = t; odd.month = 13;
+    assert(rtc.set_time(odd) == peripherals::Status::ErrorOutOfRange);
+    odd = t; odd.day = 0;
+    assert(rtc.set_time(odd) == peripherals::Status::ErrorOutOfRange);
+    odd = t; odd.day = 32;
+    assert(rtc.set_time(odd) == peripherals::Status::ErrorOutOfRange);
+    odd = t; odd.hour = 24;
+    assert(rtc.set_time(odd) == peripherals::Status::ErrorOutOfRange);
+    odd = t; odd.minute = 60;
+    assert(rtc.set_time(odd) == peripherals::Status::ErrorOutOfRange);
+    odd = t; odd.second = -1;
+    assert(rtc.set_time(odd) == peripherals::Status::ErrorOutOfRange);
+    assert(conn.write_register_calls == 0);
+
+    std::cout << "✓ test_ds3231_burst_time passed" << std::endl;
+}
+
+void test_wall_clock_model()
+{
+    using namespace std::chrono;
+
+    // Calendar conversion round trip, including a leap day
+    for (int64_t s : {int64_t(0), int64_t(951782400), int64_t(1769089530), int64_t(4102444800)})
+        assert(app::to_unix_seconds(app::from_unix_seconds(s)) == s);
+    assert(app::from_unix_seconds(951782400).month == 2 && app::from_unix_seconds(951782400).day == 29);
+
+    app::wall_clock clock;
+    assert(!clock.synced());
+
+    const steady_clock::time_point t0{seconds(1000)};
+    const int64_t w0 = 1769089530LL * 1000000000LL;
+    clock.discipline(t0, w0);
+    assert(clock.synced() && clock.rate_ppm() == 0.0);
+    assert(clock.wall_ns_at(t0 + seconds(5)) == w0 + 5000000000LL);
+
+    // RTC ran 10 ms ahead over 100 s of monotonic time: +100 ppm
+    clock.discipline(t0 + seconds(100), w0 + 100010000000LL);
+    assert(std::fabs(clock.rate_ppm() - 100.0) < 1e-6);
+    assert(std::llabs(clock.wall_ns_at(t0 + seconds(200)) - (w0 + 200020000000LL)) < 10);
+
+    // A stepped reference restarts the baseline instead of producing an absurd rate
+    clock.discipline(t0 + seconds(300), w0 + 3600000000000LL);
+    assert(clock.rate_ppm() == 0.0);
+    assert(clock.wall_ns_at(t0 + seconds(300)) == w0 + 3600000000000LL);
+
+    // Seqlock readers never observe a half-written value
+    struct pair_value { int64_t a; int64_t b; };
+    app::seqlock<pair_value> lock(pair_value{0, 0});
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int64_t i = 1; i <= 200000; ++i)
+            lock.store({i, -i});
+        done = true;
+    });
+    while (!done) {
+        pair_value v = lock.load();
+        assert(v.a == -v.b);
+    }
+    writer.join();
+    assert(lock.load().a == 200000);
+
+    // The first RTC sync (up to ~1 s for the seconds edge) runs on the keeper's
+    // thread: swapping in a new RTC does not hold up the caller, and stop cuts it short
+    test_connection_mock rtc_conn;
+    rtc_conn.initialize();
+    ds3231 rtc(&rtc_conn, 0x68);
+    assert(rtc.initialize() == peripherals::Status::Success);
+    rtc_conn.regs[4] = 0x22; rtc_conn.regs[5] = 0x01; rtc_conn.regs[6] = 0x26; // frozen seconds: no edge
+    app::wall_clock rtc_clock;
+    const auto began = std::chrono::steady_clock::now();
+    std::optional<app::timekeeper> keeper;
+    keeper.emplace(rtc_clock, &rtc);
+    assert(std::chrono::steady_clock::now() - began < std::chrono::milliseconds(100));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(!rtc_clock.synced());
+    keeper.reset();
+    assert(std::chrono::steady_clock::now() - began < std::chrono::milliseconds(500));
+
+    std::cout << "✓ test_wall_clock_model passed" << std::endl;
+}
+
+void test_spsc_queue_observed_size()
+{
+    // size() from a thread that is neither side never exceeds the capacity
+    app::spsc_queue<int, 8> queue;
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        for (int i = 0; !done.load(std::memory_order_relaxed); ++i)
+            queue.try_push(i);
+    });
+    std::thread consumer([&] {
+        int v;
+        while (!done.load(std::memory_order_relaxed))
+            queue.try_pop(v);
+    });
+    size_t largest = 0;
+    for (int i = 0; i < 200000; ++i)
+        largest = std::max(largest, queue.size());
+    done = true;
+    producer.join();
+    consumer.join();
+    assert(largest <= queue.capacity());
+
+    std::cout << "✓ test_spsc_queue_observed_size passed" << std::endl;
+}
+
+void test_sample_bus()
+{
+    app::sample_bus bus;
+    assert(!bus.latest(app::channel::co2_ppm).valid);
+
+    auto *fast = bus.subscribe("fast");
+    auto *slow = bus.subscribe("slow");
+    assert(fast && slow);
+
+    // Gas sensor values win, the environmental frame only fills what is missing
+    app::sample_frame frame;
+    frame.set(app::channel::co2_ppm, 612.0);
+    frame.set(app::channel::temperature_c, 22.5);
+    app::sample_frame env;
+    env.set(app::channel::temperature_c, 21.0);
+    env.set(app::channel::pressure_pa, 101325.0);
+    frame.merge_missing(env);
+    frame.wall_ns = 1000;
+    assert(frame.get(app::channel::temperature_c) == 22.5 && frame.has(app::channel::pressure_pa));
+    assert(!frame.has(app::channel::voc_index));
+
+    const uint32_t co2_version = bus.version(app::channel::co2_ppm);
+    bus.publish(frame);
+    assert(bus.version(app::channel::co2_ppm) != co2_version);
+    assert(bus.latest(app::channel::co2_ppm).value == 612.0 && bus.latest(app::channel::co2_ppm).wall_ns == 1000);
+
+    // A frame without CO2 leaves the latest CO2 value in place
+    app::sample_frame voc_only;
+    voc_only.set(app::channel::voc_index, 101);
+    voc_only.wall_ns = 2000;
+    bus.publish(voc_only);
+    assert(bus.latest(app::channel::co2_ppm).value == 612.0);
+    assert(bus.latest(app::channel::voc_index).valid);
+
+    // Each subscriber sees every frame at its own pace
+    app::sample_frame got;
+    assert(fast->try_pop(got) && got.wall_ns == 1000);
+    assert(fast->try_pop(got) && got.wall_ns == 2000);
+    assert(!fast->try_pop(got));
+
+    // A stalled subscriber loses frames instead of blocking the producer
+    for (size_t i = 0; i < app::sample_bus::QUEUE_CAPACITY; ++i)
+        bus.publish(voc_only);
+    assert(slow->dropped() == 2);
+    assert(fast->dropped() == 0);
+    assert(slow->try_pop(got) && got.wall_ns == 1000);
+
+    // Blocking consumer wakes up on publish
+    auto *waiter = bus.subscribe("waiter");
+    std::jthread consumer([&](std::stop_token stop) {
+        app::sample_frame f;
+        assert(waiter->wait_pop(f, stop, std::chrono::milliseconds(5000)));
+        assert(f.wall_ns == 3000);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    voc_only.wall_ns = 3000;
+    bus.publish(voc_only);
+    consumer.join();
+
+    std::cout << "✓ test_sample_bus passed" << std::endl;
+}
+
+void test_csv_logger_subscriber()
+{
+    const std::string path = "test_csv_logger.csv";
+    std::remove(path.c_str());
+    std::remove((path + ".old").c_str());
+    std::remove(app::log_index_path(path).c_str());
+    {
+        std::ofstream legacy(path);
+        legacy << "timestamp,co2_ppm,temperature_c,pressure_pa,humidity_rh\n";
+    }
+
+    {
+        app::sample_bus bus;
+        app::csv_logger logger(path, bus);
+        app::sample_frame frame;
+        frame.wall_ns = 1769089530LL * 1000000000LL;
+        frame.set(app::channel::co2_ppm, 700);
+        frame.set(app::channel::voc_index, 120);
+        bus.publish(frame);
+    }
+
+    // The old column layout was moved aside, the new log starts with its header
+    std::ifstream old_log(path + ".old");
+    assert(old_log.good());
+
+    std::ifstream log(path);
+    std::string header, row;
+    assert(std::getline(log, header) && header == app::csv_logger::HEADER);
+    assert(std::getline(log, row));
+    assert(row.size() > 19 && row.substr(19) == ",700,,,,120,");
+
+    // The first row got an index entry
+    assert(std::filesystem::file_size(app::log_index_path(path)) == app::LOG_INDEX_HEADER + sizeof(app::log_index_entry));
+
+    std::remove(path.c_str());
+    std::remove((path + ".old").c_str());
+    std::remove(app::log_index_path(path).c_str());
+    std::cout << "✓ test_csv_logger_subscriber passed" << std::endl;
+}
+
+void test_tsdb_rollups()
+{
+    app::tsdb_settings settings;
+    settings.raw_capacity = 100;
+    settings.minute_capacity = 10;
+    settings.hour_capacity = 4;
+    app::tsdb db(settings);
+    const size_t footprint = db.footprint_bytes();
+
+    // Three hours of CO2 at 5 s, value = sample number
+    const int64_t s = 1000000000LL;
+    const int64_t t0 = 1769086800LL * s; // 2026-01-22 13:00:00 UTC, hour aligned
+    const int n = 3 * 3600 / 5;
+    for (int i = 0; i < n; ++i) {
+        app::sample_frame frame;
+        frame.wall_ns = t0 + i * 5 * s;
+        frame.set(app::channel::co2_ppm, i);
+        db.append(frame);
+    }
+    assert(db.footprint_bytes() == footprint);
+
+    // Raw ring keeps the newest 100 samples
+    std::vector<app::tsdb_point> points;
+    assert(db.query_raw(app::channel::co2_ppm, 0, INT64_MAX, points) == 100);
+    assert(points.front().value == n - 100 && points.back().value == n - 1);
+    assert(db.query_raw(app::channel::temperature_c, 0, INT64_MAX, points) == 0);
+
+    // Ten closed minutes survive plus the open one
+    std::vector<app::tsdb_rollup> minutes;
+    assert(db.query_rollups(app::channel::co2_ppm, app::tsdb_tier::minute, 0, INT64_MAX, minutes) == 11);
+    const auto &open = minutes.back();
+    assert(open.count == 12 && open.min == n - 12 && open.max == n - 1);
+    assert(open.mean() == (n - 12 + n - 1) / 2.0);
+    assert(minutes[9].start_ns + app::tsdb::MINUTE_NS == open.start_ns);
+
+    std::vector<app::tsdb_rollup> hours;
+    assert(db.query_rollups(app::channel::co2_ppm, app::tsdb_tier::hour, 0, INT64_MAX, hours) == 3);
+    assert(hours[0].start_ns == t0 && hours[0].count == 720 && hours[0].min == 0 && hours[0].max == 719);
+    assert(hours[0].mean() == 359.5);
+
+    // Ranges: the raw window answers the last five minutes, hours answer the whole run
+    auto recent = db.summarize(app::channel::co2_ppm, t0 + 10500 * s, INT64_MAX);
+    assert(recent.count == 60 && recent.mean() == (2100 + n - 1) / 2.0);
+    auto all = db.summarize(app::channel::co2_ppm, t0, INT64_MAX);
+    assert(all.count == static_cast<uint32_t>(n) && all.min == 0 && all.max == n - 1);
+
+    // A sample slightly older than the newest one is dropped
+    app::sample_frame late;
+    late.wall_ns = t0 + ((n - 1) * 5 - 2) * s;
+    late.set(app::channel::co2_ppm, 1);
+    db.append(late);
+    assert(db.out_of_order() == 1 && db.clock_steps() == 0);
+    points.clear();
+    assert(db.query_raw(app::channel::co2_ppm, 0, INT64_MAX, points) == 100);
+
+    // The clock set back by ~5 min: samples 2101.. are discarded, the channel goes on
+    app::sample_frame stepped;
+    stepped.wall_ns = t0 + 10502 * s;
+    stepped.set(app::channel::co2_ppm, 5000);
+    db.append(stepped);
+    assert(db.clock_steps() == 1 && db.out_of_order() == 1);
+    points.clear();
+    assert(db.query_raw(app::channel::co2_ppm, 0, INT64_MAX, points) == 42);
+    assert(points[40].value == 2100 && points.back().value == 5000 && points.back().wall_ns == stepped.wall_ns);
+
+    // Minute 175 (samples 2100..2111) is reopened, later minutes are gone
+    minutes.clear();
+    assert(db.query_rollups(app::channel::co2_ppm, app::tsdb_tier::minute, 0, INT64_MAX, minutes) == 7);
+    assert(minutes.back().start_ns == t0 + 10500 * s && minutes.back().count == 13 && minutes.back().max == 5000);
+    hours.clear();
+    assert(db.query_rollups(app::channel::co2_ppm, app::tsdb_tier::hour, 0, INT64_MAX, hours) == 3);
+    assert(hours.back().count == 721);
+
+    stepped.wall_ns += 5 * s;
+    db.append(stepped);
+    points.clear();
+    assert(db.query_raw(app::channel::co2_ppm, 0, INT64_MAX, points) == 43 && db.out_of_order() == 1);
+
+    std::cout << "✓ test_tsdb_rollups passed" << std::endl;
+}
+
+void test_peripheral_health_backoff()
+{
+    using namespace std::chrono;
+    using clock = app::peripheral_health::clock;
+
+    int probes = 0;
+    bool present = false;
+    app::health_policy policy;
+    policy.fail_after = 3;
+    policy.initial_backoff = milliseconds(1000);
+    policy.max_backoff = milliseconds(4000);
+    app::peripheral_health health(nullptr, "scd41", [&] { ++probes; return present; }, policy);
+
+    const clock::time_point t0{};
+    // "No data yet" and a read cut short by the tick's budget are not failures
+    assert(health.report(peripherals::Status::ErrorInvalidData, t0) == app::health_state::healthy);
+    assert(health.report(peripherals::Status::ErrorDeadline, t0) == app::health_state::healthy);
+    assert(health.report(peripherals::Status::ErrorCommunication, t0) == app::health_state::degraded);
+    assert(health.report(peripherals::Status::ErrorDeadline, t0) == app::health_state::degraded);
+    assert(health.consecutive_failures() == 1);
+    assert(health.report(peripherals::Status::Success, t0) == app::health_state::healthy);
+    assert(health.consecutive_failures() == 0);
+
+    health.report(peripherals::Status::ErrorCommunication, t0);
+    health.report(peripherals::Status::ErrorTimeout, t0);
+    assert(health.usable());
+    assert(health.report(peripherals::Status::ErrorCommunication, t0) == app::health_state::failed);
+    assert(!health.usable());
+
+    // Backoff doubles up to the cap while the device stays away
+    assert(!health.probe_if_due(t0 + milliseconds(999)) && probes == 0);
+    assert(!health.probe_if_due(t0 + milliseconds(1000)) && probes == 1);
+    assert(health.backoff() == milliseconds(2000));
+    assert(!health.probe_if_due(t0 + milliseconds(2999)) && probes == 1);
+    assert(!health.probe_if_due(t0 + milliseconds(3000)) && probes == 2);
+    assert(!health.probe_if_due(t0 + milliseconds(7000)) && probes == 3);
+    assert(health.backoff() == milliseconds(4000));
+
+    present = true;
+    assert(health.probe_if_due(t0 + milliseconds(11000)) && probes == 4);
+    assert(health.state() == app::health_state::healthy && health.recoveries() == 1);
+
+    std::cout << "✓ test_peripheral_health_backoff passed" << std::endl;
+}
+
+void test_health_monitor_reinitializes()
+{
+    using namespace std::chrono;
+
+    test_connection_mock conn;
+    conn.initialize();
+    load_bosch_example(conn, 0x60);
+    bme280 sensor(&conn, 0x76);
+    assert(sensor.initialize() == peripherals::Status::Success);
+
+    app::health_monitor monitor(milliseconds(5));
+    app::health_policy policy;
+    policy.fail_after = 2;
+    policy.initial_backoff = milliseconds(10);
+    auto &health = monitor.add(&sensor, "env@0x76", [&sensor] {
+        sensor.deinitialize();
+        return sensor.initialize() == peripherals::Status::Success;
+    }, policy);
+    assert(monitor.find(&sensor) == &health);
+    monitor.start();
+
+    // Unplugged: two failed reads take it out of the poll
+    conn.unplugged = true;
+    combined_env_data data{};
+    health.report(sensor.read_data(data));
+    health.report(sensor.read_data(data));
+    assert(health.state() == app::health_state::failed);
+
+    // Plugged back: the monitor re-initializes it on its own
+    std::this_thread::sleep_for(milliseconds(50));
+    assert(health.state() == app::health_state::failed);
+    conn.unplugged = false;
+    for (int i = 0; i < 200 && health.state() != app::health_state::healthy; ++i)
+        std::this_thread::sleep_for(milliseconds(5));
+    assert(health.state() == app::health_state::healthy && health.recoveries() == 1);
+    assert(sensor.is_initialized());
+    assert(sensor.read_data(data) == peripherals::Status::Success);
+
+    monitor.stop();
+    std::cout << "✓ test_health_monitor_reinitializes passed" << std::endl;
+}
+
+// Gas sensor stand-in that counts bring-ups and tear-downs
+class counting_gas_sensor : public gas_sensor_iface
+{
+public:
+    counting_gas_sensor(uint8_t address, int &inits, int &deinits)
+        : gas_sensor_iface(nullptr, address), inits_(inits), deinits_(deinits) {}
+
+    peripherals::Status initialize() override { ++inits_; initialized_ = true; return peripherals::Status::Success; }
+    void deinitialize() override { ++deinits_; initialized_ = false; }
+    bool is_connected() override { return true; }
+    peripherals::Status reset() override { return peripherals::Status::Success; }
+    peripherals::Status read_data(gas_data &) override { return peripherals::Status::Success; }
+    peripherals::Status set_measurement_mode(uint8_t) override { return peripherals::Status::Success; }
+    peripherals::Status read_co2(float &) override { return peripherals::Status::Success; }
+    peripherals::Status read_tvoc(float &) override { return peripherals::Status::Success; }
+
+private:
+    int &inits_;
+    int &deinits_;
+};
+
+void test_peripheral_set_reload_diff()
+{
+    int inits = 0, deinits = 0;
+    app::slot_factory make = [&](const config::PeripheralSpec &spec) {
+        auto slot = std::make_shared<app::peripheral_slot>();
+        slot->gas = std::make_unique<counting_gas_sensor>(spec.address, inits, deinits);
+        slot->gas->initialize();
+        return slot;
+    };
+    auto spec = [](const char *type, uint8_t address) {
+        config::PeripheralSpec p;
+        p.connection = "i2c";
+        p.device = "/dev/i2c-1";
+        p.type = type;
+        p.address = address;
+        return p;
+    };
+
+    config::AppConfig cfg;
+    cfg.peripherals = {spec("scd41", 0x62), spec("sgp41", 0x59)};
+    auto first = app::diff_peripherals(nullptr, cfg, make);
+    assert(first.added.size() == 2 && first.removed.empty());
+    assert(first.next->gas_sensors.size() == 2 && inits == 2);
+    std::shared_ptr<const app::peripheral_set> running = std::move(first.next);
+
+    // SGP41 options change, a second SCD41 appears: the first SCD41 is left alone
+    cfg.peripherals[1].options["sampling_interval_s"] = "10";
+    cfg.peripherals.push_back(spec("scd41", 0x62));
+
+    // The new SGP41 takes the old one's address, so that one is dropped first;
+    // the SCD41 is kept even though the second one shares its address
+    auto evicted = app::evict_replaced(*running, cfg);
+    assert(evicted.removed.size() == 1 && evicted.removed[0] == running->slots[1]);
+    assert(evicted.next->slots.size() == 1 && evicted.next->slots[0] == running->slots[0]);
+    assert(evicted.next->gas_sensors.size() == 1 && evicted.next->generation == running->generation + 1);
+    assert(evicted.next->config.peripherals.size() == 2);
+    assert(app::evict_replaced(*running, running->config).removed.empty());
+    evicted = {};
+
+    auto second = app::diff_peripherals(running.get(), cfg, make);
+    assert(second.next->generation == running->generation + 1);
+    assert(second.next->slots[0] == running->slots[0]);
+    assert(second.next->slots[1] != running->slots[1]);
+    assert(second.next->slots[2] != second.next->slots[0]); // identical entry, own device
+    assert(second.added.size() == 2 && second.removed.size() == 1);
+    assert(second.removed[0] == running->slots[1]);
+    assert(inits == 4 && deinits == 0);
+
+    // The health record of a removed device goes with it
+    app::health_monitor monitor;
+    const void *old_sgp = second.removed[0]->device();
+    monitor.add(old_sgp, "gas", [] { return true; });
+    monitor.add(second.next->slots[0]->device(), "gas", [] { return true; });
+    assert(monitor.remove(old_sgp) && !monitor.remove(old_sgp));
+    assert(monitor.size() == 1 && monitor.find(old_sgp) == nullptr);
+
+    // Old snapshot and the diff let go: only the replaced SGP41 is torn down
+    first.added.clear();
+    running.reset();
+    second.removed.clear();
+    assert(deinits == 1);
+
+    // Unknown entries are dropped, the rest still diffs
+    cfg.peripherals.push_back(spec("bogus", 0x10));
+    auto third = app::diff_peripherals(second.next.get(), cfg,
+        [&](const config::PeripheralSpec &p) { return p.type == "bogus" ? nullptr : make(p); });
+    assert(third.added.empty() && third.removed.empty());
+    assert(third.next->slots.size() == 3 && inits == 4);
+
+    std::cout << "✓ test_peripheral_set_reload_diff passed" << std::endl;
+}
+
+void test_sighup_requests_reload()
+{
+    using namespace std::chrono;
+
+    app::signal_handler::install();
+    std::atomic<int> reloads{0};
+    app::signal_handler::set_reload_callback([&reloads] { ++reloads; });
+
+    auto t0 = steady_clock::now();
+    std::raise(SIGHUP);
+    while (reloads.load() == 0 && steady_clock::now() - t0 < milliseconds(500))
+        std::this_thread::sleep_for(milliseconds(1));
+    assert(reloads.load() == 1);
+    assert(!app::signal_handler::shutdown_requested());
+    assert(!app::signal_handler::stop_token().stop_requested());
+
+    app::signal_handler::set_reload_callback(nullptr);
+    std::cout << "✓ test_sighup_requests_reload passed" << std::endl;
+}
+
+// Blocking loopback client: one response per call, leftovers kept for pipelining
+struct http_client
+{
+    int fd = -1;
+    std::string pending;
+
+    explicit http_client(uint16_t port)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        assert(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    }
+    ~http_client() { close(fd); }
+
+    void send_all(const std::string &data) { assert(send(fd, data.data(), data.size(), 0) == ssize_t(data.size())); }
+
+    // "" once the server has closed the connection
+    std::string response()
+    {
+        char buf[4096];
+        size_t head_end;
+        while ((head_end = pending.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return "";
+            pending.append(buf, size_t(n));
+        }
+        size_t length = std::stoul(pending.substr(pending.find("Content-Length: ") + 16));
+        while (pending.size() < head_end + 4 + length) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return "";
+            pending.append(buf, size_t(n));
+        }
+        std::string out = pending.substr(0, head_end + 4 + length);
+        pending.erase(0, out.size());
+        return out;
+    }
+};
+
+void test_metrics_server()
+{
+    using namespace std::chrono;
+
+    app::sample_bus bus;
+    app::health_monitor monitor;
+    int probe_target = 0;
+    auto &scd = monitor.add(&probe_target, "gas@0x62", [] { return true; });
+    scd.report(peripherals::Status::ErrorCommunication);
+    scd.record_read(microseconds(1500));
+    scd.record_read(microseconds(500));
+
+    app::metrics_server server("127.0.0.1", 0, bus, &monitor);
+    assert(server.listening() && server.port() != 0);
+    assert(server.renders() == 1);
+
+    // Before the first frame: counters, no readings
+    http_client client(server.port());
+    const std::string get = "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n";
+    client.send_all(get);
+    std::string r = client.response();
+    assert(r.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    assert(r.find("atmolyt_reading{") == std::string::npos);
+    assert(r.find("atmolyt_peripheral_errors_total{device=\"gas@0x62\"} 1\n") != std::string::npos);
+    assert(r.find("atmolyt_peripheral_read_duration_seconds_sum{device=\"gas@0x62\"} 0.002\n") != std::string::npos);
+    assert(r.find("atmolyt_peripheral_read_duration_seconds_count{device=\"gas@0x62\"} 2\n") != std::string::npos);
+
+    // A frame re-renders the buffer; the same connection sees it
+    app::sample_frame frame;
+    frame.wall_ns = 1700000000LL * 1000000000LL;
+    frame.set(app::channel::co2_ppm, 612);
+    bus.publish(frame);
+    for (int i = 0; i < 200 && server.renders() < 2; ++i)
+        std::this_thread::sleep_for(milliseconds(5));
+    assert(server.renders() == 2);
+    client.send_all(get);
+    r = client.response();
+    assert(r.find("atmolyt_reading{channel=\"co2_ppm\"} 612\n") != std::string::npos);
+    assert(r.find("atmolyt_reading_timestamp_seconds{channel=\"co2_ppm\"} 1700000000\n") != std::string::npos);
+    assert(r.find("atmolyt_subscriber_queue_depth{subscriber=\"metrics\"} 0\n") != std::string::npos);
+
+    // Pipelined requests are answered in order
+    client.send_all("GET /nope HTTP/1.1\r\n\r\nPOST /metrics HTTP/1.1\r\n\r\n" + get);
+    assert(client.response().rfind("HTTP/1.1 404", 0) == 0);
+    assert(client.response().rfind("HTTP/1.1 405", 0) == 0);
+    assert(client.response().rfind("HTTP/1.1 200", 0) == 0);
+
+    // Scrapes never re-render
+    for (int i = 0; i < 500; ++i) {
+        client.send_all(get);
+        assert(!client.response().empty());
+    }
+    assert(server.renders() == 2);
+
+    // Connection: close is honoured
+    client.send_all("GET /metrics HTTP/1.1\r\nConnection: close\r\n\r\n");
+    assert(!client.response().empty());
+    assert(client.response().empty());
+
+    std::string host;
+    uint16_t port = 0;
+    assert(app::parse_listen_address("127.0.0.1:9105", host, port) && host == "127.0.0.1" && port == 9105);
+    assert(app::parse_listen_address(":80", host, port) && host.empty() && port == 80);
+    assert(!app::parse_listen_address("9105", host, port) && !app::parse_listen_address("h:70000", host, port));
+
+    std::cout << "✓ test_metrics_server passed" << std::endl;
+}
+
+extern "C" int shm_c_read_co2(const char *name, double *ppm, int64_t *wall_ns);
+
+void test_shm_latest_sample()
+{
+    using namespace std::chrono;
+    const std::string name = "/atmolyt_test_" + std::to_string(getpid());
+
+    const atmolyt_shm_segment *seg = nullptr;
+    {
+        app::shm_publisher writer(name);
+        assert(writer.is_open());
+        seg = atmolyt_shm_map(name.c_str());
+        assert(seg && seg->channel_count == app::CHANNEL_COUNT && seg->writer_pid == getpid());
+
+        app::sample_frame frame;
+        frame.wall_ns = 1700000000LL * 1000000000LL;
+        frame.set(app::channel::co2_ppm, 612);
+        writer.publish(frame);
+
+        atmolyt_shm_sample s{};
+        assert(atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &s) && s.value == 612 && s.updates == 1);
+        assert(s.wall_ns == frame.wall_ns && seg->frames == 1);
+        assert(!atmolyt_shm_read(seg, ATMOLYT_SHM_HUMIDITY_RH, &s));
+
+        double ppm = 0;
+        int64_t wall_ns = 0;
+        assert(shm_c_read_co2(name.c_str(), &ppm, &wall_ns) && ppm == 612 && wall_ns == frame.wall_ns);
+    }
+
+    // The writer is gone, the values stay; a new writer carries on the sequence
+    atmolyt_shm_sample s{};
+    assert(seg->writer_pid == 0 && atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &s) && s.value == 612);
+    app::shm_publisher writer(name);
+    app::sample_bus bus;
+    assert(writer.attach(bus));
+
+    // Torn-read stress: value and timestamp are written as a pair, readers
+    // must never see one without the other
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0}, torn{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            uint64_t last_updates = 0;
+            atmolyt_shm_sample sample{};
+            while (!done.load(std::memory_order_relaxed)) {
+                atmolyt_shm_read(seg, ATMOLYT_SHM_TEMPERATURE_C, &sample);
+                if (sample.updates && (sample.wall_ns != static_cast<int64_t>(sample.value) * 1000 + 7 ||
+                                       sample.updates < last_updates))
+                    torn.fetch_add(1);
+                last_updates = sample.updates;
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    app::sample_frame frame;
+    const auto until = steady_clock::now() + milliseconds(200);
+    int64_t i = 0;
+    for (; steady_clock::now() < until; ++i) {
+        frame.set(app::channel::temperature_c, static_cast<double>(i));
+        frame.wall_ns = i * 1000 + 7;
+        writer.publish(frame);
+    }
+    done = true;
+    for (auto &t : readers)
+        t.join();
+    assert(torn.load() == 0 && reads.load() > 1000);
+    assert(atmolyt_shm_read(seg, ATMOLYT_SHM_TEMPERATURE_C, &s) && s.updates == static_cast<uint64_t>(i));
+
+    // Frames from the bus land there too
+    frame = app::sample_frame{};
+    frame.set(app::channel::co2_ppm, 800);
+    bus.publish(frame);
+    for (int k = 0; k < 200 && (atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &s), s.value != 800); ++k)
+        std::this_thread::sleep_for(milliseconds(5));
+    assert(s.value == 800 && s.updates == 2);
+
+    atmolyt_shm_unmap(seg);
+    shm_unlink(name.c_str());
+    std::cout << "✓ test_shm_latest_sample passed" << std::endl;
+}
+
+void test_shm_takeover_torn_record()
+{
+    const std::string name = "/atmolyt_test_torn_" + std::to_string(getpid());
+    {
+        app::shm_publisher writer(name);
+        app::sample_frame frame;
+        frame.set(app::channel::co2_ppm, 612);
+        writer.publish(frame);
+    }
+
+    // The previous writer died inside a store: seq is left odd
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    assert(fd >= 0);
+    void *p = mmap(nullptr, sizeof(atmolyt_shm_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    assert(p != MAP_FAILED);
+    auto *seg = static_cast<atmolyt_shm_segment *>(p);
+    uint64_t &seq = seg->records[ATMOLYT_SHM_CO2_PPM].seq;
+    assert(seq == 2);
+    seq = 3;
+
+    // The next writer rounds it up, so its stores complete and readers get through
+    app::shm_publisher writer(name);
+    assert(seq == 4);
+    app::sample_frame frame;
+    frame.set(app::channel::co2_ppm, 700);
+    writer.publish(frame);
+    atmolyt_shm_sample s{};
+    assert(seq == 6 && atmolyt_shm_read(seg, ATMOLYT_SHM_CO2_PPM, &s) && s.value == 700);
+
+    munmap(p, sizeof(atmolyt_shm_segment));
+    shm_unlink(name.c_str());
+    std::cout << "✓ test_shm_takeover_torn_record passed" << std::endl;
+}
+
+// Blocking Unix-socket client that decodes whole stream frames
+struct stream_client
+{
+    int fd = -1;
+    std::vector<uint8_t> buffer;
+
+    explicit stream_client(const std::string &path)
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, path.c_str());
+        assert(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    }
+    ~stream_client() { close(fd); }
+
+    void send_line(const std::string &line) { assert(send(fd, line.data(), line.size(), 0) == ssize_t(line.size())); }
+
+    bool next(app::sample_frame &frame, uint64_t &seq)
+    {
+        for (;;) {
+            size_t used = app::decode_stream_frame(buffer.data(), buffer.size(), frame, seq);
+            if (used) {
+                buffer.erase(buffer.begin(), buffer.begin() + long(used));
+                return true;
+            }
+            uint8_t chunk[4096];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            buffer.insert(buffer.end(), chunk, chunk + n);
+        }
+    }
+};
+
+void test_stream_server()
+{
+    using namespace std::chrono;
+
+    // Codec: only requested channels go out, as floats
+    app::sample_frame frame;
+    frame.wall_ns = 123456789;
+    frame.set(app::channel::co2_ppm, 612);
+    frame.set(app::channel::temperature_c, 21.5);
+    frame.set(app::channel::pressure_pa, 101325);
+    uint8_t wire[app::STREAM_FRAME_MAX];
+    size_t size = app::encode_stream_frame(frame, (1u << 0) | (1u << 3), 7, wire);
+    assert(size == sizeof(app::stream_frame_header) + 2 * sizeof(float));
+    app::sample_frame decoded;
+    uint64_t seq = 0;
+    assert(app::decode_stream_frame(wire, size - 1, decoded, seq) == 0);
+    assert(app::decode_stream_frame(wire, size, decoded, seq) == size && seq == 7);
+    assert(decoded.wall_ns == frame.wall_ns && decoded.get(app::channel::co2_ppm) == 612);
+    assert(decoded.get(app::channel::pressure_pa) == 101325 && !decoded.has(app::channel::temperature_c));
+
+    app::stream_filter filter;
+    assert(app::parse_stream_request("SUB co2_ppm,humidity_rh 12\r", filter) && filter.mask == 0b101 && filter.every == 12);
+    assert(app::parse_stream_request("SUB *", filter) && filter.mask == 0b111111 && filter.every == 1);
+    assert(!app::parse_stream_request("SUB bogus", filter) && !app::parse_stream_request("SUB * 0", filter));
+    assert(!app::parse_stream_request("GET /", filter));
+
+    const std::string path = "/tmp/atmolyt_stream_" + std::to_string(getpid()) + ".sock";
+    app::sample_bus bus;
+    {
+        app::stream_server server(path, bus);
+        assert(server.listening());
+
+        stream_client fast(path);
+        for (int i = 0; i < 200 && server.clients() < 1; ++i)
+            std::this_thread::sleep_for(milliseconds(5));
+        bus.publish(frame);
+        assert(fast.next(decoded, seq) && seq == 0);
+        assert(decoded.get(app::channel::temperature_c) == 21.5f && decoded.get(app::channel::co2_ppm) == 612);
+
+        // CO2 only, every third frame that has it
+        fast.send_line("SUB co2_ppm 3\n");
+        std::this_thread::sleep_for(milliseconds(50));
+        app::sample_frame pressure_only;
+        pressure_only.set(app::channel::pressure_pa, 1);
+        for (int i = 1; i <= 7; ++i) {
+            app::sample_frame f;
+            f.set(app::channel::co2_ppm, i);
+            f.set(app::channel::temperature_c, 20);
+            bus.publish(f);
+            bus.publish(pressure_only);
+        }
+        for (int expect : {1, 4, 7}) {
+            assert(fast.next(decoded, seq));
+            assert(decoded.valid == 1u && decoded.get(app::channel::co2_ppm) == expect);
+        }
+        assert(seq == 3);
+
+        // A client that never reads: its socket fills, then its ring drops the
+        // oldest frames; the other client still gets every frame in order
+        fast.send_line("SUB * 1\n");
+        std::this_thread::sleep_for(milliseconds(50));
+        stream_client stuck(path);
+        for (int i = 0; i < 200 && server.clients() < 2; ++i)
+            std::this_thread::sleep_for(milliseconds(5));
+
+        timeval timeout{2, 0};
+        setsockopt(fast.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        const int total = 3000;
+        std::atomic<bool> in_order{true};
+        std::atomic<int> received{0};
+        std::thread reader([&] {
+            app::sample_frame f;
+            uint64_t s = 0, expect = 4;
+            for (int i = 1; i <= total && in_order; ++i) {
+                if (!fast.next(f, s) || s != expect++ || f.get(app::channel::co2_ppm) != i)
+                    in_order = false;
+                received = i;
+            }
+        });
+        for (int i = 1; i <= total && in_order; ++i) {
+            app::sample_frame f;
+            f.set(app::channel::co2_ppm, i);
+            bus.publish(f);
+            // Paced by the fast client, so only the stuck one falls behind
+            while (i - received.load() > 32 && in_order)
+                std::this_thread::sleep_for(microseconds(100));
+        }
+        reader.join();
+        assert(in_order);
+        assert(server.dropped() > 0);
+
+        // The stuck client finds a gap and, at the end, the newest frame
+        timeout = {0, 500000};
+        setsockopt(stuck.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        size_t got = 0;
+        uint64_t last_seq = 0;
+        bool gap = false;
+        while (stuck.next(decoded, seq)) {
+            if (got && seq != last_seq + 1)
+                gap = true;
+            last_seq = seq;
+            ++got;
+            if (decoded.get(app::channel::co2_ppm) == total)
+                break;
+        }
+        assert(gap && got < size_t(total) && decoded.get(app::channel::co2_ppm) == total);
+    }
+    assert(access(path.c_str(), F_OK) != 0);
+
+    std::cout << "✓ test_stream_server passed" << std::endl;
+}
+
+void test_disk_spool()
+{
+    namespace fs = std::filesystem;
+    const std::string dir = "/tmp/atmolyt_spool_" + std::to_string(getpid());
+    fs::remove_all(dir);
+    auto segments = [&] {
+        size_t n = 0;
+        for (const auto &entry : fs::directory_iterator(dir))
+            n += entry.path().extension() == ".seg";
+        return n;
+    };
+
+    app::spool_settings settings;
+    settings.segment_bytes = 256;
+    std::string record;
+    app::spool_position next, acked;
+    {
+        app::disk_spool spool(dir, settings);
+        assert(spool.ok() && spool.empty() && !spool.read(record, next));
+        for (int i = 0; i < 100; ++i)
+            assert(spool.append("record-" + std::to_string(i)));
+        const size_t written = segments();
+        assert(written > 5);
+        for (int i = 0; i < 40; ++i) {
+            assert(spool.read(record, next) && record == "record-" + std::to_string(i));
+            if (i == 29)
+                acked = next;
+        }
+        // 0..29 delivered: the segments wholly before them are deleted
+        spool.ack(acked);
+        assert(segments() < written && spool.backlog_bytes() > 0);
+    }
+
+    // Power cut in the middle of an append: a torn record at the tail
+    std::string tail;
+    for (const auto &entry : fs::directory_iterator(dir))
+        if (entry.path().extension() == ".seg" && entry.path().string() > tail)
+            tail = entry.path().string();
+    {
+        std::ofstream f(tail, std::ios::app | std::ios::binary);
+        f.write("\x40\0\0\0ab", 6);
+    }
+    {
+        // Reading resumes at the committed cursor, so 30..39 come again
+        app::disk_spool spool(dir, settings);
+        assert(spool.corrupt_records() == 1);
+        assert(spool.read(record, next) && record == "record-30");
+        assert(spool.append("after-crash"));
+        int count = 1;
+        while (spool.read(record, next))
+            ++count;
+        assert(count == 71 && record == "after-crash");
+        spool.ack(next);
+        assert(spool.empty() && spool.backlog_bytes() == 0 && segments() == 1);
+    }
+
+    // Full: whole oldest segments go, the newest records stay
+    {
+        settings.max_bytes = 1024;
+        app::disk_spool spool(dir, settings);
+        for (int i = 0; i < 200; ++i)
+            assert(spool.append("record-" + std::to_string(i)));
+        assert(spool.dropped_segments() > 0 && spool.backlog_bytes() <= 1024);
+        assert(spool.read(record, next) && record != "record-0");
+        while (spool.read(record, next)) {
+        }
+        assert(record == "record-199");
+    }
+    fs::remove_all(dir);
+
+    std::cout << "✓ test_disk_spool passed" << std::endl;
+}
+
+void test_mqtt_sink()
+{
+    using namespace std::chrono;
+
+    // Codec: remaining length, CONNECT and PUBLISH bytes, packet framing
+    std::string len;
+    app::mqtt_append_length(len, 321);
+    assert(len == std::string("\xc1\x02", 2));
+    len.clear();
+    app::mqtt_append_length(len, 2097152);
+    assert(len == std::string("\x80\x80\x80\x01", 4));
+    assert(app::mqtt_connect("c", 30, "", "") == std::string("\x10\x0d\0\4MQTT\4\x02\0\x1e\0\1c", 15));
+    const std::string pub = app::mqtt_publish("a/b", "xy", 1, 10, true);
+    assert(pub == std::string("\x3a\x09\0\3a/b\0\x0axy", 11));
+    std::string in = pub.substr(0, 5);
+    uint8_t header = 0;
+    std::string body;
+    assert(app::mqtt_take_packet(in, header, body) == app::mqtt_parse::incomplete);
+    in = pub + app::mqtt_puback(10);
+    assert(app::mqtt_take_packet(in, header, body) == app::mqtt_parse::complete && header == 0x3a && body.size() == 9);
+    assert(app::mqtt_take_packet(in, header, body) == app::mqtt_parse::complete && header == 0x40 && in.empty());
+    in = std::string("\x30\xff\xff\xff\xff\x01", 6);
+    assert(app::mqtt_take_packet(in, header, body) == app::mqtt_parse::malformed);
+
+    app::sample_frame frame;
+    frame.wall_ns = 1700000000123456789;
+    frame.set(app::channel::co2_ppm, 612);
+    frame.set(app::channel::temperature_c, 21.5);
+    assert(app::mqtt_payload({frame}) == R"({"t":1700000000.123,"co2_ppm":612,"temperature_c":21.5})");
+    assert(app::mqtt_payload({frame, frame}).front() == '[');
+
+    auto co2_of = [](const std::string &payload, size_t nth) {
+        size_t pos = 0;
+        for (size_t i = 0; i <= nth; ++i)
+            pos = payload.find("\"co2_ppm\":", pos) + 10;
+        return std::atoi(payload.c_str() + pos);
+    };
+
+    fake_mqtt_broker broker;
+    assert(broker.port() != 0);
+    {
+        app::sample_bus bus;
+        app::mqtt_settings settings;
+        settings.port = broker.port();
+        settings.client_id = "test";
+        settings.topic = "atmolyt/test";
+        settings.batch = 2;
+        settings.max_inflight = 4;
+        settings.reconnect_min = milliseconds(20);
+        settings.reconnect_max = milliseconds(100);
+        app::mqtt_sink sink(settings, bus);
+        assert(sink.running());
+        for (int i = 0; i < 300 && !sink.connected(); ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+        assert(sink.connected() && broker.connects() == 1);
+
+        // Acks withheld: only a window's worth goes out
+        broker.hold_acks(true);
+        for (int i = 1; i <= 20; ++i) {
+            app::sample_frame f;
+            f.set(app::channel::co2_ppm, i);
+            bus.publish(f);
+        }
+        assert(broker.wait_for([](auto &b) { return b.received_count() >= 4; }));
+        std::this_thread::sleep_for(milliseconds(50));
+        assert(broker.received().size() == 4 && sink.in_flight() == 4 && sink.acked() == 0);
+
+        // Released: the rest follows in order, two samples per message
+        broker.hold_acks(false);
+        assert(broker.wait_for([](auto &b) { return b.received_count() == 10; }));
+        for (int i = 0; i < 300 && sink.acked() < 10; ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+        assert(sink.acked() == 10 && sink.in_flight() == 0);
+        auto got = broker.received();
+        for (size_t k = 0; k < got.size(); ++k) {
+            assert(got[k].topic == "atmolyt/test" && got[k].qos == 1 && !got[k].dup);
+            assert(co2_of(got[k].payload, 0) == int(2 * k + 1) && co2_of(got[k].payload, 1) == int(2 * k + 2));
+            assert(k == 0 || got[k].packet_id != got[k - 1].packet_id);
+        }
+
+        // Connection lost with two messages unacknowledged: both are resent as
+        // duplicates with their ids once the sink is back
+        broker.hold_acks(true);
+        for (int i = 21; i <= 24; ++i) {
+            app::sample_frame f;
+            f.set(app::channel::co2_ppm, i);
+            bus.publish(f);
+        }
+        assert(broker.wait_for([](auto &b) { return b.received_count() == 12; }));
+        broker.kick();
+        assert(broker.wait_for([](auto &b) { return b.connect_count() == 2 && b.received_count() == 14; }));
+        broker.hold_acks(false);
+        for (int i = 0; i < 300 && sink.acked() < 12; ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+        assert(sink.acked() == 12 && sink.connects() == 2);
+        got = broker.received();
+        for (size_t k = 12; k < 14; ++k) {
+            assert(got[k].dup && got[k].packet_id == got[k - 2].packet_id && got[k].payload == got[k - 2].payload);
+        }
+    }
+    // Clean shutdown says goodbye
+    for (int i = 0; i < 100 && broker.disconnects() == 0; ++i)
+        std::this_thread::sleep_for(milliseconds(10));
+    assert(broker.disconnects() == 1);
+
+    // QoS 0: fire and forget
+    {
+        app::sample_bus bus;
+        app::mqtt_settings settings;
+        settings.port = broker.port();
+        settings.qos = 0;
+        app::mqtt_sink sink(settings, bus);
+        for (int i = 0; i < 300 && !sink.connected(); ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+        bus.publish(frame);
+        assert(broker.wait_for([](auto &b) { return b.received_count() == 15; }));
+        assert(broker.received().back().qos == 0 && sink.published() == 1 && sink.acked() == 0);
+    }
+
+    // Store and forward: while the broker is away payloads go to disk; once it
+    // is back they drain at the configured rate, with live ones going first
+    const std::string spool_dir = "/tmp/atmolyt_mqtt_spool_" + std::to_string(getpid());
+    std::filesystem::remove_all(spool_dir);
+    uint16_t port = 0;
+    {
+        fake_mqtt_broker probe;
+        port = probe.port();
+    }
+    {
+        app::sample_bus bus;
+        app::mqtt_settings settings;
+        settings.port = port;
+        settings.max_inflight = 4;
+        settings.reconnect_min = milliseconds(20);
+        settings.reconnect_max = milliseconds(50);
+        settings.spool_dir = spool_dir;
+        settings.drain_rate = 50;
+        app::mqtt_sink sink(settings, bus);
+        for (int i = 1; i <= 30; ++i) {
+            app::sample_frame f;
+            f.set(app::channel::co2_ppm, i);
+            bus.publish(f);
+        }
+        for (int i = 0; i < 300 && sink.spooled() < 30; ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+        assert(sink.spooled() == 30 && !sink.connected() && sink.dropped() == 0);
+
+        fake_mqtt_broker back(port);
+        assert(back.port() == port);
+        for (int i = 0; i < 300 && !sink.connected(); ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+        const auto start = steady_clock::now();
+        app::sample_frame live;
+        live.set(app::channel::co2_ppm, 1000);
+        bus.publish(live);
+        assert(back.wait_for([](auto &b) { return b.received_count() == 31; }));
+        // A five-message burst, then 50/s
+        assert(steady_clock::now() - start >= milliseconds(400));
+
+        const auto drained = back.received();
+        int expect = 1;
+        size_t live_at = drained.size();
+        for (size_t k = 0; k < drained.size(); ++k) {
+            const int co2 = co2_of(drained[k].payload, 0);
+            if (co2 == 1000)
+                live_at = k;
+            else
+                assert(co2 == expect++);
+        }
+        assert(live_at < 15);
+        for (int i = 0; i < 300 && (sink.acked() < 31 || sink.backlog_bytes() > 0); ++i)
+            std::this_thread::sleep_for(milliseconds(10));
+        assert(sink.acked() == 31 && sink.backlog_bytes() == 0);
+    }
+    std::filesystem::remove_all(spool_dir);
+
+    std::cout << "✓ test_mqtt_sink passed" << std::endl;
+}
+
+void test_log_query()
+{
+    // Parse helpers
+    int64_t t = 0;
+    assert(app::civil_seconds(1970, 1, 1, 0, 0, 0) == 0);
+    assert(app::parse_log_timestamp("2026-03-29 02:30:00,415", t));
+    assert(t == app::civil_seconds(2026, 3, 29, 2, 30, 0));
+    assert(app::format_civil(t) == "2026-03-29 02:30:00");
+    assert(!app::parse_log_timestamp("2026-13-29 02:30:00", t));
+    assert(!app::parse_log_timestamp("timestamp,co2_ppm", t));
+    assert(app::parse_query_time("2026-03-29", 0, t) && t == app::civil_seconds(2026, 3, 29, 0, 0, 0));
+    assert(app::parse_query_time("2026-03-29 06:15", 0, t) && t == app::civil_seconds(2026, 3, 29, 6, 15, 0));
+    assert(app::parse_query_time("-2h", 100000, t) && t == 100000 - 7200);
+    assert(!app::parse_query_time("yesterday", 0, t));
+    int64_t bucket = 0;
+    assert(app::parse_query_duration("15m", bucket) && bucket == 900);
+    assert(app::parse_query_duration("1d", bucket) && bucket == 86400);
+    assert(app::parse_query_duration("all", bucket) && bucket == 0);
+    assert(!app::parse_query_duration("5x", bucket));
+
+    // Three days every 10 s; every 13th row has no CO2 and one line is garbage
+    struct row
+    {
+        int64_t t;
+        bool has;
+        double co2;
+    };
+    std::vector<row> rows;
+    std::string log = std::string(app::csv_logger::HEADER) + "\n";
+    const int64_t start = app::civil_seconds(2026, 3, 28, 0, 0, 0);
+    for (int i = 0; i < 3 * 8640; ++i)
+    {
+        const row r{start + i * 10, i % 13 != 0, 400 + (i * 37 % 1000) + 0.5};
+        rows.push_back(r);
+        log += app::format_civil(r.t) + ",";
+        if (r.has)
+            log += std::to_string(r.co2).substr(0, std::to_string(r.co2).find('.') + 2);
+        log += ",21.5,101325,40.2,,\n";
+        if (i == 5000)
+            log += "garbage\n";
+    }
+
+    // find_log_time lands on the first row at or after t
+    const int64_t from = app::civil_seconds(2026, 3, 28, 6, 0, 5);
+    const size_t body = log.find('\n') + 1;
+    const size_t at = app::find_log_time(log, body, from);
+    assert(log.compare(at, 19, "2026-03-28 06:00:10") == 0);
+    assert(app::find_log_time(log, body, start) == body);
+    assert(app::find_log_time(log, body, start + 365 * 86400) == log.size());
+
+    app::query_spec spec;
+    spec.from = from;
+    spec.to = app::civil_seconds(2026, 3, 29, 18, 30, 0);
+    spec.bucket_s = 3600;
+
+    // Brute force over the same range
+    std::map<int64_t, std::vector<float>> expected;
+    uint64_t in_range = 0;
+    for (const row &r : rows)
+    {
+        if (r.t < spec.from || r.t >= spec.to)
+            continue;
+        ++in_range;
+        if (r.has)
+            expected[r.t / 3600 * 3600].push_back(static_cast<float>(r.co2));
+    }
+
+    auto check = [&](const app::query_result &result) {
+        assert(result.ok && result.rows == in_range);
+        assert(result.buckets.size() == expected.size());
+        size_t i = 0;
+        for (auto &[key, values] : expected)
+        {
+            const app::query_bucket &b = result.buckets[i++];
+            std::vector<float> sorted = values;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0;
+            for (float v : values)
+                sum += v;
+            assert(b.start == key && b.count == values.size());
+            assert(b.min == sorted.front() && b.max == sorted.back());
+            assert(std::fabs(b.mean - sum / static_cast<double>(values.size())) < 1e-6);
+            assert(b.percentiles.size() == 3);
+            const double rank = 0.95 * static_cast<double>(sorted.size() - 1);
+            const size_t lo = static_cast<size_t>(rank);
+            assert(std::fabs(b.percentiles[1] - (sorted[lo] + (sorted[lo + 1] - sorted[lo]) * (rank - lo))) < 1e-3);
+        }
+    };
+
+    spec.threads = 1;
+    const app::query_result one = app::run_log_query(log, spec);
+    check(one);
+    spec.threads = 4;
+    const app::query_result four = app::run_log_query(log, spec);
+    assert(four.threads == 4);
+    check(four);
+
+    // One bucket over the whole log starts at the first value (row 0 has none)
+    spec = app::query_spec{};
+    spec.bucket_s = 0;
+    spec.threads = 3;
+    const app::query_result all = app::run_log_query(log, spec);
+    assert(all.ok && all.buckets.size() == 1 && all.rows == rows.size());
+    assert(all.buckets[0].start == start + 10 && all.buckets[0].count == rows.size() - (rows.size() + 12) / 13);
+
+    std::ostringstream out;
+    app::print_query_result(one, app::query_spec{}, out);
+    assert(out.str().rfind("bucket,count,min,max,mean,p50,p95,p99\n2026-03-28 06:00:00,", 0) == 0);
+
+    // Unknown columns and channels are errors, not empty results
+    spec.ch = app::channel::nox_index;
+    assert(app::run_log_query("timestamp,co2_ppm\n", spec).ok == false);
+    app::query_command cmd;
+    cmd.channel = "radon";
+    std::ostringstream err;
+    assert(app::run_query_command(cmd, out, err) == -EINVAL);
+
+    std::cout << "✓ test_log_query passed" << std::endl;
+}
+
+void test_log_index()
+{
+    const std::string path = "/tmp/atmolyt_log_index_" + std::to_string(getpid()) + ".csv";
+    const std::string idx = app::log_index_path(path);
+    std::remove(idx.c_str());
+
+    // Rows every 10 s, then a burst of 600 rows stamped the same second
+    std::string log = std::string(app::csv_logger::HEADER) + "\n";
+    const int64_t start = app::civil_seconds(2026, 2, 1, 0, 0, 0);
+    int64_t last = start;
+    auto add_row = [&](std::string &out, int64_t t, int i) {
+        out += app::format_civil(t) + "," + std::to_string(400 + i % 900) + ",21.5,,,,\n";
+        last = t;
+    };
+    for (int i = 0; i < 20000; ++i)
+        add_row(log, start + i * 10, i);
+    for (int i = 0; i < 600; ++i)
+        add_row(log, last + (i == 0), i);
+    {
+        std::ofstream(path, std::ios::binary) << log;
+    }
+
+    auto read_file = [](const std::string &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+
+    app::log_index_writer writer;
+    assert(writer.open(path));
+    // One entry a minute, plus one every 256 rows of the burst
+    assert(writer.entries() == 20000 / 6 + 1 + 600 / 256);
+    const std::string built = read_file(idx);
+
+    auto agrees = [&](const std::string &text) {
+        const app::log_index index(path, text);
+        assert(index.ok());
+        const size_t body = text.find('\n') + 1;
+        for (int64_t t : {start - 5, start, start + 7, start + 12345, start + 99995, last, last + 1})
+        {
+            const auto [lo, hi] = index.window(t, text.size());
+            assert(lo <= hi && hi - lo <= 256 * 64);
+            assert(app::find_log_time(text, std::max(lo, body), t, hi) == app::find_log_time(text, body, t));
+        }
+        app::query_spec spec;
+        spec.from = start + 1805;
+        spec.to = start + 5 * 3600 + 17;
+        const app::query_result plain = app::run_log_query(text, spec);
+        const app::query_result indexed = app::run_log_query(text, spec, &index);
+        assert(indexed.indexed && indexed.rows == plain.rows && indexed.bytes == plain.bytes);
+        assert(indexed.buckets.size() == plain.buckets.size());
+        for (size_t i = 0; i < plain.buckets.size(); ++i)
+            assert(indexed.buckets[i].count == plain.buckets[i].count && indexed.buckets[i].mean == plain.buckets[i].mean);
+    };
+    agrees(log);
+
+    // Appended rows extend it incrementally
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        for (int i = 0; i < 120; ++i)
+        {
+            const uint64_t offset = log.size();
+            add_row(log, last + 10, i);
+            out << log.substr(offset);
+            out.flush();
+            writer.add(last, offset);
+        }
+    }
+    assert(writer.entries() == 20000 / 6 + 1 + 600 / 256 + 20);
+    agrees(log);
+
+    // Missing: rebuilt to the same bytes from the log alone
+    const std::string grown = read_file(idx);
+    writer.close();
+    std::remove(idx.c_str());
+    assert(writer.open(path) && read_file(idx) == grown);
+    assert(grown.compare(0, built.size(), built) == 0);
+
+    // Rows the writer missed are picked up on open; a torn entry is cut off
+    writer.close();
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        const size_t offset = log.size();
+        for (int i = 0; i < 30; ++i)
+            add_row(log, last + 10, i);
+        out << log.substr(offset);
+        std::ofstream(idx, std::ios::binary | std::ios::app) << "torn";
+    }
+    assert(writer.open(path) && writer.entries() == 20000 / 6 + 1 + 600 / 256 + 25);
+    agrees(log);
+
+    // An index of another log is not used, and the writer starts it over
+    writer.close();
+    log = std::string(app::csv_logger::HEADER) + "\n";
+    for (int i = 0; i < 50; ++i)
+        add_row(log, start + 7 + i * 60, i);
+    {
+        std::ofstream(path, std::ios::binary) << log;
+    }
+    assert(!app::log_index(path, log).ok());
+    assert(writer.open(path) && writer.entries() == 50);
+    agrees(log);
+
+    // Reopened on an empty log with an empty index: nothing of the last one is carried over
+    writer.close();
+    log = std::string(app::csv_logger::HEADER) + "\n";
+    {
+        std::ofstream(path, std::ios::binary) << log;
+        app::log_index_writer fresh;
+        assert(fresh.open(path) && fresh.entries() == 0);
+    }
+    assert(std::filesystem::file_size(idx) == app::LOG_INDEX_HEADER);
+    assert(writer.open(path) && writer.entries() == 0);
+    writer.add(start, log.size());
+    assert(writer.entries() == 1);
+
+    writer.close();
+    std::remove(path.c_str());
+    std::remove(idx.c_str());
+    std::cout << "✓ test_log_index passed" << std::endl;
+}
+
+void test_log_replay()
+{
+    using namespace std::chrono;
+    using connections::replay_row;
+    const std::string path = "/tmp/atmolyt_replay_" + std::to_string(getpid()) + ".csv";
+
+    // 50 rows 5 s apart and a line that is not a row
+    const int64_t start = app::civil_seconds(2026, 2, 3, 10, 0, 0);
+    {
+        std::ofstream out(path);
+        out << app::csv_logger::HEADER << "\n";
+        for (int i = 0; i < 50; ++i) {
+            out << app::format_civil(start + i * 5) << "," << 600 + i << "," << 21.5 << ",101325," << 40 + i % 10;
+            out << (i % 2 ? ",120,1\n" : ",,\n");
+            if (i == 20)
+                out << "garbage\n";
+        }
+    }
+
+    // As fast as possible: every row in order, none skipped, then never due again
+    {
+        connections::replay_settings settings;
+        settings.speed = 0;
+        connections::replay_connection replay(path, settings);
+        assert(replay.initialize() == connections::Status::Success);
+        replay_row row;
+        for (int i = 0; i < 50; ++i) {
+            assert(replay.take(row));
+            assert(row.t_ms == (start + i * 5) * 1000 && row.get(replay_row::co2_ppm) == 600 + i);
+            assert(row.get(replay_row::pressure_pa) == 101325 && row.has(replay_row::voc_index) == (i % 2 == 1));
+        }
+        assert(!replay.take(row) && replay.next_due() == steady_clock::time_point::max());
+        assert(replay.played() == 50 && replay.skipped() == 0);
+    }
+
+    // Through the sensor interfaces at 100x: rows 50 ms apart, starting at `from`
+    {
+        connections::replay_settings settings;
+        settings.speed = 100;
+        settings.from = app::format_civil(start + 100);
+        connections::replay_connection replay(path, settings);
+        assert(replay.initialize() == connections::Status::Success);
+        peripherals::replay_gas_sensor gas(&replay);
+        assert(gas.initialize() == peripherals::Status::Success);
+
+        // Readiness checks neither move the recording nor start its clock: a read
+        // after a wait still gets the first row, and the next one 50 ms later
+        auto ready = gas.data_ready_at();
+        assert(ready && *ready <= steady_clock::now());
+        std::this_thread::sleep_for(milliseconds(60));
+        ready = gas.data_ready_at();
+        assert(ready && *ready <= steady_clock::now());
+
+        peripherals::gas_data data;
+        const auto began = steady_clock::now();
+        for (int i = 20; i < 25; ++i) {
+            assert(gas.read_data(data) == peripherals::Status::Success);
+            assert(data.co2_ppm == 600 + i && data.humidity_rh == 40 + i % 10);
+            assert(data.voc_index == (i % 2 ? 120 : -1));
+        }
+        assert(steady_clock::now() - began >= milliseconds(195));
+
+        // A deadline before the next row: not waited for, and data_ready_at() says so
+        peripherals::read_context ctx;
+        ctx.deadline = steady_clock::now();
+        assert(gas.data_ready_at() && *gas.data_ready_at() > ctx.deadline);
+        assert(gas.read_data_within(data, ctx) == peripherals::Status::ErrorDeadline);
+
+        // Read late: the rows that came due meanwhile are skipped like a real sensor's
+        std::this_thread::sleep_for(milliseconds(120));
+        assert(gas.read_data(data) == peripherals::Status::Success && data.co2_ppm >= 600 + 26);
+        assert(replay.skipped() >= 1);
+    }
+
+    // Looping, as the environmental sensor of a BME280 slot
+    {
+        connections::replay_settings settings;
+        settings.speed = 0;
+        settings.loop = true;
+        connections::replay_connection replay(path, settings);
+        assert(replay.initialize() == connections::Status::Success);
+        peripherals::replay_environmental env(&replay);
+        assert(env.initialize() == peripherals::Status::Success);
+        peripherals::combined_env_data data;
+        for (int i = 0; i < 120; ++i) {
+            assert(env.read_data(data) == peripherals::Status::Success);
+            assert(data.temperature.celsius == 21.5f && data.pressure.pascals == 101325.0f);
+            assert(data.humidity.relative_humidity == 40 + (i % 50) % 10);
+        }
+    }
+
+    // A raw BME280 capture plays as compensated values at its recorded spacing
+    const std::string capture = path + ".bin";
+    std::remove(capture.c_str());
+    peripherals::bme280_calibration calib;
+    calib.dig_T1 = 27504; calib.dig_T2 = 26435; calib.dig_T3 = -1000;
+    calib.dig_P1 = 36477; calib.dig_P2 = -10685; calib.dig_P3 = 3024; calib.dig_P4 = 2855;
+    calib.dig_P5 = 140; calib.dig_P6 = -7; calib.dig_P7 = 15500; calib.dig_P8 = -14600; calib.dig_P9 = 6000;
+    {
+        app::raw_capture_writer writer(capture, calib, false);
+        for (int i = 0; i < 10; ++i)
+            assert(writer.append(1769000000000LL + i * 1000, {519888 + i * 100, 415148, 0, true}));
+    }
+    {
+        connections::replay_settings settings;
+        settings.speed = 0;
+        connections::replay_connection replay(capture, settings);
+        assert(replay.initialize() == connections::Status::Success);
+        peripherals::replay_environmental env(&replay);
+        assert(env.initialize() == peripherals::Status::Success);
+        peripherals::combined_env_data data;
+        for (int i = 0; i < 10; ++i) {
+            assert(env.read_data(data) == peripherals::Status::Success);
+            const int32_t t_fine = peripherals::bme280_t_fine(calib, 519888 + i * 100);
+            assert(data.temperature.celsius == static_cast<float>(peripherals::bme280_temperature_centi(t_fine)) / 100.0f);
+            assert(data.pressure.pascals == static_cast<float>(peripherals::bme280_pressure_q24_8(calib, 415148, t_fine)) / 256.0f);
+            assert(!data.humidity.valid);
+        }
+        assert(env.read_data(data) == peripherals::Status::ErrorInvalidData);
+    }
+
+    // Nothing to play
+    connections::replay_connection missing(path + ".missing");
+    assert(missing.initialize() != connections::Status::Success);
+
+    std::remove(path.c_str());
+    std::remove(capture.c_str());
+    std::cout << "✓ test_log_replay passed" << std::endl;
+}
+
+void test_read_deadlines_and_cancellation()
+{
+    using namespace std::chrono;
+    using clock = steady_clock;
+
+    // SCD41 single shot takes 5 s: a 100 ms budget ends the read at once and the
+    // shot stays pending, so the next read does not trigger another one
+    test_connection_mock conn;
+    conn.initialize();
+    scd41 shot(&conn, 0x62, scd41_mode::single_shot);
+    assert(shot.initialize() == peripherals::Status::Success);
+    conn.commands.clear();
+
+    peripherals::read_context ctx;
+    ctx.deadline = clock::now() + milliseconds(100);
+    gas_data gas{};
+    auto t0 = clock::now();
+    assert(shot.read_data_within(gas, ctx) == peripherals::Status::ErrorDeadline);
+    assert(clock::now() - t0 < milliseconds(50));
+    ctx.deadline = clock::now() + milliseconds(100);
+    assert(shot.read_data_within(gas, ctx) == peripherals::Status::ErrorDeadline);
+    assert(conn.commands == std::vector<uint16_t>{0x219d});
+
+    // A stop request interrupts a read that is waiting for the periodic result
+    scd41 periodic(&conn, 0x62, scd41_mode::periodic);
+    assert(periodic.initialize() == peripherals::Status::Success);
+    std::stop_source source;
+    peripherals::read_context long_ctx;
+    long_ctx.stop = source.get_token();
+    std::jthread stopper([&source] {
+        std::this_thread::sleep_for(milliseconds(20));
+        source.request_stop();
+    });
+    t0 = clock::now();
+    assert(periodic.read_data_within(gas, long_ctx) == peripherals::Status::ErrorDeadline);
+    assert(clock::now() - t0 < milliseconds(70));
+
+    // BME280 forced: a budget below the conversion time keeps the conversion for the next read
+    test_connection_mock env_conn;
+    env_conn.initialize();
+    load_bosch_example(env_conn, 0x60);
+    bme280_settings forced;
+    forced.forced = true;
+    bme280 env(&env_conn, 0x76, forced);
+    assert(env.initialize() == peripherals::Status::Success);
+    env_conn.regs[0xF3] = 0; // status: not measuring
+    peripherals::read_context short_ctx;
+    short_ctx.deadline = clock::now() + milliseconds(2);
+    combined_env_data env_data{};
+    assert(env.read_data_within(env_data, short_ctx) == peripherals::Status::ErrorDeadline);
+    const size_t writes = env_conn.write_register_calls;
+    assert(env.read_data(env_data) == peripherals::Status::Success);
+    assert(env_conn.write_register_calls == writes);
+
+    // SIGTERM becomes a stop request through the self-pipe
+    app::signal_handler::install();
+    auto token = app::signal_handler::stop_token();
+    assert(!token.stop_requested());
+    t0 = clock::now();
+    std::raise(SIGTERM);
+    while (!token.stop_requested() && clock::now() - t0 < milliseconds(500))
+        std::this_thread::sleep_for(milliseconds(1));
+    assert(token.stop_requested() && app::signal_handler::shutdown_requested());
+    assert(clock::now() - t0 < milliseconds(50));
+
+    std::cout << "✓ test_read_deadlines_and_cancellation passed" << std::endl;
+}
+
+// Concrete drivers and the virtual interfaces both model the concept
+static_assert(sensor_driver_of<bme280, combined_env_data>);
+static_assert(sensor_driver_of<scd41, gas_data>);
+static_assert(sensor_driver_of<sgp41, gas_data>);
+static_assert(sensor_driver_of<ds3231, time_data>);
+static_assert(sensor_driver<gas_sensor_iface>);
+static_assert(!sensor_driver<int>);
+static_assert(type_from_name("SCD41") == PeripheralType::SCD41);
+static_assert(find_descriptor(PeripheralType::SSD1306)->default_address == 0x3C);
+
+void test_static_sensor_set()
+{
+    test_connection_mock conn;
+    conn.initialize();
+    conn.regs[0x00] = 0x30; conn.regs[0x01] = 0x45; conn.regs[0x02] = 0x13; conn.regs[0x03] = 0x04;
+    conn.regs[0x04] = 0x22; conn.regs[0x05] = 0x01; conn.regs[0x06] = 0x26;
+
+    mock_environmental env(&conn, 0x76);
+    ds3231 rtc(&conn, 0x68);
+    sensor_set sensors(env, rtc);
+    static_assert(decltype(sensors)::size() == 2);
+    assert(sensors.initialize_all() == peripherals::Status::Success);
+
+    int polled = 0;
+    float pressure = 0;
+    int year = 0;
+    sensors.poll([&](auto &driver, peripherals::Status status, const auto &data) {
+        assert(status == peripherals::Status::Success);
+        ++polled;
+        if constexpr (std::is_same_v<std::decay_t<decltype(driver)>, mock_environmental>)
+            pressure = data.pressure.pascals;
+        else
+            year = data.year;
+    });
+    assert(polled == 2 && pressure == 101325.0f && year == 2026);
+    assert(&sensors.get<1>() == &rtc);
+
+    // Dynamic configs keep using the interface as the driver type
+    auto dynamic = peripheral_factory::create_environmental_sensor(PeripheralType::BME280, &conn, 0x76);
+    sensor_set<environmental_sensor_iface> adapter(*dynamic);
+    assert(adapter.initialize_all() == peripherals::Status::Success);
+    adapter.poll([&](auto &, peripherals::Status status, const combined_env_data &data) {
+        assert(status == peripherals::Status::Success && data.temperature.valid);
+    });
+
+    // A failing driver in the middle does not keep the ones after it down
+    test_connection_mock absent;
+    absent.initialize();
+    absent.unplugged = true;
+    ds3231 missing_rtc(&absent, 0x68);
+    ds3231 last_rtc(&conn, 0x68);
+    sensor_set partial(env, missing_rtc, last_rtc);
+    assert(partial.initialize_all() == peripherals::Status::ErrorCommunication);
+    assert(!missing_rtc.is_initialized() && last_rtc.is_initialized());
+
+    assert(peripheral_factory::string_to_type("Ds3231") == PeripheralType::DS3231);
+    assert(peripheral_factory::type_to_string(PeripheralType::Unknown) == "unknown");
+
+    std::cout << "✓ test_static_sensor_set passed" << std::endl;
+}
+
 void test_connection_mock_read()
 {
     test_connection_mock conn;
@@ -62,12 +2158,291 @@ void test_peripheral_factory()
     std::cout << "✓ test_peripheral_factory passed" << std::endl;
 }
 
+void test_json_arena_dom()
+{
+    static_assert(sizeof(json::Node) == 24, "DOM node should stay compact");
+
+    auto doc = json::parse(R"({"name": "a\"b\\c", "n": -42, "x": 1.5e3, "ok": true, "none": null,)"
+                           R"( "u": "\u00e9\ud83d\ude00", "dup": 1, "dup": 2,)"
+                           R"( "list": [1, {"k": "v"}, [], {}], "last": "z"})");
+    assert(doc);
+    json::Value root = doc.root();
+    assert(root.is_object() && root.size() == 10);
+    assert(root.get_string("name") == "a\"b\\c");
+    assert(root.get_int("n") == -42 && root.get_number("x") == 1500.0);
+    assert(root.get_bool("ok") && root.get("none").is_null() && root.get("none"));
+    assert(root.get_string("u") == "\xc3\xa9\xf0\x9f\x98\x80");
+    assert(root.get_int("dup") == 2); // last one wins
+    assert(!root.get("missing") && root.get_int("missing", 7) == 7);
+    assert(root.get_string("n", "def") == "def"); // wrong type falls back
+    assert(root.get("x").is_int() && root.get("x").as_int() == 1500);
+
+    // Fractions and values outside int are not cast
+    auto wide = json::parse(R"({"f": 2.5, "big": 1e10, "neg": -3e9})");
+    assert(wide);
+    assert(!wide.root().get("f").is_int() && wide.root().get("f").as_int() == 0);
+    assert(wide.root().get_int("big", 7) == 7 && wide.root().get_int("neg", 7) == 7);
+
+    json::Value list = root.get("list");
+    assert(list.is_array() && list.size() == 4);
+    std::vector<json::Type> types;
+    for (json::Value v : list)
+        types.push_back(v.type());
+    assert(types == std::vector<json::Type>({json::Type::Number, json::Type::Object, json::Type::Array, json::Type::Object}));
+
+    // Members come back in document order with their keys
+    std::string keys;
+    for (json::Value v : root)
+        keys += std::string(v.key()) + ",";
+    assert(keys == "name,n,x,ok,none,u,dup,dup,list,last,");
+
+    // Values survive moving the document
+    json::Document moved = std::move(doc);
+    assert(!doc && root.get_string("last") == "z");
+
+    assert(!json::parse(R"({"a": 1} x)"));
+    assert(!json::parse(R"({"a": "open)"));
+    assert(!json::parse(R"([1, 2,])"));
+    assert(!json::parse(""));
+    assert(!json::parse(std::string(300, '[') + std::string(300, ']')));
+
+    // Files are mapped privately and unescaped in place without touching the file
+    const char *path = "test_json_dom.json";
+    const std::string text = R"({"peripherals": [{"type": "scd41", "label": "tab\there"}]})";
+    {
+        std::ofstream f(path);
+        f << text;
+    }
+    {
+        auto file_doc = json::parse_file(path);
+        assert(file_doc);
+        json::Value item = *file_doc.root().get("peripherals").begin();
+        assert(item.get_string("type") == "scd41" && item.get_string("label") == "tab\there");
+    }
+    std::ifstream check(path);
+    std::string on_disk((std::istreambuf_iterator<char>(check)), std::istreambuf_iterator<char>());
+    std::remove(path);
+    assert(on_disk == text);
+    assert(!json::parse_file("does_not_exist.json"));
+
+    std::cout << "✓ test_json_arena_dom passed" << std::endl;
+}
+
+void test_config_pull_reader()
+{
+    // Token stream, escaped keys and the typed helpers
+    json::Reader in(R"({"ab": [1, "x", null, {"deep": [true]}], "n": 2.5, "s": 7})");
+    std::string keys;
+    std::vector<std::string> elements;
+    double n = 0;
+    std::string s = "kept";
+    assert(in.object([&](std::string_view key) {
+        keys += std::string(key) + ",";
+        if (key == "ab")
+            in.array([&] {
+                json::Token t = in.read_scalar();
+                elements.push_back(t == json::Token::Number ? std::string(in.raw()) : t == json::Token::String ? std::string(in.string()) : "?");
+            });
+        else if (key == "n")
+            in.read(n);
+        else if (key == "s")
+            in.read(s); // wrong type: skipped, default kept
+    }));
+    assert(in.next() == json::Token::End);
+    assert(keys == "ab,n,s," && n == 2.5 && s == "kept");
+    assert(elements == std::vector<std::string>({"1", "x", "?", "?"}));
+
+    // Errors carry line and column
+    json::Reader bad("{\n  \"a\": 1\n  \"b\": 2\n}");
+    bad.object([&](std::string_view) { bad.skip(); });
+    assert(bad.failed() && bad.error() == "line 3, column 3: Expected ',' or '}' in object");
+    json::Reader trailing("[1,]");
+    assert(!trailing.array([&] { trailing.skip(); }) && trailing.error().rfind("line 1, column 4", 0) == 0);
+
+    // An int must be a whole number that fits: no undefined cast, no silent truncation
+    int ms = 5000;
+    json::Reader huge(R"({"poll_interval_ms": 1e12})");
+    assert(!huge.object([&](std::string_view) { huge.read(ms); }) && huge.failed() && ms == 5000);
+    assert(huge.error() == "line 1, column 26: Expected an integer within int range");
+    json::Reader fraction("[2.5]");
+    assert(!fraction.array([&] { fraction.read(ms); }) && ms == 5000);
+    json::Reader edge("[-2147483648, 2147483647]");
+    std::vector<int> ints;
+    assert(edge.array([&] { int v = 0; edge.read(v); ints.push_back(v); }));
+    assert(ints == std::vector<int>({std::numeric_limits<int>::min(), std::numeric_limits<int>::max()}));
+
+    // The loader binds straight into AppConfig
+    const char *path = "test_config_pull.json";
+    {
+        std::ofstream f(path);
+        f << "{\"peripherals\": [\n"
+          << R"(  {"type": "scd41", "address": 98, "label": "r\u00e9", "calib": {"a": 1}, "ratio": 0.5, "on": true},)" << "\n"
+          << R"(  {"type": "bme280", "address": "0x77"}, 5,)" << "\n"
+          << R"(  {"connection": "spi", "address": [1]}], "unknown": {"x": [1, 2]}, "read_budget_ms": 1500, "poll_interval_ms": 0, "metrics_listen": ":9105",)" << "\n"
+          << R"( "mqtt": {"broker": "broker.local:1883", "qos": 0, "batch": 12, "extra": [1]}})";
+    }
+    config::AppConfig cfg;
+    assert(config::load_config(path, cfg));
+    assert(cfg.read_budget_ms == 1500 && cfg.log_path == "atmolyt_data.csv");
+    assert(cfg.poll_interval_ms == 0);
+    assert(cfg.metrics_listen == ":9105");
+    assert(cfg.mqtt.broker == "broker.local:1883" && cfg.mqtt.qos == 0 && cfg.mqtt.batch == 12);
+    assert(cfg.mqtt.topic == "atmolyt/samples" && cfg.mqtt.max_inflight == 16);
+    assert(cfg.peripherals.size() == 3);
+    const auto &scd = cfg.peripherals[0];
+    assert(scd.type == "scd41" && scd.connection == "i2c" && scd.address == 98);
+    assert(scd.options.at("label") == "r\xc3\xa9" && scd.options.at("ratio") == "0.5" && scd.options.at("on") == "true");
+    assert(scd.options.count("calib") == 0);
+    assert(cfg.peripherals[1].address == 0x77);
+    assert(cfg.peripherals[2].connection == "spi" && cfg.peripherals[2].address == 0x76);
+
+    // A malformed file leaves the previous config untouched
+    {
+        std::ofstream f(path);
+        f << "{\"read_budget_ms\": 10,\n \"peripherals\": [}";
+    }
+    assert(!config::load_config(path, cfg));
+    assert(cfg.read_budget_ms == 1500 && cfg.peripherals.size() == 3);
+
+    // So does an address the bus cannot have: fractions, garbage, > 0xFF, > 0x7F on I2C
+    for (const char *address : {"118.5", "-1", "256", "\"0x1ZZ\"", "\"0x\"", "\"300\"", "\"0x80\""}) {
+        {
+            std::ofstream f(path);
+            f << R"({"read_budget_ms": 10, "peripherals": [{"address": )" << address << "}]}";
+        }
+        assert(!config::load_config(path, cfg));
+        assert(cfg.read_budget_ms == 1500 && cfg.peripherals.size() == 3);
+    }
+    {
+        std::ofstream f(path);
+        f << R"({"peripherals": [{"address": 200, "connection": "spi"}, {"address": "0X7f"}]})";
+    }
+    assert(config::load_config(path, cfg));
+    assert(cfg.peripherals[0].address == 200 && cfg.peripherals[1].address == 0x7F);
+    std::remove(path);
+
+    std::cout << "✓ test_config_pull_reader passed" << std::endl;
+}
+
+void test_config_peripheral_options()
+{
+    const char *path = "test_config_options.json";
+    {
+        std::ofstream f(path);
+        f << R"({"log_path": "x.csv", "peripherals": [)"
+          << R"({"connection": "spi", "type": "ssd1306", "device": "/dev/spidev0.0", "address": 0,)"
+          << R"( "speed_hz": 8000000, "gpio_chip": "/dev/gpiochip0", "dc_line": 25}]})";
+    }
+
+    config::AppConfig cfg;
+    bool ok = config::load_config(path, cfg);
+    std::remove(path);
+    assert(ok);
+    assert(cfg.peripherals.size() == 1);
+
+    const auto &opts = cfg.peripherals[0].options;
+    assert(cfg.peripherals[0].connection == "spi");
+    assert(opts.count("connection") == 0);
+    assert(peripherals::option_int(opts, "speed_hz") == 8000000);
+    assert(peripherals::option_int(opts, "dc_line", -1) == 25);
+    assert(peripherals::option_string(opts, "gpio_chip") == "/dev/gpiochip0");
+    assert(peripherals::option_int(opts, "missing", -1) == -1);
+
+    std::cout << "✓ test_config_peripheral_options passed" << std::endl;
+}
+
+// Display double that keeps a 128x64 bitmap
+class bitmap_display : public peripherals::display_iface
+{
+public:
+    bitmap_display() : display_iface(nullptr, 0) {}
+    peripherals::Status initialize() override { return peripherals::Status::Success; }
+    void deinitialize() override {}
+    bool is_connected() override { return true; }
+    peripherals::Status reset() override { return peripherals::Status::Success; }
+    peripherals::Status read_data(display_data &) override { return peripherals::Status::Success; }
+    peripherals::Status clear() override { pixels.fill(0); return peripherals::Status::Success; }
+    peripherals::Status display_text(const std::string &, uint8_t, uint8_t, uint8_t, bool) override { return peripherals::Status::Success; }
+    peripherals::Status set_cursor(uint8_t, uint8_t) override { return peripherals::Status::Success; }
+    void draw_pixel(int x, int y, int color) override {
+        if (x < 0 || x >= 128 || y < 0 || y >= 64) return;
+        pixels[y * 128 + x] = color ? 1 : 0;
+        ++pixel_writes;
+    }
+    void draw_line(int x0, int y0, int x1, int y1, int color) override {
+        // vertical only, enough for the sparkline
+        for (int y = std::min(y0, y1); y <= std::max(y0, y1); ++y) draw_pixel(x0, y, color);
+    }
+
+    std::array<uint8_t, 128 * 64> pixels{};
+    size_t pixel_writes = 0;
+};
+
+void test_sparkline_incremental_matches_redraw()
+{
+    bitmap_display incremental;
+    bitmap_display full;
+    app::sparkline a(&incremental, 0, 32, 16, 32, 0.0f, 100.0f);
+    app::sparkline b(&full, 0, 32, 16, 32, 0.0f, 100.0f);
+
+    for (int i = 0; i < 40; ++i) {
+        app::minmax_pair p{static_cast<float>((i * 37) % 100), static_cast<float>((i * 37) % 100 + (i % 3) * 10)};
+        a.append(p);
+        b.append(p);
+    }
+    incremental.pixel_writes = 0;
+    a.append({50.0f, 50.0f});
+    size_t scroll_cost = incremental.pixel_writes;
+    b.append({50.0f, 50.0f});
+
+    full.clear();
+    b.redraw();
+    assert(incremental.pixels == full.pixels);
+    assert(scroll_cost < 16 * 32); // less than repainting the plot area
+
+    std::cout << "✓ test_sparkline_incremental_matches_redraw passed" << std::endl;
+}
+
 int main()
 {
     try {
         test_connection_mock_read();
         test_peripheral_factory();
         test_bme280_initialization();
+        test_bme280_single_burst_read();
+        test_bme280_forced_mode_settings();
+        test_bme280_standby_per_chip();
+        test_bme280_batch_compensation();
+        test_sensirion_codec();
+        test_scd41_modes_and_ready_time();
+        test_gas_index_algorithm_persistence();
+        test_sgp41_conditioning_and_state();
+        test_ds3231_burst_time();
+        test_wall_clock_model();
+        test_spsc_queue_observed_size();
+        test_sample_bus();
+        test_csv_logger_subscriber();
+        test_static_sensor_set();
+        test_tsdb_rollups();
+        test_peripheral_health_backoff();
+        test_health_monitor_reinitializes();
+        test_peripheral_set_reload_diff();
+        test_metrics_server();
+        test_shm_latest_sample();
+        test_shm_takeover_torn_record();
+        test_stream_server();
+        test_disk_spool();
+        test_mqtt_sink();
+        test_log_query();
+        test_log_index();
+        test_log_replay();
+        // Before the SIGTERM in test_read_deadlines_and_cancellation ends the watcher
+        test_sighup_requests_reload();
+        test_read_deadlines_and_cancellation();
+        test_json_arena_dom();
+        test_config_pull_reader();
+        test_config_peripheral_options();
+        test_sparkline_incremental_matches_redraw();
         std::cout << "\n✓ All tests passed!" << std::endl;
         return 0;
     }